@@ -339,6 +339,29 @@ void TwoDAFile::createHeaderMap() {
 		_headerMap.insert(std::make_pair(_headers[i], i));
 }
 
+/** Format a cell of a columnar GDA, which doesn't have its rows as GFF4 structs anymore. */
+static Common::UString getGDAColumnarCell(const GDAFile &gda, size_t row, const GDAFile::Header &header) {
+	switch (header.type) {
+		case GDAFile::kTypeString:
+		case GDAFile::kTypeResource:
+			return gda.getString(row, header.hash);
+
+		case GDAFile::kTypeInt:
+			return Common::UString::format("%d", (int) gda.getInt(row, header.hash));
+
+		case GDAFile::kTypeFloat:
+			return Common::UString::format("%f", gda.getFloat(row, header.hash));
+
+		case GDAFile::kTypeBool:
+			return Common::UString::format("%u", (uint) gda.getInt(row, header.hash));
+
+		default:
+			break;
+	}
+
+	return "";
+}
+
 void TwoDAFile::load(const GDAFile &gda) {
 	try {
 
@@ -360,7 +383,11 @@ void TwoDAFile::load(const GDAFile &gda) {
 			_rows[i]->_data.resize(gda.getColumnCount());
 
 			for (size_t j = 0; j < gda.getColumnCount(); j++) {
-				if (row) {
+				if (gda.isColumnar()) {
+					if (gda.hasRow(i))
+						_rows[i]->_data[j] = getGDAColumnarCell(gda, i, headers[j]);
+
+				} else if (row) {
 					switch (headers[j].type) {
 						case GDAFile::kTypeString:
 						case GDAFile::kTypeResource:
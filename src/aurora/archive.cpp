@@ -41,6 +41,10 @@ uint32 Archive::getResourceSize(uint32 UNUSED(index)) const {
 	return 0xFFFFFFFF;
 }
 
+Common::SeekableReadStream *Archive::getResourceStream(uint32 index) const {
+	return getResource(index, true);
+}
+
 Common::HashAlgo Archive::getNameHashAlgo() const {
 	return Common::kHashNone;
 }
@@ -73,6 +73,17 @@ public:
 	 */
 	virtual Common::SeekableReadStream *getResource(uint32 index, bool tryNoCopy = false) const = 0;
 
+	/** Return a stream of the resource's contents, meant to be read once from start to end.
+	 *
+	 *  Where the archive supports it, the resource is decompressed on the fly
+	 *  while reading, instead of all at once. Seeking backwards in such a
+	 *  stream starts decompressing over, and broken data only shows up as
+	 *  errors while reading.
+	 *
+	 *  By default, this is the same as getResource() with tryNoCopy.
+	 */
+	virtual Common::SeekableReadStream *getResourceStream(uint32 index) const;
+
 	/** Return with which algorithm the name is hashed. */
 	virtual Common::HashAlgo getNameHashAlgo() const;
 
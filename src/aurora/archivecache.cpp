@@ -0,0 +1,191 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  A cache for the data of archives within archives.
+ */
+
+#include <cassert>
+
+#include "src/common/util.h"
+#include "src/common/error.h"
+#include "src/common/readstream.h"
+
+#include "src/aurora/archivecache.h"
+#include "src/aurora/archive.h"
+
+namespace Aurora {
+
+/** A stream reading the cached data of an archive member. */
+class ArchiveCache::MemberStream : public Common::SeekableReadStream {
+public:
+	MemberStream(ArchiveCache &cache, const Archive &archive, uint32 index, size_t size) :
+		_cache(&cache), _archive(&archive), _index(index), _size(size), _pos(0), _eos(false) {
+	}
+
+	~MemberStream() {
+	}
+
+	size_t read(void *dataPtr, size_t dataSize) {
+		if (dataSize > (_size - _pos)) {
+			dataSize = _size - _pos;
+			_eos = true;
+		}
+
+		if (dataSize == 0)
+			return 0;
+
+		// The data is shared with other streams, so we always need to seek first
+		Data data = _cache->get(*_archive, _index);
+
+		data->seek(_pos);
+		dataSize = data->read(dataPtr, dataSize);
+
+		_pos += dataSize;
+
+		return dataSize;
+	}
+
+	bool eos() const {
+		return _eos;
+	}
+
+	size_t pos() const {
+		return _pos;
+	}
+
+	size_t size() const {
+		return _size;
+	}
+
+	size_t seek(ptrdiff_t offset, Origin whence = kOriginBegin) {
+		const size_t oldPos = _pos;
+		const size_t newPos = evalSeek(offset, whence, _pos, 0, _size);
+		if (newPos > _size)
+			throw Common::Exception(Common::kSeekError);
+
+		_pos = newPos;
+		_eos = false;
+
+		return oldPos;
+	}
+
+private:
+	ArchiveCache *_cache;
+
+	const Archive *_archive;
+	uint32 _index;
+
+	size_t _size;
+	size_t _pos;
+
+	bool _eos;
+};
+
+
+ArchiveCache::ArchiveCache(size_t maxSize) : _size(0), _maxSize(maxSize) {
+}
+
+ArchiveCache::~ArchiveCache() {
+}
+
+size_t ArchiveCache::getSize() const {
+	return _size;
+}
+
+void ArchiveCache::clear() {
+	_entries.clear();
+	_size = 0;
+}
+
+void ArchiveCache::remove(const Archive &archive) {
+	for (std::list<Entry>::iterator e = _entries.begin(); e != _entries.end(); ) {
+		if (e->archive == &archive) {
+			_size -= e->data->size();
+			e = _entries.erase(e);
+		} else
+			++e;
+	}
+}
+
+Common::SeekableReadStream *ArchiveCache::open(const Archive &archive, uint32 index) {
+	// Do we already have this member's data?
+	Data data = find(archive, index);
+	if (data)
+		return new MemberStream(*this, archive, index, data->size());
+
+	std::unique_ptr<Common::SeekableReadStream> stream(archive.getResource(index, true));
+
+	// If the archive could give us a view into its own data, we can use that directly
+	if (dynamic_cast<Common::SeekableSubReadStream *>(stream.get()))
+		return stream.release();
+
+	// Otherwise, we got a copy of the data. Keep it around for everybody to read
+	const size_t size = stream->size();
+	add(archive, index, stream.release());
+
+	return new MemberStream(*this, archive, index, size);
+}
+
+ArchiveCache::Data ArchiveCache::add(const Archive &archive, uint32 index, Common::SeekableReadStream *data) {
+	assert(data);
+
+	Entry entry;
+
+	entry.archive = &archive;
+	entry.index   = index;
+	entry.data    = Data(data);
+
+	_entries.push_front(entry);
+	_size += data->size();
+
+	// Evict the least recently used members, but keep the one we just added
+	while ((_size > _maxSize) && (_entries.size() > 1)) {
+		_size -= _entries.back().data->size();
+		_entries.pop_back();
+	}
+
+	return entry.data;
+}
+
+ArchiveCache::Data ArchiveCache::find(const Archive &archive, uint32 index) {
+	for (std::list<Entry>::iterator e = _entries.begin(); e != _entries.end(); ++e) {
+		if ((e->archive != &archive) || (e->index != index))
+			continue;
+
+		// Mark this member as the most recently used one
+		if (e != _entries.begin())
+			_entries.splice(_entries.begin(), _entries, e);
+
+		return _entries.front().data;
+	}
+
+	return Data();
+}
+
+ArchiveCache::Data ArchiveCache::get(const Archive &archive, uint32 index) {
+	Data data = find(archive, index);
+	if (data)
+		return data;
+
+	return add(archive, index, archive.getResource(index));
+}
+
+} // End of namespace Aurora
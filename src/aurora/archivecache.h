@@ -0,0 +1,106 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  A cache for the data of archives within archives.
+ */
+
+#ifndef AURORA_ARCHIVECACHE_H
+#define AURORA_ARCHIVECACHE_H
+
+#include <list>
+#include <memory>
+
+#include <boost/noncopyable.hpp>
+
+#include "src/common/types.h"
+
+namespace Common {
+	class SeekableReadStream;
+}
+
+namespace Aurora {
+
+class Archive;
+
+/** A cache holding the data of archive members that are read like files.
+ *
+ *  To open an archive stored within another archive, we need random access
+ *  to its data. If the outer archive stores it uncompressed, we just read
+ *  straight out of the outer archive. Otherwise, it has to be decompressed
+ *  into memory first.
+ *
+ *  The decompressed data is shared by all streams of the same member and
+ *  held in this cache. The cache only keeps the most recently used members,
+ *  up to a maximum total size; evicted members are transparently read from
+ *  the outer archive again when they're next needed.
+ */
+class ArchiveCache : boost::noncopyable {
+public:
+	/** The default maximum size of the data held in the cache. */
+	static const size_t kDefaultMaxSize = 256 * 1024 * 1024;
+
+	ArchiveCache(size_t maxSize = kDefaultMaxSize);
+	~ArchiveCache();
+
+	/** Open a member of an archive for random access.
+	 *
+	 *  Both the archive and the cache need to be kept around for as long
+	 *  as the returned stream is in use.
+	 */
+	Common::SeekableReadStream *open(const Archive &archive, uint32 index);
+
+	/** Return the size of all data currently held in the cache. */
+	size_t getSize() const;
+
+	/** Remove all data from the cache. */
+	void clear();
+	/** Remove the data of all members of this archive from the cache. */
+	void remove(const Archive &archive);
+
+private:
+	class MemberStream;
+
+	typedef std::shared_ptr<Common::SeekableReadStream> Data;
+
+	struct Entry {
+		const Archive *archive;
+		uint32 index;
+
+		Data data;
+	};
+
+	/** All cached members, most recently used first. */
+	std::list<Entry> _entries;
+
+	size_t _size;
+	size_t _maxSize;
+
+	/** Return the data of this archive member, if it's in the cache. */
+	Data find(const Archive &archive, uint32 index);
+	/** Return the data of this archive member, reading it if necessary. */
+	Data get(const Archive &archive, uint32 index);
+	/** Add the data of an archive member to the cache. */
+	Data add(const Archive &archive, uint32 index, Common::SeekableReadStream *data);
+};
+
+} // End of namespace Aurora
+
+#endif // AURORA_ARCHIVECACHE_H
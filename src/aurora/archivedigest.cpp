@@ -0,0 +1,123 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Hashing and verifying the resources of an archive with MD5.
+ */
+
+#include <cstring>
+
+#include "src/common/error.h"
+#include "src/common/readstream.h"
+#include "src/common/md5.h"
+
+#include "src/aurora/archivedigest.h"
+#include "src/aurora/archive.h"
+#include "src/aurora/util.h"
+
+namespace Aurora {
+
+void hashMD5(const Archive &archive, const std::vector<uint32> &indices,
+             std::vector< std::vector<byte> > &digests) {
+
+	Common::hashMD5(indices.size(), [&archive, &indices](size_t i) -> Common::ReadStream * {
+		try {
+			// Read once from start to end, so the archive may decompress on the fly
+			return archive.getResourceStream(indices[i]);
+		} catch (...) {
+			// A broken resource simply gets no digest
+			return 0;
+		}
+	}, digests);
+}
+
+/** Collect the indices and file names of all resources in the archive. */
+static void getResources(const Archive &archive, std::vector<uint32> &indices,
+                         std::vector<Common::UString> &names) {
+
+	const Archive::ResourceList &resources = archive.getResources();
+
+	indices.reserve(resources.size());
+	names.reserve(resources.size());
+
+	for (Archive::ResourceList::const_iterator r = resources.begin(); r != resources.end(); ++r) {
+		indices.push_back(r->index);
+		names.push_back(TypeMan.setFileType(r->name, r->type));
+	}
+}
+
+void hashMD5(const Archive &archive, ResourceDigests &digests) {
+	std::vector<uint32> indices;
+	std::vector<Common::UString> names;
+	getResources(archive, indices, names);
+
+	std::vector< std::vector<byte> > hashed;
+	hashMD5(archive, indices, hashed);
+
+	digests.clear();
+	for (size_t i = 0; i < names.size(); i++)
+		digests[names[i]].swap(hashed[i]);
+}
+
+std::vector<Common::UString> verifyMD5(const Archive &archive, const ResourceDigests &digests) {
+	std::vector<uint32> indices;
+	std::vector<Common::UString> names;
+	getResources(archive, indices, names);
+
+	std::map<Common::UString, uint32> archiveIndices;
+	for (size_t i = 0; i < names.size(); i++)
+		archiveIndices.insert(std::make_pair(names[i].toLower(), indices[i]));
+
+	// Only hash the resources we know a digest for
+	std::vector<uint32> hashIndices;
+	std::vector<size_t> hashed(digests.size(), SIZE_MAX);
+
+	size_t n = 0;
+	for (ResourceDigests::const_iterator d = digests.begin(); d != digests.end(); ++d, ++n) {
+		std::map<Common::UString, uint32>::const_iterator a = archiveIndices.find(d->first.toLower());
+		if (a == archiveIndices.end())
+			continue;
+
+		hashed[n] = hashIndices.size();
+		hashIndices.push_back(a->second);
+	}
+
+	std::vector< std::vector<byte> > hashDigests;
+	hashMD5(archive, hashIndices, hashDigests);
+
+	std::vector<Common::UString> mismatches;
+
+	n = 0;
+	for (ResourceDigests::const_iterator d = digests.begin(); d != digests.end(); ++d, ++n) {
+		if (hashed[n] == SIZE_MAX) {
+			mismatches.push_back(d->first);
+			continue;
+		}
+
+		const std::vector<byte> &digest = hashDigests[hashed[n]];
+		if ((digest.size() != Common::kMD5Length) || (d->second.size() != Common::kMD5Length) ||
+		    std::memcmp(&digest[0], &d->second[0], Common::kMD5Length))
+			mismatches.push_back(d->first);
+	}
+
+	return mismatches;
+}
+
+} // End of namespace Aurora
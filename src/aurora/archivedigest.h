@@ -0,0 +1,66 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Hashing and verifying the resources of an archive with MD5.
+ */
+
+#ifndef AURORA_ARCHIVEDIGEST_H
+#define AURORA_ARCHIVEDIGEST_H
+
+#include <vector>
+#include <map>
+
+#include "src/common/types.h"
+#include "src/common/ustring.h"
+
+namespace Aurora {
+
+class Archive;
+
+/** Expected MD5 digests of resources, by their file name including the extension. */
+typedef std::map<Common::UString, std::vector<byte> > ResourceDigests;
+
+/** Hash these resources of an archive into MD5 digests of 16 bytes each.
+ *
+ *  The resources are read with Archive::getResourceStream(), and are hashed
+ *  several at a time in parallel lanes. A resource that can't be read, even
+ *  if it only fails halfway through, gets an empty digest.
+ */
+void hashMD5(const Archive &archive, const std::vector<uint32> &indices,
+             std::vector< std::vector<byte> > &digests);
+
+/** Hash all resources of an archive, by their file name including the extension. */
+void hashMD5(const Archive &archive, ResourceDigests &digests);
+
+/** Verify the resources of an archive against their expected MD5 digests.
+ *
+ *  The resource names are compared case-insensitively. Resources in the
+ *  archive without an expected digest are ignored.
+ *
+ *  @return The names of the resources that are missing from the archive,
+ *          that can't be read, or whose digest doesn't match, in the order
+ *          of the expected digests.
+ */
+std::vector<Common::UString> verifyMD5(const Archive &archive, const ResourceDigests &digests);
+
+} // End of namespace Aurora
+
+#endif // AURORA_ARCHIVEDIGEST_H
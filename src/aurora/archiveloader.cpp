@@ -0,0 +1,197 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Opening archive files of any type.
+ */
+
+#include <memory>
+
+#include "src/common/error.h"
+#include "src/common/readfile.h"
+#include "src/common/readwritefile.h"
+#include "src/common/filepath.h"
+
+#include "src/aurora/archiveloader.h"
+#include "src/aurora/util.h"
+#include "src/aurora/zipfile.h"
+#include "src/aurora/erffile.h"
+#include "src/aurora/rimfile.h"
+#include "src/aurora/keyfile.h"
+#include "src/aurora/biffile.h"
+#include "src/aurora/bzffile.h"
+#include "src/aurora/herffile.h"
+#include "src/aurora/ndsrom.h"
+#include "src/aurora/erfpatcher.h"
+#include "src/aurora/bifpatcher.h"
+
+namespace Aurora {
+
+bool isArchiveType(FileType type) {
+	switch (type) {
+		case kFileTypeZIP:
+		case kFileTypeERF:
+		case kFileTypeMOD:
+		case kFileTypeNWM:
+		case kFileTypeSAV:
+		case kFileTypeHAK:
+		case kFileTypeRIM:
+		case kFileTypeKEY:
+		case kFileTypeHERF:
+		case kFileTypeNDS:
+			return true;
+
+		default:
+			break;
+	}
+
+	return false;
+}
+
+Archive *openArchive(Common::SeekableReadStream *stream, FileType type, const Common::UString &dataPath) {
+	std::unique_ptr<Common::SeekableReadStream> archiveStream(stream);
+
+	switch (type) {
+		case kFileTypeZIP:
+			return new ZIPFile(archiveStream.release());
+
+		case kFileTypeERF:
+		case kFileTypeMOD:
+		case kFileTypeNWM:
+		case kFileTypeSAV:
+		case kFileTypeHAK:
+			return new ERFFile(archiveStream.release());
+
+		case kFileTypeRIM: {
+			const bool isERF = ERFFile::isERFID(archiveStream->readUint32BE());
+			archiveStream->seek(0);
+
+			if (isERF)
+				return new ERFFile(archiveStream.release());
+
+			return new RIMFile(archiveStream.release());
+		}
+
+		case kFileTypeKEY: {
+			std::unique_ptr<KEYFile> key = std::make_unique<KEYFile>(archiveStream.release());
+			addKEYDataFiles(*key, dataPath);
+
+			return key.release();
+		}
+
+		case kFileTypeHERF:
+			return new HERFFile(archiveStream.release());
+
+		case kFileTypeNDS:
+			return new NDSFile(archiveStream.release());
+
+		default:
+			break;
+	}
+
+	throw Common::Exception("Invalid archive type %d", (int) type);
+}
+
+Archive *openArchive(const Common::UString &path) {
+	try {
+		return openArchive(new Common::ReadFile(path), TypeMan.getFileType(path), Common::FilePath::getDirectory(path));
+	} catch (Common::Exception &e) {
+		e.add("Failed to open archive \"%s\"", path.c_str());
+		throw;
+	}
+}
+
+ArchivePatcher *openArchivePatcher(Common::SeekableReadWriteStream *stream, FileType type) {
+	std::unique_ptr<Common::SeekableReadWriteStream> archiveStream(stream);
+
+	switch (type) {
+		case kFileTypeERF:
+		case kFileTypeMOD:
+		case kFileTypeNWM:
+		case kFileTypeSAV:
+		case kFileTypeHAK:
+			return new ERFPatcher(archiveStream.release());
+
+		case kFileTypeRIM: {
+			const bool isERF = ERFFile::isERFID(archiveStream->readUint32BE());
+			archiveStream->seek(0);
+
+			if (isERF)
+				return new ERFPatcher(archiveStream.release());
+
+			break;
+		}
+
+		case kFileTypeBIF:
+			return new BIFPatcher(archiveStream.release());
+
+		default:
+			break;
+	}
+
+	throw Common::Exception("Archive type can't be patched in place");
+}
+
+ArchivePatcher *openArchivePatcher(const Common::UString &path) {
+	try {
+		return openArchivePatcher(new Common::ReadWriteFile(path), TypeMan.getFileType(path));
+	} catch (Common::Exception &e) {
+		e.add("Failed to open archive \"%s\" for patching", path.c_str());
+		throw;
+	}
+}
+
+KEYDataFile *openKEYDataFile(const Common::UString &path) {
+	const FileType type = TypeMan.getFileType(path);
+
+	switch (type) {
+		case kFileTypeBIF:
+			return new BIFFile(new Common::ReadFile(path));
+
+		case kFileTypeBZF:
+			return new BZFFile(new Common::ReadFile(path));
+
+		default:
+			break;
+	}
+
+	throw Common::Exception("Unknown KEY data file type %d", (int) type);
+}
+
+void addKEYDataFiles(KEYFile &key, const Common::UString &dataPath) {
+	const std::vector<Common::UString> &dataFiles = key.getDataFileList();
+	for (size_t i = 0; i < dataFiles.size(); i++) {
+		const Common::UString path = Common::FilePath::normalize(dataPath + "/" + dataFiles[i]);
+		if (path.empty()) {
+			Common::Exception e("No such file or directory \"%s\"", (dataPath + "/" + dataFiles[i]).c_str());
+			e.add("Failed to load KEY data file \"%s\"", dataFiles[i].c_str());
+
+			Common::printException(e, "WARNING: ");
+			continue;
+		}
+
+		// Only open the data file once one of its resources is actually needed
+		key.addDataFile(i, [path]() {
+			return openKEYDataFile(path);
+		});
+	}
+}
+
+} // End of namespace Aurora
@@ -0,0 +1,90 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Opening archive files of any type.
+ */
+
+#ifndef AURORA_ARCHIVELOADER_H
+#define AURORA_ARCHIVELOADER_H
+
+#include "src/common/ustring.h"
+
+#include "src/aurora/types.h"
+
+namespace Common {
+	class SeekableReadStream;
+	class SeekableReadWriteStream;
+}
+
+namespace Aurora {
+
+class Archive;
+class ArchivePatcher;
+class KEYFile;
+class KEYDataFile;
+
+/** Is this a type of archive openArchive() can open?
+ *
+ *  BIF and BZF files are not archives in their own right: their resources
+ *  are only accessible through the KEY files indexing them.
+ */
+bool isArchiveType(FileType type);
+
+/** Open an archive of this type from a stream.
+ *
+ *  The data files of KEY files are opened on demand, relative to the dataPath.
+ *
+ *  Takes over ownership of the stream, even if opening the archive fails.
+ */
+Archive *openArchive(Common::SeekableReadStream *stream, FileType type, const Common::UString &dataPath);
+
+/** Open an archive file, figuring out its type from the file name.
+ *
+ *  The data files of KEY files are opened on demand, relative to the KEY file.
+ */
+Archive *openArchive(const Common::UString &path);
+
+/** Open an archive of this type from a stream for patching in place.
+ *
+ *  Only ERF and BIF files can be patched in place.
+ *
+ *  Takes over ownership of the stream, even if opening the archive fails.
+ */
+ArchivePatcher *openArchivePatcher(Common::SeekableReadWriteStream *stream, FileType type);
+
+/** Open an archive file for patching in place, figuring out its type from the file name.
+ *
+ *  Only ERF and BIF files can be patched in place.
+ */
+ArchivePatcher *openArchivePatcher(const Common::UString &path);
+
+/** Open a KEY data file (BIF/BZF). */
+KEYDataFile *openKEYDataFile(const Common::UString &path);
+
+/** Let a KEY file open its data files on demand, relative to the dataPath.
+ *
+ *  Data files that don't exist are skipped with a warning.
+ */
+void addKEYDataFiles(KEYFile &key, const Common::UString &dataPath);
+
+} // End of namespace Aurora
+
+#endif // AURORA_ARCHIVELOADER_H
@@ -0,0 +1,518 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Patching archives in place.
+ */
+
+#include <cassert>
+
+#include <algorithm>
+
+#include "src/common/util.h"
+#include "src/common/error.h"
+#include "src/common/readstream.h"
+#include "src/common/readwritestream.h"
+
+#include "src/aurora/archivepatcher.h"
+
+namespace Aurora {
+
+ArchiveSpace::ArchiveSpace() : _end(0), _freeSize(0), _maxUsedSize(0) {
+}
+
+void ArchiveSpace::clear() {
+	_used.clear();
+	_free.clear();
+
+	_end         = 0;
+	_freeSize    = 0;
+	_maxUsedSize = 0;
+}
+
+size_t ArchiveSpace::getEnd() const {
+	return _end;
+}
+
+size_t ArchiveSpace::getFreeSize() const {
+	return _freeSize;
+}
+
+void ArchiveSpace::use(size_t offset, size_t size) {
+	if (size == 0)
+		return;
+
+	const size_t end = offset + size;
+
+	_used.insert(std::make_pair(offset, end));
+	_maxUsedSize = MAX(_maxUsedSize, size);
+
+	// Everything between the old end and this area is a new gap
+	if (offset > _end)
+		addFree(_end, offset);
+
+	markUsed(offset, end);
+
+	_end = MAX(_end, end);
+}
+
+void ArchiveSpace::release(size_t offset, size_t size) {
+	if (size == 0)
+		return;
+
+	const size_t end = offset + size;
+
+	std::pair<UsedMap::iterator, UsedMap::iterator> range = _used.equal_range(offset);
+	for (UsedMap::iterator u = range.first; u != range.second; ++u) {
+		if (u->second != end)
+			continue;
+
+		_used.erase(u);
+
+		markFree(offset, end);
+		return;
+	}
+
+	throw Common::Exception("Releasing an unused archive area (%u, %u)", (uint)offset, (uint)size);
+}
+
+size_t ArchiveSpace::allocate(size_t size) {
+	if (size == 0)
+		return _end;
+
+	// Find the smallest gap the area fits into
+	FreeMap::const_iterator best = _free.end();
+	for (FreeMap::const_iterator f = _free.begin(); f != _free.end(); ++f) {
+		const size_t gapSize = f->second - f->first;
+		if (gapSize < size)
+			continue;
+
+		if ((best == _free.end()) || (gapSize < (best->second - best->first)))
+			best = f;
+
+		if (gapSize == size)
+			break;
+	}
+
+	size_t offset = _end;
+	if (best != _free.end())
+		offset = best->first;
+	else if (!_free.empty() && (_free.rbegin()->second == _end))
+		offset = _free.rbegin()->first; // Grow the gap at the end
+
+	use(offset, size);
+
+	return offset;
+}
+
+void ArchiveSpace::addFree(size_t offset, size_t end) {
+	if (offset >= end)
+		return;
+
+	_freeSize += end - offset;
+
+	// Merge with the gaps right before and after
+	FreeMap::iterator next = _free.lower_bound(offset);
+	if ((next != _free.end()) && (next->first == end)) {
+		end = next->second;
+		next = _free.erase(next);
+	}
+
+	if (next != _free.begin()) {
+		FreeMap::iterator prev = next;
+		--prev;
+
+		if (prev->second == offset) {
+			prev->second = end;
+			return;
+		}
+	}
+
+	_free.insert(next, std::make_pair(offset, end));
+}
+
+void ArchiveSpace::markUsed(size_t offset, size_t end) {
+	FreeMap::iterator f = _free.upper_bound(offset);
+	if (f != _free.begin()) {
+		--f;
+
+		if (f->second <= offset)
+			++f;
+	}
+
+	while ((f != _free.end()) && (f->first < end)) {
+		const size_t gapOffset = f->first;
+		const size_t gapEnd    = f->second;
+
+		f = _free.erase(f);
+		_freeSize -= gapEnd - gapOffset;
+
+		// Keep the parts of the gap outside of the used area
+		if (gapOffset < offset) {
+			_free.insert(f, std::make_pair(gapOffset, offset));
+			_freeSize += offset - gapOffset;
+		}
+
+		if (gapEnd > end) {
+			f = _free.insert(f, std::make_pair(end, gapEnd));
+			_freeSize += gapEnd - end;
+
+			break;
+		}
+	}
+}
+
+void ArchiveSpace::markFree(size_t offset, size_t end) {
+	// All used areas overlapping this range start at most _maxUsedSize bytes before it
+	UsedMap::const_iterator u = _used.lower_bound((offset > _maxUsedSize) ? (offset - _maxUsedSize) : 0);
+
+	size_t cur = offset;
+	for (; (u != _used.end()) && (u->first < end); ++u) {
+		if (u->second <= cur)
+			continue;
+
+		if (u->first > cur)
+			addFree(cur, u->first);
+
+		cur = u->second;
+		if (cur >= end)
+			return;
+	}
+
+	addFree(cur, end);
+}
+
+
+ArchivePatcher::ArchivePatcher(Common::SeekableReadWriteStream *archive) :
+	_archive(archive), _headerSize(0), _changed(false) {
+
+	assert(_archive);
+}
+
+ArchivePatcher::~ArchivePatcher() {
+}
+
+size_t ArchivePatcher::getResourceCount() const {
+	return _data.size();
+}
+
+size_t ArchivePatcher::getSize() const {
+	return _archive->size();
+}
+
+size_t ArchivePatcher::getFreeSize() const {
+	size_t freeSize = _space.getFreeSize();
+
+	// Anything after the last used area is unused, too
+	if (_archive->size() > _space.getEnd())
+		freeSize += _archive->size() - _space.getEnd();
+
+	return freeSize;
+}
+
+double ArchivePatcher::getFragmentation() const {
+	if (_archive->size() == 0)
+		return 0.0;
+
+	return ((double) getFreeSize()) / ((double) _archive->size());
+}
+
+void ArchivePatcher::initLayout(size_t headerSize, const Area &tables, const std::vector<Area> &data) {
+	_space.clear();
+	_released.clear();
+
+	_headerSize = headerSize;
+	_tables     = tables;
+	_data       = data;
+
+	_space.use(0, _headerSize);
+	_space.use(_tables.offset, _tables.size);
+
+	for (std::vector<Area>::const_iterator d = _data.begin(); d != _data.end(); ++d)
+		_space.use(d->offset, d->size);
+}
+
+const ArchivePatcher::Area &ArchivePatcher::getTables() const {
+	return _tables;
+}
+
+const ArchivePatcher::Area &ArchivePatcher::getData(size_t index) const {
+	if (index >= _data.size())
+		throw Common::Exception("Resource index out of range (%u/%u)", (uint)index, (uint)_data.size());
+
+	return _data[index];
+}
+
+void ArchivePatcher::setChanged() {
+	_changed = true;
+}
+
+void ArchivePatcher::seekWrite(size_t offset) {
+	if (offset <= _archive->size()) {
+		_archive->seek(offset);
+		return;
+	}
+
+	_archive->seek(0, Common::SeekableReadStream::kOriginEnd);
+	while (_archive->pos() < offset)
+		_archive->writeByte(0);
+}
+
+void ArchivePatcher::readStream(Common::SeekableReadStream &stream, std::vector<byte> &data) {
+	data.resize(stream.size() - stream.pos());
+	if (!data.empty() && (stream.read(&data[0], data.size()) != data.size()))
+		throw Common::Exception(Common::kReadError);
+}
+
+void ArchivePatcher::readData(size_t index, std::vector<byte> &data) {
+	const Area &area = getData(index);
+
+	data.resize(area.size);
+	if (data.empty())
+		return;
+
+	_archive->seek(area.offset);
+	if (_archive->read(&data[0], data.size()) != data.size())
+		throw Common::Exception(Common::kReadError);
+}
+
+ArchivePatcher::Area ArchivePatcher::writeNew(const byte *data, size_t size) {
+	if (size == 0)
+		return Area(_space.getEnd(), 0);
+
+	const Area area(_space.allocate(size), size);
+
+	seekWrite(area.offset);
+	if (_archive->write(data, size) != size)
+		throw Common::Exception(Common::kWriteError);
+
+	return area;
+}
+
+void ArchivePatcher::writeData(size_t index, const std::vector<byte> &data) {
+	const Area oldArea = getData(index);
+
+	_data[index] = writeNew(data.empty() ? 0 : &data[0], data.size());
+
+	_released.push_back(oldArea);
+	_changed = true;
+}
+
+size_t ArchivePatcher::addData(const std::vector<byte> &data) {
+	_data.push_back(writeNew(data.empty() ? 0 : &data[0], data.size()));
+
+	_changed = true;
+
+	return _data.size() - 1;
+}
+
+void ArchivePatcher::removeData(size_t index) {
+	_released.push_back(getData(index));
+	_data.erase(_data.begin() + index);
+
+	_changed = true;
+}
+
+void ArchivePatcher::resizeTables(size_t size) {
+	if (size == _tables.size)
+		return;
+
+	const Area oldTables = _tables;
+
+	_tables.size = size;
+	_space.use(_tables.offset, _tables.size);
+
+	_released.push_back(oldTables);
+	_changed = true;
+
+	if (size < oldTables.size)
+		return;
+
+	// Move all resource data out of the way of the grown tables
+	const size_t tablesEnd = _tables.offset + _tables.size;
+
+	std::map<std::pair<size_t, size_t>, Area> moved;
+	std::vector<byte> data;
+
+	for (size_t i = 0; i < _data.size(); i++) {
+		Area &area = _data[i];
+		if ((area.size == 0) || (area.offset >= tablesEnd) || ((area.offset + area.size) <= _tables.offset))
+			continue;
+
+		const std::pair<size_t, size_t> key = std::make_pair(area.offset, area.size);
+
+		// Resources sharing the same data only need to have it moved once
+		std::map<std::pair<size_t, size_t>, Area>::const_iterator m = moved.find(key);
+		if (m == moved.end()) {
+			readData(i, data);
+
+			m = moved.insert(std::make_pair(key, writeNew(&data[0], data.size()))).first;
+		}
+
+		_released.push_back(area);
+		area = m->second;
+	}
+}
+
+void ArchivePatcher::flush() {
+	if (!_changed)
+		return;
+
+	writeIndex();
+
+	// The new tables are written, so the old data can now be overwritten
+	for (std::vector<Area>::const_iterator r = _released.begin(); r != _released.end(); ++r)
+		_space.release(r->offset, r->size);
+
+	_released.clear();
+	_changed = false;
+}
+
+void ArchivePatcher::writeIndex() {
+	writeTables(*_archive);
+	_archive->flush();
+
+	writeHeader(*_archive);
+	_archive->flush();
+}
+
+void ArchivePatcher::moveDown(size_t from, size_t to, size_t size) {
+	static const size_t kBufferSize = 1024 * 1024;
+
+	assert(to < from);
+
+	std::vector<byte> buffer(MIN(size, kBufferSize));
+
+	// Copying front to back never overwrites data we still need to read
+	while (size > 0) {
+		const size_t chunk = MIN(size, buffer.size());
+
+		_archive->seek(from);
+		if (_archive->read(&buffer[0], chunk) != chunk)
+			throw Common::Exception(Common::kReadError);
+
+		_archive->seek(to);
+		if (_archive->write(&buffer[0], chunk) != chunk)
+			throw Common::Exception(Common::kWriteError);
+
+		from += chunk;
+		to   += chunk;
+		size -= chunk;
+	}
+}
+
+/** A contiguous range of the archive, moved as a whole while compacting. */
+struct CompactExtent {
+	size_t offset;
+	size_t end;
+
+	bool fixed; ///< Does this extent have to stay where it is?
+
+	std::vector<size_t> resources; ///< The indices of all resources with data within this extent.
+
+	CompactExtent(size_t o, size_t e, bool f) : offset(o), end(e), fixed(f) {
+	}
+
+	bool operator<(const CompactExtent &right) const {
+		return offset < right.offset;
+	}
+};
+
+void ArchivePatcher::compact() {
+	flush();
+
+	try {
+		// Collect the header, the tables and all resource data, sorted by offset
+		std::vector<CompactExtent> areas;
+
+		areas.push_back(CompactExtent(0, _headerSize, true));
+		areas.push_back(CompactExtent(_tables.offset, _tables.offset + _tables.size, true));
+
+		for (size_t i = 0; i < _data.size(); i++) {
+			if (_data[i].size == 0)
+				continue;
+
+			areas.push_back(CompactExtent(_data[i].offset, _data[i].offset + _data[i].size, false));
+			areas.back().resources.push_back(i);
+		}
+
+		std::stable_sort(areas.begin(), areas.end());
+
+		// Merge overlapping areas into extents
+		std::vector<CompactExtent> extents;
+		for (std::vector<CompactExtent>::const_iterator a = areas.begin(); a != areas.end(); ++a) {
+			if (a->offset == a->end)
+				continue;
+
+			if (extents.empty() || (a->offset >= extents.back().end)) {
+				extents.push_back(*a);
+				continue;
+			}
+
+			CompactExtent &extent = extents.back();
+
+			extent.end   = MAX(extent.end, a->end);
+			extent.fixed = extent.fixed || a->fixed;
+			extent.resources.insert(extent.resources.end(), a->resources.begin(), a->resources.end());
+		}
+
+		// Move every extent down, right after the one before
+		size_t end = 0;
+		for (std::vector<CompactExtent>::const_iterator e = extents.begin(); e != extents.end(); ++e) {
+			if (!e->fixed && (e->offset > end)) {
+				moveDown(e->offset, end, e->end - e->offset);
+
+				const size_t distance = e->offset - end;
+				for (std::vector<size_t>::const_iterator r = e->resources.begin(); r != e->resources.end(); ++r)
+					_data[*r].offset -= distance;
+
+				end += e->end - e->offset;
+			} else
+				end = MAX(end, e->end);
+		}
+
+		// Don't let empty resources point past the end of the archive
+		for (std::vector<Area>::iterator d = _data.begin(); d != _data.end(); ++d)
+			if ((d->size == 0) && (d->offset > end))
+				d->offset = end;
+
+		writeIndex();
+		_archive->truncate(end);
+		_archive->flush();
+
+		initLayout(_headerSize, _tables, _data);
+
+	} catch (Common::Exception &e) {
+		e.add("Failed compacting archive");
+		throw;
+	}
+}
+
+bool ArchivePatcher::compact(double maxFragmentation) {
+	flush();
+
+	if (getFragmentation() <= maxFragmentation)
+		return false;
+
+	compact();
+	return true;
+}
+
+} // End of namespace Aurora
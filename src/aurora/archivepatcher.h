@@ -0,0 +1,232 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Patching archives in place.
+ */
+
+#ifndef AURORA_ARCHIVEPATCHER_H
+#define AURORA_ARCHIVEPATCHER_H
+
+#include <vector>
+#include <map>
+#include <memory>
+
+#include <boost/noncopyable.hpp>
+
+#include "src/common/types.h"
+
+namespace Common {
+	class SeekableReadStream;
+	class SeekableReadWriteStream;
+}
+
+namespace Aurora {
+
+/** The used and unused space within an archive that's patched in place.
+ *
+ *  Used areas can overlap, and the same area can be used several times, like
+ *  by several resources sharing the same data. An area only becomes unused
+ *  again once all uses covering it have been released.
+ */
+class ArchiveSpace {
+public:
+	ArchiveSpace();
+
+	/** Forget all used areas. */
+	void clear();
+
+	/** Mark an area as used. */
+	void use(size_t offset, size_t size);
+	/** Release one use of an area that was marked as used before. */
+	void release(size_t offset, size_t size);
+
+	/** Find an unused area of this size and mark it as used.
+	 *
+	 *  Of all unused gaps the area fits into, the smallest is taken. If it
+	 *  doesn't fit into any, the area is placed at the end.
+	 *
+	 *  @return The offset of the allocated area.
+	 */
+	size_t allocate(size_t size);
+
+	/** Return the end of the last area that has ever been used. */
+	size_t getEnd() const;
+	/** Return the number of unused bytes before the end. */
+	size_t getFreeSize() const;
+
+private:
+	/** All used areas, offset to end. */
+	typedef std::multimap<size_t, size_t> UsedMap;
+	/** All unused gaps, offset to end. */
+	typedef std::map<size_t, size_t> FreeMap;
+
+	UsedMap _used;
+	FreeMap _free;
+
+	size_t _end;
+	size_t _freeSize;
+
+	/** The size of the largest used area, to limit the search for overlapping areas. */
+	size_t _maxUsedSize;
+
+	/** Mark everything within this range that's not covered by any used area as unused. */
+	void markFree(size_t offset, size_t end);
+	/** Remove this range from the unused gaps. */
+	void markUsed(size_t offset, size_t end);
+
+	void addFree(size_t offset, size_t end);
+};
+
+/** Base class for patching archives in place.
+ *
+ *  Changing a resource doesn't rewrite the whole archive. The data of all
+ *  other resources stays where it is. The new data is written into the
+ *  smallest unused gap it fits into, or appended to the end of the archive,
+ *  and only the tables describing the resources are rewritten.
+ *
+ *  The space of data that has been replaced is only reused after flush()
+ *  has written the new tables. Until then, the old tables still describe
+ *  the unchanged archive, so interrupting the patching before flush()
+ *  leaves the old archive intact.
+ *
+ *  flush() writes the tables first, and the header fields pointing to them
+ *  and counting the resources only once the tables are on disk. Most formats
+ *  keep their tables at a fixed position right after the header, though, so
+ *  the tables themselves are still overwritten in place. An interrupted
+ *  flush() can therefore still leave a broken archive behind. To be safe,
+ *  patch a copy of the archive and replace the original with it afterwards.
+ *
+ *  Over time, an archive patched that way collects more and more unused gaps.
+ *  compact() moves the data of all resources together and shrinks the archive.
+ *  Unlike patching, compacting moves data the old tables still point to, so
+ *  an interrupted compact() leaves a broken archive behind.
+ */
+class ArchivePatcher : boost::noncopyable {
+public:
+	virtual ~ArchivePatcher();
+
+	/** Return the number of resources in the archive. */
+	size_t getResourceCount() const;
+
+	/** Return the size of the archive. */
+	size_t getSize() const;
+	/** Return the number of unused bytes within the archive. */
+	size_t getFreeSize() const;
+	/** Return the ratio of unused bytes to the size of the archive, from 0.0 to 1.0. */
+	double getFragmentation() const;
+
+	/** Write all changed tables into the archive.
+	 *
+	 *  The tables are overwritten in place, so this should not be interrupted.
+	 */
+	void flush();
+
+	/** Move the data of all resources together, removing all unused gaps, and shrink the archive. */
+	void compact();
+	/** Compact the archive if its fragmentation is higher than this.
+	 *
+	 *  @return true if the archive has been compacted.
+	 */
+	bool compact(double maxFragmentation);
+
+protected:
+	/** An area within the archive. */
+	struct Area {
+		size_t offset;
+		size_t size;
+
+		Area(size_t o = 0, size_t s = 0) : offset(o), size(s) {
+		}
+	};
+
+	/** The archive we're patching. */
+	std::unique_ptr<Common::SeekableReadWriteStream> _archive;
+
+	/** Take over this stream of the archive to patch. */
+	ArchivePatcher(Common::SeekableReadWriteStream *archive);
+
+	/** Set up the layout of the archive.
+	 *
+	 *  @param headerSize The size of the header at the very start of the archive.
+	 *                    It's never moved and never given to resource data.
+	 *  @param tables     The area of the tables describing the resources.
+	 *  @param data       The area of each resource's data.
+	 */
+	void initLayout(size_t headerSize, const Area &tables, const std::vector<Area> &data);
+
+	/** Return the area of the tables. */
+	const Area &getTables() const;
+	/** Return the area of a resource's data. */
+	const Area &getData(size_t index) const;
+
+	/** Change the size of the tables, moving resource data out of the way if necessary. */
+	void resizeTables(size_t size);
+
+	/** Read the data of a resource as it's stored in the archive. */
+	void readData(size_t index, std::vector<byte> &data);
+
+	/** Replace the data of a resource. */
+	void writeData(size_t index, const std::vector<byte> &data);
+	/** Add the data of a new resource, returning its index. */
+	size_t addData(const std::vector<byte> &data);
+	/** Remove the data of a resource. All later resources move down by one index. */
+	void removeData(size_t index);
+
+	/** Mark the tables as changed, so that they'll be rewritten on the next flush(). */
+	void setChanged();
+
+	/** Write the tables, according to the current layout. */
+	virtual void writeTables(Common::SeekableReadWriteStream &archive) = 0;
+	/** Write the header fields describing the tables, like their offset and the number of resources. */
+	virtual void writeHeader(Common::SeekableReadWriteStream &archive) = 0;
+
+	/** Seek to this position in the archive, extending it with zeroes if necessary. */
+	void seekWrite(size_t offset);
+
+	/** Read a resource's contents out of a stream. */
+	static void readStream(Common::SeekableReadStream &stream, std::vector<byte> &data);
+
+private:
+	ArchiveSpace _space;
+
+	size_t _headerSize;
+
+	Area _tables;
+	std::vector<Area> _data;
+
+	/** Areas no longer in use, which will become unused after the next flush(). */
+	std::vector<Area> _released;
+
+	bool _changed;
+
+	/** Write data into an unused area, returning that area. */
+	Area writeNew(const byte *data, size_t size);
+
+	/** Move size bytes of data from one offset to a lower one. */
+	void moveDown(size_t from, size_t to, size_t size);
+
+	/** Write the tables, and only once they're on disk, the header pointing to them. */
+	void writeIndex();
+};
+
+} // End of namespace Aurora
+
+#endif // AURORA_ARCHIVEPATCHER_H
@@ -31,6 +31,7 @@
 #include "src/common/util.h"
 #include "src/common/strutil.h"
 #include "src/common/error.h"
+#include "src/common/readstream.h"
 #include "src/common/memreadstream.h"
 
 #include "src/aurora/biffile.h"
@@ -96,11 +97,14 @@ void BIFFile::readVarResTable(Common::SeekableReadStream &bif, uint32 offset) {
 	}
 }
 
-Common::SeekableReadStream *BIFFile::getResource(uint32 index) const {
+Common::SeekableReadStream *BIFFile::getResource(uint32 index, bool tryNoCopy) const {
 	const Resource &res = getRes(index);
 	if (res.size == 0)
 		return new Common::MemoryReadStream(static_cast<const byte *>(0), 0);
 
+	if (tryNoCopy)
+		return new Common::SeekableSubReadStream(_bif.get(), res.offset, res.offset + res.size);
+
 	_bif->seek(res.offset);
 
 	std::unique_ptr<Common::SeekableReadStream> resStream(_bif->readStream(res.size));
@@ -68,7 +68,7 @@ public:
 	~BIFFile();
 
 	/** Return a stream of the resource's contents. */
-	Common::SeekableReadStream *getResource(uint32 index) const;
+	Common::SeekableReadStream *getResource(uint32 index, bool tryNoCopy = false) const;
 
 private:
 	std::unique_ptr<Common::SeekableReadStream> _bif;
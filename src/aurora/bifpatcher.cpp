@@ -0,0 +1,178 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Patching BioWare's BIFs (resource data files) in place.
+ */
+
+#include "src/common/util.h"
+#include "src/common/strutil.h"
+#include "src/common/error.h"
+#include "src/common/readstream.h"
+#include "src/common/readwritestream.h"
+
+#include "src/aurora/bifpatcher.h"
+
+static const uint32 kBIFID     = MKTAG('B', 'I', 'F', 'F');
+static const uint32 kVersion1  = MKTAG('V', '1', ' ', ' ');
+static const uint32 kVersion11 = MKTAG('V', '1', '.', '1');
+
+static const size_t kHeaderSize = 20;
+
+namespace Aurora {
+
+BIFPatcher::BIFPatcher(Common::SeekableReadWriteStream *bif) : ArchivePatcher(bif),
+	_version(0), _entrySize(0) {
+
+	try {
+		load();
+	} catch (Common::Exception &e) {
+		e.add("Failed opening BIF file for patching");
+		throw;
+	}
+}
+
+BIFPatcher::~BIFPatcher() {
+}
+
+void BIFPatcher::load() {
+	_archive->seek(0);
+
+	const uint32 id = _archive->readUint32BE();
+	_version        = _archive->readUint32BE();
+
+	if (id != kBIFID)
+		throw Common::Exception("Not a BIF file (%s)", Common::debugTag(id).c_str());
+
+	if ((_version != kVersion1) && (_version != kVersion11))
+		throw Common::Exception("Unsupported BIF file version %s", Common::debugTag(_version).c_str());
+
+	const uint32 varResCount = _archive->readUint32LE();
+	const uint32 fixResCount = _archive->readUint32LE();
+
+	if (fixResCount != 0)
+		throw Common::Exception("TODO: Fixed BIF resources");
+
+	const uint32 offVarResTable = _archive->readUint32LE();
+	if (offVarResTable < kHeaderSize)
+		throw Common::Exception("Invalid BIF resource table offset");
+
+	_entrySize = (_version == kVersion11) ? 20 : 16;
+
+	_entries.resize(varResCount);
+
+	std::vector<Area> data;
+	data.reserve(varResCount);
+
+	_archive->seek(offVarResTable);
+	for (std::vector<Entry>::iterator e = _entries.begin(); e != _entries.end(); ++e) {
+		e->id    = _archive->readUint32LE();
+		e->flags = (_version == kVersion11) ? _archive->readUint32LE() : 0;
+
+		const uint32 offset = _archive->readUint32LE();
+		const uint32 size   = _archive->readUint32LE();
+
+		e->type = (FileType) _archive->readUint32LE();
+
+		if ((offset + (size_t) size) > _archive->size())
+			throw Common::Exception("BIF resource data out of range");
+
+		data.push_back(Area(offset, size));
+	}
+
+	initLayout(kHeaderSize, Area(offVarResTable, varResCount * _entrySize), data);
+}
+
+FileType BIFPatcher::getResourceType(uint32 index) const {
+	if (index >= _entries.size())
+		throw Common::Exception("Resource index out of range (%u/%u)", index, (uint)_entries.size());
+
+	return _entries[index].type;
+}
+
+void BIFPatcher::replace(uint32 index, Common::SeekableReadStream &data) {
+	try {
+		std::vector<byte> contents;
+		readStream(data, contents);
+
+		if (contents.size() > 0xFFFFFFFF)
+			throw Common::Exception("Resource too large for a BIF");
+
+		writeData(index, contents);
+
+	} catch (Common::Exception &e) {
+		e.add("Failed replacing BIF resource %u", index);
+		throw;
+	}
+}
+
+uint32 BIFPatcher::add(FileType type, Common::SeekableReadStream &data) {
+	try {
+		// The resource index is stored in the lower 20 bits of the ID
+		if (_entries.size() >= 0xFFFFF)
+			throw Common::Exception("Too many resources in the BIF");
+
+		std::vector<byte> contents;
+		readStream(data, contents);
+
+		if (contents.size() > 0xFFFFFFFF)
+			throw Common::Exception("Resource too large for a BIF");
+
+		Entry entry;
+
+		// Keep the upper bits of the ID, which the KEY sets to the BIF's index
+		entry.id    = (_entries.empty() ? 0 : (_entries.front().id & 0xFFF00000)) | (uint32)_entries.size();
+		entry.flags = 0;
+		entry.type  = type;
+
+		_entries.push_back(entry);
+
+		resizeTables(_entries.size() * _entrySize);
+
+		return addData(contents);
+
+	} catch (Common::Exception &e) {
+		e.add("Failed adding resource to the BIF");
+		throw;
+	}
+}
+
+void BIFPatcher::writeTables(Common::SeekableReadWriteStream &bif) {
+	seekWrite(getTables().offset);
+
+	for (size_t i = 0; i < _entries.size(); i++) {
+		bif.writeUint32LE(_entries[i].id);
+		if (_version == kVersion11)
+			bif.writeUint32LE(_entries[i].flags);
+
+		bif.writeUint32LE(getData(i).offset);
+		bif.writeUint32LE(getData(i).size);
+		bif.writeUint32LE(_entries[i].type);
+	}
+}
+
+void BIFPatcher::writeHeader(Common::SeekableReadWriteStream &bif) {
+	bif.seek(8);
+	bif.writeUint32LE(_entries.size());
+	bif.writeUint32LE(0);
+	bif.writeUint32LE(getTables().offset);
+}
+
+} // End of namespace Aurora
@@ -0,0 +1,90 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Patching BioWare's BIFs (resource data files) in place.
+ */
+
+#ifndef AURORA_BIFPATCHER_H
+#define AURORA_BIFPATCHER_H
+
+#include <vector>
+
+#include "src/common/types.h"
+
+#include "src/aurora/types.h"
+#include "src/aurora/archivepatcher.h"
+
+namespace Common {
+	class SeekableReadStream;
+	class SeekableReadWriteStream;
+}
+
+namespace Aurora {
+
+/** Patching resources within an existing BIF file.
+ *
+ *  See ArchivePatcher for how the BIF is changed. Since the names of the
+ *  resources are stored in the KEY file, adding a resource to a BIF also
+ *  needs the KEY to be patched. See KEYPatcher in keypatcher.h.
+ */
+class BIFPatcher : public ArchivePatcher {
+public:
+	/** Take over this stream and open the BIF within for patching. */
+	BIFPatcher(Common::SeekableReadWriteStream *bif);
+	~BIFPatcher();
+
+	/** Return the type of a resource. */
+	FileType getResourceType(uint32 index) const;
+
+	/** Replace the contents of a resource with the rest of this stream. */
+	void replace(uint32 index, Common::SeekableReadStream &data);
+
+	/** Add a new resource with the rest of this stream as its contents.
+	 *
+	 *  @return The index of the new resource.
+	 */
+	uint32 add(FileType type, Common::SeekableReadStream &data);
+
+protected:
+	void writeTables(Common::SeekableReadWriteStream &bif);
+	void writeHeader(Common::SeekableReadWriteStream &bif);
+
+private:
+	/** A resource's table entry, without the offset and size. */
+	struct Entry {
+		uint32 id;
+		uint32 flags;
+
+		FileType type;
+	};
+
+	uint32 _version;
+
+	size_t _entrySize;
+
+	std::vector<Entry> _entries;
+
+	void load();
+};
+
+} // End of namespace Aurora
+
+#endif // AURORA_BIFPATCHER_H
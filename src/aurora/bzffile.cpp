@@ -30,6 +30,7 @@
 #include "src/common/util.h"
 #include "src/common/strutil.h"
 #include "src/common/error.h"
+#include "src/common/readstream.h"
 #include "src/common/memreadstream.h"
 #include "src/common/lzma.h"
 
@@ -96,7 +97,7 @@ void BZFFile::readVarResTable(Common::SeekableReadStream &bzf, uint32 offset) {
 		_resources.back().packedSize = bzf.size() - _resources.back().offset;
 }
 
-Common::SeekableReadStream *BZFFile::getResource(uint32 index) const {
+Common::SeekableReadStream *BZFFile::getResource(uint32 index, bool UNUSED(tryNoCopy)) const {
 	const Resource &res = getRes(index);
 	if ((res.packedSize == 0) || (res.size == 0))
 		return new Common::MemoryReadStream(static_cast<const byte *>(0), 0);
@@ -106,4 +107,13 @@ Common::SeekableReadStream *BZFFile::getResource(uint32 index) const {
 	return Common::decompressLZMA1(*_bzf, res.packedSize, res.size);
 }
 
+Common::SeekableReadStream *BZFFile::getResourceStream(uint32 index) const {
+	const Resource &res = getRes(index);
+	if ((res.packedSize == 0) || (res.size == 0))
+		return new Common::MemoryReadStream(static_cast<const byte *>(0), 0);
+
+	return new Common::LZMA1ReadStream(new Common::SeekableSubReadStream(_bzf.get(), res.offset,
+	                                   res.offset + res.packedSize), res.packedSize, res.size);
+}
+
 } // End of namespace Aurora
@@ -51,8 +51,14 @@ public:
 	BZFFile(Common::SeekableReadStream *bzf);
 	~BZFFile();
 
-	/** Return a stream of the resource's contents. */
-	Common::SeekableReadStream *getResource(uint32 index) const;
+	/** Return a stream of the resource's contents.
+	 *
+	 *  The resource is always decompressed whole, even with tryNoCopy.
+	 */
+	Common::SeekableReadStream *getResource(uint32 index, bool tryNoCopy = false) const;
+
+	/** Return a stream decompressing the resource's contents on the fly, while reading. */
+	Common::SeekableReadStream *getResourceStream(uint32 index) const;
 
 private:
 	std::unique_ptr<Common::SeekableReadStream> _bzf;
@@ -0,0 +1,82 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  The files within a directory, treated like an archive.
+ */
+
+#include "src/common/util.h"
+#include "src/common/error.h"
+#include "src/common/filelist.h"
+#include "src/common/filepath.h"
+#include "src/common/readfile.h"
+
+#include "src/aurora/directoryarchive.h"
+#include "src/aurora/util.h"
+
+namespace Aurora {
+
+DirectoryArchive::DirectoryArchive(const Common::UString &directory, int recurseDepth) {
+	Common::FileList files;
+	if (!files.addDirectory(directory, recurseDepth))
+		throw Common::Exception("Can't read directory \"%s\"", directory.c_str());
+
+	files.sort(true);
+
+	for (Common::FileList::const_iterator f = files.begin(); f != files.end(); ++f) {
+		_resources.push_back(Resource());
+
+		Resource &res = _resources.back();
+
+		res.name  = Common::FilePath::getStem(*f);
+		res.type  = TypeMan.getFileType(*f);
+		res.index = _files.size();
+
+		_files.push_back(*f);
+	}
+}
+
+DirectoryArchive::~DirectoryArchive() {
+}
+
+const Archive::ResourceList &DirectoryArchive::getResources() const {
+	return _resources;
+}
+
+const Common::UString &DirectoryArchive::getResourcePath(uint32 index) const {
+	if (index >= _files.size())
+		throw Common::Exception("Resource index out of range (%u/%u)", index, (uint)_files.size());
+
+	return _files[index];
+}
+
+uint32 DirectoryArchive::getResourceSize(uint32 index) const {
+	const size_t size = Common::FilePath::getFileSize(getResourcePath(index));
+	if (size == Common::kFileInvalid)
+		return 0xFFFFFFFF;
+
+	return MIN<size_t>(size, 0xFFFFFFFF);
+}
+
+Common::SeekableReadStream *DirectoryArchive::getResource(uint32 index, bool UNUSED(tryNoCopy)) const {
+	return new Common::ReadFile(getResourcePath(index));
+}
+
+} // End of namespace Aurora
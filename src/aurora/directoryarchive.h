@@ -0,0 +1,84 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  The files within a directory, treated like an archive.
+ */
+
+#ifndef AURORA_DIRECTORYARCHIVE_H
+#define AURORA_DIRECTORYARCHIVE_H
+
+#include <vector>
+
+#include "src/common/types.h"
+#include "src/common/ustring.h"
+
+#include "src/aurora/types.h"
+#include "src/aurora/archive.h"
+
+namespace Common {
+	class SeekableReadStream;
+}
+
+namespace Aurora {
+
+/** The files within a directory, treated like an archive.
+ *
+ *  The games load loose resource files from directories like "override",
+ *  which take priority over the resources in their archives. This class
+ *  lets those be handled like any other archive.
+ *
+ *  The list of files is read once, on construction. The resource names
+ *  are the file names without their extension.
+ */
+class DirectoryArchive : public Archive {
+public:
+	/** Read the list of files in this directory.
+	 *
+	 *  @param directory The directory to read.
+	 *  @param recurseDepth The number of levels to recurse into subdirectories.
+	 *         0 for ignoring subdirectories, -1 for a limitless recursion.
+	 */
+	DirectoryArchive(const Common::UString &directory, int recurseDepth = 0);
+	~DirectoryArchive();
+
+	/** Return the list of resources. */
+	const ResourceList &getResources() const;
+
+	/** Return the size of a resource. */
+	uint32 getResourceSize(uint32 index) const;
+
+	/** Return a stream of the resource's contents. */
+	Common::SeekableReadStream *getResource(uint32 index, bool tryNoCopy = false) const;
+
+	/** Return the path of the file holding this resource. */
+	const Common::UString &getResourcePath(uint32 index) const;
+
+private:
+	/** External list of resource names and types. */
+	ResourceList _resources;
+
+	/** The paths of all files. */
+	std::vector<Common::UString> _files;
+};
+
+} // End of namespace Aurora
+
+#endif // AURORA_DIRECTORYARCHIVE_H
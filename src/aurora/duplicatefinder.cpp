@@ -0,0 +1,310 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Finding resources that exist several times over many archives.
+ */
+
+#include <cstring>
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+
+#include "src/common/util.h"
+#include "src/common/error.h"
+#include "src/common/strutil.h"
+#include "src/common/readstream.h"
+#include "src/common/writestream.h"
+#include "src/common/md5.h"
+#include "src/common/xxhash.h"
+#include "src/common/filepath.h"
+#include "src/common/thread.h"
+
+#include "src/aurora/duplicatefinder.h"
+#include "src/aurora/util.h"
+#include "src/aurora/archive.h"
+
+namespace Aurora {
+
+/** Everything we know about one resource. */
+struct DuplicateEntry {
+	DuplicateFinder::Location location;
+
+	bool hashed; ///< Did we hash this resource's contents?
+
+	uint64 hash;
+	byte   md5[Common::kMD5Length];
+
+	DuplicateEntry() : hashed(false), hash(0) {
+		std::memset(md5, 0, sizeof(md5));
+	}
+
+	bool sameContents(const DuplicateEntry &entry) const {
+		return hashed && entry.hashed && (location.size == entry.location.size) && (hash == entry.hash) &&
+		       !std::memcmp(md5, entry.md5, sizeof(md5));
+	}
+};
+
+static bool compareContents(const DuplicateEntry *a, const DuplicateEntry *b) {
+	if (a->location.size != b->location.size)
+		return a->location.size < b->location.size;
+	if (a->hash != b->hash)
+		return a->hash < b->hash;
+
+	const int md5 = std::memcmp(a->md5, b->md5, sizeof(a->md5));
+	if (md5 != 0)
+		return md5 < 0;
+
+	return a->location.source < b->location.source;
+}
+
+static bool compareName(const DuplicateEntry *a, const DuplicateEntry *b) {
+	const int name = a->location.name.stricmp(b->location.name);
+	if (name != 0)
+		return name < 0;
+
+	return a->location.source < b->location.source;
+}
+
+/** Hash a resource's contents, either with xxHash64 or with MD5. */
+static void hashEntry(const Archive &archive, std::mutex &mutex, DuplicateEntry &entry, bool md5) {
+	try {
+		std::unique_ptr<Common::SeekableReadStream> stream;
+
+		{
+			// Archives can't be read by several threads at once, but the hashing can run in parallel
+			std::lock_guard<std::mutex> lock(mutex);
+
+			stream.reset(archive.getResource(entry.location.index));
+		}
+
+		if (md5) {
+			std::vector<byte> digest;
+			Common::hashMD5(*stream, digest);
+
+			std::memcpy(entry.md5, &digest[0], Common::kMD5Length);
+		} else
+			entry.hash = Common::hashXXH64(*stream);
+
+		entry.hashed = true;
+
+	} catch (...) {
+		// A broken resource can't be a duplicate
+		entry.hashed = false;
+	}
+}
+
+/** Collect the entries in runs of at least two that agree according to the comparison. */
+template<typename Same>
+static std::vector<DuplicateEntry *> findRuns(const std::vector<DuplicateEntry *> &sorted, Same same) {
+	std::vector<DuplicateEntry *> runs;
+
+	for (size_t i = 0; i < sorted.size(); ) {
+		size_t j = i + 1;
+		while ((j < sorted.size()) && same(*sorted[i], *sorted[j]))
+			j++;
+
+		if ((j - i) > 1)
+			runs.insert(runs.end(), sorted.begin() + i, sorted.begin() + j);
+
+		i = j;
+	}
+
+	return runs;
+}
+
+DuplicateFinder::DuplicateFinder() {
+}
+
+DuplicateFinder::~DuplicateFinder() {
+}
+
+void DuplicateFinder::addSource(const Common::UString &name, const Archive &archive) {
+	_sourceNames.push_back(name);
+	_sources.push_back(&archive);
+}
+
+const std::vector<Common::UString> &DuplicateFinder::getSources() const {
+	return _sourceNames;
+}
+
+const std::vector<DuplicateFinder::DuplicateGroup> &DuplicateFinder::getDuplicates() const {
+	return _duplicates;
+}
+
+const std::vector<DuplicateFinder::ShadowGroup> &DuplicateFinder::getShadowed() const {
+	return _shadowed;
+}
+
+void DuplicateFinder::find(bool verifyMD5, size_t threadCount) {
+	_duplicates.clear();
+	_shadowed.clear();
+
+	// Collect all resources and their sizes
+	std::vector<DuplicateEntry> entries;
+	for (size_t i = 0; i < _sources.size(); i++) {
+		const Archive::ResourceList &resources = _sources[i]->getResources();
+
+		for (Archive::ResourceList::const_iterator r = resources.begin(); r != resources.end(); ++r) {
+			DuplicateEntry entry;
+
+			Common::UString name = r->name;
+			if (name.empty())
+				name = Common::composeString(r->hash);
+
+			entry.location.source = i;
+			entry.location.index  = r->index;
+			entry.location.name   = TypeMan.setFileType(name, r->type);
+			entry.location.type   = r->type;
+
+			try {
+				entry.location.size = _sources[i]->getResourceSize(r->index);
+			} catch (...) {
+				entry.location.size = 0xFFFFFFFF;
+			}
+
+			entries.push_back(entry);
+		}
+	}
+
+	std::vector<DuplicateEntry *> sorted(entries.size());
+	for (size_t i = 0; i < entries.size(); i++)
+		sorted[i] = &entries[i];
+
+	// Only resources that share their size with another one need to be hashed
+	std::sort(sorted.begin(), sorted.end(), [](const DuplicateEntry *a, const DuplicateEntry *b) {
+		return a->location.size < b->location.size;
+	});
+
+	std::vector<DuplicateEntry *> toHash = findRuns(sorted, [](const DuplicateEntry &a, const DuplicateEntry &b) {
+		return a.location.size == b.location.size;
+	});
+
+	toHash.erase(std::remove_if(toHash.begin(), toHash.end(), [](const DuplicateEntry *e) {
+		return (e->location.size == 0) || (e->location.size == 0xFFFFFFFF);
+	}), toHash.end());
+
+	// Every entry is hashed on its own, so that one big source doesn't end up on a single thread
+	std::vector<std::mutex> sourceMutexes(_sources.size());
+
+	auto hashAll = [&](const std::vector<DuplicateEntry *> &hashEntries, bool md5) {
+		Common::parallelFor(hashEntries.size(), [&](size_t i, size_t UNUSED(thread)) {
+			DuplicateEntry &entry = *hashEntries[i];
+
+			hashEntry(*_sources[entry.location.source], sourceMutexes[entry.location.source], entry, md5);
+		}, threadCount);
+	};
+
+	hashAll(toHash, false);
+
+	// Only resources whose xxHash64 collides with another one need to be compared with MD5
+	if (verifyMD5) {
+		std::vector<DuplicateEntry *> hashed;
+		for (std::vector<DuplicateEntry *>::const_iterator e = toHash.begin(); e != toHash.end(); ++e)
+			if ((*e)->hashed)
+				hashed.push_back(*e);
+
+		std::sort(hashed.begin(), hashed.end(), compareContents);
+
+		hashAll(findRuns(hashed, [](const DuplicateEntry &a, const DuplicateEntry &b) {
+			return (a.location.size == b.location.size) && (a.hash == b.hash);
+		}), true);
+	}
+
+	// Group the resources with identical contents
+	std::vector<DuplicateEntry *> hashed;
+	for (std::vector<DuplicateEntry>::iterator e = entries.begin(); e != entries.end(); ++e)
+		if (e->hashed)
+			hashed.push_back(&*e);
+
+	std::sort(hashed.begin(), hashed.end(), compareContents);
+
+	for (size_t i = 0; i < hashed.size(); ) {
+		size_t j = i + 1;
+		while ((j < hashed.size()) && hashed[j]->sameContents(*hashed[i]))
+			j++;
+
+		if ((j - i) > 1) {
+			_duplicates.push_back(DuplicateGroup());
+			_duplicates.back().size = hashed[i]->location.size;
+
+			for (size_t k = i; k < j; k++)
+				_duplicates.back().copies.push_back(hashed[k]->location);
+		}
+
+		i = j;
+	}
+
+	// Group the resources with the same name, ordered by source priority
+	std::sort(sorted.begin(), sorted.end(), compareName);
+
+	for (size_t i = 0; i < sorted.size(); ) {
+		size_t j = i + 1;
+		while ((j < sorted.size()) && !sorted[j]->location.name.stricmp(sorted[i]->location.name))
+			j++;
+
+		if ((j - i) > 1) {
+			_shadowed.push_back(ShadowGroup());
+
+			const DuplicateEntry &effective = *sorted[j - 1];
+			for (size_t k = i; k < j; k++) {
+				_shadowed.back().versions.push_back(sorted[k]->location);
+				_shadowed.back().identical.push_back((k == (j - 1)) || sorted[k]->sameContents(effective));
+			}
+		}
+
+		i = j;
+	}
+}
+
+void DuplicateFinder::writeReport(Common::WriteStream &stream) const {
+	uint64 wasted = 0;
+	for (std::vector<DuplicateGroup>::const_iterator d = _duplicates.begin(); d != _duplicates.end(); ++d)
+		wasted += (uint64) d->size * (d->copies.size() - 1);
+
+	stream.writeString(Common::UString::format("%u groups of identical resources, %s in redundant copies\n",
+	                   (uint) _duplicates.size(), Common::FilePath::getHumanReadableSize(wasted).c_str()));
+
+	for (std::vector<DuplicateGroup>::const_iterator d = _duplicates.begin(); d != _duplicates.end(); ++d) {
+		stream.writeString(Common::UString::format("\n%u copies of %u bytes:\n", (uint) d->copies.size(), d->size));
+
+		for (std::vector<Location>::const_iterator l = d->copies.begin(); l != d->copies.end(); ++l)
+			stream.writeString(Common::UString::format("  %s: %s\n",
+			                   _sourceNames[l->source].c_str(), l->name.c_str()));
+	}
+
+	stream.writeString(Common::UString::format("\n%u resources exist in several sources\n", (uint) _shadowed.size()));
+
+	for (std::vector<ShadowGroup>::const_iterator s = _shadowed.begin(); s != _shadowed.end(); ++s) {
+		stream.writeString(Common::UString::format("\n%s:\n", s->versions.back().name.c_str()));
+
+		for (size_t i = 0; i < s->versions.size(); i++) {
+			const char *state = "used";
+			if (i < (s->versions.size() - 1))
+				state = s->identical[i] ? "shadowed, identical" : "shadowed, different";
+
+			stream.writeString(Common::UString::format("  %s (%s)\n",
+			                   _sourceNames[s->versions[i].source].c_str(), state));
+		}
+	}
+}
+
+} // End of namespace Aurora
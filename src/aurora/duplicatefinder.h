@@ -0,0 +1,127 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Finding resources that exist several times over many archives.
+ */
+
+#ifndef AURORA_DUPLICATEFINDER_H
+#define AURORA_DUPLICATEFINDER_H
+
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+
+#include "src/common/types.h"
+#include "src/common/ustring.h"
+
+#include "src/aurora/types.h"
+
+namespace Common {
+	class WriteStream;
+}
+
+namespace Aurora {
+
+class Archive;
+
+/** Find resources that exist several times over many archives.
+ *
+ *  The games ship many resources more than once: in several BIFs, ERFs,
+ *  RIMs, DLC ZIPs and override directories. This finds
+ *  - groups of resources with identical contents, regardless of their name
+ *  - resources with the same name and type in several sources, where the
+ *    version in the source with the highest priority shadows the others
+ *
+ *  Only resources of the same size can be identical, so only those are
+ *  read at all. These are then hashed with the fast xxHash64. Optionally,
+ *  resources whose xxHash64 matches another one are read again and hashed
+ *  with MD5, to rule out hash collisions.
+ *  The resources are hashed in parallel, but each source is only read by
+ *  one thread at a time.
+ */
+class DuplicateFinder : boost::noncopyable {
+public:
+	/** A resource in one of the sources. */
+	struct Location {
+		uint32 source; ///< Index into the source list.
+		uint32 index;  ///< The resource's index within its source.
+
+		Common::UString name; ///< The resource's name, including the extension.
+		FileType type;        ///< The resource's type.
+
+		uint32 size; ///< The resource's size.
+	};
+
+	/** A group of resources with identical contents. */
+	struct DuplicateGroup {
+		uint32 size; ///< The size of each copy.
+
+		std::vector<Location> copies; ///< All copies, in source order.
+	};
+
+	/** A resource that exists in several sources. */
+	struct ShadowGroup {
+		/** All versions, ordered by source priority. The last one is the one the game uses. */
+		std::vector<Location> versions;
+		/** For each version, is it identical to the one the game uses? */
+		std::vector<bool> identical;
+	};
+
+	DuplicateFinder();
+	~DuplicateFinder();
+
+	/** Add a source of resources.
+	 *
+	 *  Sources added later have a higher priority, and their resources
+	 *  shadow those of the same name and type in sources added earlier.
+	 *  The archive has to be kept around until find() is done.
+	 */
+	void addSource(const Common::UString &name, const Archive &archive);
+
+	/** Return the names of all sources, in priority order. */
+	const std::vector<Common::UString> &getSources() const;
+
+	/** Read all sources and find duplicates.
+	 *
+	 *  @param verifyMD5 Also compare the MD5 digests of resources whose xxHash64 matches?
+	 *  @param threadCount The number of threads to use. 0 for one per CPU core.
+	 */
+	void find(bool verifyMD5 = false, size_t threadCount = 0);
+
+	/** Return the groups of identical resources found. */
+	const std::vector<DuplicateGroup> &getDuplicates() const;
+	/** Return the resources that are shadowed by others of the same name. */
+	const std::vector<ShadowGroup> &getShadowed() const;
+
+	/** Write a human-readable report of the findings. */
+	void writeReport(Common::WriteStream &stream) const;
+
+private:
+	std::vector<Common::UString> _sourceNames;
+	std::vector<const Archive *> _sources;
+
+	std::vector<DuplicateGroup> _duplicates;
+	std::vector<ShadowGroup> _shadowed;
+};
+
+} // End of namespace Aurora
+
+#endif // AURORA_DUPLICATEFINDER_H
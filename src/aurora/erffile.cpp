@@ -28,6 +28,8 @@
 
 #include <cassert>
 
+#include <memory>
+
 #include "src/common/memreadstream.h"
 #include "src/common/readfile.h"
 #include "src/common/util.h"
@@ -200,20 +202,22 @@ void ERFFile::verifyPasswordDigest() {
 			passwordNumber >>= 8;
 		}
 
+		_blowfish = std::make_unique<Common::Blowfish>(_password);
 		return;
 	}
 
 	if (_header.encryption == kEncryptionBlowfishDA2) {
 		// The digest is the MD5 sum of an [0-255] array encrypted by the password
+		_blowfish = std::make_unique<Common::Blowfish>(_password);
+
 		byte buffer[256];
 		for (size_t i = 0; i < sizeof(buffer); i++)
 			buffer[i] = i;
 
-		Common::MemoryReadStream bufferStream(buffer);
-		std::unique_ptr<Common::SeekableReadStream>
-			bufferEncrypted(Common::encryptBlowfishEBC(bufferStream, _password));
+		_blowfish->encrypt(buffer, sizeof(buffer));
 
-		if (!Common::compareMD5Digest(*bufferEncrypted, _header.passwordDigest))
+		Common::MemoryReadStream bufferEncrypted(buffer);
+		if (!Common::compareMD5Digest(bufferEncrypted, _header.passwordDigest))
 			throw Common::Exception("Password digest does not match");
 
 		return;
@@ -715,6 +719,9 @@ Common::SeekableReadStream *ERFFile::getResource(uint32 index, bool tryNoCopy) c
 	if (tryNoCopy && (_header.encryption == kEncryptionNone) && (_header.compression == kCompressionNone))
 		return new Common::SeekableSubReadStream(_erf.get(), res.offset, res.offset + res.packedSize);
 
+	if (_blowfish && (_header.encryption != kEncryptionNone))
+		return decryptAndDecompress(res);
+
 	_erf->seek(res.offset);
 
 	// Read
@@ -763,6 +770,83 @@ Common::SeekableReadStream *ERFFile::decrypt(Common::SeekableReadStream &erf, si
 	return decrypt(erf, erf.pos(), size, encryption, password);
 }
 
+Common::SeekableReadStream *ERFFile::decryptAndDecompress(const IResource &res) const {
+	/* Instead of reading the whole resource, decrypting it into a second buffer and
+	 * then decompressing it into a third, we read and decrypt in place in large
+	 * blocks and hand each block to the inflater straight away. */
+
+	static const size_t kCryptBlockSize = 64 * 1024;
+
+	assert(_blowfish);
+
+	if ((res.packedSize % Common::Blowfish::kBlockSize) != 0)
+		throw Common::Exception("Blowfish operates on blocks of 8 bytes (%u)", res.packedSize);
+
+	_erf->seek(res.offset);
+
+	if (_header.compression == kCompressionNone) {
+		std::unique_ptr<byte[]> data = std::make_unique<byte[]>(res.packedSize);
+		if (_erf->read(data.get(), res.packedSize) != res.packedSize)
+			throw Common::Exception(Common::kReadError);
+
+		_blowfish->decrypt(data.get(), res.packedSize);
+
+		return decompress(new Common::MemoryReadStream(data.release(), res.packedSize, true), res.unpackedSize);
+	}
+
+	if ((_header.compression != kCompressionBioWareZlib) &&
+	    (_header.compression != kCompressionHeaderlessZlib) &&
+	    (_header.compression != kCompressionStandardZlib))
+		throw Common::Exception("Invalid ERF compression %u", (uint) _header.compression);
+
+	std::unique_ptr<byte[]> output = std::make_unique<byte[]>(res.unpackedSize);
+	std::unique_ptr<byte[]> buffer = std::make_unique<byte[]>(MIN<size_t>(res.packedSize, kCryptBlockSize));
+
+	std::unique_ptr<Common::BlockInflater> inflater;
+
+	size_t packedLeft = res.packedSize;
+	while (packedLeft > 0) {
+		const size_t blockSize = MIN<size_t>(packedLeft, kCryptBlockSize);
+
+		if (_erf->read(buffer.get(), blockSize) != blockSize)
+			throw Common::Exception(Common::kReadError);
+
+		packedLeft -= blockSize;
+
+		_blowfish->decrypt(buffer.get(), blockSize);
+
+		const byte *data = buffer.get();
+		size_t dataSize = blockSize;
+
+		if (!inflater) {
+			// Negative window size to signal not to look for a gzip header
+			int windowBits = Common::kWindowBitsMaxRaw;
+
+			if (_header.compression == kCompressionBioWareZlib) {
+				// An extra one byte header specifies the window size
+				windowBits = -(*data >> 4);
+
+				data++;
+				dataSize--;
+			} else if (_header.compression == kCompressionStandardZlib)
+				windowBits = Common::kWindowBitsMax;
+
+			inflater = std::make_unique<Common::BlockInflater>(windowBits, output.get(), res.unpackedSize);
+		}
+
+		// Don't bother decrypting the padding after the end of the compressed stream
+		if (inflater->inflate(data, dataSize))
+			break;
+	}
+
+	if (!inflater)
+		throw Common::Exception("Failed to inflate: premature end of input");
+
+	inflater->finish();
+
+	return new Common::MemoryReadStream(output.release(), res.unpackedSize, true);
+}
+
 Common::SeekableReadStream *ERFFile::decompress(Common::MemoryReadStream *packedStream,
                                                 uint32 unpackedSize) const {
 
@@ -38,6 +38,7 @@
 
 namespace Common {
 	class SeekableReadStream;
+	class Blowfish;
 }
 
 namespace Aurora {
@@ -147,6 +148,8 @@ public:
 	static bool isERFID(uint32 id);
 
 private:
+	friend class ERFPatcher;
+
 	enum Encryption {
 		kEncryptionNone        =  0, ///< No encryption at all.
 		kEncryptionXOR         =  1, ///< XOR encryption as used by V2.2 and V3.0 (UNSUPPORTED!)
@@ -225,6 +228,9 @@ private:
 	/** The password we were given, if any. */
 	std::vector<byte> _password;
 
+	/** The Blowfish cipher set up with our password, for Dragon Age encryption. */
+	std::unique_ptr<Common::Blowfish> _blowfish;
+
 	void load();
 
 	// .--- Header
@@ -290,6 +296,9 @@ private:
 	                                    std::vector<byte> &password);
 
 	void decryptNWNPremium();
+
+	/** Decrypt a resource in blocks, decompressing each block right after decrypting it. */
+	Common::SeekableReadStream *decryptAndDecompress(const IResource &res) const;
 	// '---
 
 	// .--- Compression
@@ -0,0 +1,389 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Patching BioWare's ERF (encapsulated resource file) archives in place.
+ */
+
+#include <cstring>
+
+#include <memory>
+
+#include "src/common/util.h"
+#include "src/common/strutil.h"
+#include "src/common/error.h"
+#include "src/common/hash.h"
+#include "src/common/encoding.h"
+#include "src/common/deflate.h"
+#include "src/common/readstream.h"
+#include "src/common/readwritestream.h"
+#include "src/common/memwritestream.h"
+
+#include "src/aurora/erfpatcher.h"
+#include "src/aurora/erffile.h"
+#include "src/aurora/util.h"
+
+static const uint32 kVersion10 = MKTAG('V', '1', '.', '0');
+static const uint32 kVersion11 = MKTAG('V', '1', '.', '1');
+static const uint32 kVersion20 = MKTAG('V', '2', '.', '0');
+static const uint32 kVersion21 = MKTAG('V', '2', '.', '1');
+static const uint32 kVersion22 = MKTAG('V', '2', '.', '2');
+static const uint32 kVersion30 = MKTAG('V', '3', '.', '0');
+
+namespace Aurora {
+
+ERFPatcher::ERFPatcher(Common::SeekableReadWriteStream *erf) : ArchivePatcher(erf),
+	_version(0), _compression(0), _compressionLevel(Common::kCompressionLevelDefault),
+	_nameSize(0), _entrySize(0) {
+
+	try {
+		load();
+	} catch (Common::Exception &e) {
+		e.add("Failed opening ERF file for patching");
+		throw;
+	}
+}
+
+ERFPatcher::~ERFPatcher() {
+}
+
+void ERFPatcher::load() {
+	// Let ERFFile make sense of the ERF, without taking over our stream
+	const ERFFile erf(new Common::SeekableSubReadStream(_archive.get(), 0, _archive->size()));
+
+	const ERFFile::ERFHeader &header = erf._header;
+	if (header.encryption != ERFFile::kEncryptionNone)
+		throw Common::Exception("Encrypted ERFs can't be patched");
+
+	_version     = erf.getVersion();
+	_compression = header.compression;
+
+	_resources = erf.getResources();
+
+	const size_t resCount = erf._iResources.size();
+
+	std::vector<Area> data;
+	data.reserve(resCount);
+	_unpackedSizes.reserve(resCount);
+
+	for (ERFFile::IResourceList::const_iterator r = erf._iResources.begin(); r != erf._iResources.end(); ++r) {
+		data.push_back(Area(r->offset, r->packedSize));
+		_unpackedSizes.push_back(r->unpackedSize);
+	}
+
+	size_t headerSize = 0;
+	Area tables;
+
+	if ((_version == kVersion10) || (_version == kVersion11)) {
+		// Key list with the names and types, followed by the resource list with offsets and sizes
+		_nameSize  = ((_version == kVersion11) && !header.isNWNPremium) ? 40 : 24;
+		_entrySize = _nameSize + 8;
+
+		if ((header.offResList < (header.offKeyList + resCount * _nameSize)) ||
+		    ((header.descriptionSize > 0) && ((header.offDescription + header.descriptionSize) > header.offKeyList)))
+			throw Common::Exception("Unsupported ERF table layout");
+
+		headerSize = header.offKeyList;
+		tables     = Area(header.offKeyList, header.offResList + resCount * 8 - header.offKeyList);
+
+		_archive->seek(header.offKeyList);
+
+	} else if ((_version == kVersion20) || (_version == kVersion21) || (_version == kVersion22)) {
+		// One table with names, offsets and sizes, right after the header
+		_nameSize  = (_version == kVersion21) ? 32 : 64;
+		_entrySize = _nameSize + ((_version == kVersion20) ? 8 : 12);
+
+		headerSize = header.offResList;
+		tables     = Area(header.offResList, resCount * _entrySize);
+
+		_archive->seek(header.offResList);
+
+	} else if (_version == kVersion30) {
+		// The string table, followed by one table with name offsets, hashes, offsets and sizes
+		_nameSize  = 16;
+		_entrySize = 28;
+
+		headerSize = 0x30;
+		tables     = Area(headerSize, header.offResList - headerSize + resCount * _entrySize);
+
+		// ERFFile doesn't keep the string table around
+		_stringTable.resize(header.offResList - headerSize);
+
+		_archive->seek(headerSize);
+		if (!_stringTable.empty() && (_archive->read(&_stringTable[0], _stringTable.size()) != _stringTable.size()))
+			throw Common::Exception(Common::kReadError);
+
+	} else
+		throw Common::Exception("Unsupported ERF version %s", Common::debugTag(_version).c_str());
+
+	// Keep the names of all resources as they are
+	_names.resize(resCount);
+	for (std::vector< std::vector<byte> >::iterator n = _names.begin(); n != _names.end(); ++n) {
+		n->resize(_nameSize);
+		if (_archive->read(&(*n)[0], _nameSize) != _nameSize)
+			throw Common::Exception(Common::kReadError);
+
+		// The V1.0 and V1.1 key list consists of only the names
+		if ((_version != kVersion10) && (_version != kVersion11))
+			_archive->skip(_entrySize - _nameSize);
+	}
+
+	initLayout(headerSize, tables, data);
+}
+
+const Archive::ResourceList &ERFPatcher::getResources() const {
+	return _resources;
+}
+
+uint32 ERFPatcher::findResource(const Common::UString &name, FileType type) const {
+	for (Archive::ResourceList::const_iterator r = _resources.begin(); r != _resources.end(); ++r)
+		if ((r->type == type) && r->name.equalsIgnoreCase(name))
+			return r->index;
+
+	return 0xFFFFFFFF;
+}
+
+void ERFPatcher::setCompressionLevel(int level) {
+	_compressionLevel = level;
+}
+
+size_t ERFPatcher::getTablesSize() const {
+	return _stringTable.size() + _names.size() * _entrySize;
+}
+
+void ERFPatcher::pack(Common::SeekableReadStream &stream, FileType type,
+                      std::vector<byte> &data, uint32 &unpackedSize) const {
+
+	readStream(stream, data);
+
+	if (data.size() > 0xFFFFFFFF)
+		throw Common::Exception("Resource too large for an ERF");
+
+	unpackedSize = data.size();
+
+	if (_compression == ERFFile::kCompressionNone)
+		return;
+
+	const int windowBits = (_compression == ERFFile::kCompressionStandardZlib) ?
+	                       Common::kWindowBitsMax : Common::kWindowBitsMaxRaw;
+
+	// Like ERFWriter, don't try to compress data that's already compressed
+	const int level = isCompressedFileType(type) ? Common::kCompressionLevelNone : _compressionLevel;
+
+	size_t packedSize = 0;
+	std::unique_ptr<byte[]> packed(Common::compressDeflate(data.empty() ? 0 : &data[0], data.size(),
+	                                                       packedSize, windowBits, level));
+
+	// BioWare's variant has an extra header byte with the window size
+	const size_t headerSize = (_compression == ERFFile::kCompressionBioWareZlib) ? 1 : 0;
+
+	data.resize(headerSize + packedSize);
+	if (headerSize > 0)
+		data[0] = Common::kWindowBitsMax << 4;
+
+	std::memcpy(&data[headerSize], packed.get(), packedSize);
+}
+
+void ERFPatcher::createName(const Common::UString &name, FileType type, std::vector<byte> &entry, uint64 &hash) {
+	Common::MemoryWriteStreamDynamic stream(true);
+
+	const Common::UString fileName = TypeMan.addFileType(name, type);
+
+	hash = 0;
+
+	if ((_version == kVersion10) || (_version == kVersion11)) {
+		const size_t maxLength = _nameSize - 8;
+		if (name.size() > maxLength)
+			throw Common::Exception("Resource names in this ERF are limited to %u characters", (uint)maxLength);
+		if ((uint32)type > 0xFFFF)
+			throw Common::Exception("File type %d can't be stored in this ERF", (int) type);
+
+		Common::writeStringFixed(stream, name, Common::kEncodingASCII, maxLength);
+		stream.writeUint32LE(0); // Resource ID, set when writing the tables
+		stream.writeUint16LE(type);
+		stream.writeUint16LE(0); // Reserved
+
+	} else if ((_version == kVersion20) || (_version == kVersion21) || (_version == kVersion22)) {
+		if (fileName.size() > 32)
+			throw Common::Exception("Resource names in this ERF are limited to 32 characters");
+
+		const Common::Encoding encoding = (_version == kVersion21) ? Common::kEncodingASCII : Common::kEncodingUTF16LE;
+		Common::writeStringFixed(stream, fileName, encoding, _nameSize);
+
+	} else if (_version == kVersion30) {
+		Common::UString extension = TypeMan.getExtension(type);
+		if (extension.beginsWith("."))
+			extension.erase(extension.begin());
+
+		hash = Common::hashString(fileName.toLower(), Common::kHashFNV64);
+
+		stream.writeUint32LE(_stringTable.size());
+		stream.writeUint64LE(hash);
+		stream.writeUint32LE(Common::hashString(extension.toLower(), Common::kHashFNV32));
+
+		_stringTable.insert(_stringTable.end(), fileName.c_str(), fileName.c_str() + std::strlen(fileName.c_str()) + 1);
+	}
+
+	entry.assign(stream.getData(), stream.getData() + stream.size());
+}
+
+void ERFPatcher::replace(uint32 index, Common::SeekableReadStream &data) {
+	try {
+		FileType type = kFileTypeNone;
+		for (Archive::ResourceList::const_iterator r = _resources.begin(); r != _resources.end(); ++r)
+			if (r->index == index)
+				type = r->type;
+
+		std::vector<byte> packed;
+		uint32 unpackedSize = 0;
+
+		pack(data, type, packed, unpackedSize);
+
+		writeData(index, packed);
+		_unpackedSizes[index] = unpackedSize;
+
+	} catch (Common::Exception &e) {
+		e.add("Failed replacing ERF resource %u", index);
+		throw;
+	}
+}
+
+uint32 ERFPatcher::add(const Common::UString &name, FileType type, Common::SeekableReadStream &data) {
+	try {
+		if (getResourceCount() >= 0xFFFFFFFF)
+			throw Common::Exception("Too many resources in the ERF");
+
+		std::vector<byte> entry;
+		uint64 hash = 0;
+
+		const size_t stringTableSize = _stringTable.size();
+		createName(name, type, entry, hash);
+
+		std::vector<byte> packed;
+		uint32 unpackedSize = 0;
+
+		try {
+			pack(data, type, packed, unpackedSize);
+		} catch (...) {
+			_stringTable.resize(stringTableSize);
+			throw;
+		}
+
+		_names.push_back(entry);
+		_unpackedSizes.push_back(unpackedSize);
+
+		resizeTables(getTablesSize());
+
+		const uint32 index = addData(packed);
+
+		_resources.push_back(Archive::Resource());
+
+		_resources.back().name  = name;
+		_resources.back().type  = type;
+		_resources.back().hash  = hash;
+		_resources.back().index = index;
+
+		return index;
+
+	} catch (Common::Exception &e) {
+		e.add("Failed adding resource \"%s\" to the ERF", TypeMan.addFileType(name, type).c_str());
+		throw;
+	}
+}
+
+void ERFPatcher::remove(uint32 index) {
+	removeData(index);
+
+	_names.erase(_names.begin() + index);
+	_unpackedSizes.erase(_unpackedSizes.begin() + index);
+
+	for (Archive::ResourceList::iterator r = _resources.begin(); r != _resources.end(); ) {
+		if (r->index == index) {
+			r = _resources.erase(r);
+			continue;
+		}
+
+		if (r->index > index)
+			r->index--;
+
+		++r;
+	}
+
+	// The name of the resource stays in the V3.0 string table, unused
+	resizeTables(getTablesSize());
+}
+
+void ERFPatcher::writeTables(Common::SeekableReadWriteStream &erf) {
+	const uint32 resCount = _names.size();
+
+	seekWrite(getTables().offset);
+
+	if ((_version == kVersion10) || (_version == kVersion11)) {
+		for (uint32 i = 0; i < resCount; i++) {
+			// Update the resource ID within the key
+			WRITE_LE_UINT32(&_names[i][_nameSize - 8], i);
+
+			erf.write(&_names[i][0], _nameSize);
+		}
+
+		for (uint32 i = 0; i < resCount; i++) {
+			erf.writeUint32LE(getData(i).offset);
+			erf.writeUint32LE(getData(i).size);
+		}
+
+		return;
+	}
+
+	if (!_stringTable.empty())
+		erf.write(&_stringTable[0], _stringTable.size());
+
+	for (uint32 i = 0; i < resCount; i++) {
+		erf.write(&_names[i][0], _nameSize);
+
+		erf.writeUint32LE(getData(i).offset);
+		erf.writeUint32LE(getData(i).size);
+
+		if (_version != kVersion20)
+			erf.writeUint32LE(_unpackedSizes[i]);
+	}
+}
+
+void ERFPatcher::writeHeader(Common::SeekableReadWriteStream &erf) {
+	const uint32 resCount = _names.size();
+
+	if ((_version == kVersion10) || (_version == kVersion11)) {
+		erf.seek(0x10);
+		erf.writeUint32LE(resCount);
+
+		erf.seek(0x1C);
+		erf.writeUint32LE(getTables().offset + resCount * _nameSize);
+
+		return;
+	}
+
+	erf.seek(0x10);
+
+	if (_version == kVersion30)
+		erf.writeUint32LE(_stringTable.size());
+
+	erf.writeUint32LE(resCount);
+}
+
+} // End of namespace Aurora
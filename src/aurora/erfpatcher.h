@@ -0,0 +1,117 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Patching BioWare's ERF (encapsulated resource file) archives in place.
+ */
+
+#ifndef AURORA_ERFPATCHER_H
+#define AURORA_ERFPATCHER_H
+
+#include <vector>
+
+#include "src/common/types.h"
+#include "src/common/ustring.h"
+
+#include "src/aurora/types.h"
+#include "src/aurora/archive.h"
+#include "src/aurora/archivepatcher.h"
+
+namespace Common {
+	class SeekableReadStream;
+	class SeekableReadWriteStream;
+}
+
+namespace Aurora {
+
+/** Patching resources within an existing ERF archive.
+ *
+ *  See ArchivePatcher for how the ERF is changed. Replacing one resource only
+ *  writes that resource's new data and the resource tables, instead of the
+ *  whole ERF. Resources added to a V2.0, V2.1, V2.2 or V3.0 ERF make the
+ *  tables grow, moving the data of the first few resources to the end.
+ *
+ *  The new data is compressed the same way as the rest of the ERF.
+ *  Encrypted ERFs can't be patched.
+ */
+class ERFPatcher : public ArchivePatcher {
+public:
+	/** Take over this stream and open the ERF within for patching. */
+	ERFPatcher(Common::SeekableReadWriteStream *erf);
+	~ERFPatcher();
+
+	/** Return the list of resources. */
+	const Archive::ResourceList &getResources() const;
+
+	/** Return the index of the resource with this name and type, or 0xFFFFFFFF if there's none. */
+	uint32 findResource(const Common::UString &name, FileType type) const;
+
+	/** Set the compression level for new data in compressed ERFs. */
+	void setCompressionLevel(int level);
+
+	/** Replace the contents of a resource with the rest of this stream. */
+	void replace(uint32 index, Common::SeekableReadStream &data);
+
+	/** Add a new resource with the rest of this stream as its contents.
+	 *
+	 *  @return The index of the new resource.
+	 */
+	uint32 add(const Common::UString &name, FileType type, Common::SeekableReadStream &data);
+
+	/** Remove a resource. All later resources move down by one index. */
+	void remove(uint32 index);
+
+protected:
+	void writeTables(Common::SeekableReadWriteStream &erf);
+	void writeHeader(Common::SeekableReadWriteStream &erf);
+
+private:
+	uint32 _version;
+	uint32 _compression;
+
+	int _compressionLevel;
+
+	/** The size of a resource's name part in the tables, kept as-is. */
+	size_t _nameSize;
+	/** The size of a resource's entry in the tables. */
+	size_t _entrySize;
+
+	Archive::ResourceList _resources;
+
+	/** The name part of each resource's table entry. */
+	std::vector< std::vector<byte> > _names;
+	/** The uncompressed size of each resource. */
+	std::vector<uint32> _unpackedSizes;
+
+	/** The string table of an ERF V3.0. */
+	std::vector<byte> _stringTable;
+
+	void load();
+
+	size_t getTablesSize() const;
+
+	void pack(Common::SeekableReadStream &stream, FileType type,
+	          std::vector<byte> &data, uint32 &unpackedSize) const;
+	void createName(const Common::UString &name, FileType type, std::vector<byte> &entry, uint64 &hash);
+};
+
+} // End of namespace Aurora
+
+#endif // AURORA_ERFPATCHER_H
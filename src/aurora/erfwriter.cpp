@@ -0,0 +1,449 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Writing BioWare's ERF (encapsulated resource file) archives.
+ */
+
+#include <cassert>
+#include <cstring>
+#include <ctime>
+
+#include "src/common/util.h"
+#include "src/common/error.h"
+#include "src/common/hash.h"
+#include "src/common/encoding.h"
+#include "src/common/readstream.h"
+#include "src/common/memreadstream.h"
+#include "src/common/writestream.h"
+#include "src/common/deflate.h"
+#include "src/common/orderedprocessor.h"
+
+#include "src/aurora/erfwriter.h"
+#include "src/aurora/language.h"
+#include "src/aurora/util.h"
+
+static const uint32 kVersionTag10 = MKTAG('V', '1', '.', '0');
+static const uint32 kVersionTag20 = MKTAG('V', '2', '.', '0');
+static const uint32 kVersionTag22 = MKTAG('V', '2', '.', '2');
+static const uint32 kVersionTag30 = MKTAG('V', '3', '.', '0');
+
+namespace Aurora {
+
+ERFWriter::ERFWriter(Version version, uint32 id, Compression compression) :
+	_version(version), _id(id), _compression(compression),
+	_compressionLevel(Common::kCompressionLevelDefault), _storeCompressedTypes(true) {
+
+	if ((_compression != kCompressionNone) && (_version != kVersion22) && (_version != kVersion30))
+		throw Common::Exception("Only ERF V2.2 and V3.0 can be compressed");
+
+	const std::time_t now = std::time(0);
+	const std::tm *date = std::localtime(&now);
+
+	_buildYear = date ? (date->tm_year + 1900) : 1900;
+	_buildDay  = date ?  date->tm_yday         : 0;
+}
+
+ERFWriter::~ERFWriter() {
+}
+
+void ERFWriter::setBuildDate(uint32 year, uint32 day) {
+	_buildYear = year;
+	_buildDay  = day;
+}
+
+void ERFWriter::setDescription(const LocString &description) {
+	_description = description;
+}
+
+void ERFWriter::setCompressionLevel(int level) {
+	_compressionLevel = level;
+}
+
+void ERFWriter::setStoreCompressedTypes(bool store) {
+	_storeCompressedTypes = store;
+}
+
+void ERFWriter::add(const Common::UString &name, FileType type, Common::SeekableReadStream *data) {
+	assert(data);
+
+	std::unique_ptr<Common::SeekableReadStream> stream(data);
+
+	if (stream->size() > 0xFFFFFFFF)
+		throw Common::Exception("Resource \"%s\" too large for an ERF", name.c_str());
+
+	_resources.push_back(Resource());
+
+	Resource &resource = _resources.back();
+
+	resource.name = name;
+	resource.type = type;
+	resource.data = std::move(stream);
+
+	resource.offset       = 0;
+	resource.packedSize   = resource.data->size();
+	resource.unpackedSize = resource.data->size();
+
+	try {
+		const Common::UString fileName = getFileName(resource);
+
+		if ((_version == kVersion10) && (type > 0xFFFF))
+			throw Common::Exception("File type %d can't be stored in an ERF V1.0", (int) type);
+
+		if ((_version == kVersion10) && (fileName.size() > 16))
+			throw Common::Exception("ERF V1.0 resource names are limited to 16 characters");
+
+		if (((_version == kVersion20) || (_version == kVersion22)) && (fileName.size() > 32))
+			throw Common::Exception("ERF V2.0 and V2.2 resource names are limited to 32 characters");
+
+	} catch (Common::Exception &e) {
+		_resources.pop_back();
+
+		e.add("Can't add resource \"%s\" to the ERF", name.c_str());
+		throw;
+	}
+}
+
+size_t ERFWriter::getResourceCount() const {
+	return _resources.size();
+}
+
+Common::UString ERFWriter::getFileName(const Resource &resource) const {
+	// ERF V1.0 stores the type separately, all later versions store the full file name
+	if (_version == kVersion10)
+		return resource.name;
+
+	return TypeMan.addFileType(resource.name, resource.type);
+}
+
+void ERFWriter::compress(const Resource &resource, std::vector<byte> &data) const {
+	const bool store = _storeCompressedTypes && isCompressedFileType(resource.type);
+
+	const int level = store ? Common::kCompressionLevelNone : _compressionLevel;
+
+	size_t packedSize = 0;
+	std::unique_ptr<byte[]> packed(Common::compressDeflate(data.empty() ? 0 : &data[0], data.size(),
+	                                                       packedSize, Common::kWindowBitsMaxRaw, level));
+
+	// BioWare's variant has an extra header byte with the window size
+	const size_t headerSize = (_compression == kCompressionBioWareZlib) ? 1 : 0;
+
+	if ((headerSize + packedSize) > 0xFFFFFFFF)
+		throw Common::Exception("Compressed resource too large for an ERF");
+
+	data.resize(headerSize + packedSize);
+	if (headerSize > 0)
+		data[0] = Common::kWindowBitsMax << 4;
+
+	std::memcpy(&data[headerSize], packed.get(), packedSize);
+}
+
+void ERFWriter::pack(size_t threadCount) {
+	_packed.clear();
+	if (_compression == kCompressionNone)
+		return;
+
+	_packed.resize(_resources.size());
+
+	Common::processOrdered(_resources.size(), [this](size_t index, std::vector<byte> &data) {
+		Resource &resource = _resources[index];
+
+		resource.data->seek(0);
+
+		data.resize(resource.unpackedSize);
+		if (!data.empty() && (resource.data->read(&data[0], data.size()) != data.size()))
+			throw Common::Exception(Common::kReadError);
+
+	}, [this](size_t index, std::vector<byte> &data) {
+		compress(_resources[index], data);
+
+	}, [this](size_t index, std::vector<byte> &data) {
+		Resource &resource = _resources[index];
+
+		resource.packedSize = data.size();
+		resource.data.reset();
+
+		_packed[index].swap(data);
+
+	}, threadCount);
+}
+
+void ERFWriter::setOffsets(uint32 dataOffset) {
+	uint64 offset = dataOffset;
+
+	for (std::vector<Resource>::iterator r = _resources.begin(); r != _resources.end(); ++r) {
+		if (offset > 0xFFFFFFFF)
+			throw Common::Exception("ERF too large");
+
+		r->offset = offset;
+		offset   += r->packedSize;
+	}
+}
+
+void ERFWriter::writeData(Common::WriteStream &erf) {
+	for (size_t i = 0; i < _resources.size(); i++) {
+		Resource &resource = _resources[i];
+
+		if (!_packed.empty()) {
+			if (!_packed[i].empty() && (erf.write(&_packed[i][0], _packed[i].size()) != _packed[i].size()))
+				throw Common::Exception(Common::kWriteError);
+
+			continue;
+		}
+
+		resource.data->seek(0);
+		if (erf.writeStream(*resource.data, resource.unpackedSize) != resource.unpackedSize)
+			throw Common::Exception(Common::kWriteError);
+	}
+}
+
+void ERFWriter::write(Common::WriteStream &erf, size_t threadCount) {
+	try {
+		pack(threadCount);
+
+		switch (_version) {
+			case kVersion10:
+				writeV10(erf);
+				break;
+
+			case kVersion20:
+				writeV20(erf);
+				break;
+
+			case kVersion22:
+				writeV22(erf);
+				break;
+
+			case kVersion30:
+				writeV30(erf);
+				break;
+		}
+
+		writeData(erf);
+
+		erf.flush();
+
+	} catch (Common::Exception &e) {
+		e.add("Failed writing ERF file");
+		throw;
+	}
+
+	_resources.clear();
+	_packed.clear();
+}
+
+void ERFWriter::writeVersion(Common::WriteStream &erf, uint32 version, bool utf16le) const {
+	if (!utf16le) {
+		erf.writeUint32BE(_id);
+		erf.writeUint32BE(version);
+		return;
+	}
+
+	// Every character of ID and version as a little-endian UTF-16 code unit
+	for (int i = 3; i >= 0; i--)
+		erf.writeUint16LE((_id >> (i * 8)) & 0xFF);
+	for (int i = 3; i >= 0; i--)
+		erf.writeUint16LE((version >> (i * 8)) & 0xFF);
+}
+
+/** Convert one string of the description into the encoding of its language. */
+static Common::MemoryReadStream *convertDescription(uint32 languageID, const Common::UString &str) {
+	Common::Encoding encoding = LangMan.getEncodingLocString(LangMan.getLanguageGendered(languageID));
+	if (encoding == Common::kEncodingInvalid)
+		encoding = Common::kEncodingUTF8;
+
+	return Common::convertString(str, encoding, false);
+}
+
+uint32 ERFWriter::getDescriptionSize() const {
+	std::vector<LocString::SubLocString> strings;
+	_description.getStrings(strings);
+
+	uint32 size = 0;
+	for (std::vector<LocString::SubLocString>::const_iterator s = strings.begin(); s != strings.end(); ++s) {
+		std::unique_ptr<Common::MemoryReadStream> data(convertDescription(s->language, s->str));
+
+		size += 8 + data->size();
+	}
+
+	return size;
+}
+
+void ERFWriter::writeDescription(Common::WriteStream &erf) const {
+	std::vector<LocString::SubLocString> strings;
+	_description.getStrings(strings);
+
+	for (std::vector<LocString::SubLocString>::const_iterator s = strings.begin(); s != strings.end(); ++s) {
+		std::unique_ptr<Common::MemoryReadStream> data(convertDescription(s->language, s->str));
+
+		erf.writeUint32LE(s->language);
+		erf.writeUint32LE(data->size());
+		erf.writeStream(*data);
+	}
+}
+
+void ERFWriter::writeV10(Common::WriteStream &erf) {
+	static const uint32 kHeaderSize = 160;
+
+	std::vector<LocString::SubLocString> strings;
+	_description.getStrings(strings);
+
+	const uint32 descriptionSize = getDescriptionSize();
+
+	const uint32 offDescription = kHeaderSize;
+	const uint32 offKeyList     = offDescription + descriptionSize;
+	const uint32 offResList     = offKeyList + _resources.size() * 24;
+
+	setOffsets(offResList + _resources.size() * 8);
+
+	writeVersion(erf, kVersionTag10, false);
+
+	erf.writeUint32LE(strings.size());
+	erf.writeUint32LE(descriptionSize);
+	erf.writeUint32LE(_resources.size());
+
+	erf.writeUint32LE(offDescription);
+	erf.writeUint32LE(offKeyList);
+	erf.writeUint32LE(offResList);
+
+	erf.writeUint32LE(_buildYear - 1900);
+	erf.writeUint32LE(_buildDay);
+
+	erf.writeUint32LE(_description.getID());
+
+	for (size_t i = 0; i < 116; i++)
+		erf.writeByte(0); // Reserved
+
+	writeDescription(erf);
+
+	uint32 index = 0;
+	for (std::vector<Resource>::const_iterator r = _resources.begin(); r != _resources.end(); ++r, ++index) {
+		Common::writeStringFixed(erf, r->name, Common::kEncodingASCII, 16);
+		erf.writeUint32LE(index); // Resource ID
+		erf.writeUint16LE(r->type);
+		erf.writeUint16LE(0); // Reserved
+	}
+
+	for (std::vector<Resource>::const_iterator r = _resources.begin(); r != _resources.end(); ++r) {
+		erf.writeUint32LE(r->offset);
+		erf.writeUint32LE(r->packedSize);
+	}
+}
+
+void ERFWriter::writeV20(Common::WriteStream &erf) {
+	static const uint32 kHeaderSize = 0x20;
+
+	setOffsets(kHeaderSize + _resources.size() * 72);
+
+	writeVersion(erf, kVersionTag20, true);
+
+	erf.writeUint32LE(_resources.size());
+
+	erf.writeUint32LE(_buildYear - 1900);
+	erf.writeUint32LE(_buildDay);
+
+	erf.writeUint32LE(0xFFFFFFFF); // Unknown
+
+	for (std::vector<Resource>::const_iterator r = _resources.begin(); r != _resources.end(); ++r) {
+		Common::writeStringFixed(erf, getFileName(*r), Common::kEncodingUTF16LE, 64);
+
+		erf.writeUint32LE(r->offset);
+		erf.writeUint32LE(r->packedSize);
+	}
+}
+
+void ERFWriter::writeV22(Common::WriteStream &erf) {
+	static const uint32 kHeaderSize = 0x38;
+
+	setOffsets(kHeaderSize + _resources.size() * 76);
+
+	writeVersion(erf, kVersionTag22, true);
+
+	erf.writeUint32LE(_resources.size());
+
+	erf.writeUint32LE(_buildYear - 1900);
+	erf.writeUint32LE(_buildDay);
+
+	erf.writeUint32LE(0xFFFFFFFF); // Unknown
+
+	erf.writeUint32LE(((uint32) _compression) << 29); // Flags: no encryption
+	erf.writeUint32LE(0);                             // Module ID
+
+	for (size_t i = 0; i < 16; i++)
+		erf.writeByte(0); // Password digest, MD5
+
+	for (std::vector<Resource>::const_iterator r = _resources.begin(); r != _resources.end(); ++r) {
+		Common::writeStringFixed(erf, getFileName(*r), Common::kEncodingUTF16LE, 64);
+
+		erf.writeUint32LE(r->offset);
+		erf.writeUint32LE(r->packedSize);
+		erf.writeUint32LE(r->unpackedSize);
+	}
+}
+
+void ERFWriter::writeV30(Common::WriteStream &erf) {
+	static const uint32 kHeaderSize = 0x30;
+
+	// All resource names, zero-terminated, in one string table
+	std::vector<Common::UString> fileNames;
+	std::vector<uint32> nameOffsets;
+
+	uint32 stringTableSize = 0;
+	for (std::vector<Resource>::const_iterator r = _resources.begin(); r != _resources.end(); ++r) {
+		fileNames.push_back(getFileName(*r));
+		nameOffsets.push_back(stringTableSize);
+
+		stringTableSize += std::strlen(fileNames.back().c_str()) + 1;
+	}
+
+	setOffsets(kHeaderSize + stringTableSize + _resources.size() * 28);
+
+	writeVersion(erf, kVersionTag30, true);
+
+	erf.writeUint32LE(stringTableSize);
+	erf.writeUint32LE(_resources.size());
+
+	erf.writeUint32LE(((uint32) _compression) << 29); // Flags: no encryption
+	erf.writeUint32LE(0);                             // Module ID
+
+	for (size_t i = 0; i < 16; i++)
+		erf.writeByte(0); // Password digest, MD5
+
+	for (std::vector<Common::UString>::const_iterator n = fileNames.begin(); n != fileNames.end(); ++n)
+		erf.write(n->c_str(), std::strlen(n->c_str()) + 1);
+
+	for (size_t i = 0; i < _resources.size(); i++) {
+		const Resource &resource = _resources[i];
+
+		Common::UString extension = TypeMan.getExtension(resource.type);
+		if (extension.beginsWith("."))
+			extension.erase(extension.begin());
+
+		erf.writeUint32LE(nameOffsets[i]);
+		erf.writeUint64LE(Common::hashString(fileNames[i].toLower(), Common::kHashFNV64));
+		erf.writeUint32LE(Common::hashString(extension.toLower(), Common::kHashFNV32));
+
+		erf.writeUint32LE(resource.offset);
+		erf.writeUint32LE(resource.packedSize);
+		erf.writeUint32LE(resource.unpackedSize);
+	}
+}
+
+} // End of namespace Aurora
@@ -0,0 +1,188 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Writing BioWare's ERF (encapsulated resource file) archives.
+ */
+
+#ifndef AURORA_ERFWRITER_H
+#define AURORA_ERFWRITER_H
+
+#include <vector>
+#include <memory>
+
+#include <boost/noncopyable.hpp>
+
+#include "src/common/types.h"
+#include "src/common/endianness.h"
+#include "src/common/ustring.h"
+
+#include "src/aurora/types.h"
+#include "src/aurora/locstring.h"
+
+namespace Common {
+	class SeekableReadStream;
+	class WriteStream;
+}
+
+namespace Aurora {
+
+/** A class writing ERF archives.
+ *
+ *  Supported versions:
+ *  - 1.0: Neverwinter Nights, Knights of the Old Republic I and II,
+ *         Jade Empire and The Witcher. Up to 16 characters per
+ *         resource name, plus a localized description.
+ *  - 2.0: Dragon Age: Origins. Up to 32 characters per resource name,
+ *         including the extension.
+ *  - 2.2: Dragon Age: Origins. Like 2.0, optionally DEFLATE compressed.
+ *  - 3.0: Dragon Age II. Any length of resource names, hashed names and
+ *         types, optionally DEFLATE compressed.
+ *
+ *  Encryption isn't supported.
+ *
+ *  Compressed resources are compressed on several threads at once. Since
+ *  the resource table, with the compressed sizes of all resources, comes
+ *  before the resource data, the compressed resources of a compressed ERF
+ *  are collected in memory before anything is written. Uncompressed ERFs
+ *  are copied straight from the source streams.
+ */
+class ERFWriter : boost::noncopyable {
+public:
+	/** The ERF version to write. */
+	enum Version {
+		kVersion10, ///< ERF V1.0.
+		kVersion20, ///< ERF V2.0.
+		kVersion22, ///< ERF V2.2.
+		kVersion30  ///< ERF V3.0.
+	};
+
+	/** How to compress the resources. Only ERF V2.2 and V3.0 support compression. */
+	enum Compression {
+		kCompressionNone           = 0, ///< No compression as all.
+		kCompressionBioWareZlib    = 1, ///< DEFLATE with an extra header byte.
+		kCompressionHeaderlessZlib = 7  ///< Raw DEFLATE, without any header.
+	};
+
+	/** Create an ERF writer.
+	 *
+	 *  @param version     The ERF version to write.
+	 *  @param id          The ID of the ERF: 'ERF ', 'MOD ', 'HAK ' or 'SAV '.
+	 *  @param compression How to compress the resources.
+	 */
+	ERFWriter(Version version, uint32 id = MKTAG('E', 'R', 'F', ' '),
+	          Compression compression = kCompressionNone);
+	~ERFWriter();
+
+	/** Set the date the ERF was built. By default, that's today. */
+	void setBuildDate(uint32 year, uint32 day);
+
+	/** Set the description. Only ERF V1.0 has a description. */
+	void setDescription(const LocString &description);
+
+	/** Set the compression level to use, from kCompressionLevelNone to kCompressionLevelBest. */
+	void setCompressionLevel(int level);
+
+	/** Don't bother compressing resources that are already compressed, like Ogg Vorbis
+	 *  sounds or Bink videos? On by default.
+	 *
+	 *  Compression is set for the whole ERF, so these resources are still wrapped
+	 *  into a DEFLATE stream, but only stored in it, which costs next to no time.
+	 */
+	void setStoreCompressedTypes(bool store);
+
+	/** Add a resource to the ERF.
+	 *
+	 *  The ERFWriter takes over the stream. It is only read when the ERF is written.
+	 *
+	 *  @param name The resource's name, without extension.
+	 *  @param type The resource's type.
+	 *  @param data The resource's contents.
+	 */
+	void add(const Common::UString &name, FileType type, Common::SeekableReadStream *data);
+
+	/** Return the number of resources added so far. */
+	size_t getResourceCount() const;
+
+	/** Write the ERF into this stream.
+	 *
+	 *  All added resources are written, and then removed from the ERFWriter.
+	 *
+	 *  @param erf         The stream to write the ERF into.
+	 *  @param threadCount The number of threads to compress on. 0 for one per CPU core.
+	 */
+	void write(Common::WriteStream &erf, size_t threadCount = 0);
+
+private:
+	/** A resource to write. */
+	struct Resource {
+		Common::UString name;
+		FileType type;
+
+		std::unique_ptr<Common::SeekableReadStream> data;
+
+		uint32 offset;       ///< The offset of the resource data within the ERF.
+		uint32 packedSize;   ///< The size of the resource data within the ERF.
+		uint32 unpackedSize; ///< The size of the uncompressed resource data.
+	};
+
+	Version _version;
+	uint32 _id;
+
+	Compression _compression;
+	int _compressionLevel;
+	bool _storeCompressedTypes;
+
+	uint32 _buildYear;
+	uint32 _buildDay;
+
+	LocString _description;
+
+	std::vector<Resource> _resources;
+
+	/** Packed resource data, for compressed ERFs. */
+	std::vector< std::vector<byte> > _packed;
+
+	Common::UString getFileName(const Resource &resource) const;
+
+	void compress(const Resource &resource, std::vector<byte> &data) const;
+	void pack(size_t threadCount);
+
+	void setOffsets(uint32 dataOffset);
+	void writeData(Common::WriteStream &erf);
+
+	// .--- Header
+	void writeVersion(Common::WriteStream &erf, uint32 version, bool utf16le) const;
+
+	uint32 getDescriptionSize() const;
+	void writeDescription(Common::WriteStream &erf) const;
+	// '---
+
+	// .--- Versions
+	void writeV10(Common::WriteStream &erf);
+	void writeV20(Common::WriteStream &erf);
+	void writeV22(Common::WriteStream &erf);
+	void writeV30(Common::WriteStream &erf);
+	// '---
+};
+
+} // End of namespace Aurora
+
+#endif // AURORA_ERFWRITER_H
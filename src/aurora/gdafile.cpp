@@ -27,7 +27,11 @@
  */
 
 #include <cassert>
+#include <cstring>
 
+#include <algorithm>
+
+#include "src/common/util.h"
 #include "src/common/error.h"
 #include "src/common/readstream.h"
 #include "src/common/hash.h"
@@ -45,7 +49,9 @@ namespace Aurora {
 const size_t GDAFile::kInvalidColumn;
 const size_t GDAFile::kInvalidRow;
 
-GDAFile::GDAFile(Common::SeekableReadStream *gda) : _columns(0), _rowCount(0) {
+GDAFile::GDAFile(Common::SeekableReadStream *gda, bool columnar) :
+	_rowCount(0), _rowIDCount(0), _columnar(columnar) {
+
 	assert(gda);
 
 	load(gda);
@@ -55,7 +61,7 @@ GDAFile::~GDAFile() {
 }
 
 size_t GDAFile::getColumnCount() const {
-	return _columns->size();
+	return _headers.size();
 }
 
 size_t GDAFile::getRowCount() const {
@@ -67,6 +73,9 @@ const GDAFile::Headers &GDAFile::getHeaders() const {
 }
 
 bool GDAFile::hasRow(size_t row) const {
+	if (_columnar)
+		return (row < _rowExists.size()) && _rowExists[row];
+
 	return getRow(row) != 0;
 }
 
@@ -93,26 +102,44 @@ const GFF4Struct *GDAFile::getRow(size_t row) const {
 }
 
 size_t GDAFile::findRow(uint32 id) const {
+	indexRowIDs();
+
+	RowIDMap::const_iterator r = _rowIDMap.find(id);
+	if (r == _rowIDMap.end())
+		return kInvalidRow;
+
+	return r->second;
+}
+
+void GDAFile::indexRowIDs() const {
+	if (_rowIDCount >= _rowCount)
+		return;
+
 	size_t idColumn = findColumn("ID");
 	if (idColumn == kInvalidColumn)
-		return kInvalidRow;
+		return;
 
-	// Go through all rows of all GFF4s, and look for the ID
+	/* Go through all rows of all GFF4s we haven't looked at yet, and map their
+	 * IDs to the rows. When several rows share an ID, the first one wins. */
 
-	size_t gff4 = 0;
-	for (size_t i = 0, j = 0; i < _rowCount; i++, j++) {
-		if (j >= _rows[gff4]->size()) {
-			if (++gff4 >= _rows.size())
-				break;
+	if (_columnar) {
+		for (size_t row = _rowIDCount; row < _rowCount; row++)
+			if (_rowExists[row])
+				_rowIDMap.insert(std::make_pair((uint32) getColumnarInt(row, idColumn, 0), row));
+	}
 
-			j = 0;
-		}
+	for (size_t i = 0; i < _rows.size(); i++) {
+		const size_t rowStart = _rowStarts[i];
+		const size_t rowEnd   = rowStart + _rows[i]->size();
 
-		if ((*_rows[gff4])[j] && ((*_rows[gff4])[j]->getUint(idColumn) == id))
-			return i;
+		for (size_t row = MAX(rowStart, _rowIDCount); row < rowEnd; row++) {
+			const GFF4Struct *gdaRow = (*_rows[i])[row - rowStart];
+			if (gdaRow)
+				_rowIDMap.insert(std::make_pair((uint32) gdaRow->getUint(idColumn), row));
+		}
 	}
 
-	return kInvalidRow;
+	_rowIDCount = _rowCount;
 }
 
 size_t GDAFile::findColumn(const Common::UString &name) const {
@@ -131,18 +158,6 @@ size_t GDAFile::findColumn(uint32 hash) const {
 	if (c != _columnHashMap.end())
 		return c->second;
 
-	for (size_t i = 0; i < _columns->size(); i++) {
-		if (!(*_columns)[i])
-			continue;
-
-		if ((*_columns)[i]->getUint(kGFF4G2DAColumnHash) == hash) {
-			_columnHashMap[hash] = kGFF4G2DAColumn1 + i;
-
-			return kGFF4G2DAColumn1 + i;
-		}
-	}
-
-	_columnHashMap[hash] = kInvalidColumn;
 	return kInvalidColumn;
 }
 
@@ -163,6 +178,9 @@ const GFF4Struct *GDAFile::getRowColumn(size_t row, const Common::UString &name,
 }
 
 Common::UString GDAFile::getString(size_t row, uint32 columnHash, const Common::UString &def) const {
+	if (_columnar)
+		return getColumnarString(row, findColumn(columnHash), def);
+
 	size_t gdaColumn;
 	const GFF4Struct *gdaRow = getRowColumn(row, columnHash, gdaColumn);
 	if (!gdaRow)
@@ -173,6 +191,9 @@ Common::UString GDAFile::getString(size_t row, uint32 columnHash, const Common::
 
 Common::UString GDAFile::getString(size_t row, const Common::UString &columnName,
                                    const Common::UString &def) const {
+	if (_columnar)
+		return getColumnarString(row, findColumn(columnName), def);
+
 	size_t gdaColumn;
 	const GFF4Struct *gdaRow = getRowColumn(row, columnName, gdaColumn);
 	if (!gdaRow)
@@ -182,6 +203,9 @@ Common::UString GDAFile::getString(size_t row, const Common::UString &columnName
 }
 
 int32 GDAFile::getInt(size_t row, uint32 columnHash, int32 def) const {
+	if (_columnar)
+		return getColumnarInt(row, findColumn(columnHash), def);
+
 	size_t gdaColumn;
 	const GFF4Struct *gdaRow = getRowColumn(row, columnHash, gdaColumn);
 	if (!gdaRow)
@@ -191,6 +215,9 @@ int32 GDAFile::getInt(size_t row, uint32 columnHash, int32 def) const {
 }
 
 int32 GDAFile::getInt(size_t row, const Common::UString &columnName, int32 def) const {
+	if (_columnar)
+		return getColumnarInt(row, findColumn(columnName), def);
+
 	size_t gdaColumn;
 	const GFF4Struct *gdaRow = getRowColumn(row, columnName, gdaColumn);
 	if (!gdaRow)
@@ -200,6 +227,9 @@ int32 GDAFile::getInt(size_t row, const Common::UString &columnName, int32 def)
 }
 
 float GDAFile::getFloat(size_t row, uint32 columnHash, float def) const {
+	if (_columnar)
+		return getColumnarFloat(row, findColumn(columnHash), def);
+
 	size_t gdaColumn;
 	const GFF4Struct *gdaRow = getRowColumn(row, columnHash, gdaColumn);
 	if (!gdaRow)
@@ -209,6 +239,9 @@ float GDAFile::getFloat(size_t row, uint32 columnHash, float def) const {
 }
 
 float GDAFile::getFloat(size_t row, const Common::UString &columnName, float def) const {
+	if (_columnar)
+		return getColumnarFloat(row, findColumn(columnName), def);
+
 	size_t gdaColumn;
 	const GFF4Struct *gdaRow = getRowColumn(row, columnName, gdaColumn);
 	if (!gdaRow)
@@ -217,6 +250,196 @@ float GDAFile::getFloat(size_t row, const Common::UString &columnName, float def
 	return gdaRow->getDouble(gdaColumn, def);
 }
 
+bool GDAFile::isColumnar() const {
+	return _columnar;
+}
+
+const GDAFile::ColumnData &GDAFile::getColumnData(uint32 columnHash, Type type) const {
+	if (!_columnar)
+		throw Common::Exception("GDA: Not loaded into columns");
+
+	const size_t column = findColumn(columnHash);
+	if (column == kInvalidColumn)
+		throw Common::Exception("GDA: No such column %u", columnHash);
+
+	const ColumnData &data = _columnData[column - kGFF4G2DAColumn1];
+
+	const Type dataType = (data.type == kTypeResource) ? kTypeString : data.type;
+	if (dataType != type)
+		throw Common::Exception("GDA: Column %u has type %d, not %d", columnHash, (int) data.type, (int) type);
+
+	return data;
+}
+
+const std::vector<int32> &GDAFile::getIntColumn(uint32 columnHash) const {
+	return getColumnData(columnHash, kTypeInt).ints;
+}
+
+const std::vector<int32> &GDAFile::getIntColumn(const Common::UString &columnName) const {
+	return getIntColumn(Common::hashStringCRC32(columnName.toLower(), Common::kEncodingUTF16LE));
+}
+
+const std::vector<float> &GDAFile::getFloatColumn(uint32 columnHash) const {
+	return getColumnData(columnHash, kTypeFloat).floats;
+}
+
+const std::vector<float> &GDAFile::getFloatColumn(const Common::UString &columnName) const {
+	return getFloatColumn(Common::hashStringCRC32(columnName.toLower(), Common::kEncodingUTF16LE));
+}
+
+const std::vector<uint8> &GDAFile::getBoolColumn(uint32 columnHash) const {
+	return getColumnData(columnHash, kTypeBool).bools;
+}
+
+const std::vector<uint8> &GDAFile::getBoolColumn(const Common::UString &columnName) const {
+	return getBoolColumn(Common::hashStringCRC32(columnName.toLower(), Common::kEncodingUTF16LE));
+}
+
+const std::vector<uint32> &GDAFile::getStringColumn(uint32 columnHash) const {
+	return getColumnData(columnHash, kTypeString).strings;
+}
+
+const std::vector<uint32> &GDAFile::getStringColumn(const Common::UString &columnName) const {
+	return getStringColumn(Common::hashStringCRC32(columnName.toLower(), Common::kEncodingUTF16LE));
+}
+
+const char *GDAFile::getColumnString(uint32 offset) const {
+	if (offset >= _stringArena.size())
+		throw Common::Exception("GDA: String offset out of range (%u >= %u)", offset, (uint) _stringArena.size());
+
+	return &_stringArena[offset];
+}
+
+const GDAFile::ColumnData *GDAFile::getRowColumnData(size_t row, size_t column) const {
+	if ((row >= _rowExists.size()) || !_rowExists[row] || (column == kInvalidColumn))
+		return 0;
+
+	const ColumnData &data = _columnData[column - kGFF4G2DAColumn1];
+	if (data.type == kTypeEmpty)
+		return 0;
+
+	return &data;
+}
+
+Common::UString GDAFile::getColumnarString(size_t row, size_t column, const Common::UString &def) const {
+	const ColumnData *data = getRowColumnData(row, column);
+	if (!data)
+		return def;
+
+	if ((data->type != kTypeString) && (data->type != kTypeResource))
+		throw Common::Exception("GDA: Column is not of string type");
+
+	return getColumnString(data->strings[row]);
+}
+
+int32 GDAFile::getColumnarInt(size_t row, size_t column, int32 def) const {
+	const ColumnData *data = getRowColumnData(row, column);
+	if (!data)
+		return def;
+
+	if (data->type == kTypeInt)
+		return data->ints[row];
+	if (data->type == kTypeBool)
+		return data->bools[row];
+
+	throw Common::Exception("GDA: Column is not of int type");
+}
+
+float GDAFile::getColumnarFloat(size_t row, size_t column, float def) const {
+	const ColumnData *data = getRowColumnData(row, column);
+	if (!data)
+		return def;
+
+	if (data->type != kTypeFloat)
+		throw Common::Exception("GDA: Column is not of float type");
+
+	return data->floats[row];
+}
+
+uint32 GDAFile::addColumnString(const Common::UString &str) {
+	// The arena starts with an empty string, which all empty strings share
+	if (str.empty())
+		return 0;
+
+	const uint32 offset = _stringArena.size();
+
+	_stringArena.insert(_stringArena.end(), str.c_str(), str.c_str() + std::strlen(str.c_str()) + 1);
+
+	return offset;
+}
+
+void GDAFile::loadColumns(const GFF4List &rows) {
+	/* Decode all cells of these rows, and append them to the column arrays.
+	 * If anything goes wrong, we roll back to the rows we already had. */
+
+	if (_columnData.empty()) {
+		_columnData.resize(_headers.size());
+		for (size_t i = 0; i < _headers.size(); i++)
+			_columnData[i].type = _headers[i].type;
+
+		_stringArena.push_back('\0');
+	}
+
+	const size_t rowCount  = _rowExists.size();
+	const size_t arenaSize  = _stringArena.size();
+
+	try {
+		_rowExists.reserve(rowCount + rows.size());
+
+		for (size_t i = 0; i < rows.size(); i++)
+			_rowExists.push_back(rows[i] != 0);
+
+		for (size_t i = 0; i < _columnData.size(); i++) {
+			ColumnData &data = _columnData[i];
+
+			const uint32 field = _headers[i].field;
+
+			switch (data.type) {
+				case kTypeString:
+				case kTypeResource:
+					data.strings.reserve(rowCount + rows.size());
+					for (size_t j = 0; j < rows.size(); j++)
+						data.strings.push_back(rows[j] ? addColumnString(rows[j]->getString(field)) : 0);
+					break;
+
+				case kTypeInt:
+					data.ints.reserve(rowCount + rows.size());
+					for (size_t j = 0; j < rows.size(); j++)
+						data.ints.push_back(rows[j] ? (int32) rows[j]->getSint(field) : 0);
+					break;
+
+				case kTypeFloat:
+					data.floats.reserve(rowCount + rows.size());
+					for (size_t j = 0; j < rows.size(); j++)
+						data.floats.push_back(rows[j] ? rows[j]->getFloat(field) : 0.0f);
+					break;
+
+				case kTypeBool:
+					data.bools.reserve(rowCount + rows.size());
+					for (size_t j = 0; j < rows.size(); j++)
+						data.bools.push_back(rows[j] ? (rows[j]->getUint(field) != 0) : 0);
+					break;
+
+				default:
+					break;
+			}
+		}
+
+	} catch (...) {
+		_rowExists.resize(rowCount);
+		_stringArena.resize(arenaSize);
+
+		for (ColumnDatas::iterator c = _columnData.begin(); c != _columnData.end(); ++c) {
+			c->ints.resize(std::min(c->ints.size(), rowCount));
+			c->floats.resize(std::min(c->floats.size(), rowCount));
+			c->bools.resize(std::min(c->bools.size(), rowCount));
+			c->strings.resize(std::min(c->strings.size(), rowCount));
+		}
+
+		throw;
+	}
+}
+
 GDAFile::Type GDAFile::identifyType(const Columns &columns, const Row &rows, size_t column) const {
 	if (!columns || (column >= columns->size()) || !(*columns)[column])
 		return kTypeEmpty;
@@ -273,7 +496,7 @@ GDAFile::Type GDAFile::identifyType(const Columns &columns, const Row &rows, siz
 
 void GDAFile::load(Common::SeekableReadStream *gda) {
 	try {
-		_gff4s.push_back(new GFF4File(gda, kG2DAID));
+		_gff4s.push_back(new GFF4File(gda, kG2DAID, true, &_templates));
 
 		const uint32 version = _gff4s.back()->getTypeVersion();
 		if ((version != kVersion01) && (version != kVersion02))
@@ -281,22 +504,24 @@ void GDAFile::load(Common::SeekableReadStream *gda) {
 
 		const GFF4Struct &top = _gff4s.back()->getTopLevel();
 
-		_columns = &top.getList(kGFF4G2DAColumnList);
-		_rows.push_back(&top.getList(kGFF4G2DARowList));
-
-		_rowStarts.push_back(_rowCount);
-		_rowCount += _rows.back()->size();
+		Columns columns = &top.getList(kGFF4G2DAColumnList);
+		Row     rows    = &top.getList(kGFF4G2DARowList);
 
-		_headers.resize(_columns->size());
-		for (size_t i = 0; i < _columns->size(); i++) {
-			if (!(*_columns)[i])
+		_headers.resize(columns->size());
+		for (size_t i = 0; i < columns->size(); i++) {
+			if (!(*columns)[i])
 				continue;
 
-			_headers[i].hash  = (uint32) (*_columns)[i]->getUint(kGFF4G2DAColumnHash);
-			_headers[i].type  =          identifyType(_columns, _rows.back(), i);
+			_headers[i].hash  = (uint32) (*columns)[i]->getUint(kGFF4G2DAColumnHash);
+			_headers[i].type  =          identifyType(columns, rows, i);
 			_headers[i].field = (uint32) kGFF4G2DAColumn1 + i;
+
+			// Should several columns share a hash, the first one wins
+			_columnHashMap.insert(std::make_pair(_headers[i].hash, (size_t) _headers[i].field));
 		}
 
+		addRows(*rows);
+
 	} catch (Common::Exception &e) {
 		e.add("Failed reading GDA file");
 		throw;
@@ -305,7 +530,7 @@ void GDAFile::load(Common::SeekableReadStream *gda) {
 
 void GDAFile::add(Common::SeekableReadStream *gda) {
 	try {
-		_gff4s.push_back(new GFF4File(gda, kG2DAID));
+		_gff4s.push_back(new GFF4File(gda, kG2DAID, true, &_templates));
 
 		const uint32 version = _gff4s.back()->getTypeVersion();
 		if ((version != kVersion01) && (version != kVersion02))
@@ -313,32 +538,44 @@ void GDAFile::add(Common::SeekableReadStream *gda) {
 
 		const GFF4Struct &top = _gff4s.back()->getTopLevel();
 
-		_rows.push_back(&top.getList(kGFF4G2DARowList));
-
-		_rowStarts.push_back(_rowCount);
-		_rowCount += _rows.back()->size();
-
 		Columns columns = &top.getList(kGFF4G2DAColumnList);
-		if (columns->size() != _columns->size())
+		Row     rows    = &top.getList(kGFF4G2DARowList);
+
+		if (columns->size() != _headers.size())
 			throw Common::Exception("Column counts don't match (%u vs. %u)",
-			                        (uint)columns->size(), (uint)_columns->size());
+			                        (uint)columns->size(), (uint)_headers.size());
 
 		for (size_t i = 0; i < columns->size(); i++) {
-			const uint32 hash1 = (uint32) (* columns)[i]->getUint(kGFF4G2DAColumnHash);
-			const uint32 hash2 = (uint32) (*_columns)[i]->getUint(kGFF4G2DAColumnHash);
-
-			const Type type1 = identifyType( columns, _rows.back(), i);
-			const Type type2 = identifyType(_columns, _rows[0]    , i);
+			const uint32 hash = (*columns)[i] ? (uint32) (*columns)[i]->getUint(kGFF4G2DAColumnHash) : 0;
+			const Type   type = identifyType(columns, rows, i);
 
-			if ((hash1 != hash2) || (type1 != type2))
+			if ((hash != _headers[i].hash) || (type != _headers[i].type))
 				throw Common::Exception("Columns don't match (%u: %u+%d vs. %u+%d)", (uint) i,
-				                        hash1, (int)type1, hash2, (int)type2);
+				                        hash, (int)type, _headers[i].hash, (int)_headers[i].type);
 		}
 
+		addRows(*rows);
+
 	} catch (Common::Exception &e) {
 		e.add("Failed adding GDA file");
 		throw;
 	}
 }
 
+void GDAFile::addRows(const GFF4List &rows) {
+	if (_columnar) {
+		loadColumns(rows);
+
+		/* All cells are decoded into the columns now, so we don't need the GFF4s
+		 * anymore. Dropping them frees the row structs, and the GDA data itself. */
+		_gff4s.clear();
+
+	} else {
+		_rows.push_back(&rows);
+		_rowStarts.push_back(_rowCount);
+	}
+
+	_rowCount += rows.size();
+}
+
 } // End of namespace Aurora
@@ -27,6 +27,7 @@
 
 #include <vector>
 #include <map>
+#include <unordered_map>
 
 #include <boost/noncopyable.hpp>
 
@@ -34,6 +35,7 @@
 #include "src/common/ptrvector.h"
 
 #include "src/aurora/types.h"
+#include "src/aurora/gff4file.h"
 
 namespace Common {
 	class UString;
@@ -58,6 +60,13 @@ namespace Aurora {
  *  by the Dragon Age games. Within these MGDAs, rows are not anymore
  *  identified by raw row index (since this index is now meaningless),
  *  but by an "ID" column.
+ *
+ *  Optionally, all cells of the GDA can be decoded once when loading,
+ *  into one typed array per column. The getString(), getInt() and
+ *  getFloat() methods then read from these arrays, and the whole
+ *  column can be accessed directly with getIntColumn() and friends.
+ *  The GFF4s themselves are not kept around in this case, so the rows
+ *  are not available as GFF4 structs anymore.
  */
 class GDAFile : boost::noncopyable {
 public:
@@ -84,8 +93,12 @@ public:
 	typedef std::vector<Header> Headers;
 
 
-	/** Take over this stream and read a GDA file out of it. */
-	GDAFile(Common::SeekableReadStream *gda);
+	/** Take over this stream and read a GDA file out of it.
+	 *
+	 *  @param gda      The stream to read the GDA out of.
+	 *  @param columnar Decode all cells into typed column arrays?
+	 */
+	GDAFile(Common::SeekableReadStream *gda, bool columnar = false);
 	~GDAFile();
 
 	/** Add another GDA with the same column structure to the bottom of this GDA.
@@ -110,7 +123,7 @@ public:
 	/** Get the column headers. */
 	const Headers &getHeaders() const;
 
-	/** Get a row as a GFF4 struct. */
+	/** Get a row as a GFF4 struct. Always 0 for columnar GDAs. */
 	const GFF4Struct *getRow(size_t row) const;
 
 	/** Find a row by its ID value. */
@@ -131,6 +144,29 @@ public:
 	float getFloat(size_t row, uint32 columnHash, float def = 0.0f) const;
 	float getFloat(size_t row, const Common::UString &columnName, float def = 0.0f) const;
 
+	/** Were the cells of this GDA decoded into typed column arrays? */
+	bool isColumnar() const;
+
+	/** Return all values of an int column, one per row. Only valid for columnar GDAs. */
+	const std::vector<int32> &getIntColumn(uint32 columnHash) const;
+	const std::vector<int32> &getIntColumn(const Common::UString &columnName) const;
+
+	/** Return all values of a float column, one per row. Only valid for columnar GDAs. */
+	const std::vector<float> &getFloatColumn(uint32 columnHash) const;
+	const std::vector<float> &getFloatColumn(const Common::UString &columnName) const;
+
+	/** Return all values of a bool column, one per row. Only valid for columnar GDAs. */
+	const std::vector<uint8> &getBoolColumn(uint32 columnHash) const;
+	const std::vector<uint8> &getBoolColumn(const Common::UString &columnName) const;
+
+	/** Return all values of a string or resource column, one per row, as offsets
+	 *  for getColumnString(). Only valid for columnar GDAs. */
+	const std::vector<uint32> &getStringColumn(uint32 columnHash) const;
+	const std::vector<uint32> &getStringColumn(const Common::UString &columnName) const;
+
+	/** Return the UTF-8 string at this offset, as found in a string column. */
+	const char *getColumnString(uint32 offset) const;
+
 
 private:
 	typedef Common::PtrVector<GFF4File> GFF4s;
@@ -139,27 +175,73 @@ private:
 	typedef std::vector<Row> Rows;
 	typedef std::vector<size_t> RowStarts;
 
-	typedef std::map<uint32, size_t> ColumnHashMap;
+	typedef std::unordered_map<uint32, size_t> ColumnHashMap;
 	typedef std::map<Common::UString, size_t> ColumnNameMap;
+	typedef std::unordered_map<uint32, size_t> RowIDMap;
 
+	/** A column with all its cells decoded. Only the array matching the type is filled. */
+	struct ColumnData {
+		Type type;
+
+		std::vector<int32>  ints;    ///< The values of a kTypeInt column.
+		std::vector<float>  floats;  ///< The values of a kTypeFloat column.
+		std::vector<uint8>  bools;   ///< The values of a kTypeBool column.
+		std::vector<uint32> strings; ///< The string arena offsets of a kTypeString/kTypeResource column.
+
+		ColumnData() : type(kTypeEmpty) { }
+	};
+	typedef std::vector<ColumnData> ColumnDatas;
+
+
+	/** The struct templates shared by all GFF4s making up this GDA. */
+	GFF4File::TemplateCache _templates;
 
 	GFF4s _gff4s;
 
 	Headers _headers;
 
-	Columns _columns;
-	Rows    _rows;
+	/** The rows of each GFF4, if we're not columnar. */
+	Rows _rows;
 
 	size_t _rowCount;
 
 	RowStarts _rowStarts;
 
-	mutable ColumnHashMap _columnHashMap;
+	/** The column of each column hash, created when loading. */
+	ColumnHashMap _columnHashMap;
 	mutable ColumnNameMap _columnNameMap;
 
+	/** The row of each row ID, created on the first findRow() call. */
+	mutable RowIDMap _rowIDMap;
+	/** The number of rows already added to the row ID map. */
+	mutable size_t _rowIDCount;
+
+	bool _columnar;
+
+	/** The decoded cells of each column, if we're columnar. */
+	ColumnDatas _columnData;
+	/** Does each row exist? */
+	std::vector<uint8> _rowExists;
+	/** All strings of all string columns, each terminated by a 0. */
+	std::vector<char> _stringArena;
+
 
 	void load(Common::SeekableReadStream *gda);
 
+	void indexRowIDs() const;
+
+	void addRows(const GFF4List &rows);
+
+	void loadColumns(const GFF4List &rows);
+	uint32 addColumnString(const Common::UString &str);
+
+	const ColumnData &getColumnData(uint32 columnHash, Type type) const;
+	const ColumnData *getRowColumnData(size_t row, size_t column) const;
+
+	Common::UString getColumnarString(size_t row, size_t column, const Common::UString &def) const;
+	int32 getColumnarInt(size_t row, size_t column, int32 def) const;
+	float getColumnarFloat(size_t row, size_t column, float def) const;
+
 	Type identifyType(const Columns &columns, const Row &rows, size_t column) const;
 
 	const GFF4Struct *getRowColumn(size_t row, uint32 hash, size_t &column) const;
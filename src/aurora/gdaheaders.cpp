@@ -22,6 +22,8 @@
  *   Resolve a GDA column header hash back to its string.
  */
 
+#include <cassert>
+
 #include "src/common/util.h"
 #include "src/common/binsearch.h"
 
@@ -33,7 +35,8 @@ typedef Common::BinSearchValue<uint32, const char *> GDAHeaderHash;
 
 /** All currently known GDA column header strings, together with their CRC32 hashes.
  *
- *  Note: For the binary search to work, this list needs to stay sorted by hash value!
+ *  Note: The list is sorted by hash value, and each hash value may only appear once.
+ *  The latter is enforced when the lookup table below is created at compile time.
  */
 static const GDAHeaderHash kGDAHeaderHashes[] = {
 	{   1421660U, "AttackScatter"               },
@@ -2243,12 +2246,133 @@ static const GDAHeaderHash kGDAHeaderHashes[] = {
 	{4294639615U, "CameraOffset"                }
 };
 
+static const size_t kGDAHeaderCount = ARRAYSIZE(kGDAHeaderHashes);
+
+/* To find the header string for a hash in constant time, we use a perfect hash
+ * table, created once on first use with the "hash, displace" method:
+ *
+ * The hashes are distributed into buckets by their topmost bits. For each bucket,
+ * starting with the biggest ones, we then search for a seed that maps all of the
+ * bucket's hashes into free slots of the table. Looking up a hash then needs just
+ * the seed of its bucket and a single slot, without any probing. */
+
+static const uint32 kGDAHeaderBucketBits = 10;
+static const uint32 kGDAHeaderSlotBits   = 12;
+
+static const size_t kGDAHeaderBucketCount = 1 << kGDAHeaderBucketBits;
+static const size_t kGDAHeaderSlotCount   = 1 << kGDAHeaderSlotBits;
+
+static const uint16 kGDAHeaderEmptySlot = 0xFFFF;
+static const uint16 kGDAHeaderMaxSeed   = 0xFFFF;
+
+static_assert(kGDAHeaderCount < kGDAHeaderEmptySlot, "Too many GDA headers for a 16-bit index");
+static_assert(kGDAHeaderCount < kGDAHeaderSlotCount, "Too many GDA headers for the perfect hash table");
+
+struct GDAHeaderTable {
+	uint16 seeds[kGDAHeaderBucketCount]; ///< The seed of each bucket.
+	uint16 slots[kGDAHeaderSlotCount];   ///< Indices into kGDAHeaderHashes.
+
+	bool valid; ///< Did we find a seed for every bucket?
+};
+
+static uint32 getGDAHeaderBucket(uint32 hash) {
+	return hash >> (32 - kGDAHeaderBucketBits);
+}
+
+static uint32 getGDAHeaderSlot(uint32 hash, uint32 seed) {
+	return ((hash ^ (seed * 0x9E3779B9U)) * 0x85EBCA6BU) >> (32 - kGDAHeaderSlotBits);
+}
+
+/** Try to place all hashes of this bucket into free slots, using this seed. */
+static bool placeGDAHeaderBucket(GDAHeaderTable &table, const uint16 *headers,
+                                 size_t count, uint32 seed) {
+
+	for (size_t i = 0; i < count; i++) {
+		const uint32 slot = getGDAHeaderSlot(kGDAHeaderHashes[headers[i]].key, seed);
+		if (table.slots[slot] != kGDAHeaderEmptySlot)
+			return false;
+
+		// Two hashes of the same bucket can't share a slot either
+		for (size_t j = 0; j < i; j++)
+			if (getGDAHeaderSlot(kGDAHeaderHashes[headers[j]].key, seed) == slot)
+				return false;
+	}
+
+	for (size_t i = 0; i < count; i++)
+		table.slots[getGDAHeaderSlot(kGDAHeaderHashes[headers[i]].key, seed)] = headers[i];
+
+	return true;
+}
+
+static GDAHeaderTable createGDAHeaderTable() {
+	GDAHeaderTable table {};
+
+	for (size_t i = 0; i < kGDAHeaderSlotCount; i++)
+		table.slots[i] = kGDAHeaderEmptySlot;
+
+	// Sort the headers by bucket
+
+	uint16 bucketStarts[kGDAHeaderBucketCount + 1] {};
+	for (size_t i = 0; i < kGDAHeaderCount; i++)
+		bucketStarts[getGDAHeaderBucket(kGDAHeaderHashes[i].key) + 1]++;
+
+	size_t maxBucketSize = 0;
+	for (size_t i = 0; i < kGDAHeaderBucketCount; i++) {
+		if (bucketStarts[i + 1] > maxBucketSize)
+			maxBucketSize = bucketStarts[i + 1];
+
+		bucketStarts[i + 1] += bucketStarts[i];
+	}
+
+	uint16 bucketEnds[kGDAHeaderBucketCount] {};
+	for (size_t i = 0; i < kGDAHeaderBucketCount; i++)
+		bucketEnds[i] = bucketStarts[i];
+
+	uint16 headers[kGDAHeaderCount] {};
+	for (size_t i = 0; i < kGDAHeaderCount; i++)
+		headers[bucketEnds[getGDAHeaderBucket(kGDAHeaderHashes[i].key)]++] = i;
+
+	// Place the biggest buckets first, while the table is still mostly empty
+
+	for (size_t size = maxBucketSize; size > 0; size--) {
+		for (size_t i = 0; i < kGDAHeaderBucketCount; i++) {
+			if ((size_t) (bucketEnds[i] - bucketStarts[i]) != size)
+				continue;
+
+			uint32 seed = 0;
+			while ((seed < kGDAHeaderMaxSeed) &&
+			       !placeGDAHeaderBucket(table, headers + bucketStarts[i], size, seed))
+				seed++;
+
+			if (seed == kGDAHeaderMaxSeed)
+				return table;
+
+			table.seeds[i] = seed;
+		}
+	}
+
+	table.valid = true;
+	return table;
+}
+
+static const GDAHeaderTable &getGDAHeaderTable() {
+	static const GDAHeaderTable table = createGDAHeaderTable();
+
+	assert(table.valid && "Failed to create the GDA header table. Are there duplicate hashes?");
+
+	return table;
+}
+
 const char *findGDAHeader(uint32 hash) {
-	const GDAHeaderHash *header = Common::binarySearch(kGDAHeaderHashes, ARRAYSIZE(kGDAHeaderHashes), hash);
-	if (!header)
+	const GDAHeaderTable &table = getGDAHeaderTable();
+
+	const uint32 seed = table.seeds[getGDAHeaderBucket(hash)];
+	const uint16 index = table.slots[getGDAHeaderSlot(hash, seed)];
+
+	if ((index == kGDAHeaderEmptySlot) || (kGDAHeaderHashes[index].key != hash))
 		return 0;
 
-	return header->value;
+	return kGDAHeaderHashes[index].value;
 }
 
 } // End of namespace Aurora
@@ -32,6 +32,7 @@
 #include "src/common/readstream.h"
 #include "src/common/encoding.h"
 #include "src/common/strutil.h"
+#include "src/common/xxhash.h"
 
 #include "src/aurora/gff4file.h"
 #include "src/aurora/util.h"
@@ -73,8 +74,8 @@ bool GFF4File::Header::isBigEndian() const {
 }
 
 
-GFF4File::GFF4File(Common::SeekableReadStream *gff4, uint32 type) :
-	_origStream(gff4), _topLevelStruct(0) {
+GFF4File::GFF4File(Common::SeekableReadStream *gff4, uint32 type, bool lazy, TemplateCache *templates) :
+	_origStream(gff4), _lazy(lazy), _templateCache(templates), _topLevelStruct(0) {
 
 	assert(_origStream);
 
@@ -131,6 +132,7 @@ void GFF4File::load(uint32 type) {
 	try {
 
 		loadHeader(type);
+		loadTemplates();
 		loadStructs();
 		loadStrings();
 
@@ -165,7 +167,56 @@ void GFF4File::loadHeader(uint32 type) {
 		throw Common::Exception("GFF4 has no structs");
 }
 
-void GFF4File::loadStructs() {
+void GFF4File::loadTemplates() {
+	const uint32 structTemplateStart = _stream->pos();
+
+	bool contained = false;
+
+	if (!_templateCache) {
+		_structTemplates.reset(readTemplates(structTemplateStart, contained));
+		return;
+	}
+
+	/* The struct templates, including their field declarations, are
+	 * normally found between the header and the data. Files with the
+	 * exact same raw template data share the same parsed templates. */
+
+	std::vector<byte> data;
+	if (_header.dataOffset > structTemplateStart) {
+		data.resize(_header.dataOffset - structTemplateStart);
+
+		if (_stream->read(&data[0], data.size()) != data.size())
+			throw Common::Exception(Common::kReadError);
+	}
+
+	const uint64 hash = Common::hashXXH64(data.empty() ? 0 : &data[0], data.size());
+
+	/* The field declarations are found by their offset within the file,
+	 * and the number of structs isn't part of the data. Both need to
+	 * match, too, for the same raw data to mean the same templates. */
+	TemplateCache::Entry entry;
+
+	entry.bigEndian   = _header.isBigEndian();
+	entry.structCount = _header.structCount;
+	entry.offset      = structTemplateStart;
+	entry.data.swap(data);
+
+	_structTemplates = _templateCache->find(hash, entry);
+	if (_structTemplates)
+		return;
+
+	_stream->seek(structTemplateStart);
+	_structTemplates.reset(readTemplates(structTemplateStart, contained));
+
+	// Only templates described fully by the raw data can be shared
+	if (contained) {
+		entry.templates = _structTemplates;
+
+		_templateCache->add(hash, entry);
+	}
+}
+
+GFF4File::StructTemplates *GFF4File::readTemplates(uint32 start, bool &contained) {
 	/* Load the struct templates.
 	 *
 	 * The struct template defines the structure of a struct, i.e. how
@@ -178,13 +229,17 @@ void GFF4File::loadStructs() {
 	 * looked, in a GFF4 this has been sourced out into these templates. */
 
 	static const uint32 kStructTemplateSize = 16;
-	const uint32 structTemplateStart = _stream->pos();
+	static const uint32 kFieldTemplateSize  = 12;
+
+	contained = (start + (uint64) _header.structCount * kStructTemplateSize) <= _header.dataOffset;
 
-	_structTemplates.resize(_header.structCount);
+	std::unique_ptr<StructTemplates> structTemplates = std::make_unique<StructTemplates>();
+
+	structTemplates->resize(_header.structCount);
 	for (uint32 i = 0; i < _header.structCount; i++) {
-		_stream->seek(structTemplateStart + i * kStructTemplateSize);
+		_stream->seek(start + i * kStructTemplateSize);
 
-		StructTemplate &strct = _structTemplates[i];
+		StructTemplate &strct = (*structTemplates)[i];
 
 		// Read struct properties
 
@@ -204,6 +259,10 @@ void GFF4File::loadStructs() {
 			continue;
 		}
 
+		if ((fieldOffset < start) ||
+		    ((fieldOffset + (uint64) fieldCount * kFieldTemplateSize) > _header.dataOffset))
+			contained = false;
+
 		_stream->seek(fieldOffset);
 
 		// Read the field declarations
@@ -222,9 +281,14 @@ void GFF4File::loadStructs() {
 		}
 	}
 
-	/* And load the top level struct, which itself recurses into field structs.
-	 * The top level struct is always constructed using the first template. */
-	_topLevelStruct = new GFF4Struct(*this, _header.dataOffset, _structTemplates[0]);
+	return structTemplates.release();
+}
+
+void GFF4File::loadStructs() {
+	/* Load the top level struct, which itself recurses into field structs,
+	 * unless we're loading lazily. The top level struct is always
+	 * constructed using the first template. */
+	_topLevelStruct = new GFF4Struct(*this, _header.dataOffset, (*_structTemplates)[0]);
 	_topLevelStruct->_refCount++;
 }
 
@@ -288,11 +352,15 @@ uint32 GFF4File::getDataOffset() const {
 }
 
 const GFF4File::StructTemplate &GFF4File::getStructTemplate(uint32 i) const {
-	if (i >= _structTemplates.size())
+	if (i >= _structTemplates->size())
 		throw Common::Exception("GFF4: Struct template out of range (%u >= %u)",
-		                        i, (uint) _structTemplates.size());
+		                        i, (uint) _structTemplates->size());
+
+	return (*_structTemplates)[i];
+}
 
-	return _structTemplates[i];
+bool GFF4File::isLazy() const {
+	return _lazy;
 }
 
 bool GFF4File::hasSharedStrings() const {
@@ -311,6 +379,54 @@ Common::UString GFF4File::getSharedString(uint32 i) const {
 }
 
 
+GFF4File::TemplateCache::TemplateCache() {
+}
+
+GFF4File::TemplateCache::~TemplateCache() {
+}
+
+size_t GFF4File::TemplateCache::getSize() const {
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	return _entries.size();
+}
+
+void GFF4File::TemplateCache::clear() {
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	_entries.clear();
+}
+
+std::shared_ptr<const GFF4File::StructTemplates>
+GFF4File::TemplateCache::find(uint64 hash, const Entry &key) const {
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	std::pair<Entries::const_iterator, Entries::const_iterator> range = _entries.equal_range(hash);
+	for (Entries::const_iterator e = range.first; e != range.second; ++e)
+		if (matches(e->second, key))
+			return e->second.templates;
+
+	return std::shared_ptr<const StructTemplates>();
+}
+
+void GFF4File::TemplateCache::add(uint64 hash, const Entry &entry) {
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	// Another thread might have added the same templates in the meantime
+	std::pair<Entries::const_iterator, Entries::const_iterator> range = _entries.equal_range(hash);
+	for (Entries::const_iterator e = range.first; e != range.second; ++e)
+		if (matches(e->second, entry))
+			return;
+
+	_entries.insert(std::make_pair(hash, entry));
+}
+
+bool GFF4File::TemplateCache::matches(const Entry &a, const Entry &b) {
+	return (a.bigEndian == b.bigEndian) && (a.structCount == b.structCount) &&
+	       (a.offset == b.offset) && (a.data == b.data);
+}
+
+
 GFF4Struct::Field::Field(uint32 l, uint16 t, uint16 f, uint32 o, bool g) :
 	label(l), offset(o), isGeneric(g) {
 
@@ -404,7 +520,8 @@ void GFF4Struct::load(GFF4File &parent, uint32 offset, const GFF4File::StructTem
 	 * Go through all the fields in the template and create field
 	 * instances within this struct instance. If the field is itself
 	 * a struct, recursively create a new struct instance for it. If
-	 * the field is a generic, create a struct for it as well. */
+	 * the field is a generic, create a struct for it as well. When
+	 * loading lazily, these structs are only created on access. */
 
 	for (size_t i = 0; i < tmplt.fields.size(); i++) {
 		const GFF4File::StructTemplate::Field &field = tmplt.fields[i];
@@ -418,10 +535,11 @@ void GFF4Struct::load(GFF4File &parent, uint32 offset, const GFF4File::StructTem
 
 		// Load the field and its struct(s), if any
 		Field &f = _fields[field.label] = Field(field.label, field.type, field.flags, fieldOffset);
-		if (f.type == kFieldTypeStruct)
-			loadStructs(parent, f);
 		if (f.type == kFieldTypeGeneric)
-			loadGeneric(parent, f);
+			f.offset = getDataOffset(f.isList, f.offset);
+
+		if (!parent.isLazy())
+			loadFieldStructs(f);
 
 		if ((f.type == kFieldTypeASCIIString) && parent.hasSharedStrings())
 			throw Common::Exception("GFF4: TODO: ASCII string field in a file with shared strings");
@@ -430,7 +548,24 @@ void GFF4Struct::load(GFF4File &parent, uint32 offset, const GFF4File::StructTem
 	_fieldCount = _fields.size();
 }
 
-void GFF4Struct::loadStructs(GFF4File &parent, Field &field) {
+void GFF4Struct::loadFieldStructs(const Field &field) const {
+	if (field.structsLoaded || ((field.type != kFieldTypeStruct) && (field.type != kFieldTypeGeneric)))
+		return;
+
+	try {
+		if (field.type == kFieldTypeStruct)
+			loadStructs(*_parent, field);
+		else
+			loadGeneric(*_parent, field);
+	} catch (...) {
+		field.structs.clear();
+		throw;
+	}
+
+	field.structsLoaded = true;
+}
+
+void GFF4Struct::loadStructs(GFF4File &parent, const Field &field) const {
 	if (field.offset == 0xFFFFFFFF)
 		return;
 
@@ -473,8 +608,7 @@ void GFF4Struct::loadStructs(GFF4File &parent, Field &field) {
 	}
 }
 
-void GFF4Struct::loadGeneric(GFF4File &parent, Field &field) {
-	field.offset = getDataOffset(field.isList, field.offset);
+void GFF4Struct::loadGeneric(GFF4File &parent, const Field &field) const {
 	if (field.offset == 0xFFFFFFFF)
 		return;
 
@@ -519,11 +653,12 @@ void GFF4Struct::load(GFF4File &parent, const Field &genericParent) {
 
 		// Load the field and its struct(s), if any
 		Field &f = _fields[i] = Field(i, fieldType, fieldFlags, fieldOffset, true);
-		if (f.type == kFieldTypeStruct)
-			loadStructs(parent, f);
 		if (f.type == kFieldTypeGeneric)
 			throw Common::Exception("GFF4: Found a generic with type generic?");
 
+		if (!parent.isLazy())
+			loadFieldStructs(f);
+
 		if ((f.type == kFieldTypeASCIIString) && parent.hasSharedStrings())
 			throw Common::Exception("GFF4: TODO: ASCII string field in a file with shared strings");
 	}
@@ -1314,6 +1449,8 @@ const GFF4Struct *GFF4Struct::getStruct(uint32 field) const {
 	if (f->isList)
 		throw Common::Exception("GFF4: Tried reading list as singular value");
 
+	loadFieldStructs(*f);
+
 	if (!f->structs.empty())
 		return f->structs[0];
 
@@ -1330,6 +1467,8 @@ const GFF4Struct *GFF4Struct::getGeneric(uint32 field) const {
 	if (f->type != kFieldTypeGeneric)
 		throw Common::Exception("GFF4: Field is not of generic type");
 
+	loadFieldStructs(*f);
+
 	if (!f->structs.empty())
 		return f->structs[0];
 
@@ -1346,6 +1485,8 @@ const GFF4List &GFF4Struct::getList(uint32 field) const {
 	if (f->type != kFieldTypeStruct)
 		throw Common::Exception("GFF4: Field is not of struct type");
 
+	loadFieldStructs(*f);
+
 	return f->structs;
 }
 
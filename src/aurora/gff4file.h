@@ -27,6 +27,7 @@
 
 #include <vector>
 #include <map>
+#include <unordered_map>
 #include <memory>
 
 #include <boost/noncopyable.hpp>
@@ -34,6 +35,7 @@
 #include "src/common/types.h"
 #include "src/common/ustring.h"
 #include "src/common/encoding.h"
+#include "src/common/mutex.h"
 
 #include "src/aurora/types.h"
 #include "src/aurora/aurorafile.h"
@@ -85,13 +87,33 @@ class GFF4Struct;
  *    French, Italian, German and Spanish (EFIGS) versions have the strings
  *    in TLK files encoded in Windows CP-1252.
  *
+ *  By default, all structs reachable from the top-level struct are loaded
+ *  right away. When opened lazily, a struct is only loaded once it's
+ *  actually accessed through getStruct(), getGeneric() or getList() of
+ *  the struct containing it. This makes opening large GFF4s much faster
+ *  when only a few fields are needed.
+ *
+ *  Several GFF4 files of the same type usually contain the exact same
+ *  struct templates. A TemplateCache shared by these files parses each
+ *  distinct set of templates only once.
+ *
  *  See also: GFF3File in gff3file.h for the earlier V3.2/V3.3 versions of
  *  the GFF format.
  */
 class GFF4File : boost::noncopyable, public AuroraFile {
 public:
-	/** Take over this stream and read a GFF4 file out of it. */
-	GFF4File(Common::SeekableReadStream *gff4, uint32 type = 0xFFFFFFFF);
+	class TemplateCache;
+
+	/** Take over this stream and read a GFF4 file out of it.
+	 *
+	 *  @param gff4      The stream to read the GFF4 out of.
+	 *  @param type      The GFF4 type to enforce, or 0xFFFFFFFF for any type.
+	 *  @param lazy      Only load structs once they're accessed?
+	 *  @param templates A cache to share the struct templates with other GFF4s.
+	 *                   It has to exist for as long as this GFF4File exists.
+	 */
+	GFF4File(Common::SeekableReadStream *gff4, uint32 type = 0xFFFFFFFF,
+	         bool lazy = false, TemplateCache *templates = 0);
 	~GFF4File();
 
 	/** Return the GFF4's specific type. */
@@ -151,7 +173,7 @@ private:
 
 	typedef std::vector<StructTemplate> StructTemplates;
 	typedef std::vector<Common::UString> SharedStrings;
-	typedef std::map<uint64, GFF4Struct *> StructMap;
+	typedef std::unordered_map<uint64, GFF4Struct *> StructMap;
 
 
 
@@ -160,8 +182,13 @@ private:
 
 	/** This GFF4's header. */
 	Header          _header;
-	/** All struct templates in this GFF4. */
-	StructTemplates _structTemplates;
+	/** All struct templates in this GFF4, possibly shared with other GFF4s. */
+	std::shared_ptr<const StructTemplates> _structTemplates;
+
+	/** Only load structs once they're accessed? */
+	bool _lazy;
+	/** The cache to share the struct templates with other GFF4s, if any. */
+	TemplateCache *_templateCache;
 
 	/** The shared strings used in V4.1. */
 	SharedStrings _sharedStrings;
@@ -175,9 +202,12 @@ private:
 	// .--- Loading helpers
 	void load(uint32 type);
 	void loadHeader(uint32 type);
+	void loadTemplates();
 	void loadStructs();
 	void loadStrings();
 
+	StructTemplates *readTemplates(uint32 start, bool &contained);
+
 	void clear();
 	// '---
 
@@ -190,6 +220,8 @@ private:
 	const StructTemplate &getStructTemplate(uint32 i) const;
 	uint32 getDataOffset() const;
 
+	bool isLazy() const;
+
 	bool hasSharedStrings() const;
 	Common::UString getSharedString(uint32 i) const;
 	// '---
@@ -197,6 +229,49 @@ private:
 	friend class GFF4Struct;
 };
 
+/** Struct templates shared by several GFF4 files.
+ *
+ *  The templates of a GFF4 are only taken from the cache if the raw template
+ *  data within the GFF4 is exactly the same as that of a GFF4 loaded before,
+ *  at the same offset and with the same number of structs.
+ *  Access to the cache is thread-safe.
+ */
+class GFF4File::TemplateCache : boost::noncopyable {
+public:
+	TemplateCache();
+	~TemplateCache();
+
+	/** Return the number of distinct sets of struct templates in the cache. */
+	size_t getSize() const;
+
+	/** Remove all struct templates from the cache. */
+	void clear();
+
+private:
+	struct Entry {
+		bool bigEndian;
+		uint32 structCount;     ///< The number of struct templates.
+		uint32 offset;          ///< The offset of the raw template data within the GFF4.
+		std::vector<byte> data; ///< The raw template data.
+
+		std::shared_ptr<const StructTemplates> templates;
+	};
+
+	typedef std::multimap<uint64, Entry> Entries;
+
+	Entries _entries;
+
+	mutable std::mutex _mutex;
+
+	std::shared_ptr<const StructTemplates> find(uint64 hash, const Entry &key) const;
+	void add(uint64 hash, const Entry &entry);
+
+	/** Do the raw templates of these two entries describe the same struct templates? */
+	static bool matches(const Entry &a, const Entry &b);
+
+	friend class GFF4File;
+};
+
 class GFF4Struct {
 public:
 	/** The type of a GFF4 field. */
@@ -227,7 +302,11 @@ public:
 
 	/** Return the struct's unique ID within the GFF4. */
 	uint64 getID() const;
-	/** Return the number of structs that refer to this struct. */
+	/** Return the number of structs that refer to this struct.
+	 *
+	 *  In a lazily loaded GFF4, only references from structs that have been
+	 *  loaded already are counted.
+	 */
 	uint32 getRefCount() const;
 
 	/** Return the struct's label.
@@ -352,7 +431,9 @@ private:
 		bool isGeneric { false };   ///< Is this field found in a generic?
 
 		uint16   structIndex { 0 }; ///< Index of the field's struct type (if kFieldTypeStruct).
-		GFF4List structs;           ///< List of GFF4Struct (if kFieldTypeStruct).
+
+		mutable GFF4List structs;                 ///< List of GFF4Struct (if kFieldTypeStruct).
+		mutable bool     structsLoaded { false }; ///< Have the structs been loaded yet?
 
 		Field() = default;
 		Field(uint32 l, uint16 t, uint16 f, uint32 o, bool g = false);
@@ -362,7 +443,7 @@ private:
 	typedef std::map<uint32, Field> FieldMap;
 
 
-	const GFF4File *_parent;
+	GFF4File *_parent;
 
 	uint32 _label;
 
@@ -385,8 +466,11 @@ private:
 	~GFF4Struct();
 
 	void load(GFF4File &parent, uint32 offset, const GFF4File::StructTemplate &tmplt);
-	void loadStructs(GFF4File &parent, Field &field);
-	void loadGeneric(GFF4File &parent, Field &field);
+	void loadStructs(GFF4File &parent, const Field &field) const;
+	void loadGeneric(GFF4File &parent, const Field &field) const;
+
+	/** Make sure the structs of this field are loaded, in a lazily loaded GFF4. */
+	void loadFieldStructs(const Field &field) const;
 
 	void load(GFF4File &parent, const Field &genericParent);
 
@@ -42,6 +42,10 @@ uint32 KEYDataFile::getResourceSize(uint32 index) const {
 	return getRes(index).size;
 }
 
+Common::SeekableReadStream *KEYDataFile::getResourceStream(uint32 index) const {
+	return getResource(index, true);
+}
+
 const KEYDataFile::Resource &KEYDataFile::getRes(uint32 index) const {
 	if (index >= _resources.size())
 		throw Common::Exception("Resource index out of range (%u/%u)", index, (uint)_resources.size());
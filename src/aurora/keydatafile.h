@@ -51,8 +51,22 @@ public:
 	/** Return the size of a resource. */
 	uint32 getResourceSize(uint32 index) const;
 
-	/** Return a stream of the resource's contents. */
-	virtual Common::SeekableReadStream *getResource(uint32 index) const = 0;
+	/** Return a stream of the resource's contents.
+	 *
+	 *  @param  index The index of the resource we want.
+	 *  @param  tryNoCopy Try to return a stream reading straight out of the data file,
+	 *                    instead of copying the whole resource. Compressed resources
+	 *                    are still decompressed whole.
+	 *  @return A (sub)stream of the resource's contents.
+	 */
+	virtual Common::SeekableReadStream *getResource(uint32 index, bool tryNoCopy = false) const = 0;
+
+	/** Return a stream of the resource's contents, meant to be read once from start to end.
+	 *
+	 *  See Archive::getResourceStream(). By default, this is the same as
+	 *  getResource() with tryNoCopy.
+	 */
+	virtual Common::SeekableReadStream *getResourceStream(uint32 index) const;
 
 protected:
 	/** Resource information. */
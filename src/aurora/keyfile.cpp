@@ -33,6 +33,7 @@
 #include "src/common/error.h"
 #include "src/common/readstream.h"
 #include "src/common/encoding.h"
+#include "src/common/mutex.h"
 
 #include "src/aurora/keyfile.h"
 #include "src/aurora/keydatafile.h"
@@ -43,6 +44,45 @@ static const uint32 kVersion11 = MKTAG('V', '1', '.', '1');
 
 namespace Aurora {
 
+/** A resource stream reading out of a data file opened on demand.
+ *
+ *  It keeps the data file alive, in case the KEY file closes it in the meantime.
+ */
+class KEYDataFileStream : public Common::SeekableReadStream {
+public:
+	KEYDataFileStream(const std::shared_ptr<KEYDataFile> &dataFile, Common::SeekableReadStream *stream) :
+		_dataFile(dataFile), _stream(stream) {
+
+	}
+
+	bool eos() const {
+		return _stream->eos();
+	}
+
+	size_t read(void *dataPtr, size_t dataSize) {
+		return _stream->read(dataPtr, dataSize);
+	}
+
+	size_t pos() const {
+		return _stream->pos();
+	}
+
+	size_t size() const {
+		return _stream->size();
+	}
+
+	size_t seek(ptrdiff_t offset, Origin whence = kOriginBegin) {
+		return _stream->seek(offset, whence);
+	}
+
+private:
+	// Declared first, so that it's destroyed after the stream reading from it
+	std::shared_ptr<KEYDataFile> _dataFile;
+
+	std::unique_ptr<Common::SeekableReadStream> _stream;
+};
+
+
 KEYFile::KEYFile(Common::SeekableReadStream *key) {
 	std::unique_ptr<Common::SeekableReadStream> keyStream(key);
 
@@ -53,27 +93,132 @@ KEYFile::~KEYFile() {
 }
 
 bool KEYFile::haveDataFile(uint32 index) const {
-	return getIResource(index).dataFile != 0;
+	const IResource &iRes = getIResource(index);
+	if (iRes.dataFileIndex >= _dataFileInfo.size())
+		return false;
+
+	std::lock_guard<std::mutex> lock(_dataFileMutex);
+
+	const DataFile &dataFile = _dataFileInfo[iRes.dataFileIndex];
+	return (dataFile.dataFile != 0) || dataFile.opener;
+}
+
+void KEYFile::mergeDataFile(uint32 dataFileIndex, const KEYDataFile &dataFile) const {
+	// Make sure the information for all resources where the data file index matches
+	for (std::vector<const Resource *>::const_iterator r = _dataFileInfo[dataFileIndex].resources.begin();
+	     r != _dataFileInfo[dataFileIndex].resources.end(); ++r) {
+
+		const IResource &iRes = _iResources[(*r)->index];
+
+		if ((*r)->type != dataFile.getResourceType(iRes.resIndex))
+			throw Common::Exception("Resource type doesn't match in data file (%d, %d, %d, %d, %d)",
+			                        (*r)->index, iRes.dataFileIndex, iRes.resIndex,
+			                        (*r)->type, dataFile.getResourceType(iRes.resIndex));
+	}
 }
 
 void KEYFile::addDataFile(uint32 dataFileIndex, KEYDataFile *dataFile) {
 	if (!dataFile)
 		throw Common::Exception("KEYFile::addDataFile(): dataFile == 0");
 
-	ResourceList::iterator   res = _resources.begin();
-	IResourceList::iterator iRes = _iResources.begin();
-	for (; (res != _resources.end()) && (iRes != _iResources.end()); ++res, ++iRes) {
-		// Merge information for all resources where the data file index matches
-		if (iRes->dataFileIndex != dataFileIndex)
-			continue;
+	if (dataFileIndex >= _dataFileInfo.size())
+		return;
 
-		if (res->type != dataFile->getResourceType(iRes->resIndex))
-			throw Common::Exception("Resource type doesn't match in data file (%d, %d, %d, %d, %d)",
-			                        res->index, iRes->dataFileIndex, iRes->resIndex,
-			                        res->type, dataFile->getResourceType(iRes->resIndex));
+	mergeDataFile(dataFileIndex, *dataFile);
+
+	std::lock_guard<std::mutex> lock(_dataFileMutex);
+
+	DataFile &info = _dataFileInfo[dataFileIndex];
+	if (info.openedDataFile) {
+		_openDataFiles.erase(info.lruPosition);
+		info.openedDataFile.reset();
+	}
 
-		iRes->dataFile = dataFile;
+	info.opener   = DataFileOpener();
+	info.dataFile = dataFile;
+}
+
+void KEYFile::addDataFile(uint32 dataFileIndex, const DataFileOpener &opener) {
+	if (!opener)
+		throw Common::Exception("KEYFile::addDataFile(): No opener");
+
+	if (dataFileIndex >= _dataFileInfo.size())
+		return;
+
+	std::lock_guard<std::mutex> lock(_dataFileMutex);
+
+	DataFile &info = _dataFileInfo[dataFileIndex];
+	if (info.openedDataFile) {
+		_openDataFiles.erase(info.lruPosition);
+		info.openedDataFile.reset();
 	}
+
+	info.opener   = opener;
+	info.dataFile = 0;
+}
+
+void KEYFile::setMaxOpenDataFiles(size_t count) {
+	std::lock_guard<std::mutex> lock(_dataFileMutex);
+
+	_maxOpenDataFiles = MAX<size_t>(count, 1);
+
+	closeDataFiles(_maxOpenDataFiles);
+}
+
+void KEYFile::closeDataFiles(size_t count) const {
+	while (_openDataFiles.size() > count) {
+		DataFile &info = _dataFileInfo[_openDataFiles.back()];
+
+		info.dataFile = 0;
+		info.openedDataFile.reset();
+
+		_openDataFiles.pop_back();
+	}
+}
+
+std::shared_ptr<KEYDataFile> KEYFile::getDataFile(const IResource &iRes) const {
+	if (iRes.dataFileIndex >= _dataFileInfo.size())
+		return std::shared_ptr<KEYDataFile>();
+
+	DataFile &info = _dataFileInfo[iRes.dataFileIndex];
+
+	if (info.dataFile) {
+		if (!info.openedDataFile) {
+			// Not ours, so it's not reference counted either
+			return std::shared_ptr<KEYDataFile>(std::shared_ptr<KEYDataFile>(), info.dataFile);
+		}
+
+		// Mark this data file as the most recently used one
+		_openDataFiles.splice(_openDataFiles.begin(), _openDataFiles, info.lruPosition);
+
+		return info.openedDataFile;
+	}
+
+	if (!info.opener)
+		return std::shared_ptr<KEYDataFile>();
+
+	try {
+		std::unique_ptr<KEYDataFile> dataFile(info.opener());
+		if (!dataFile)
+			throw Common::Exception("Failed to open data file");
+
+		mergeDataFile(iRes.dataFileIndex, *dataFile);
+
+		// Make room for the new data file
+		closeDataFiles(_maxOpenDataFiles - 1);
+
+		info.openedDataFile = std::move(dataFile);
+		info.dataFile       = info.openedDataFile.get();
+
+		_openDataFiles.push_front(iRes.dataFileIndex);
+		info.lruPosition = _openDataFiles.begin();
+
+	} catch (Common::Exception &e) {
+		e.add("Failed to open KEY data file \"%s\"", _dataFiles[iRes.dataFileIndex].c_str());
+		throw;
+	}
+
+	return info.openedDataFile;
 }
 
 const std::vector<Common::UString> &KEYFile::getDataFileList() const {
@@ -111,6 +256,8 @@ void KEYFile::load(Common::SeekableReadStream &key) {
 		_iResources.resize(resCount);
 		readResList(key, offResTable);
 
+		indexDataFiles();
+
 	} catch (Common::Exception &e) {
 		e.add("Failed reading KEY file");
 		throw;
@@ -154,8 +301,6 @@ void KEYFile::readResList(Common::SeekableReadStream &key, uint32 offset) {
 	ResourceList::iterator   res = _resources.begin();
 	IResourceList::iterator iRes = _iResources.begin();
 	for (; (res != _resources.end()) && (iRes != _iResources.end()); ++index, ++res, ++iRes) {
-		iRes->dataFile = 0;
-
 		res->name  = Common::readStringFixed(key, Common::kEncodingASCII, 16);
 		res->type  = (FileType) key.readUint16LE();
 		res->index = index;
@@ -175,6 +320,16 @@ void KEYFile::readResList(Common::SeekableReadStream &key, uint32 offset) {
 	}
 }
 
+void KEYFile::indexDataFiles() {
+	_dataFileInfo.resize(_dataFiles.size());
+
+	ResourceList::const_iterator   res = _resources.begin();
+	IResourceList::const_iterator iRes = _iResources.begin();
+	for (; (res != _resources.end()) && (iRes != _iResources.end()); ++res, ++iRes)
+		if (iRes->dataFileIndex < _dataFileInfo.size())
+			_dataFileInfo[iRes->dataFileIndex].resources.push_back(&*res);
+}
+
 const Archive::ResourceList &KEYFile::getResources() const {
 	return _resources;
 }
@@ -188,31 +343,51 @@ const KEYFile::IResource &KEYFile::getIResource(uint32 index) const {
 
 uint32 KEYFile::getResourceSize(uint32 index) const {
 	const IResource &iRes = getIResource(index);
-	if (!iRes.dataFile)
+
+	std::lock_guard<std::mutex> lock(_dataFileMutex);
+
+	std::shared_ptr<KEYDataFile> dataFile = getDataFile(iRes);
+	if (!dataFile)
 		return 0xFFFFFFFF;
 
-	return iRes.dataFile->getResourceSize(iRes.resIndex);
+	return dataFile->getResourceSize(iRes.resIndex);
 }
 
-Common::SeekableReadStream *KEYFile::getResource(uint32 index, bool UNUSED(tryNoCopy)) const {
+Common::SeekableReadStream *KEYFile::getResource(uint32 index, bool tryNoCopy) const {
+	return openResource(index, tryNoCopy, false);
+}
+
+Common::SeekableReadStream *KEYFile::getResourceStream(uint32 index) const {
+	return openResource(index, true, true);
+}
+
+Common::SeekableReadStream *KEYFile::openResource(uint32 index, bool tryNoCopy, bool sequential) const {
 	const IResource &iRes = getIResource(index);
-	if (!iRes.dataFile)
+
+	// The data files read from a single stream, so only one thread may read them at a time
+	std::lock_guard<std::mutex> lock(_dataFileMutex);
+
+	std::shared_ptr<KEYDataFile> dataFile = getDataFile(iRes);
+	if (!dataFile)
 		throw Common::Exception("Data files for resource %d (\"%s\") missing", index,
-		                        _dataFiles[iRes.dataFileIndex].c_str());
+		                        (iRes.dataFileIndex < _dataFiles.size()) ? _dataFiles[iRes.dataFileIndex].c_str() : "");
+
+	std::unique_ptr<Common::SeekableReadStream> stream(sequential ? dataFile->getResourceStream(iRes.resIndex) :
+	                                                                dataFile->getResource(iRes.resIndex, tryNoCopy));
+
+	// A view into a data file we might close needs to keep the data file alive
+	if (tryNoCopy && _dataFileInfo[iRes.dataFileIndex].openedDataFile)
+		return new KEYDataFileStream(dataFile, stream.release());
 
-	return iRes.dataFile->getResource(iRes.resIndex);
+	return stream.release();
 }
 
 std::vector<const Archive::Resource *> KEYFile::getResourceListForDataFile(const Common::UString &dataFile) const {
 	std::vector<const Archive::Resource *> list;
 
-	uint32 i = 0;
-	for (auto it = _resources.begin(); it != _resources.end(); ++it, i++) {
-		if (_dataFiles[getIResource(i).dataFileIndex] != dataFile)
-			continue;
-
-		list.push_back(&(*it));
-	}
+	for (size_t i = 0; i < _dataFiles.size(); i++)
+		if (_dataFiles[i] == dataFile)
+			list.insert(list.end(), _dataFileInfo[i].resources.begin(), _dataFileInfo[i].resources.end());
 
 	return list;
 }
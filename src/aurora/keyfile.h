@@ -25,10 +25,14 @@
 #ifndef AURORA_KEYFILE_H
 #define AURORA_KEYFILE_H
 
+#include <list>
 #include <vector>
+#include <memory>
+#include <functional>
 
 #include "src/common/types.h"
 #include "src/common/ustring.h"
+#include "src/common/mutex.h"
 
 #include "src/aurora/types.h"
 #include "src/aurora/aurorafile.h"
@@ -64,12 +68,25 @@ class KEYDataFile;
  *    the Old Republic, Knight of the Old Republic II and Jade Empire
  *  - V1.1, used by The Witcher
  *
+ *  Data files can either be added already opened, or as a function that
+ *  opens them. In the latter case, the data file is only opened once one
+ *  of its resources is actually accessed, and only a limited number of
+ *  these data files are kept open at the same time. A data file that's
+ *  closed again stays alive for as long as streams returned by
+ *  getResource() still read from it.
+ *
  *  Please note that KEY (and BIF) files found in Infinity Engine
  *  games (Baldur's Gate et al) are not supported at all, even though
  *  they claim to be V1.
  */
 class KEYFile : public Archive, public AuroraFile {
 public:
+	/** A function that opens a data file. */
+	typedef std::function<KEYDataFile *()> DataFileOpener;
+
+	/** The default number of data files opened on demand kept open at the same time. */
+	static const size_t kDefaultMaxOpenDataFiles = 16;
+
 	KEYFile(Common::SeekableReadStream *key);
 	~KEYFile();
 
@@ -80,6 +97,18 @@ public:
 	 */
 	void addDataFile(uint32 dataFileIndex, KEYDataFile *dataFile);
 
+	/** Add a data file that's managed by this KEY file, opened on demand.
+	 *
+	 *  The opener is only called when a resource within this data file is
+	 *  first accessed. The KEYFile object takes ownership of the data files
+	 *  created this way. When too many of them are open, the one that went
+	 *  unused the longest is closed again, to be reopened when needed.
+	 */
+	void addDataFile(uint32 dataFileIndex, const DataFileOpener &opener);
+
+	/** Set the number of data files opened on demand kept open at the same time. */
+	void setMaxOpenDataFiles(size_t count);
+
 	/** Return the list of data files (BIF/BZF) this KEY file indexes. */
 	const std::vector<Common::UString> &getDataFileList() const;
 
@@ -103,9 +132,21 @@ public:
 	 *  Note: Since the resource's data is stored in data files,
 	 *        this method will throw an error if the respective
 	 *        data file was not added first with addDataFile().
+	 *
+	 *  This method may be called from several threads at once. Streams
+	 *  reading straight out of a data file (tryNoCopy) share that data
+	 *  file's stream, though, so only one thread may read them at a time.
 	 */
 	Common::SeekableReadStream *getResource(uint32 index, bool tryNoCopy = false) const;
 
+	/** Return a stream of the resource's contents, meant to be read once from start to end.
+	 *
+	 *  Like streams reading straight out of a data file, these share the data
+	 *  file's stream, so only one thread may read them at a time.
+	 */
+	Common::SeekableReadStream *getResourceStream(uint32 index) const;
+
+	/** Return all resources stored in this data file. */
 	std::vector<const Archive::Resource *> getResourceListForDataFile(const Common::UString &dataFile) const;
 
 private:
@@ -113,12 +154,23 @@ private:
 	struct IResource {
 		uint32 dataFileIndex; ///< Index into the data file list.
 		uint32 resIndex;      ///< Index into the data file's resource table.
-
-		KEYDataFile *dataFile; ///< The actual data file containing this resource.
 	};
 
 	typedef std::vector<IResource> IResourceList;
 
+	/** Internal data file information. */
+	struct DataFile {
+		KEYDataFile *dataFile { nullptr }; ///< The data file, if it's currently available.
+
+		DataFileOpener opener; ///< The function opening this data file on demand.
+		std::shared_ptr<KEYDataFile> openedDataFile; ///< The data file we opened on demand.
+
+		std::list<uint32>::iterator lruPosition; ///< Our position in the open data files list.
+
+		/** All resources stored in this data file. */
+		std::vector<const Archive::Resource *> resources;
+	};
+
 	/** External list of resource names and types. */
 	ResourceList _resources;
 
@@ -128,12 +180,39 @@ private:
 	/** All managed data files (BIF/BZF). */
 	std::vector<Common::UString> _dataFiles;
 
+	/** Information about all managed data files, opening them on demand. */
+	mutable std::vector<DataFile> _dataFileInfo;
+
+	/** All data files opened on demand, most recently used first. */
+	mutable std::list<uint32> _openDataFiles;
+
+	size_t _maxOpenDataFiles { kDefaultMaxOpenDataFiles };
+
+	/** Protects the data file information and the reading from the data files. */
+	mutable std::mutex _dataFileMutex;
+
 	void load(Common::SeekableReadStream &key);
 
 	void readDataFileList(Common::SeekableReadStream &key, uint32 offset);
 	void readResList(Common::SeekableReadStream &key, uint32 offset);
 
+	void indexDataFiles();
+
 	const IResource &getIResource(uint32 index) const;
+
+	/** Make sure the resource types in the data file match ours. */
+	void mergeDataFile(uint32 dataFileIndex, const KEYDataFile &dataFile) const;
+
+	/** Return the data file a resource is in, opening it if necessary.
+	 *
+	 *  The returned pointer keeps a data file opened on demand alive, even
+	 *  after it has been closed to make room for others.
+	 */
+	std::shared_ptr<KEYDataFile> getDataFile(const IResource &iRes) const;
+	/** Return a stream of the resource's contents, either out of getResource() or getResourceStream(). */
+	Common::SeekableReadStream *openResource(uint32 index, bool tryNoCopy, bool sequential) const;
+	/** Close the least recently used data files, until at most count are open. */
+	void closeDataFiles(size_t count) const;
 };
 
 } // End of namespace Aurora
@@ -0,0 +1,185 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Patching BioWare's KEYs (resource index files) in place.
+ */
+
+#include <cassert>
+
+#include "src/common/util.h"
+#include "src/common/strutil.h"
+#include "src/common/error.h"
+#include "src/common/encoding.h"
+#include "src/common/readwritestream.h"
+#include "src/common/memwritestream.h"
+
+#include "src/aurora/keypatcher.h"
+
+static const uint32 kKEYID     = MKTAG('K', 'E', 'Y', ' ');
+static const uint32 kVersion1  = MKTAG('V', '1', ' ', ' ');
+static const uint32 kVersion11 = MKTAG('V', '1', '.', '1');
+
+/** The size of a data file's entry in the file table. */
+static const size_t kFileEntrySize = 12;
+
+namespace Aurora {
+
+KEYPatcher::KEYPatcher(Common::SeekableReadWriteStream *key) : _key(key), _version(0),
+	_dataFileCount(0), _resCount(0), _offFileTable(0), _offResTable(0), _entrySize(0) {
+
+	assert(_key);
+
+	try {
+		load();
+	} catch (Common::Exception &e) {
+		e.add("Failed opening KEY file for patching");
+		throw;
+	}
+}
+
+KEYPatcher::~KEYPatcher() {
+}
+
+void KEYPatcher::load() {
+	_key->seek(0);
+
+	const uint32 id = _key->readUint32BE();
+	_version        = _key->readUint32BE();
+
+	if (id != kKEYID)
+		throw Common::Exception("Not a KEY file (%s)", Common::debugTag(id).c_str());
+
+	if ((_version != kVersion1) && (_version != kVersion11))
+		throw Common::Exception("Unsupported KEY file version %s", Common::debugTag(_version).c_str());
+
+	_dataFileCount = _key->readUint32LE();
+	_resCount      = _key->readUint32LE();
+
+	// Version 1.1 has some NULL bytes here
+	if (_version == kVersion11)
+		_key->skip(4);
+
+	_offFileTable = _key->readUint32LE();
+	_offResTable  = _key->readUint32LE();
+
+	// Version 1.1 added a flags field holding the data file index
+	_entrySize = (_version == kVersion11) ? 26 : 22;
+
+	const size_t size = _key->size();
+	if (((_offFileTable + (size_t) _dataFileCount * kFileEntrySize) > size) ||
+	    ((_offResTable  + (size_t) _resCount      * _entrySize)     > size))
+		throw Common::Exception("KEY tables out of range");
+}
+
+size_t KEYPatcher::getDataFileCount() const {
+	return _dataFileCount;
+}
+
+size_t KEYPatcher::getResourceCount() const {
+	return _resCount + _newEntries.size() / _entrySize;
+}
+
+void KEYPatcher::setDataFileSize(uint32 dataFileIndex, uint32 size) {
+	if (dataFileIndex >= _dataFileCount)
+		throw Common::Exception("Data file index out of range (%u/%u)", dataFileIndex, _dataFileCount);
+
+	_dataFileSizes[dataFileIndex] = size;
+}
+
+void KEYPatcher::add(const Common::UString &name, FileType type, uint32 dataFileIndex, uint32 resIndex) {
+	if (dataFileIndex >= _dataFileCount)
+		throw Common::Exception("Data file index out of range (%u/%u)", dataFileIndex, _dataFileCount);
+	if ((dataFileIndex > 0xFFF) || (resIndex > 0xFFFFF))
+		throw Common::Exception("Resource ID out of range (%u, %u)", dataFileIndex, resIndex);
+
+	if (name.size() > 16)
+		throw Common::Exception("Resource name \"%s\" is too long for a KEY", name.c_str());
+	if ((uint32)type > 0xFFFF)
+		throw Common::Exception("File type %d can't be stored in a KEY", (int) type);
+
+	Common::MemoryWriteStreamDynamic entry(true);
+
+	Common::writeStringFixed(entry, name, Common::kEncodingASCII, 16);
+	entry.writeUint16LE(type);
+	entry.writeUint32LE((dataFileIndex << 20) | resIndex);
+
+	if (_version == kVersion11)
+		entry.writeUint32LE(dataFileIndex << 20);
+
+	_newEntries.insert(_newEntries.end(), entry.getData(), entry.getData() + entry.size());
+}
+
+void KEYPatcher::flush() {
+	for (std::map<uint32, uint32>::const_iterator s = _dataFileSizes.begin(); s != _dataFileSizes.end(); ++s) {
+		_key->seek(_offFileTable + s->first * kFileEntrySize);
+		_key->writeUint32LE(s->second);
+	}
+
+	_dataFileSizes.clear();
+
+	if (_newEntries.empty()) {
+		_key->flush();
+		return;
+	}
+
+	uint32 offResTable = _offResTable;
+	uint32 resCount    = _resCount;
+
+	std::vector<byte> entries;
+
+	const size_t resTableEnd = _offResTable + (size_t) _resCount * _entrySize;
+	if (resTableEnd != (size_t) _key->size()) {
+		// Something else follows the resource table, so move the whole table to the end
+		entries.resize((size_t) _resCount * _entrySize);
+
+		_key->seek(_offResTable);
+		if (!entries.empty() && (_key->read(&entries[0], entries.size()) != entries.size()))
+			throw Common::Exception(Common::kReadError);
+
+		if (_key->size() > 0xFFFFFFFF)
+			throw Common::Exception("KEY file too large");
+
+		offResTable = _key->size();
+		resCount    = 0;
+	}
+
+	entries.insert(entries.end(), _newEntries.begin(), _newEntries.end());
+
+	// Write the entries first, so that the header never points to unwritten entries
+	_key->seek(offResTable + (size_t) resCount * _entrySize);
+	if (_key->write(&entries[0], entries.size()) != entries.size())
+		throw Common::Exception(Common::kWriteError);
+
+	_offResTable = offResTable;
+	_resCount    = resCount + entries.size() / _entrySize;
+
+	_newEntries.clear();
+
+	_key->seek(12);
+	_key->writeUint32LE(_resCount);
+
+	_key->seek((_version == kVersion11) ? 0x18 : 0x14);
+	_key->writeUint32LE(_offResTable);
+
+	_key->flush();
+}
+
+} // End of namespace Aurora
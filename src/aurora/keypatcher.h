@@ -0,0 +1,100 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Patching BioWare's KEYs (resource index files) in place.
+ */
+
+#ifndef AURORA_KEYPATCHER_H
+#define AURORA_KEYPATCHER_H
+
+#include <vector>
+#include <map>
+#include <memory>
+
+#include <boost/noncopyable.hpp>
+
+#include "src/common/types.h"
+#include "src/common/ustring.h"
+
+#include "src/aurora/types.h"
+
+namespace Common {
+	class SeekableReadWriteStream;
+}
+
+namespace Aurora {
+
+/** Patching the resource index within an existing KEY file.
+ *
+ *  Together with BIFPatcher, this allows adding resources to a KEY/BIF
+ *  archive without rewriting it: the new data is added to the BIF, and
+ *  the KEY gets a new entry pointing to it.
+ *
+ *  New entries are written right after the existing resource table, if
+ *  it's at the end of the KEY. Otherwise, the whole resource table is
+ *  moved to the end. The list of data files is never changed, only the
+ *  sizes of the data files within it are updated.
+ */
+class KEYPatcher : boost::noncopyable {
+public:
+	/** Take over this stream and open the KEY within for patching. */
+	KEYPatcher(Common::SeekableReadWriteStream *key);
+	~KEYPatcher();
+
+	/** Return the number of data files the KEY indexes. */
+	size_t getDataFileCount() const;
+	/** Return the number of resources in the KEY, including those not yet flushed. */
+	size_t getResourceCount() const;
+
+	/** Update the size of a data file, after it has been patched. */
+	void setDataFileSize(uint32 dataFileIndex, uint32 size);
+
+	/** Add a resource found in this data file, at this index within it. */
+	void add(const Common::UString &name, FileType type, uint32 dataFileIndex, uint32 resIndex);
+
+	/** Write all changes into the KEY. */
+	void flush();
+
+private:
+	std::unique_ptr<Common::SeekableReadWriteStream> _key;
+
+	uint32 _version;
+
+	uint32 _dataFileCount;
+	uint32 _resCount;
+
+	uint32 _offFileTable;
+	uint32 _offResTable;
+
+	/** The size of a resource's entry in the resource table. */
+	size_t _entrySize;
+
+	/** Data file sizes that have been changed, by data file index. */
+	std::map<uint32, uint32> _dataFileSizes;
+	/** The entries of all added resources, not yet written. */
+	std::vector<byte> _newEntries;
+
+	void load();
+};
+
+} // End of namespace Aurora
+
+#endif // AURORA_KEYPATCHER_H
@@ -0,0 +1,140 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Extracting many resources of an archive in parallel.
+ */
+
+#include <algorithm>
+#include <memory>
+
+#include "src/common/util.h"
+#include "src/common/error.h"
+#include "src/common/readstream.h"
+#include "src/common/mutex.h"
+#include "src/common/thread.h"
+
+#include "src/aurora/resourceextractor.h"
+#include "src/aurora/archive.h"
+
+namespace Aurora {
+
+ResourceExtractor::ResourceExtractor(const ArchiveOpener &opener) : _opener(opener) {
+}
+
+ResourceExtractor::~ResourceExtractor() {
+}
+
+const std::vector<ResourceExtractor::Failure> &ResourceExtractor::getFailures() const {
+	return _failures;
+}
+
+void ResourceExtractor::extractAll(const ResourceSink &sink, size_t threadCount) {
+	std::unique_ptr<Archive> archive(_opener());
+
+	std::vector<uint32> indices;
+
+	const Archive::ResourceList &resources = archive->getResources();
+	for (Archive::ResourceList::const_iterator r = resources.begin(); r != resources.end(); ++r)
+		indices.push_back(r->index);
+
+	extract(*archive, indices, sink, threadCount);
+}
+
+void ResourceExtractor::extract(const std::vector<uint32> &indices, const ResourceSink &sink, size_t threadCount) {
+	std::unique_ptr<Archive> archive(_opener());
+
+	extract(*archive, indices, sink, threadCount);
+}
+
+void ResourceExtractor::extract(Archive &archive, const std::vector<uint32> &indices,
+                                const ResourceSink &sink, size_t threadCount) {
+
+	_failures.clear();
+
+	// Start with the largest resources
+	std::vector< std::pair<uint32, uint32> > sorted;
+	sorted.reserve(indices.size());
+
+	for (std::vector<uint32>::const_iterator i = indices.begin(); i != indices.end(); ++i) {
+		uint32 size = 0;
+		try {
+			size = archive.getResourceSize(*i);
+		} catch (...) {
+		}
+
+		sorted.push_back(std::make_pair(size, *i));
+	}
+
+	std::stable_sort(sorted.begin(), sorted.end(), [](const std::pair<uint32, uint32> &a,
+	                                                  const std::pair<uint32, uint32> &b) {
+		return a.first > b.first;
+	});
+
+	threadCount = MIN<size_t>(Common::getThreadCount(threadCount), sorted.size());
+
+	/* Every thread but the calling one opens its own instance of the archive, so
+	 * that it can read straight out of it. Threads that fail to open one share
+	 * the caller's instance instead, one at a time. */
+	std::vector< std::unique_ptr<Archive> > sources(threadCount);
+
+	Common::runThreads(threadCount, [&](size_t thread) {
+		if (thread == 0)
+			return;
+
+		try {
+			sources[thread].reset(_opener());
+		} catch (...) {
+		}
+	});
+
+	std::mutex sharedMutex, failureMutex;
+
+	Common::parallelFor(sorted.size(), [&](size_t i, size_t thread) {
+		const uint32 index = sorted[i].second;
+
+		Archive *source = sources[thread].get();
+
+		std::unique_lock<std::mutex> sharedLock(sharedMutex, std::defer_lock);
+		if (!source) {
+			source = &archive;
+			sharedLock.lock();
+		}
+
+		try {
+			std::unique_ptr<Common::SeekableReadStream> data(source->getResourceStream(index));
+
+			sink(index, *data);
+
+		} catch (std::exception &e) {
+			std::lock_guard<std::mutex> lock(failureMutex);
+			_failures.push_back({ index, e.what() });
+		} catch (...) {
+			std::lock_guard<std::mutex> lock(failureMutex);
+			_failures.push_back({ index, "Unknown exception" });
+		}
+	}, threadCount);
+
+	std::sort(_failures.begin(), _failures.end(), [](const Failure &a, const Failure &b) {
+		return a.index < b.index;
+	});
+}
+
+} // End of namespace Aurora
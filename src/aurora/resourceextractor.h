@@ -0,0 +1,109 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Extracting many resources of an archive in parallel.
+ */
+
+#ifndef AURORA_RESOURCEEXTRACTOR_H
+#define AURORA_RESOURCEEXTRACTOR_H
+
+#include <vector>
+#include <functional>
+
+#include <boost/noncopyable.hpp>
+
+#include "src/common/types.h"
+#include "src/common/ustring.h"
+
+namespace Common {
+	class SeekableReadStream;
+}
+
+namespace Aurora {
+
+class Archive;
+
+/** Extract many resources of an archive in parallel.
+ *
+ *  Decompressing large resources, like the movies and voice banks in Dragon
+ *  Age's ZIPs and ERFs, is bound by the CPU. But archives read their resources
+ *  through a single stream, so one archive can't be read by several threads
+ *  at once. Instead, every thread opens its own instance of the archive from
+ *  the same file, sharing the file's data through the system's file cache,
+ *  and decompresses its share of the resources on its own.
+ *
+ *  The largest resources are extracted first, so that one big resource at
+ *  the end doesn't keep a single thread busy while the others idle.
+ *
+ *  Where the archive supports it, resources are handed to the sink as streams
+ *  reading straight out of the archive, decompressing on the fly. The sink
+ *  should therefore read the data from start to end.
+ */
+class ResourceExtractor : boost::noncopyable {
+public:
+	/** Opens a new instance of the archive to extract from. */
+	typedef std::function<Archive *()> ArchiveOpener;
+	/** Receives the data of an extracted resource. Called from several threads at once. */
+	typedef std::function<void(uint32 index, Common::SeekableReadStream &data)> ResourceSink;
+
+	/** A resource that couldn't be extracted. */
+	struct Failure {
+		uint32 index;          ///< The resource's index within the archive.
+		Common::UString error; ///< Why the resource couldn't be extracted.
+	};
+
+	ResourceExtractor(const ArchiveOpener &opener);
+	~ResourceExtractor();
+
+	/** Extract these resources, and hand each of them to the sink.
+	 *
+	 *  Resources that can't be read, or that the sink throws on, are skipped
+	 *  and collected as failures.
+	 *
+	 *  @param indices The indices of the resources to extract.
+	 *  @param sink The receiver of the resources' data.
+	 *  @param threadCount The number of threads to use. 0 for one per CPU core.
+	 */
+	void extract(const std::vector<uint32> &indices, const ResourceSink &sink, size_t threadCount = 0);
+
+	/** Extract these resources of an archive that's already open.
+	 *
+	 *  The calling thread extracts out of this instance of the archive,
+	 *  while every other thread opens its own.
+	 */
+	void extract(Archive &archive, const std::vector<uint32> &indices,
+	             const ResourceSink &sink, size_t threadCount = 0);
+
+	/** Extract all resources of the archive. */
+	void extractAll(const ResourceSink &sink, size_t threadCount = 0);
+
+	/** Return the resources that failed to extract during the last extract(), ordered by index. */
+	const std::vector<Failure> &getFailures() const;
+
+private:
+	ArchiveOpener _opener;
+
+	std::vector<Failure> _failures;
+};
+
+} // End of namespace Aurora
+
+#endif // AURORA_RESOURCEEXTRACTOR_H
@@ -0,0 +1,205 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Resolving resources over a priority-ordered set of archives.
+ */
+
+#include <algorithm>
+
+#include "src/common/strutil.h"
+#include "src/common/readstream.h"
+
+#include "src/aurora/resourceoverlay.h"
+#include "src/aurora/archive.h"
+
+namespace Aurora {
+
+bool ResourceOverlay::Key::operator==(const Key &key) const {
+	return (type == key.type) && (name == key.name);
+}
+
+size_t ResourceOverlay::KeyHash::operator()(const Key &key) const {
+	return Common::hashUStringCaseSensitive()(key.name) * 31 + (size_t) key.type;
+}
+
+bool ResourceOverlay::Version::operator<(const Version &version) const {
+	if (location.priority != version.location.priority)
+		return location.priority < version.location.priority;
+
+	return sequence < version.sequence;
+}
+
+
+ResourceOverlay::ResourceOverlay() : _sequence(0) {
+}
+
+ResourceOverlay::~ResourceOverlay() {
+}
+
+uint32 ResourceOverlay::getDefaultPriority(FileType archiveType) {
+	switch (archiveType) {
+		case kFileTypeKEY:
+			return kPriorityKEY;
+
+		case kFileTypeMOD:
+		case kFileTypeNWM:
+		case kFileTypeSAV:
+			return kPriorityModule;
+
+		case kFileTypeHAK:
+			return kPriorityHAK;
+
+		case kFileTypeNone:
+			return kPriorityOverride;
+
+		default:
+			break;
+	}
+
+	return kPriorityArchive;
+}
+
+ResourceOverlay::Key ResourceOverlay::createKey(const Common::UString &name, FileType type) {
+	Key key;
+
+	key.name = name.toLower();
+	key.type = type;
+
+	return key;
+}
+
+void ResourceOverlay::addArchive(const Archive &archive, uint32 priority) {
+	removeArchive(archive);
+
+	ArchiveEntry entry;
+
+	entry.archive  = &archive;
+	entry.priority = priority;
+	entry.sequence = _sequence++;
+
+	_archives.push_back(entry);
+
+	addResources(entry);
+}
+
+void ResourceOverlay::removeArchive(const Archive &archive) {
+	std::vector<ArchiveEntry>::const_iterator entry = findArchive(archive);
+	if (entry == _archives.end())
+		return;
+
+	removeResources(archive);
+
+	_archives.erase(entry);
+}
+
+void ResourceOverlay::clear() {
+	_resources.clear();
+	_archives.clear();
+}
+
+bool ResourceOverlay::hasArchive(const Archive &archive) const {
+	return findArchive(archive) != _archives.end();
+}
+
+size_t ResourceOverlay::getArchiveCount() const {
+	return _archives.size();
+}
+
+size_t ResourceOverlay::getResourceCount() const {
+	return _resources.size();
+}
+
+std::vector<ResourceOverlay::ArchiveEntry>::const_iterator
+ResourceOverlay::findArchive(const Archive &archive) const {
+	return std::find_if(_archives.begin(), _archives.end(), [&archive](const ArchiveEntry &entry) {
+		return entry.archive == &archive;
+	});
+}
+
+void ResourceOverlay::addResources(const ArchiveEntry &archive) {
+	const Archive::ResourceList &resources = archive.archive->getResources();
+
+	for (Archive::ResourceList::const_iterator r = resources.begin(); r != resources.end(); ++r) {
+		const Common::UString name = r->name.empty() ? Common::composeString(r->hash) : r->name;
+
+		Version version;
+
+		version.location.archive  = archive.archive;
+		version.location.index    = r->index;
+		version.location.priority = archive.priority;
+		version.sequence          = archive.sequence;
+
+		// Most resources exist only once, so this is usually a simple push_back()
+		std::vector<Version> &versions = _resources[createKey(name, r->type)];
+		versions.insert(std::upper_bound(versions.begin(), versions.end(), version), version);
+	}
+}
+
+void ResourceOverlay::removeResources(const Archive &archive) {
+	const Archive::ResourceList &resources = archive.getResources();
+
+	for (Archive::ResourceList::const_iterator r = resources.begin(); r != resources.end(); ++r) {
+		const Common::UString name = r->name.empty() ? Common::composeString(r->hash) : r->name;
+
+		ResourceMap::iterator res = _resources.find(createKey(name, r->type));
+		if (res == _resources.end())
+			continue;
+
+		std::vector<Version> &versions = res->second;
+		versions.erase(std::remove_if(versions.begin(), versions.end(), [&archive](const Version &version) {
+			return version.location.archive == &archive;
+		}), versions.end());
+
+		if (versions.empty())
+			_resources.erase(res);
+	}
+}
+
+const ResourceOverlay::Location *ResourceOverlay::find(const Common::UString &name, FileType type) const {
+	ResourceMap::const_iterator res = _resources.find(createKey(name, type));
+	if (res == _resources.end())
+		return 0;
+
+	return &res->second.back().location;
+}
+
+std::vector<ResourceOverlay::Location> ResourceOverlay::findAll(const Common::UString &name, FileType type) const {
+	std::vector<Location> locations;
+
+	ResourceMap::const_iterator res = _resources.find(createKey(name, type));
+	if (res == _resources.end())
+		return locations;
+
+	for (std::vector<Version>::const_iterator v = res->second.begin(); v != res->second.end(); ++v)
+		locations.push_back(v->location);
+
+	return locations;
+}
+
+Common::SeekableReadStream *ResourceOverlay::getResource(const Common::UString &name, FileType type) const {
+	const Location *location = find(name, type);
+	if (!location)
+		return 0;
+
+	return location->archive->getResource(location->index);
+}
+
+} // End of namespace Aurora
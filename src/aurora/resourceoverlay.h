@@ -0,0 +1,166 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Resolving resources over a priority-ordered set of archives.
+ */
+
+#ifndef AURORA_RESOURCEOVERLAY_H
+#define AURORA_RESOURCEOVERLAY_H
+
+#include <vector>
+#include <unordered_map>
+
+#include <boost/noncopyable.hpp>
+
+#include "src/common/types.h"
+#include "src/common/ustring.h"
+
+#include "src/aurora/types.h"
+
+namespace Common {
+	class SeekableReadStream;
+}
+
+namespace Aurora {
+
+class Archive;
+
+/** Resolve resources by name and type over many archives, like the games do.
+ *
+ *  The games look up a resource by its name and type in all archives they
+ *  have loaded: KEY/BIF, modules, haks and override directories. When
+ *  several archives contain the same resource, the one in the archive with
+ *  the highest priority shadows all others.
+ *
+ *  All resources of all archives are kept in one hash table, so that looking
+ *  up the effective version of a resource takes constant time. Adding or
+ *  removing an archive only touches the entries of that archive's resources.
+ *
+ *  Resources without a name are indexed with their hash as their name, the
+ *  same way the resource tree shows them.
+ *
+ *  The overlay does not own the archives, they have to be kept around until
+ *  they are removed from the overlay again.
+ */
+class ResourceOverlay : boost::noncopyable {
+public:
+	/** The default archive priorities, roughly in the order the games apply them. */
+	enum Priority {
+		kPriorityKEY      = 100, ///< KEY files, indexing the base game's BIFs.
+		kPriorityArchive  = 200, ///< Other archives, like ERFs, RIMs and ZIPs.
+		kPriorityModule   = 300, ///< Modules and savegames.
+		kPriorityHAK      = 400, ///< Hak paks.
+		kPriorityOverride = 500  ///< Override directories.
+	};
+
+	/** A resource within one of the archives. */
+	struct Location {
+		const Archive *archive; ///< The archive containing the resource.
+		uint32 index;           ///< The resource's index within the archive.
+		uint32 priority;        ///< The priority of the archive.
+	};
+
+	ResourceOverlay();
+	~ResourceOverlay();
+
+	/** Return the default priority of an archive of this type.
+	 *
+	 *  Directories, like those opened as a DirectoryArchive, have the type kFileTypeNone.
+	 */
+	static uint32 getDefaultPriority(FileType archiveType);
+
+	/** Add an archive to the overlay.
+	 *
+	 *  Its resources shadow those of archives with a lower priority, and those
+	 *  of archives with the same priority that were added earlier.
+	 *  Adding an archive that's already in the overlay changes its priority.
+	 */
+	void addArchive(const Archive &archive, uint32 priority);
+	/** Remove an archive from the overlay, uncovering the resources it shadowed. */
+	void removeArchive(const Archive &archive);
+
+	/** Remove all archives from the overlay. */
+	void clear();
+
+	/** Is this archive part of the overlay? */
+	bool hasArchive(const Archive &archive) const;
+	/** Return the number of archives in the overlay. */
+	size_t getArchiveCount() const;
+	/** Return the number of distinct resources over all archives. */
+	size_t getResourceCount() const;
+
+	/** Find the effective version of a resource, or nullptr if no archive contains it. */
+	const Location *find(const Common::UString &name, FileType type) const;
+	/** Find all versions of a resource, ordered by priority. The last one is the effective one. */
+	std::vector<Location> findAll(const Common::UString &name, FileType type) const;
+
+	/** Return the contents of the effective version of a resource, or nullptr if it doesn't exist. */
+	Common::SeekableReadStream *getResource(const Common::UString &name, FileType type) const;
+
+private:
+	/** A resource's name and type, identifying it over all archives. */
+	struct Key {
+		Common::UString name; ///< The resource's name, in lower case.
+		FileType type;
+
+		bool operator==(const Key &key) const;
+	};
+
+	struct KeyHash {
+		size_t operator()(const Key &key) const;
+	};
+
+	/** An archive that's part of the overlay. */
+	struct ArchiveEntry {
+		const Archive *archive;
+
+		uint32 priority;
+		uint64 sequence; ///< When the archive was added, to order archives of the same priority.
+	};
+
+	/** A version of a resource. */
+	struct Version {
+		Location location;
+		uint64 sequence; ///< The sequence number of the archive.
+
+		/** Is this version shadowed by the other one? */
+		bool operator<(const Version &version) const;
+	};
+
+	/** All versions of each resource, ordered by priority. */
+	typedef std::unordered_map<Key, std::vector<Version>, KeyHash> ResourceMap;
+
+	std::vector<ArchiveEntry> _archives;
+	uint64 _sequence;
+
+	ResourceMap _resources;
+
+	static Key createKey(const Common::UString &name, FileType type);
+
+	std::vector<ArchiveEntry>::const_iterator findArchive(const Archive &archive) const;
+
+	void addResources(const ArchiveEntry &archive);
+	void removeResources(const Archive &archive);
+};
+
+} // End of namespace Aurora
+
+#endif // AURORA_RESOURCEOVERLAY_H
@@ -30,12 +30,25 @@ src_aurora_libaurora_la_SOURCES += \
     src/aurora/locstring.h \
     src/aurora/aurorafile.h \
     src/aurora/archive.h \
+    src/aurora/archivecache.h \
+    src/aurora/archiveloader.h \
+    src/aurora/searchindex.h \
+    src/aurora/directoryarchive.h \
+    src/aurora/duplicatefinder.h \
+    src/aurora/resourceoverlay.h \
+    src/aurora/resourceextractor.h \
+    src/aurora/archivedigest.h \
     src/aurora/zipfile.h \
     src/aurora/erffile.h \
+    src/aurora/erfwriter.h \
+    src/aurora/archivepatcher.h \
+    src/aurora/erfpatcher.h \
     src/aurora/rimfile.h \
     src/aurora/keyfile.h \
     src/aurora/keydatafile.h \
     src/aurora/biffile.h \
+    src/aurora/bifpatcher.h \
+    src/aurora/keypatcher.h \
     src/aurora/bzffile.h \
     src/aurora/herffile.h \
     src/aurora/ndsrom.h \
@@ -52,12 +65,25 @@ src_aurora_libaurora_la_SOURCES += \
     src/aurora/locstring.cpp \
     src/aurora/aurorafile.cpp \
     src/aurora/archive.cpp \
+    src/aurora/archivecache.cpp \
+    src/aurora/archiveloader.cpp \
+    src/aurora/searchindex.cpp \
+    src/aurora/directoryarchive.cpp \
+    src/aurora/duplicatefinder.cpp \
+    src/aurora/resourceoverlay.cpp \
+    src/aurora/resourceextractor.cpp \
+    src/aurora/archivedigest.cpp \
     src/aurora/zipfile.cpp \
     src/aurora/erffile.cpp \
+    src/aurora/erfwriter.cpp \
+    src/aurora/archivepatcher.cpp \
+    src/aurora/erfpatcher.cpp \
     src/aurora/rimfile.cpp \
     src/aurora/keyfile.cpp \
     src/aurora/keydatafile.cpp \
     src/aurora/biffile.cpp \
+    src/aurora/bifpatcher.cpp \
+    src/aurora/keypatcher.cpp \
     src/aurora/bzffile.cpp \
     src/aurora/herffile.cpp \
     src/aurora/ndsrom.cpp \
@@ -0,0 +1,493 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  An index for searching through the resources of many archives.
+ */
+
+#include <cstring>
+
+#include <algorithm>
+#include <memory>
+#include <exception>
+
+#include "src/common/util.h"
+#include "src/common/error.h"
+#include "src/common/strutil.h"
+#include "src/common/readstream.h"
+#include "src/common/writestream.h"
+#include "src/common/memwritestream.h"
+#include "src/common/encoding.h"
+#include "src/common/filepath.h"
+#include "src/common/thread.h"
+
+#include "src/aurora/searchindex.h"
+#include "src/aurora/util.h"
+#include "src/aurora/archive.h"
+#include "src/aurora/archiveloader.h"
+#include "src/aurora/2dafile.h"
+
+static const uint32 kSearchIndexID = MKTAG('P', 'S', 'I', 'X');
+static const uint32 kVersion2      = MKTAG('V', '2', '.', '0');
+
+/** Don't index the contents of resources larger than this. */
+static const size_t kMaxContentsSize = 16 * 1024 * 1024;
+
+namespace Aurora {
+
+static std::string toLowerASCII(const char *str) {
+	std::string lower(str);
+
+	for (std::string::iterator c = lower.begin(); c != lower.end(); ++c)
+		if ((*c >= 'A') && (*c <= 'Z'))
+			*c += 'a' - 'A';
+
+	return lower;
+}
+
+static bool isTextType(FileType type) {
+	return (type == kFileType2DA) || (type == kFileTypeTXT) || (type == kFileTypeTXI) || (type == kFileTypeNSS);
+}
+
+static void writeString(Common::WriteStream &stream, const Common::UString &str) {
+	const size_t length = strlen(str.c_str());
+
+	stream.writeUint32LE(length);
+	stream.write(str.c_str(), length);
+}
+
+static Common::UString readString(Common::SeekableReadStream &stream) {
+	const size_t length = stream.readUint32LE();
+
+	return Common::readStringFixed(stream, Common::kEncodingUTF8, length);
+}
+
+
+SearchIndex::SearchIndex() {
+}
+
+SearchIndex::~SearchIndex() {
+}
+
+void SearchIndex::clear() {
+	_archives.clear();
+	_archiveStamps.clear();
+
+	_resources.clear();
+	_keys.clear();
+
+	_nameTrigrams.clear();
+	_contentTrigrams.clear();
+}
+
+const std::vector<Common::UString> &SearchIndex::getArchives() const {
+	return _archives;
+}
+
+size_t SearchIndex::getResourceCount() const {
+	return _resources.size();
+}
+
+void SearchIndex::addTrigrams(TrigramMap &trigrams, const std::string &str, uint32 id) {
+	if (str.size() < 3)
+		return;
+
+	std::vector<uint32> strTrigrams;
+	strTrigrams.reserve(str.size() - 2);
+
+	for (size_t i = 0; i < str.size() - 2; i++)
+		strTrigrams.push_back(((byte) str[i] << 16) | ((byte) str[i + 1] << 8) | (byte) str[i + 2]);
+
+	std::sort(strTrigrams.begin(), strTrigrams.end());
+	strTrigrams.erase(std::unique(strTrigrams.begin(), strTrigrams.end()), strTrigrams.end());
+
+	// Resources are added in order, so the lists stay sorted
+	for (std::vector<uint32>::const_iterator t = strTrigrams.begin(); t != strTrigrams.end(); ++t)
+		trigrams[*t].push_back(id);
+}
+
+std::vector<uint32> SearchIndex::findTrigrams(const TrigramMap &trigrams, const std::string &str) {
+	std::vector<const std::vector<uint32> *> lists;
+
+	for (size_t i = 0; i < str.size() - 2; i++) {
+		const uint32 trigram = ((byte) str[i] << 16) | ((byte) str[i + 1] << 8) | (byte) str[i + 2];
+
+		TrigramMap::const_iterator list = trigrams.find(trigram);
+		if (list == trigrams.end())
+			return std::vector<uint32>();
+
+		lists.push_back(&list->second);
+	}
+
+	// Start with the shortest list, to keep the intermediate results small
+	std::sort(lists.begin(), lists.end(), [](const std::vector<uint32> *a, const std::vector<uint32> *b) {
+		return a->size() < b->size();
+	});
+
+	std::vector<uint32> result = *lists.front();
+	std::vector<uint32> intersection;
+
+	for (size_t i = 1; (i < lists.size()) && !result.empty(); i++) {
+		intersection.clear();
+		std::set_intersection(result.begin(), result.end(), lists[i]->begin(), lists[i]->end(),
+		                      std::back_inserter(intersection));
+
+		result.swap(intersection);
+	}
+
+	return result;
+}
+
+std::string SearchIndex::readContents(const Archive &archive, uint32 index, FileType type) {
+	if (archive.getResourceSize(index) > kMaxContentsSize)
+		return "";
+
+	std::unique_ptr<Common::SeekableReadStream> stream(archive.getResource(index));
+
+	Common::MemoryWriteStreamDynamic text(true);
+
+	if (type == kFileType2DA) {
+		// Binary 2DAs are converted to text, so that we find their cells
+		TwoDAFile twoDA(*stream);
+
+		twoDA.writeASCII(text);
+	} else
+		text.writeStream(*stream);
+
+	text.writeByte(0);
+
+	return toLowerASCII(reinterpret_cast<const char *>(text.getData()));
+}
+
+void SearchIndex::addResource(const IResource &resource, const std::string &contents) {
+	const uint32 id = _resources.size();
+
+	_resources.push_back(resource);
+	_keys.push_back(toLowerASCII((_archives[resource.archive] + "/" + resource.name).c_str()));
+
+	addTrigrams(_nameTrigrams, _keys.back(), id);
+	addTrigrams(_contentTrigrams, contents, id);
+}
+
+void SearchIndex::addArchiveStamp(const Common::UString &path, uint64 size, uint64 modified) {
+	ArchiveStamp stamp;
+	stamp.size     = size;
+	stamp.modified = modified;
+
+	_archives.push_back(path);
+	_archiveStamps.push_back(stamp);
+}
+
+void SearchIndex::addArchive(const Common::UString &path, const Archive &archive,
+                             bool indexContents, uint64 size, uint64 modified) {
+
+	IResource resource;
+	resource.archive = _archives.size();
+
+	addArchiveStamp(path, size, modified);
+
+	const Archive::ResourceList &resources = archive.getResources();
+	for (Archive::ResourceList::const_iterator r = resources.begin(); r != resources.end(); ++r) {
+		Common::UString name = r->name;
+		if (name.empty())
+			name = Common::composeString(r->hash);
+
+		resource.index = r->index;
+		resource.type  = r->type;
+		resource.name  = TypeMan.setFileType(name, r->type);
+
+		std::string contents;
+		if (indexContents && isTextType(r->type)) {
+			try {
+				contents = readContents(archive, r->index, r->type);
+			} catch (...) {
+				// Broken resources are still found by their name
+			}
+		}
+
+		addResource(resource, contents);
+	}
+}
+
+void SearchIndex::append(SearchIndex &index) {
+	const uint32 archiveOffset  = _archives.size();
+	const uint32 resourceOffset = _resources.size();
+
+	_archives.insert(_archives.end(), index._archives.begin(), index._archives.end());
+	_archiveStamps.insert(_archiveStamps.end(), index._archiveStamps.begin(), index._archiveStamps.end());
+
+	for (std::vector<IResource>::iterator r = index._resources.begin(); r != index._resources.end(); ++r) {
+		r->archive += archiveOffset;
+
+		_resources.push_back(*r);
+	}
+
+	_keys.insert(_keys.end(), index._keys.begin(), index._keys.end());
+
+	// The appended resources have higher ids, so the lists stay sorted
+	TrigramMap *trigramMaps[2][2] = {
+		{ &_nameTrigrams   , &index._nameTrigrams    },
+		{ &_contentTrigrams, &index._contentTrigrams }
+	};
+
+	for (size_t i = 0; i < 2; i++) {
+		for (TrigramMap::const_iterator t = trigramMaps[i][1]->begin(); t != trigramMaps[i][1]->end(); ++t) {
+			std::vector<uint32> &list = (*trigramMaps[i][0])[t->first];
+
+			list.reserve(list.size() + t->second.size());
+			for (std::vector<uint32>::const_iterator id = t->second.begin(); id != t->second.end(); ++id)
+				list.push_back(*id + resourceOffset);
+		}
+	}
+
+	index.clear();
+}
+
+void SearchIndex::addArchiveFiles(const std::vector<Common::UString> &paths, bool indexContents,
+                                  size_t threadCount) {
+
+	// Every archive is indexed on its own, and all of them are then appended in order
+	std::vector< std::unique_ptr<SearchIndex> > indices(paths.size());
+
+	Common::parallelFor(paths.size(), [&](size_t i, size_t UNUSED(thread)) {
+		indices[i] = std::make_unique<SearchIndex>();
+
+		std::unique_ptr<Archive> archive;
+		try {
+			archive.reset(openArchive(paths[i]));
+		} catch (Common::Exception &e) {
+			Common::printException(e, "WARNING: ");
+		} catch (...) {
+		}
+
+		const uint64 size     = Common::FilePath::getFileSize(paths[i]);
+		const uint64 modified = Common::FilePath::getModificationTime(paths[i]);
+
+		if (archive) {
+			indices[i]->addArchive(paths[i], *archive, indexContents, size, modified);
+			return;
+		}
+
+		// Remember the broken archive, so that the index still counts as current
+		indices[i]->addArchiveStamp(paths[i], size, modified);
+	}, threadCount);
+
+	for (std::vector< std::unique_ptr<SearchIndex> >::iterator i = indices.begin(); i != indices.end(); ++i)
+		append(**i);
+}
+
+bool SearchIndex::isCurrent(const std::vector<Common::UString> &paths) const {
+	if (paths != _archives)
+		return false;
+
+	// An archive rewritten in place can keep its size, so we check the modification time too
+	for (size_t i = 0; i < _archives.size(); i++)
+		if ((Common::FilePath::getFileSize(_archives[i])         != _archiveStamps[i].size) ||
+		    (Common::FilePath::getModificationTime(_archives[i]) != _archiveStamps[i].modified))
+			return false;
+
+	return true;
+}
+
+std::vector<SearchIndex::Hit> SearchIndex::find(const Common::UString &query, size_t maxHits,
+                                                const ArchiveOpener &opener) const {
+	std::vector<Hit> hits;
+
+	const std::string lowerQuery = toLowerASCII(query.c_str());
+	if (lowerQuery.empty())
+		return hits;
+
+	std::vector<uint32> nameIDs, contentIDs;
+
+	if (lowerQuery.size() >= 3) {
+		std::vector<uint32> candidates = findTrigrams(_nameTrigrams, lowerQuery);
+
+		// All trigrams matching doesn't mean they're in the right order
+		for (std::vector<uint32>::const_iterator id = candidates.begin(); id != candidates.end(); ++id)
+			if (_keys[*id].find(lowerQuery) != std::string::npos)
+				nameIDs.push_back(*id);
+
+		contentIDs = findTrigrams(_contentTrigrams, lowerQuery);
+
+	} else {
+		// Too short for trigrams, look at every name
+		for (size_t id = 0; id < _keys.size(); id++)
+			if (_keys[id].find(lowerQuery) != std::string::npos)
+				nameIDs.push_back(id);
+	}
+
+	/* All trigrams being in the contents doesn't mean the query is, and we
+	 * don't keep the contents around. So we read them again. The candidates
+	 * are sorted, so we only need to keep one archive open at a time. */
+	std::unique_ptr<Archive> archive;
+	uint32 archiveIndex = 0xFFFFFFFF;
+
+	auto containsQuery = [&](const IResource &resource) -> bool {
+		if (resource.archive != archiveIndex) {
+			archiveIndex = resource.archive;
+
+			archive.reset();
+			try {
+				const Common::UString &path = _archives[archiveIndex];
+
+				archive.reset(opener ? opener(path) : openArchive(path));
+			} catch (...) {
+			}
+		}
+
+		if (!archive)
+			return false;
+
+		try {
+			return readContents(*archive, resource.index, resource.type).find(lowerQuery) != std::string::npos;
+		} catch (...) {
+			return false;
+		}
+	};
+
+	// Merge both lists, in the order the resources were added
+	std::vector<uint32>::const_iterator n = nameIDs.begin(), c = contentIDs.begin();
+	while ((hits.size() < maxHits) && ((n != nameIDs.end()) || (c != contentIDs.end()))) {
+		bool inContents = (n == nameIDs.end()) || ((c != contentIDs.end()) && (*c < *n));
+
+		const uint32 id = inContents ? *c : *n;
+
+		if (!inContents && (c != contentIDs.end()) && (*c == *n))
+			++c;
+
+		if (inContents)
+			++c;
+		else
+			++n;
+
+		const IResource &resource = _resources[id];
+		if (inContents && !containsQuery(resource))
+			continue;
+
+		Hit hit;
+		hit.archive    = _archives[resource.archive];
+		hit.name       = resource.name;
+		hit.type       = resource.type;
+		hit.index      = resource.index;
+		hit.inContents = inContents;
+
+		hits.push_back(hit);
+	}
+
+	return hits;
+}
+
+void SearchIndex::save(Common::WriteStream &stream) const {
+	stream.writeUint32BE(kSearchIndexID);
+	stream.writeUint32BE(kVersion2);
+
+	stream.writeUint32LE(_archives.size());
+	for (size_t i = 0; i < _archives.size(); i++) {
+		writeString(stream, _archives[i]);
+		stream.writeUint64LE(_archiveStamps[i].size);
+		stream.writeUint64LE(_archiveStamps[i].modified);
+	}
+
+	stream.writeUint32LE(_resources.size());
+	for (std::vector<IResource>::const_iterator r = _resources.begin(); r != _resources.end(); ++r) {
+		stream.writeUint32LE(r->archive);
+		stream.writeUint32LE(r->index);
+		stream.writeUint32LE((uint32) r->type);
+
+		writeString(stream, r->name);
+	}
+
+	// The name trigrams are recreated on load, but we can't do that for the contents
+	stream.writeUint32LE(_contentTrigrams.size());
+	for (TrigramMap::const_iterator t = _contentTrigrams.begin(); t != _contentTrigrams.end(); ++t) {
+		stream.writeUint32LE(t->first);
+		stream.writeUint32LE(t->second.size());
+
+		for (std::vector<uint32>::const_iterator id = t->second.begin(); id != t->second.end(); ++id)
+			stream.writeUint32LE(*id);
+	}
+}
+
+void SearchIndex::load(Common::SeekableReadStream &stream) {
+	clear();
+
+	try {
+		const uint32 id      = stream.readUint32BE();
+		const uint32 version = stream.readUint32BE();
+
+		if (id != kSearchIndexID)
+			throw Common::Exception("Not a search index (%s)", Common::debugTag(id).c_str());
+		if (version != kVersion2)
+			throw Common::Exception("Unsupported search index version %s", Common::debugTag(version).c_str());
+
+		const uint32 archiveCount = stream.readUint32LE();
+		for (uint32 i = 0; i < archiveCount; i++) {
+			const Common::UString path = readString(stream);
+
+			const uint64 size     = stream.readUint64LE();
+			const uint64 modified = stream.readUint64LE();
+
+			addArchiveStamp(path, size, modified);
+		}
+
+		const uint32 resourceCount = stream.readUint32LE();
+		_resources.reserve(resourceCount);
+		_keys.reserve(resourceCount);
+
+		for (uint32 i = 0; i < resourceCount; i++) {
+			IResource resource;
+
+			resource.archive = stream.readUint32LE();
+			resource.index   = stream.readUint32LE();
+			resource.type    = (FileType) stream.readUint32LE();
+			resource.name    = readString(stream);
+
+			if (resource.archive >= _archives.size())
+				throw Common::Exception("Archive index out of range (%u/%u)",
+				                        resource.archive, (uint) _archives.size());
+
+			addResource(resource, "");
+		}
+
+		const uint32 trigramCount = stream.readUint32LE();
+		for (uint32 i = 0; i < trigramCount; i++) {
+			const uint32 trigram = stream.readUint32LE();
+			const uint32 count   = stream.readUint32LE();
+
+			if (count > _resources.size())
+				throw Common::Exception("Invalid trigram list size %u", count);
+
+			std::vector<uint32> &list = _contentTrigrams[trigram];
+
+			list.resize(count);
+			for (uint32 j = 0; j < count; j++)
+				if ((list[j] = stream.readUint32LE()) >= _resources.size())
+					throw Common::Exception("Resource index out of range (%u/%u)", list[j], (uint) _resources.size());
+		}
+
+	} catch (Common::Exception &e) {
+		clear();
+
+		e.add("Failed reading search index");
+		throw;
+	}
+}
+
+} // End of namespace Aurora
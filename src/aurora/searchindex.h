@@ -0,0 +1,172 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  An index for searching through the resources of many archives.
+ */
+
+#ifndef AURORA_SEARCHINDEX_H
+#define AURORA_SEARCHINDEX_H
+
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <functional>
+
+#include <boost/noncopyable.hpp>
+
+#include "src/common/types.h"
+#include "src/common/ustring.h"
+
+#include "src/aurora/types.h"
+
+namespace Common {
+	class SeekableReadStream;
+	class WriteStream;
+}
+
+namespace Aurora {
+
+class Archive;
+
+/** An index for searching through the resources of many archives.
+ *
+ *  For every resource, the index knows its name, its type and the path of
+ *  the archive it's in. Optionally, the contents of text-like resources
+ *  (2DA, TXT, TXI and NSS files) are indexed as well.
+ *
+ *  Searches are case-insensitive substring matches. To find them quickly,
+ *  the index keeps, for every trigram (three consecutive characters), a
+ *  list of all resources containing it. A search then only needs to look
+ *  at the resources containing all trigrams of the query. Only the trigrams
+ *  of the contents are kept, so contents that contain all trigrams are read
+ *  again from their archive, to check that they contain the query itself.
+ *
+ *  The index can be saved to and loaded from a file, so that it doesn't
+ *  need to be rebuilt every time.
+ */
+class SearchIndex : boost::noncopyable {
+public:
+	/** A resource found by a search. */
+	struct Hit {
+		Common::UString archive; ///< The path of the archive the resource is in.
+		Common::UString name;    ///< The resource's name, including the extension.
+
+		FileType type;  ///< The resource's type.
+		uint32   index; ///< The resource's index within the archive.
+
+		bool inContents; ///< Did the query match the contents rather than the name or path?
+	};
+
+	/** A function opening the archive file at this path. */
+	typedef std::function<Archive *(const Common::UString &path)> ArchiveOpener;
+
+	SearchIndex();
+	~SearchIndex();
+
+	/** Remove everything from the index. */
+	void clear();
+
+	/** Return the paths of all archives in the index. */
+	const std::vector<Common::UString> &getArchives() const;
+	/** Return the number of resources in the index. */
+	size_t getResourceCount() const;
+
+	/** Add all resources of an archive to the index.
+	 *
+	 *  @param path The path of the archive, used to find it again.
+	 *  @param archive The archive to index.
+	 *  @param indexContents Also index the contents of text-like resources?
+	 *  @param size The size of the archive file, to notice when it changes.
+	 *  @param modified The time the archive file was last modified, likewise.
+	 */
+	void addArchive(const Common::UString &path, const Archive &archive,
+	                bool indexContents = false, uint64 size = 0, uint64 modified = 0);
+
+	/** Open and add all these archive files to the index, using several threads.
+	 *
+	 *  Archive files that can't be opened are added without any resources.
+	 *  If threadCount is 0, one thread per CPU core is used.
+	 */
+	void addArchiveFiles(const std::vector<Common::UString> &paths, bool indexContents = false,
+	                     size_t threadCount = 0);
+
+	/** Is this an index of exactly these archive files, unchanged since they were added? */
+	bool isCurrent(const std::vector<Common::UString> &paths) const;
+
+	/** Find all resources whose path, name or contents contain the query.
+	 *
+	 *  Resources whose contents might contain the query are read again, from
+	 *  archives opened with the opener. Without an opener, the archive files
+	 *  are opened with openArchive(). Resources that can't be read anymore
+	 *  are only found by their name.
+	 */
+	std::vector<Hit> find(const Common::UString &query, size_t maxHits = SIZE_MAX,
+	                      const ArchiveOpener &opener = ArchiveOpener()) const;
+
+	/** Write the index into a stream. */
+	void save(Common::WriteStream &stream) const;
+	/** Replace the index with one read from a stream. */
+	void load(Common::SeekableReadStream &stream);
+
+private:
+	/** Internal resource information. */
+	struct IResource {
+		uint32   archive; ///< Index into the archive list.
+		uint32   index;   ///< Index of the resource within its archive.
+		FileType type;
+
+		Common::UString name;
+	};
+
+	/** What an archive file looked like when it was added. */
+	struct ArchiveStamp {
+		uint64 size;
+		uint64 modified;
+	};
+
+	/** For each trigram, a sorted list of all resources containing it. */
+	typedef std::unordered_map<uint32, std::vector<uint32> > TrigramMap;
+
+	std::vector<Common::UString> _archives;
+	std::vector<ArchiveStamp> _archiveStamps;
+
+	std::vector<IResource> _resources;
+
+	/** For each resource, the lowercase string the name search matches against. */
+	std::vector<std::string> _keys;
+
+	TrigramMap _nameTrigrams;
+	TrigramMap _contentTrigrams;
+
+	void addResource(const IResource &resource, const std::string &contents);
+	void addArchiveStamp(const Common::UString &path, uint64 size, uint64 modified);
+	/** Append another index to this one. */
+	void append(SearchIndex &index);
+
+	static void addTrigrams(TrigramMap &trigrams, const std::string &str, uint32 id);
+	static std::vector<uint32> findTrigrams(const TrigramMap &trigrams, const std::string &str);
+
+	static std::string readContents(const Archive &archive, uint32 index, FileType type);
+};
+
+} // End of namespace Aurora
+
+#endif // AURORA_SEARCHINDEX_H
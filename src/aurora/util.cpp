@@ -523,4 +523,27 @@ Common::UString getResourceTypeDescription(ResourceType type) {
 	return names[type];
 }
 
+bool isCompressedFileType(FileType type) {
+	switch (type) {
+		case kFileTypeBIK:
+		case kFileTypeMPG:
+		case kFileTypeWMV:
+		case kFileTypeXMV:
+		case kFileTypeOGG:
+		case kFileTypeMP3:
+		case kFileTypeWMA:
+		case kFileTypeFSB:
+		case kFileTypeJPG:
+		case kFileTypePNG:
+		case kFileTypeZIP:
+		case kFileTypeBZF:
+			return true;
+
+		default:
+			break;
+	}
+
+	return false;
+}
+
 } // End of namespace Aurora
@@ -42,6 +42,9 @@ Common::UString getPlatformDescription(Platform platform);
 /** Return the human readable description of a resource type. */
 Common::UString getResourceTypeDescription(ResourceType type);
 
+/** Is data of this file type already compressed, so that compressing it again gains next to nothing? */
+bool isCompressedFileType(FileType type);
+
 
 class FileTypeManager : public Common::Singleton<FileTypeManager> {
 public:
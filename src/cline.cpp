@@ -43,6 +43,27 @@ Job parseCommandLine(const std::vector<Common::UString> &argv) {
 			break;
 		}
 
+		// Find --render, --compact and --output, which all take a file as a parameter
+		const bool isRender  = (argv[i] == Common::UString("-r")) || (argv[i] == Common::UString("--render"));
+		const bool isCompact = (argv[i] == Common::UString("-c")) || (argv[i] == Common::UString("--compact"));
+		const bool isOutput  = (argv[i] == Common::UString("-o")) || (argv[i] == Common::UString("--output"));
+
+		if (isRender || isCompact || isOutput) {
+			if (((i + 1) >= argv.size()) || ((isRender || isCompact) && !job.path.empty()) ||
+			    (isOutput && !job.output.empty())) {
+				job.operation = kOperationInvalid;
+				break;
+			}
+
+			if (isRender || isCompact) {
+				job.operation = isRender ? kOperationRenderSound : kOperationCompactArchive;
+				job.path      = argv[++i];
+			} else
+				job.output = argv[++i];
+
+			continue;
+		}
+
 		// We only allow one path, so a second one makes the command line invalid
 		if (!job.path.empty()) {
 			job.operation = kOperationInvalid;
@@ -52,6 +73,10 @@ Job parseCommandLine(const std::vector<Common::UString> &argv) {
 		job.path = argv[i];
 	}
 
+	// An output file only makes sense when rendering
+	if (!job.output.empty() && ((job.operation == kOperationPath) || (job.operation == kOperationCompactArchive)))
+		job.operation = kOperationInvalid;
+
 	return job;
 }
 
@@ -73,7 +98,12 @@ Common::UString createHelpText(const Common::UString &name) {
 	                                Version::getProjectName());
 	text += Common::UString::format("Usage: %s [options] [<path>]\n", name.c_str());
 	text += Common::UString::format("  -h      --help              Display this text and exit.\n");
-	text += Common::UString::format("  -v      --version           Display version information and exit.");
+	text += Common::UString::format("  -v      --version           Display version information and exit.\n");
+	text += Common::UString::format("  -r      --render <file>     Decode a sound file offline, without OpenAL,\n");
+	text += Common::UString::format("                              print the throughput and exit.\n");
+	text += Common::UString::format("  -o      --output <file>     Write the rendered 16-bit PCM data into this file.\n");
+	text += Common::UString::format("  -c      --compact <file>    Remove the unused gaps left in an ERF, or in\n");
+	text += Common::UString::format("                              all BIFs indexed by a KEY, and exit.");
 
 	return text;
 }
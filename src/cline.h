@@ -31,16 +31,19 @@
 
 /** Type for all operations this tool can do. */
 enum Operation {
-	kOperationInvalid = 0, ///< Invalid command line.
-	kOperationHelp       , ///< Show the help text.
-	kOperationVersion    , ///< Show version information.
-	kOperationPath         ///< Crawl through a game directory.
+	kOperationInvalid = 0,   ///< Invalid command line.
+	kOperationHelp       ,   ///< Show the help text.
+	kOperationVersion    ,   ///< Show version information.
+	kOperationPath       ,   ///< Crawl through a game directory.
+	kOperationRenderSound,   ///< Render a sound file offline.
+	kOperationCompactArchive ///< Remove the unused gaps from an archive patched in place.
 };
 
 /** Full description of the job this tool will be doing. */
 struct Job {
-	Operation operation;  ///< The operation to perform.
-	Common::UString path; ///< The game directory to look through.
+	Operation operation;    ///< The operation to perform.
+	Common::UString path;   ///< The game directory to look through, the sound file to render or the archive to compact.
+	Common::UString output; ///< The file to write rendered sound data into.
 
 	Job() : operation(kOperationInvalid) {
 	}
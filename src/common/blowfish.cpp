@@ -23,6 +23,7 @@
  */
 
 #include <cassert>
+#include <cstring>
 
 #include <memory>
 
@@ -336,36 +337,125 @@ static void blowfishECB(BlowfishContext &ctx, Mode mode, const byte *input, byte
 }
 // '--- Blowfish, based on the implementation from mbed TLS ---'
 
-MemoryReadStream *blowfishEBC(SeekableReadStream &input, const std::vector<byte> &key, Mode mode) {
-	BlowfishContext ctx;
+/* In EBC mode, the blocks don't depend on each other. So we process several
+ * blocks at once, round by round, interleaving their S-box lookups. */
+
+static const size_t kInterleave = 4;
+
+static void blowfishEnc(BlowfishContext &ctx, uint32 (&xl)[kInterleave], uint32 (&xr)[kInterleave]) {
+	for (size_t i = 0; i < kRoundCount; i++) {
+		for (size_t j = 0; j < kInterleave; j++) {
+			xl[j] = xl[j] ^ ctx.P[i];
+			xr[j] = F(ctx, xl[j]) ^ xr[j];
+
+			SWAP(xl[j], xr[j]);
+		}
+	}
+
+	for (size_t j = 0; j < kInterleave; j++) {
+		SWAP(xl[j], xr[j]);
+
+		xr[j] = xr[j] ^ ctx.P[kRoundCount];
+		xl[j] = xl[j] ^ ctx.P[kRoundCount + 1];
+	}
+}
+
+static void blowfishDec(BlowfishContext &ctx, uint32 (&xl)[kInterleave], uint32 (&xr)[kInterleave]) {
+	for (size_t i = kRoundCount + 1; i > 1; i--) {
+		for (size_t j = 0; j < kInterleave; j++) {
+			xl[j] = xl[j] ^ ctx.P[i];
+			xr[j] = F(ctx, xl[j]) ^ xr[j];
+
+			SWAP(xl[j], xr[j]);
+		}
+	}
+
+	for (size_t j = 0; j < kInterleave; j++) {
+		SWAP(xl[j], xr[j]);
+
+		xr[j] = xr[j] ^ ctx.P[1];
+		xl[j] = xl[j] ^ ctx.P[0];
+	}
+}
+
+static void blowfishECB(BlowfishContext &ctx, Mode mode, byte *data, size_t size) {
+	if ((size % kBlockSize) != 0)
+		throw Exception("Blowfish operates on blocks of 8 bytes (%u)", (uint) size);
+
+	byte * const end = data + size;
+
+	for (; (end - data) >= (ptrdiff_t)(kInterleave * kBlockSize); data += kInterleave * kBlockSize) {
+		uint32 X0[kInterleave], X1[kInterleave];
 
-	blowfishSetKey(ctx, &key[0], key.size());
+		for (size_t j = 0; j < kInterleave; j++) {
+			X0[j] = READ_BE_UINT32(data + j * kBlockSize);
+			X1[j] = READ_BE_UINT32(data + j * kBlockSize + 4);
+		}
+
+		switch (mode) {
+			case kModeDecrypt:
+				blowfishDec(ctx, X0, X1);
+				break;
+			case kModeEncrypt:
+				blowfishEnc(ctx, X0, X1);
+				break;
+
+			default:
+				assert(false);
+		}
+
+		for (size_t j = 0; j < kInterleave; j++) {
+			WRITE_BE_UINT32(data + j * kBlockSize    , X0[j]);
+			WRITE_BE_UINT32(data + j * kBlockSize + 4, X1[j]);
+		}
+	}
+
+	// The remaining few blocks
+	for (; data < end; data += kBlockSize)
+		blowfishECB(ctx, mode, data, data);
+}
 
-	size_t inputSize = input.size() - input.pos();
+MemoryReadStream *blowfishEBC(SeekableReadStream &input, const Blowfish &blowfish, Mode mode) {
+	const size_t inputSize = input.size() - input.pos();
 
 	// Round up to the next multiple of the block size
 	const size_t outputSize = ((inputSize + kBlockSize - 1) / kBlockSize) * kBlockSize;
 
 	std::unique_ptr<byte[]> output = std::make_unique<byte[]>(outputSize);
 
-	byte buffer[kBlockSize];
-	byte *data = output.get();
-	while (inputSize > 0) {
-		const size_t toRead = MIN<size_t>(inputSize, kBlockSize);
+	if (input.read(output.get(), inputSize) != inputSize)
+		throw Exception(kReadError);
 
-		if (input.read(buffer, toRead) != toRead)
-			throw Exception(kReadError);
+	std::memset(output.get() + inputSize, 0, outputSize - inputSize);
 
-		if (toRead < kBlockSize)
-			std::memset(buffer + toRead, 0, kBlockSize - toRead);
+	if (mode == kModeEncrypt)
+		blowfish.encrypt(output.get(), outputSize);
+	else
+		blowfish.decrypt(output.get(), outputSize);
 
-		blowfishECB(ctx, mode, buffer, data);
+	return new MemoryReadStream(output.release(), outputSize, true);
+}
 
-		data      += toRead;
-		inputSize -= toRead;
-	}
+MemoryReadStream *blowfishEBC(SeekableReadStream &input, const std::vector<byte> &key, Mode mode) {
+	const Blowfish blowfish(key);
 
-	return new MemoryReadStream(output.release(), outputSize, true);
+	return blowfishEBC(input, blowfish, mode);
+}
+
+
+Blowfish::Blowfish(const std::vector<byte> &key) : _context(std::make_unique<BlowfishContext>()) {
+	blowfishSetKey(*_context, key.data(), key.size());
+}
+
+Blowfish::~Blowfish() {
+}
+
+void Blowfish::encrypt(byte *data, size_t size) const {
+	blowfishECB(*_context, kModeEncrypt, data, size);
+}
+
+void Blowfish::decrypt(byte *data, size_t size) const {
+	blowfishECB(*_context, kModeDecrypt, data, size);
 }
 
 MemoryReadStream *encryptBlowfishEBC(SeekableReadStream &input, const std::vector<byte> &key) {
@@ -26,6 +26,9 @@
 #define COMMON_BLOWFISH_H
 
 #include <vector>
+#include <memory>
+
+#include <boost/noncopyable.hpp>
 
 #include "src/common/types.h"
 
@@ -34,6 +37,35 @@ namespace Common {
 class SeekableReadStream;
 class MemoryReadStream;
 
+struct BlowfishContext;
+
+/** A Blowfish cipher with a fixed key, working in EBC mode.
+ *
+ *  Setting up the key is expensive: it runs the cipher 521 times. When a lot
+ *  of data is processed with the same key, for example all the resources of
+ *  an encrypted archive, a Blowfish object should be kept around instead of
+ *  using the stream functions below.
+ */
+class Blowfish : boost::noncopyable {
+public:
+	static const size_t kBlockSize = 8;
+
+	Blowfish(const std::vector<byte> &key);
+	~Blowfish();
+
+	/** Encrypt data in place. The size has to be a multiple of the block size.
+	 *
+	 *  Since blocks in EBC mode are independent of each other, large buffers
+	 *  are processed several blocks at a time, so pass as much data as possible.
+	 */
+	void encrypt(byte *data, size_t size) const;
+	/** Decrypt data in place. The size has to be a multiple of the block size. */
+	void decrypt(byte *data, size_t size) const;
+
+private:
+	std::unique_ptr<BlowfishContext> _context;
+};
+
 /** Encrypt the stream with the Blowfish algorithm in EBC mode. */
 MemoryReadStream *encryptBlowfishEBC(SeekableReadStream &input, const std::vector<byte> &key);
 /** Decrypt the stream with the Blowfish algorithm in EBC mode. */
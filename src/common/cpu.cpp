@@ -0,0 +1,107 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Runtime detection of CPU features, for picking SIMD code paths.
+ */
+
+#include <cassert>
+
+#include <atomic>
+
+#include "src/common/cpu.h"
+
+#if defined(_MSC_VER) && defined(PHAETHON_SIMD_X86)
+	#include <intrin.h>
+	#include <immintrin.h>
+#endif
+
+namespace Common {
+
+static std::atomic<bool> _cpuFeatureEnabled[kCPUFeatureMAX] = { {true}, {true}, {true} };
+
+static bool detectCPUFeature(CPUFeature feature) {
+#if defined(__GNUC__) && defined(PHAETHON_SIMD_X86)
+
+	__builtin_cpu_init();
+
+	switch (feature) {
+		case kCPUFeatureSSE2:
+			return __builtin_cpu_supports("sse2");
+
+		case kCPUFeatureSSSE3:
+			return __builtin_cpu_supports("ssse3");
+
+		case kCPUFeatureAVX:
+			return __builtin_cpu_supports("avx");
+
+		default:
+			break;
+	}
+
+#elif defined(_MSC_VER) && defined(PHAETHON_SIMD_X86)
+
+	int info[4];
+	__cpuid(info, 1);
+
+	switch (feature) {
+		case kCPUFeatureSSE2:
+			return (info[3] & (1 << 26)) != 0;
+
+		case kCPUFeatureSSSE3:
+			return (info[2] & (1 << 9)) != 0;
+
+		case kCPUFeatureAVX:
+			// The CPU needs to support AVX, and the OS needs to save the YMM registers
+			if (!(info[2] & (1 << 28)) || !(info[2] & (1 << 27)))
+				return false;
+
+			return (_xgetbv(0) & 6) == 6;
+
+		default:
+			break;
+	}
+
+#else
+	(void) feature;
+#endif
+
+	return false;
+}
+
+bool hasCPUFeature(CPUFeature feature) {
+	assert((feature >= 0) && (feature < kCPUFeatureMAX));
+
+	static const bool kSupported[kCPUFeatureMAX] = {
+		detectCPUFeature(kCPUFeatureSSE2),
+		detectCPUFeature(kCPUFeatureSSSE3),
+		detectCPUFeature(kCPUFeatureAVX)
+	};
+
+	return kSupported[feature] && _cpuFeatureEnabled[feature].load(std::memory_order_relaxed);
+}
+
+void setCPUFeatureEnabled(CPUFeature feature, bool enabled) {
+	assert((feature >= 0) && (feature < kCPUFeatureMAX));
+
+	_cpuFeatureEnabled[feature].store(enabled, std::memory_order_relaxed);
+}
+
+} // End of namespace Common
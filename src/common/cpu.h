@@ -0,0 +1,74 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Runtime detection of CPU features, for picking SIMD code paths.
+ */
+
+#ifndef COMMON_CPU_H
+#define COMMON_CPU_H
+
+/* PHAETHON_SIMD_X86 is defined if we can compile x86 SIMD intrinsics. Functions
+ * using them need to be marked with PHAETHON_TARGET_SSE2, PHAETHON_TARGET_SSSE3 or
+ * PHAETHON_TARGET_AVX, so that they can be compiled without enabling these
+ * instruction sets globally.
+ * They must only be called after hasCPUFeature() confirmed the CPU supports them.
+ */
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+	#define PHAETHON_SIMD_X86 1
+
+	#define PHAETHON_TARGET_SSE2  __attribute__((target("sse2")))
+	#define PHAETHON_TARGET_SSSE3 __attribute__((target("ssse3")))
+	#define PHAETHON_TARGET_AVX   __attribute__((target("avx")))
+#elif defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+	#define PHAETHON_SIMD_X86 1
+
+	#define PHAETHON_TARGET_SSE2
+	#define PHAETHON_TARGET_SSSE3
+	#define PHAETHON_TARGET_AVX
+#endif
+
+namespace Common {
+
+/** CPU features we have specialized code paths for. */
+enum CPUFeature {
+	kCPUFeatureSSE2 = 0, ///< x86 Streaming SIMD Extensions 2.
+	kCPUFeatureSSSE3   , ///< x86 Supplemental Streaming SIMD Extensions 3.
+	kCPUFeatureAVX     , ///< x86 Advanced Vector Extensions.
+
+	kCPUFeatureMAX
+};
+
+/** Does the CPU we're running on support this feature, and is its use enabled? */
+bool hasCPUFeature(CPUFeature feature);
+
+/** Enable or disable the use of a CPU feature.
+ *
+ *  Disabling a feature makes objects created afterwards fall back to the
+ *  generic code paths. This is useful to compare the SIMD code against the
+ *  generic implementation, for testing and benchmarking.
+ *
+ *  Enabling a feature the CPU does not support has no effect.
+ */
+void setCPUFeatureEnabled(CPUFeature feature, bool enabled);
+
+} // End of namespace Common
+
+#endif // COMMON_CPU_H
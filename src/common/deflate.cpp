@@ -22,10 +22,16 @@
  *  Compress (deflate) and decompress (inflate) using zlib's DEFLATE algorithm.
  */
 
+#include "src/common/system.h"
+
 #include <memory>
 
 #include <zlib.h>
 
+#if defined(ENABLE_LIBDEFLATE)
+	#include <libdeflate.h>
+#endif
+
 #include <boost/scope_exit.hpp>
 
 #include "src/common/deflate.h"
@@ -61,11 +67,70 @@ static void initZStream(z_stream &strm, int windowBits, size_t size, const byte
 		throw Exception("Could not initialize zlib inflate: %s (%d)", zError(zResult), zResult);
 }
 
+#if defined(ENABLE_LIBDEFLATE)
+/** Decompress with libdeflate, which decodes whole buffers a lot faster than zlib.
+ *
+ *  Returns false if libdeflate can't handle this kind of stream, and zlib needs
+ *  to be used instead.
+ */
+static bool decompressLibDeflate(const byte *data, size_t inputSize,
+                                 byte *output, size_t outputSize, int windowBits) {
+
+	// libdeflate doesn't do zlib's automatic header detection
+	if (windowBits > 31)
+		return false;
+
+	libdeflate_decompressor *decompressor = libdeflate_alloc_decompressor();
+	if (!decompressor)
+		return false;
+
+	BOOST_SCOPE_EXIT( (&decompressor) ) {
+			libdeflate_free_decompressor(decompressor);
+	} BOOST_SCOPE_EXIT_END
+
+	/* Negative window bits is raw DEFLATE, more than 15 is a gzip stream,
+	 * and anything else is a zlib stream. libdeflate always uses the full
+	 * window, which decodes streams made with a smaller one just fine.
+	 *
+	 * Since we don't ask for the actual output size, libdeflate fails if
+	 * the output isn't exactly as large as we expect. */
+
+	libdeflate_result result;
+	if (windowBits < 0)
+		result = libdeflate_deflate_decompress(decompressor, data, inputSize, output, outputSize, 0);
+	else if (windowBits > 15)
+		result = libdeflate_gzip_decompress(decompressor, data, inputSize, output, outputSize, 0);
+	else
+		result = libdeflate_zlib_decompress(decompressor, data, inputSize, output, outputSize, 0);
+
+	switch (result) {
+		case LIBDEFLATE_SUCCESS:
+			return true;
+
+		case LIBDEFLATE_SHORT_OUTPUT:
+			throw Exception("Failed to inflate: output buffer not completely filled");
+
+		case LIBDEFLATE_INSUFFICIENT_SPACE:
+			throw Exception("Failed to inflate: premature end of output buffer");
+
+		default:
+			break;
+	}
+
+	throw Exception("Failed to inflate: invalid or incomplete DEFLATE data (%d)", (int) result);
+}
+#endif
+
 byte *decompressDeflate(const byte *data, size_t inputSize,
                         size_t outputSize, int windowBits) {
 
 	std::unique_ptr<byte[]> decompressedData = std::make_unique<byte[]>(outputSize);
 
+#if defined(ENABLE_LIBDEFLATE)
+	if (decompressLibDeflate(data, inputSize, decompressedData.get(), outputSize, windowBits))
+		return decompressedData.release();
+#endif
+
 	z_stream strm;
 	BOOST_SCOPE_EXIT( (&strm) ) {
 			inflateEnd(&strm);
@@ -204,4 +269,139 @@ size_t decompressDeflateChunk(SeekableReadStream &input, int windowBits,
 	return strm.total_out;
 }
 
+
+#if defined(ENABLE_LIBDEFLATE)
+/** Compress with libdeflate, which is both faster and tighter than zlib.
+ *
+ *  Returns 0 if libdeflate can't produce this kind of stream, and zlib needs
+ *  to be used instead.
+ */
+static byte *compressLibDeflate(const byte *data, size_t inputSize, size_t &outputSize,
+                                int windowBits, int level) {
+
+	// libdeflate always uses the full window. A stream made with it might
+	// not be decodable with the smaller window the reader expects
+	if ((windowBits != kWindowBitsMax) && (windowBits != kWindowBitsMaxRaw))
+		return 0;
+
+	// Older libdeflate versions can't just store
+	if (level == kCompressionLevelNone)
+		return 0;
+
+	if (level == kCompressionLevelDefault)
+		level = 6;
+
+	libdeflate_compressor *compressor = libdeflate_alloc_compressor(level);
+	if (!compressor)
+		return 0;
+
+	BOOST_SCOPE_EXIT( (&compressor) ) {
+			libdeflate_free_compressor(compressor);
+	} BOOST_SCOPE_EXIT_END
+
+	const size_t bound = (windowBits < 0) ?
+		libdeflate_deflate_compress_bound(compressor, inputSize) :
+		libdeflate_zlib_compress_bound   (compressor, inputSize);
+
+	std::unique_ptr<byte[]> compressedData = std::make_unique<byte[]>(bound);
+
+	outputSize = (windowBits < 0) ?
+		libdeflate_deflate_compress(compressor, data, inputSize, compressedData.get(), bound) :
+		libdeflate_zlib_compress   (compressor, data, inputSize, compressedData.get(), bound);
+
+	if (outputSize == 0)
+		throw Exception("Failed to deflate: premature end of output buffer");
+
+	return compressedData.release();
+}
+#endif
+
+byte *compressDeflate(const byte *data, size_t inputSize, size_t &outputSize,
+                      int windowBits, int level) {
+
+#if defined(ENABLE_LIBDEFLATE)
+	byte *libDeflateData = compressLibDeflate(data, inputSize, outputSize, windowBits, level);
+	if (libDeflateData)
+		return libDeflateData;
+#endif
+
+	if (inputSize > 0xFFFFFFFF)
+		throw Exception("Failed to deflate: input too large");
+
+	z_stream strm;
+	strm.zalloc = Z_NULL;
+	strm.zfree  = Z_NULL;
+	strm.opaque = Z_NULL;
+
+	int zResult = deflateInit2(&strm, level, Z_DEFLATED, windowBits, 8, Z_DEFAULT_STRATEGY);
+	if (zResult != Z_OK)
+		throw Exception("Could not initialize zlib deflate: %s (%d)", zError(zResult), zResult);
+
+	BOOST_SCOPE_EXIT( (&strm) ) {
+			deflateEnd(&strm);
+	} BOOST_SCOPE_EXIT_END
+
+	// deflateBound() gives us a buffer size that's guaranteed to fit everything
+	const size_t bound = deflateBound(&strm, inputSize);
+	std::unique_ptr<byte[]> compressedData = std::make_unique<byte[]>(bound);
+
+	setZStreamInput(strm, inputSize, data);
+
+	strm.avail_out = bound;
+	strm.next_out  = compressedData.get();
+
+	zResult = deflate(&strm, Z_FINISH);
+	if (zResult != Z_STREAM_END)
+		throw Exception("Failed to deflate: %s (%d)", zError(zResult), zResult);
+
+	outputSize = strm.total_out;
+	return compressedData.release();
+}
+
+BlockInflater::BlockInflater(int windowBits, byte *output, size_t outputSize) :
+	_strm(std::make_unique<z_stream>()), _ended(false) {
+
+	initZStream(*_strm, windowBits, 0, 0);
+
+	_strm->avail_out = outputSize;
+	_strm->next_out  = output;
+}
+
+BlockInflater::~BlockInflater() {
+	inflateEnd(_strm.get());
+}
+
+bool BlockInflater::inflate(const byte *data, size_t size) {
+	if (_ended)
+		return true;
+
+	setZStreamInput(*_strm, size, data);
+
+	// Decompress. Z_SYNC_FLUSH, because we want to decompress partwise.
+	const int zResult = ::inflate(_strm.get(), Z_SYNC_FLUSH);
+
+	if (zResult == Z_STREAM_END) {
+		_ended = true;
+		return true;
+	}
+
+	// Z_BUF_ERROR just means no progress was possible; finish() catches the reason
+	if ((zResult != Z_OK) && (zResult != Z_BUF_ERROR))
+		throw Exception("Failed to inflate: %s (%d)", zError(zResult), zResult);
+
+	return false;
+}
+
+void BlockInflater::finish() const {
+	if (!_ended) {
+		if (_strm->avail_out == 0)
+			throw Exception("Failed to inflate: premature end of output buffer");
+
+		throw Exception("Failed to inflate: premature end of input");
+	}
+
+	if (_strm->avail_out != 0)
+		throw Exception("Failed to inflate: output buffer not completely filled");
+}
+
 } // End of namespace Common
@@ -25,12 +25,17 @@
 #ifndef COMMON_DEFLATE_H
 #define COMMON_DEFLATE_H
 
+#include <memory>
+
+#include <boost/noncopyable.hpp>
+
 #include "src/common/types.h"
 
+struct z_stream_s;
+
 namespace Common {
 
 /* TODO (should be need it):
- * - Compression
  * - Decompress dynamically, without needing to know the size
  *   of the decompressed data beforehand
  */
@@ -41,7 +46,13 @@ class SeekableReadStream;
 static const int kWindowBitsMax    =  15;
 static const int kWindowBitsMaxRaw = -kWindowBitsMax;
 
+static const int kCompressionLevelNone    =  0; ///< Only store the data in uncompressed blocks.
+static const int kCompressionLevelDefault = -1; ///< zlib's default trade-off between speed and size.
+static const int kCompressionLevelBest    =  9; ///< The smallest output zlib can produce.
+
 /** Decompress (inflate) using zlib's DEFLATE algorithm.
+ *
+ *  If Phaethon was built with libdeflate, it is used instead of zlib here.
  *
  *  @param  data       The compressed input data.
  *  @param  inputSize  The size of the input data in bytes.
@@ -117,6 +128,64 @@ SeekableReadStream *decompressDeflateWithoutOutputSize(ReadStream &input, size_t
 size_t decompressDeflateChunk(SeekableReadStream &input, int windowBits, byte *output, size_t outputSize,
                               unsigned int frameSize = 4096);
 
+/** Compress (deflate) using zlib's DEFLATE algorithm.
+ *
+ *  If Phaethon was built with libdeflate, it is used instead of zlib where
+ *  it can produce the same kind of stream.
+ *
+ *  @param  data       The input data.
+ *  @param  inputSize  The size of the input data in bytes.
+ *  @param  outputSize The size of the compressed output data is stored here.
+ *  @param windowBits  The base two logarithm of the window size (the size of
+ *                     the history buffer). Negative for a raw DEFLATE stream
+ *                     without zlib header. See the zlib documentation on
+ *                     deflateInit2() for details.
+ *  @param level       The compression level, from kCompressionLevelNone to
+ *                     kCompressionLevelBest, or kCompressionLevelDefault.
+ *  @return The compressed data.
+ */
+byte *compressDeflate(const byte *data, size_t inputSize, size_t &outputSize,
+                      int windowBits, int level = kCompressionLevelDefault);
+
+/** Decompress (inflate) using zlib's DEFLATE algorithm, with the input given in blocks.
+ *
+ *  This is meant for compressed data that needs to be processed (for example,
+ *  decrypted) before it can be decompressed. Each block can be given to the
+ *  inflater right after processing it, without collecting the whole input
+ *  into another buffer first.
+ *
+ *  Like decompressDeflate(), it is assumed that the size of the decompressed
+ *  data is known beforehand.
+ */
+class BlockInflater : boost::noncopyable {
+public:
+	/** Create an inflater.
+	 *
+	 *  @param windowBits  The base two logarithm of the window size (the size of
+	 *                     the history buffer). See the zlib documentation on
+	 *                     inflateInit2() for details.
+	 *  @param output      The buffer to decompress into. It has to stay valid
+	 *                     while the inflater is used.
+	 *  @param outputSize  The size of the decompressed output data.
+	 */
+	BlockInflater(int windowBits, byte *output, size_t outputSize);
+	~BlockInflater();
+
+	/** Decompress the next block of compressed input.
+	 *
+	 *  @return true if the end of the compressed stream has been reached.
+	 */
+	bool inflate(const byte *data, size_t size);
+
+	/** Make sure the compressed stream ended, and the output buffer was filled completely. */
+	void finish() const;
+
+private:
+	std::unique_ptr<z_stream_s> _strm;
+
+	bool _ended;
+};
+
 } // End of namespace Common
 
 #endif // COMMON_DEFLATE_H
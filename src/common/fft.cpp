@@ -56,11 +56,16 @@
 #include "src/common/maths.h"
 #include "src/common/cosinetables.h"
 #include "src/common/util.h"
+#include "src/common/cpu.h"
 #include "src/common/fft.h"
 
+#ifdef PHAETHON_SIMD_X86
+	#include <emmintrin.h>
+#endif
+
 namespace Common {
 
-FFT::FFT(int bits, bool inverse) : _bits(bits), _inverse(inverse) {
+FFT::FFT(int bits, bool inverse) : _bits(bits), _inverse(inverse), _simd(false) {
 	assert((_bits >= 2) && (_bits <= 16));
 
 	int n = 1 << bits;
@@ -71,6 +76,8 @@ FFT::FFT(int bits, bool inverse) : _bits(bits), _inverse(inverse) {
 
 	for (int i = 0; i < n; i++)
 		_revTab[-splitRadixPermutation(i, n, _inverse) & (n - 1)] = i;
+
+	_simd = hasCPUFeature(kCPUFeatureSSE2);
 }
 
 FFT::~FFT() {
@@ -199,6 +206,98 @@ static void fft##n(Complex *z)\
 	pass(z,getCosineTable(t),n4/2);\
 }
 
+#ifdef PHAETHON_SIMD_X86
+
+/** Load 4 complex numbers, split into their real and imaginary parts. */
+PHAETHON_TARGET_SSE2 static inline void loadComplexSSE2(const Complex *z, __m128 &re, __m128 &im) {
+	const __m128 lo = _mm_loadu_ps(&z[0].re);
+	const __m128 hi = _mm_loadu_ps(&z[2].re);
+
+	re = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0));
+	im = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1));
+}
+
+/** Interleave real and imaginary parts of 4 complex numbers, and store them. */
+PHAETHON_TARGET_SSE2 static inline void storeComplexSSE2(Complex *z, __m128 re, __m128 im) {
+	_mm_storeu_ps(&z[0].re, _mm_unpacklo_ps(re, im));
+	_mm_storeu_ps(&z[2].re, _mm_unpackhi_ps(re, im));
+}
+
+/** The same pass as above, 4 butterflies at a time.
+ *
+ *  Only the first 4 butterflies are done in scalar code, to keep the special
+ *  zero-twiddle case. All operations happen in the same order as in the scalar
+ *  TRANSFORM() macro, so the results are bit-identical.
+ */
+PHAETHON_TARGET_SSE2 static void pass_sse2(Complex *z, const float *wre, unsigned int n)
+{
+	float t1, t2, t3, t4, t5, t6;
+	const int o1 = 2*n;
+	const int o2 = 4*n;
+	const int o3 = 6*n;
+	const float *wim = wre+o1;
+
+	TRANSFORM_ZERO(z[0],z[o1],z[o2],z[o3]);
+	TRANSFORM(z[1],z[o1+1],z[o2+1],z[o3+1],wre[1],wim[-1]);
+	TRANSFORM(z[2],z[o1+2],z[o2+2],z[o3+2],wre[2],wim[-2]);
+	TRANSFORM(z[3],z[o1+3],z[o2+3],z[o3+3],wre[3],wim[-3]);
+
+	for (int k = 4; k < o1; k += 4) {
+		__m128 r0, i0, r1, i1, r2, i2, r3, i3;
+
+		loadComplexSSE2(z + k     , r0, i0);
+		loadComplexSSE2(z + k + o1, r1, i1);
+		loadComplexSSE2(z + k + o2, r2, i2);
+		loadComplexSSE2(z + k + o3, r3, i3);
+
+		const __m128 wr = _mm_loadu_ps(wre + k);
+
+		__m128 wi = _mm_loadu_ps(wim - k - 3);
+		wi = _mm_shuffle_ps(wi, wi, _MM_SHUFFLE(0, 1, 2, 3));
+
+		// TRANSFORM
+		const __m128 v1 = _mm_add_ps(_mm_mul_ps(r2, wr), _mm_mul_ps(i2, wi));
+		const __m128 v2 = _mm_sub_ps(_mm_mul_ps(i2, wr), _mm_mul_ps(r2, wi));
+		      __m128 v5 = _mm_sub_ps(_mm_mul_ps(r3, wr), _mm_mul_ps(i3, wi));
+		      __m128 v6 = _mm_add_ps(_mm_mul_ps(i3, wr), _mm_mul_ps(r3, wi));
+
+		// BUTTERFLIES
+		const __m128 v3 = _mm_sub_ps(v5, v1);
+		v5 = _mm_add_ps(v5, v1);
+
+		r2 = _mm_sub_ps(r0, v5);
+		r0 = _mm_add_ps(r0, v5);
+
+		i3 = _mm_sub_ps(i1, v3);
+		i1 = _mm_add_ps(i1, v3);
+
+		const __m128 v4 = _mm_sub_ps(v2, v6);
+		v6 = _mm_add_ps(v2, v6);
+
+		r3 = _mm_sub_ps(r1, v4);
+		r1 = _mm_add_ps(r1, v4);
+
+		i2 = _mm_sub_ps(i0, v6);
+		i0 = _mm_add_ps(i0, v6);
+
+		storeComplexSSE2(z + k     , r0, i0);
+		storeComplexSSE2(z + k + o1, r1, i1);
+		storeComplexSSE2(z + k + o2, r2, i2);
+		storeComplexSSE2(z + k + o3, r3, i3);
+	}
+}
+
+#define DECL_FFT_SSE2(t,n,n2,n4)\
+PHAETHON_TARGET_SSE2 static void fft##n##_sse2(Complex *z)\
+{\
+	fft##n2##_sse2(z);\
+	fft##n4##_sse2(z+n4*2);\
+	fft##n4##_sse2(z+n4*3);\
+	pass_sse2(z,getCosineTable(t),n4/2);\
+}
+
+#endif // PHAETHON_SIMD_X86
+
 static void fft4(Complex *z)
 {
 	float t1, t2, t3, t4, t5, t6, t7, t8;
@@ -268,7 +367,41 @@ static void (* const fft_dispatch[])(Complex*) = {
 	fft2048, fft4096, fft8192, fft16384, fft32768, fft65536,
 };
 
+#ifdef PHAETHON_SIMD_X86
+
+// The smaller transforms have no SIMD version
+#define fft4_sse2  fft4
+#define fft8_sse2  fft8
+#define fft16_sse2 fft16
+
+DECL_FFT_SSE2(5, 32,16,8)
+DECL_FFT_SSE2(6, 64,32,16)
+DECL_FFT_SSE2(7, 128,64,32)
+DECL_FFT_SSE2(8, 256,128,64)
+DECL_FFT_SSE2(9, 512,256,128)
+DECL_FFT_SSE2(10, 1024,512,256)
+DECL_FFT_SSE2(11, 2048,1024,512)
+DECL_FFT_SSE2(12, 4096,2048,1024)
+DECL_FFT_SSE2(13, 8192,4096,2048)
+DECL_FFT_SSE2(14, 16384,8192,4096)
+DECL_FFT_SSE2(15, 32768,16384,8192)
+DECL_FFT_SSE2(16, 65536,32768,16384)
+
+static void (* const fft_dispatch_sse2[])(Complex*) = {
+	fft4_sse2, fft8_sse2, fft16_sse2, fft32_sse2, fft64_sse2, fft128_sse2, fft256_sse2, fft512_sse2, fft1024_sse2,
+	fft2048_sse2, fft4096_sse2, fft8192_sse2, fft16384_sse2, fft32768_sse2, fft65536_sse2,
+};
+
+#endif // PHAETHON_SIMD_X86
+
 void FFT::calc(Complex *z) {
+#ifdef PHAETHON_SIMD_X86
+	if (_simd) {
+		fft_dispatch_sse2[_bits - 2](z);
+		return;
+	}
+#endif
+
 	fft_dispatch[_bits - 2](z);
 }
 
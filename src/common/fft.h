@@ -84,6 +84,7 @@ public:
 private:
 	int  _bits;
 	bool _inverse;
+	bool _simd; ///< Use the SSE2 transform passes?
 
 	std::unique_ptr<uint16[]> _revTab;
 
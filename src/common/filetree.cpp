@@ -28,14 +28,23 @@
 
 namespace Common {
 
-FileTree::Entry::Entry() {
+FileTree::Entry::Entry() : directory(false), size(kFileInvalid) {
 }
 
-FileTree::Entry::Entry(const boost::filesystem::path &p) : name(p.filename().generic_string()), path(p) {
+FileTree::Entry::Entry(const boost::filesystem::path &p) : name(p.filename().generic_string()), path(p),
+	directory(boost::filesystem::is_directory(p)), size(kFileInvalid) {
+
+	if (!directory)
+		size = FilePath::getFileSize(p.generic_string().c_str());
+}
+
+FileTree::Entry::Entry(const boost::filesystem::path &p, bool isDirectory, size_t fileSize) :
+	name(p.filename().generic_string()), path(p), directory(isDirectory), size(fileSize) {
+
 }
 
 bool FileTree::Entry::isDirectory() const {
-	return boost::filesystem::is_directory(path);
+	return directory;
 }
 
 
@@ -49,6 +58,9 @@ void FileTree::clear() {
 	_root.name.clear();
 	_root.path.clear();
 	_root.children.clear();
+
+	_root.directory = false;
+	_root.size      = kFileInvalid;
 }
 
 bool FileTree::isEmpty() const {
@@ -72,8 +84,7 @@ void FileTree::readPath(boost::filesystem::path path, int recurseDepth) {
 
 	path = FilePath::normalize(path.generic_string().c_str()).c_str();
 
-	_root.name = path.filename().generic_string();
-	_root.path = path;
+	_root = Entry(path);
 
 	// If we can't or shouldn't recurse, we're done
 	if (boost::filesystem::is_regular_file(path) || (recurseDepth == 0))
@@ -82,16 +93,112 @@ void FileTree::readPath(boost::filesystem::path path, int recurseDepth) {
 	addPath(_root, path, (recurseDepth == -1) ? -1 : (recurseDepth - 1));
 }
 
+const FileTree::Entry *FileTree::findEntry(const boost::filesystem::path &path) const {
+	return const_cast<FileTree *>(this)->getEntry(path);
+}
+
+FileTree::Entry *FileTree::getEntry(const boost::filesystem::path &path) {
+	if (isEmpty())
+		return 0;
+
+	// The path has to start with the root path
+	boost::filesystem::path::const_iterator p = path.begin();
+	for (boost::filesystem::path::const_iterator r = _root.path.begin(); r != _root.path.end(); ++r, ++p)
+		if ((p == path.end()) || (*p != *r))
+			return 0;
+
+	// Walk down the tree, one path component at a time
+	Entry *entry = &_root;
+	for (; p != path.end(); ++p) {
+		if ((*p == ".") || p->empty())
+			continue;
+
+		const UString name = p->generic_string();
+
+		std::list<Entry>::iterator child = entry->children.begin();
+		while ((child != entry->children.end()) && (child->name != name))
+			++child;
+
+		if (child == entry->children.end())
+			return 0;
+
+		entry = &*child;
+	}
+
+	return entry;
+}
+
+const FileTree::Entry *FileTree::addEntry(const boost::filesystem::path &path) {
+	Entry *existing = getEntry(path);
+	if (existing && existing->isDirectory()) {
+		// A directory was moved over this one, so read what's within it again
+		existing->children.clear();
+		addPath(*existing, path, -1);
+
+		return existing;
+	}
+
+	if (existing)
+		return updateEntry(path);
+
+	Entry *parent = getEntry(path.parent_path());
+	if (!parent || !parent->isDirectory() || !boost::filesystem::exists(path))
+		return 0;
+
+	parent->children.push_back(Entry(path));
+
+	Entry &entry = parent->children.back();
+	if (entry.isDirectory())
+		addPath(entry, path, -1);
+
+	return &entry;
+}
+
+bool FileTree::removeEntry(const boost::filesystem::path &path) {
+	Entry *parent = getEntry(path.parent_path());
+	if (!parent)
+		return false;
+
+	const UString name = path.filename().generic_string();
+
+	for (std::list<Entry>::iterator child = parent->children.begin(); child != parent->children.end(); ++child) {
+		if (child->name == name) {
+			parent->children.erase(child);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+const FileTree::Entry *FileTree::updateEntry(const boost::filesystem::path &path) {
+	Entry *entry = getEntry(path);
+	if (!entry)
+		return 0;
+
+	if (!entry->isDirectory())
+		entry->size = FilePath::getFileSize(entry->path.generic_string().c_str());
+
+	return entry;
+}
+
 void FileTree::addPath(Entry &entry, const boost::filesystem::path &path, int recurseDepth) {
 	try {
 		// Iterator over the directory's contents
 		boost::filesystem::directory_iterator itEnd;
 		for (boost::filesystem::directory_iterator itDir(path); itDir != itEnd; ++itDir) {
+			const bool isDirectory = boost::filesystem::is_directory(itDir->status());
+
+			// Get the size while we're here, so that nobody needs to ask again later
+			size_t size = kFileInvalid;
+			if (!isDirectory)
+				size = FilePath::getFileSize(itDir->path().generic_string().c_str());
+
 			// Add the file/directory to the entry's children
-			entry.children.push_back(Entry(itDir->path()));
+			entry.children.push_back(Entry(itDir->path(), isDirectory, size));
 
 			// Recurse into directory until the depth limit is reached
-			if (is_directory(itDir->status()))
+			if (isDirectory)
 				if (recurseDepth != 0)
 					addPath(entry.children.back(), itDir->path(), (recurseDepth == -1) ? -1 : (recurseDepth - 1));
 		}
@@ -33,7 +33,12 @@
 
 namespace Common {
 
-/** A tree structure of files in directories. */
+/** A tree structure of files in directories.
+ *
+ *  Whether an entry is a directory and the size of files are found out
+ *  while walking the directories, so that users of the tree don't have to
+ *  ask the file system about each file again.
+ */
 class FileTree {
 public:
 	/** An entry in the file tree. */
@@ -43,11 +48,17 @@ public:
 		/** The full normalized path of the file or directory. */
 		boost::filesystem::path path;
 
+		/** Is this a directory? */
+		bool directory;
+		/** The size of the file, or kFileInvalid for directories. */
+		size_t size;
+
 		/** The files and directories inside this directory entry. */
 		std::list<Entry> children;
 
 		Entry();
 		Entry(const boost::filesystem::path &p);
+		Entry(const boost::filesystem::path &p, bool isDirectory, size_t fileSize);
 
 		bool isDirectory() const;
 	};
@@ -84,9 +95,36 @@ public:
 	 */
 	void readPath(const Common::UString &path, int recurseDepth = 0);
 
+	/** Return the entry for this path, or 0 if it's not in the tree. */
+	const Entry *findEntry(const boost::filesystem::path &path) const;
+
+	/** Add a file or directory that was created within the tree.
+	 *
+	 *  Directories are added with everything within them. If the path is
+	 *  already in the tree, for example because a file was renamed over it,
+	 *  it is updated instead, and a directory's contents are read again.
+	 *
+	 *  @return The new entry, or 0 if the path is not within the tree.
+	 */
+	const Entry *addEntry(const boost::filesystem::path &path);
+
+	/** Remove a file or directory, with everything within it, from the tree.
+	 *
+	 *  @return true if the path was in the tree, false otherwise.
+	 */
+	bool removeEntry(const boost::filesystem::path &path);
+
+	/** Read the size of a file in the tree again.
+	 *
+	 *  @return The updated entry, or 0 if the path is not in the tree.
+	 */
+	const Entry *updateEntry(const boost::filesystem::path &path);
+
 private:
 	Entry _root;
 
+	Entry *getEntry(const boost::filesystem::path &path);
+
 	void addPath(Entry &entry, const boost::filesystem::path &path, int recurseDepth);
 };
 
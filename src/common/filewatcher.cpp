@@ -0,0 +1,202 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Watching directories for changes.
+ */
+
+#include "src/common/system.h"
+
+#if defined(HAVE_SYS_INOTIFY_H)
+	#include <unistd.h>
+	#include <fcntl.h>
+	#include <errno.h>
+	#include <sys/inotify.h>
+#endif
+
+#include <boost/filesystem.hpp>
+
+#include "src/common/filewatcher.h"
+#include "src/common/error.h"
+
+namespace Common {
+
+#if defined(HAVE_SYS_INOTIFY_H)
+static const uint32 kWatchMask = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_CLOSE_WRITE | IN_ONLYDIR;
+#endif
+
+FileWatcher::FileWatcher() : _fd(-1) {
+}
+
+FileWatcher::~FileWatcher() {
+	clear();
+}
+
+bool FileWatcher::isSupported() {
+#if defined(HAVE_SYS_INOTIFY_H)
+	return true;
+#else
+	return false;
+#endif
+}
+
+bool FileWatcher::isWatching() const {
+	return !_directories.empty();
+}
+
+void FileWatcher::clear() {
+#if defined(HAVE_SYS_INOTIFY_H)
+	if (_fd != -1)
+		::close(_fd);
+#endif
+
+	_fd = -1;
+	_directories.clear();
+}
+
+void FileWatcher::watch(const UString &directory) {
+#if defined(HAVE_SYS_INOTIFY_H)
+	if (_fd == -1) {
+		_fd = inotify_init();
+		if (_fd == -1)
+			throw Exception("Failed to initialize inotify: %d", errno);
+
+		fcntl(_fd, F_SETFL, fcntl(_fd, F_GETFL) | O_NONBLOCK);
+		fcntl(_fd, F_SETFD, FD_CLOEXEC);
+	}
+
+	try {
+		addWatch(directory);
+
+		boost::filesystem::recursive_directory_iterator itEnd;
+		for (boost::filesystem::recursive_directory_iterator itDir(directory.c_str()); itDir != itEnd; ++itDir)
+			if (boost::filesystem::is_directory(itDir->status()))
+				addWatch(itDir->path().generic_string());
+
+	} catch (Exception &e) {
+		e.add("Failed to watch directory \"%s\"", directory.c_str());
+		throw;
+	} catch (std::exception &e) {
+		Exception se(e);
+
+		se.add("Failed to watch directory \"%s\"", directory.c_str());
+		throw se;
+	}
+#else
+	(void) directory;
+#endif
+}
+
+void FileWatcher::addWatch(const UString &directory) {
+#if defined(HAVE_SYS_INOTIFY_H)
+	const int wd = inotify_add_watch(_fd, directory.c_str(), kWatchMask);
+	if (wd == -1)
+		throw Exception("Failed to watch \"%s\": %d", directory.c_str(), errno);
+
+	_directories[wd] = directory;
+#else
+	(void) directory;
+#endif
+}
+
+void FileWatcher::removeWatches(const UString &directory) {
+#if defined(HAVE_SYS_INOTIFY_H)
+	const UString prefix = directory + "/";
+
+	for (std::map<int, UString>::iterator d = _directories.begin(); d != _directories.end(); ) {
+		if ((d->second == directory) || d->second.beginsWith(prefix)) {
+			inotify_rm_watch(_fd, d->first);
+			d = _directories.erase(d);
+		} else
+			++d;
+	}
+#else
+	(void) directory;
+#endif
+}
+
+void FileWatcher::getEvents(std::vector<Event> &events) {
+#if defined(HAVE_SYS_INOTIFY_H)
+	if (_fd == -1)
+		return;
+
+	// Aligned the way inotify wants it
+	alignas(struct inotify_event) char buffer[4096];
+
+	while (true) {
+		const ssize_t length = ::read(_fd, buffer, sizeof(buffer));
+		if (length <= 0)
+			break;
+
+		for (ssize_t offset = 0; offset < length; ) {
+			const struct inotify_event *event = reinterpret_cast<const struct inotify_event *>(buffer + offset);
+			offset += sizeof(struct inotify_event) + event->len;
+
+			if (event->mask & IN_Q_OVERFLOW) {
+				events.push_back({ kEventOverflow, UString(), false });
+				continue;
+			}
+
+			if (event->mask & IN_IGNORED) {
+				// The directory is gone, and so is its watch
+				_directories.erase(event->wd);
+				continue;
+			}
+
+			std::map<int, UString>::const_iterator dir = _directories.find(event->wd);
+			if ((dir == _directories.end()) || (event->len == 0))
+				continue;
+
+			Event e;
+
+			e.path      = dir->second + "/" + event->name;
+			e.directory = (event->mask & IN_ISDIR) != 0;
+
+			if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+				e.type = kEventCreated;
+
+				if (e.directory) {
+					try {
+						watch(e.path);
+					} catch (Exception &) {
+						// Probably already gone again
+					}
+				}
+
+			} else if (event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+				e.type = kEventRemoved;
+
+				if (e.directory)
+					removeWatches(e.path);
+
+			} else if (event->mask & IN_CLOSE_WRITE) {
+				e.type = kEventModified;
+			} else
+				continue;
+
+			events.push_back(e);
+		}
+	}
+#else
+	(void) events;
+#endif
+}
+
+} // End of namespace Common
@@ -0,0 +1,98 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Watching directories for changes.
+ */
+
+#ifndef COMMON_FILEWATCHER_H
+#define COMMON_FILEWATCHER_H
+
+#include <vector>
+#include <map>
+
+#include <boost/noncopyable.hpp>
+
+#include "src/common/ustring.h"
+
+namespace Common {
+
+/** Watch a directory tree for files and directories being created, removed and modified.
+ *
+ *  On GNU/Linux, this uses inotify. On other platforms, watching is not
+ *  supported (yet), and no events are ever reported.
+ *
+ *  Changes are not reported asynchronously: they have to be collected
+ *  with getEvents(), which never blocks.
+ */
+class FileWatcher : boost::noncopyable {
+public:
+	enum EventType {
+		kEventCreated,  ///< A file or directory was created, or moved in.
+		kEventRemoved,  ///< A file or directory was removed, or moved out.
+		kEventModified, ///< A file was written to.
+		kEventOverflow  ///< Too many changes at once, events were lost. Everything needs to be rescanned.
+	};
+
+	/** A change to a file or directory. */
+	struct Event {
+		EventType type;
+
+		/** The full path of the file or directory. */
+		UString path;
+		/** Is this a directory? */
+		bool directory;
+	};
+
+	FileWatcher();
+	~FileWatcher();
+
+	/** Can we watch for changes on this platform? */
+	static bool isSupported();
+
+	/** Watch this directory and all directories within it.
+	 *
+	 *  Directories created later within are watched automatically.
+	 */
+	void watch(const UString &directory);
+
+	/** Stop watching all directories. */
+	void clear();
+
+	/** Are we watching any directories? */
+	bool isWatching() const;
+
+	/** Add all changes since the last call to the list of events, in order. */
+	void getEvents(std::vector<Event> &events);
+
+private:
+	/** The watched directories, by watch descriptor. */
+	std::map<int, UString> _directories;
+
+	/** The file descriptor of our inotify instance, or -1 if we have none. */
+	int _fd;
+
+	void addWatch(const UString &directory);
+	void removeWatches(const UString &directory);
+};
+
+} // End of namespace Common
+
+#endif // COMMON_FILEWATCHER_H
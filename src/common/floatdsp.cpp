@@ -0,0 +1,191 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Vector operations on arrays of floats, used by our audio decoders.
+ */
+
+#include "src/common/cpu.h"
+#include "src/common/floatdsp.h"
+
+#ifdef PHAETHON_SIMD_X86
+	#include <immintrin.h>
+#endif
+
+namespace Common {
+
+// .--- Generic implementations
+static void vectorFMulAddC(float *dst, const float *src0, const float *src1, const float *src2, int len) {
+	while (len-- > 0)
+		*dst++ = *src0++ * *src1++ + *src2++;
+}
+
+static void vectorFMulReverseC(float *dst, const float *src0, const float *src1, int len) {
+	src1 += len - 1;
+
+	while (len-- > 0)
+		*dst++ = *src0++ * *src1--;
+}
+
+static void butterflyFloatsC(float *v1, float *v2, int len) {
+	while (len-- > 0) {
+		float t = *v1 - *v2;
+
+		*v1++ += *v2;
+		*v2++  = t;
+	}
+}
+// '---
+
+#ifdef PHAETHON_SIMD_X86
+
+/* The SIMD versions do the same multiplications and additions, in the same order,
+ * as the generic implementations, so their results are bit-identical. */
+
+// .--- SSE2 implementations
+PHAETHON_TARGET_SSE2 static void vectorFMulAddSSE2(float *dst, const float *src0,
+                                                   const float *src1, const float *src2, int len) {
+	for (; len >= 4; len -= 4, dst += 4, src0 += 4, src1 += 4, src2 += 4)
+		_mm_storeu_ps(dst, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(src0), _mm_loadu_ps(src1)), _mm_loadu_ps(src2)));
+
+	vectorFMulAddC(dst, src0, src1, src2, len);
+}
+
+PHAETHON_TARGET_SSE2 static void vectorFMulReverseSSE2(float *dst, const float *src0,
+                                                       const float *src1, int len) {
+	const float *rev = src1 + len;
+
+	for (; len >= 4; len -= 4, dst += 4, src0 += 4) {
+		rev -= 4;
+
+		__m128 r = _mm_loadu_ps(rev);
+		r = _mm_shuffle_ps(r, r, _MM_SHUFFLE(0, 1, 2, 3));
+
+		_mm_storeu_ps(dst, _mm_mul_ps(_mm_loadu_ps(src0), r));
+	}
+
+	vectorFMulReverseC(dst, src0, src1, len);
+}
+
+PHAETHON_TARGET_SSE2 static void butterflyFloatsSSE2(float *v1, float *v2, int len) {
+	for (; len >= 4; len -= 4, v1 += 4, v2 += 4) {
+		const __m128 a = _mm_loadu_ps(v1);
+		const __m128 b = _mm_loadu_ps(v2);
+
+		_mm_storeu_ps(v1, _mm_add_ps(a, b));
+		_mm_storeu_ps(v2, _mm_sub_ps(a, b));
+	}
+
+	butterflyFloatsC(v1, v2, len);
+}
+// '---
+
+// .--- AVX implementations
+PHAETHON_TARGET_AVX static void vectorFMulAddAVX(float *dst, const float *src0,
+                                                 const float *src1, const float *src2, int len) {
+	for (; len >= 8; len -= 8, dst += 8, src0 += 8, src1 += 8, src2 += 8)
+		_mm256_storeu_ps(dst, _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(src0), _mm256_loadu_ps(src1)),
+		                                    _mm256_loadu_ps(src2)));
+
+	vectorFMulAddC(dst, src0, src1, src2, len);
+}
+
+PHAETHON_TARGET_AVX static void vectorFMulReverseAVX(float *dst, const float *src0,
+                                                     const float *src1, int len) {
+	const float *rev = src1 + len;
+
+	for (; len >= 8; len -= 8, dst += 8, src0 += 8) {
+		rev -= 8;
+
+		// Reverse the order of the 8 floats: swap the two halves, then reverse within each half
+		__m256 r = _mm256_loadu_ps(rev);
+		r = _mm256_permute2f128_ps(r, r, 0x01);
+		r = _mm256_permute_ps(r, _MM_SHUFFLE(0, 1, 2, 3));
+
+		_mm256_storeu_ps(dst, _mm256_mul_ps(_mm256_loadu_ps(src0), r));
+	}
+
+	vectorFMulReverseC(dst, src0, src1, len);
+}
+
+PHAETHON_TARGET_AVX static void butterflyFloatsAVX(float *v1, float *v2, int len) {
+	for (; len >= 8; len -= 8, v1 += 8, v2 += 8) {
+		const __m256 a = _mm256_loadu_ps(v1);
+		const __m256 b = _mm256_loadu_ps(v2);
+
+		_mm256_storeu_ps(v1, _mm256_add_ps(a, b));
+		_mm256_storeu_ps(v2, _mm256_sub_ps(a, b));
+	}
+
+	butterflyFloatsC(v1, v2, len);
+}
+// '---
+
+#endif // PHAETHON_SIMD_X86
+
+void vectorFMulAdd(float *dst, const float *src0, const float *src1, const float *src2, int len) {
+#ifdef PHAETHON_SIMD_X86
+	if (hasCPUFeature(kCPUFeatureAVX)) {
+		vectorFMulAddAVX(dst, src0, src1, src2, len);
+		return;
+	}
+
+	if (hasCPUFeature(kCPUFeatureSSE2)) {
+		vectorFMulAddSSE2(dst, src0, src1, src2, len);
+		return;
+	}
+#endif
+
+	vectorFMulAddC(dst, src0, src1, src2, len);
+}
+
+void vectorFMulReverse(float *dst, const float *src0, const float *src1, int len) {
+#ifdef PHAETHON_SIMD_X86
+	if (hasCPUFeature(kCPUFeatureAVX)) {
+		vectorFMulReverseAVX(dst, src0, src1, len);
+		return;
+	}
+
+	if (hasCPUFeature(kCPUFeatureSSE2)) {
+		vectorFMulReverseSSE2(dst, src0, src1, len);
+		return;
+	}
+#endif
+
+	vectorFMulReverseC(dst, src0, src1, len);
+}
+
+void butterflyFloats(float *v1, float *v2, int len) {
+#ifdef PHAETHON_SIMD_X86
+	if (hasCPUFeature(kCPUFeatureAVX)) {
+		butterflyFloatsAVX(v1, v2, len);
+		return;
+	}
+
+	if (hasCPUFeature(kCPUFeatureSSE2)) {
+		butterflyFloatsSSE2(v1, v2, len);
+		return;
+	}
+#endif
+
+	butterflyFloatsC(v1, v2, len);
+}
+
+} // End of namespace Common
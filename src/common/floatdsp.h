@@ -0,0 +1,47 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Vector operations on arrays of floats, used by our audio decoders.
+ */
+
+#ifndef COMMON_FLOATDSP_H
+#define COMMON_FLOATDSP_H
+
+namespace Common {
+
+/** dst[i] = src0[i] * src1[i] + src2[i]
+ *
+ *  dst may point to the same memory as src0 or src2.
+ */
+void vectorFMulAdd(float *dst, const float *src0, const float *src1, const float *src2, int len);
+
+/** dst[i] = src0[i] * src1[len - 1 - i]
+ *
+ *  dst may point to the same memory as src0.
+ */
+void vectorFMulReverse(float *dst, const float *src0, const float *src1, int len);
+
+/** v1[i] = v1[i] + v2[i], v2[i] = v1[i] - v2[i] */
+void butterflyFloats(float *v1, float *v2, int len);
+
+} // End of namespace Common
+
+#endif // COMMON_FLOATDSP_H
@@ -26,11 +26,15 @@
 #include "src/common/types.h"
 #include <lzma.h>
 
+#include <cassert>
+#include <cstdlib>
+
 #include <memory>
 
 #include <boost/scope_exit.hpp>
 
 #include "src/common/lzma.h"
+#include "src/common/util.h"
 #include "src/common/error.h"
 #include "src/common/memreadstream.h"
 
@@ -128,4 +132,157 @@ SeekableReadStream *decompressLZMA1(ReadStream &input, size_t inputSize, size_t
 	return new MemoryReadStream(outputData, outputSize, true);
 }
 
+
+struct LZMA1ReadStream::Decoder {
+	lzma_stream strm;
+	lzma_filter filters[2];
+
+	Decoder() : strm(LZMA_STREAM_INIT) {
+		filters[0].id      = LZMA_FILTER_LZMA1;
+		filters[0].options = 0;
+		filters[1].id      = LZMA_VLI_UNKNOWN;
+		filters[1].options = 0;
+	}
+
+	~Decoder() {
+		kLZMAAllocator.free(0, filters[0].options);
+		lzma_end(&strm);
+	}
+};
+
+LZMA1ReadStream::LZMA1ReadStream(SeekableReadStream *input, size_t inputSize, size_t outputSize) :
+	_input(input), _inputStart(0), _inputSize(inputSize), _inputLeft(0), _outputSize(outputSize),
+	_window(std::make_unique<byte[]>(kInputWindowSize)), _pos(0), _eos(false) {
+
+	assert(_input);
+
+	_inputStart = _input->pos();
+
+	restart();
+}
+
+LZMA1ReadStream::~LZMA1ReadStream() {
+}
+
+void LZMA1ReadStream::restart() {
+	_decoder = std::make_unique<Decoder>();
+
+	lzma_filter *filters = _decoder->filters;
+
+	if (!lzma_filter_decoder_is_supported(filters[0].id))
+		throw Exception("LZMA1 compression not supported");
+
+	uint32 propsSize;
+	if (lzma_properties_size(&propsSize, &filters[0]) != LZMA_OK)
+		throw Exception("Can't get LZMA1 properties size");
+
+	if ((propsSize > _inputSize) || (propsSize > kInputWindowSize))
+		throw Exception("LZMA1 properties size larger than input data");
+
+	_input->seek(_inputStart);
+	if (_input->read(_window.get(), propsSize) != propsSize)
+		throw Exception(kReadError);
+
+	if (lzma_properties_decode(&filters[0], &kLZMAAllocator, _window.get(), propsSize) != LZMA_OK)
+		throw Exception("Failed to decode LZMA1 properties");
+
+	lzma_ret lzmaRet = LZMA_OK;
+	if ((lzmaRet = lzma_raw_decoder(&_decoder->strm, filters)) != LZMA_OK)
+		throw Exception("Failed to create raw LZMA1 decoder: %d", (int) lzmaRet);
+
+	_inputLeft = _inputSize - propsSize;
+
+	_pos = 0;
+	_eos = false;
+}
+
+void LZMA1ReadStream::decompress(byte *data, size_t size) {
+	lzma_stream &strm = _decoder->strm;
+
+	strm.next_out  = data;
+	strm.avail_out = size;
+
+	while (strm.avail_out > 0) {
+		// Refill the input window
+		if ((strm.avail_in == 0) && (_inputLeft > 0)) {
+			const size_t windowSize = MIN(_inputLeft, kInputWindowSize);
+			if (_input->read(_window.get(), windowSize) != windowSize)
+				throw Exception(kReadError);
+
+			_inputLeft -= windowSize;
+
+			strm.next_in  = _window.get();
+			strm.avail_in = windowSize;
+		}
+
+		const lzma_ret lzmaRet = lzma_code(&strm, (_inputLeft == 0) ? LZMA_FINISH : LZMA_RUN);
+
+		if (lzmaRet == LZMA_STREAM_END) {
+			if (strm.avail_out != 0)
+				throw Exception("Failed to uncompress LZMA1 data: output buffer not completely filled");
+
+			break;
+		}
+
+		if (lzmaRet != LZMA_OK)
+			throw Exception("Failed to uncompress LZMA1 data: %d", (int) lzmaRet);
+	}
+}
+
+bool LZMA1ReadStream::eos() const {
+	return _eos;
+}
+
+size_t LZMA1ReadStream::read(void *dataPtr, size_t dataSize) {
+	assert(dataPtr);
+
+	// Read at most as many bytes as are still available...
+	if (dataSize > (_outputSize - _pos)) {
+		dataSize = _outputSize - _pos;
+		_eos = true;
+	}
+
+	decompress(static_cast<byte *>(dataPtr), dataSize);
+	_pos += dataSize;
+
+	return dataSize;
+}
+
+size_t LZMA1ReadStream::pos() const {
+	return _pos;
+}
+
+size_t LZMA1ReadStream::size() const {
+	return _outputSize;
+}
+
+size_t LZMA1ReadStream::seek(ptrdiff_t offset, Origin whence) {
+	const size_t oldPos = _pos;
+	const size_t newPos = evalSeek(offset, whence, _pos, 0, size());
+	if (newPos > _outputSize)
+		throw Exception(kSeekError);
+
+	// We can only decompress forward
+	if (newPos < _pos)
+		restart();
+
+	// Decompress and throw away everything up to the new position
+	if (newPos > _pos) {
+		const size_t skipSize = MIN<size_t>(newPos - _pos, 64 * 1024);
+		std::unique_ptr<byte[]> skipBuffer = std::make_unique<byte[]>(skipSize);
+
+		while (_pos < newPos) {
+			const size_t toSkip = MIN(newPos - _pos, skipSize);
+
+			decompress(skipBuffer.get(), toSkip);
+			_pos += toSkip;
+		}
+	}
+
+	// Reset end-of-stream flag on a successful seek
+	_eos = false;
+
+	return oldPos;
+}
+
 } // End of namespace Common
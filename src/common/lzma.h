@@ -25,13 +25,13 @@
 #ifndef COMMON_LZMA_H
 #define COMMON_LZMA_H
 
+#include <memory>
+
 #include "src/common/types.h"
+#include "src/common/readstream.h"
 
 namespace Common {
 
-class ReadStream;
-class SeekableReadStream;
-
 /** Decompress using the LZMA1 algorithm.
  *
  *  @param  data       The compressed input data.
@@ -56,6 +56,65 @@ byte *decompressLZMA1(const byte *data, size_t inputSize, size_t outputSize);
  */
 SeekableReadStream *decompressLZMA1(ReadStream &input, size_t inputSize, size_t outputSize);
 
+/** A stream decompressing LZMA1 data on the fly.
+ *
+ *  Instead of decompressing everything up front, the data is decompressed
+ *  when it is read, while the compressed data is read through a small
+ *  window. This keeps the memory use low and makes the first bytes
+ *  available right away, which is useful for large resources that are
+ *  read from start to end, like sounds.
+ *
+ *  Seeking forward decompresses and discards the data in between. Seeking
+ *  backward has to start decompressing from the beginning again.
+ */
+class LZMA1ReadStream : public SeekableReadStream {
+public:
+	/** Create a stream decompressing LZMA1 data.
+	 *
+	 *  @param input      The compressed input data, starting with the LZMA1
+	 *                    properties at its current position.
+	 *                    The LZMA1ReadStream takes over the input stream.
+	 *  @param inputSize  The size of the input data in bytes.
+	 *  @param outputSize The size of the decompressed output data.
+	 */
+	LZMA1ReadStream(SeekableReadStream *input, size_t inputSize, size_t outputSize);
+	~LZMA1ReadStream();
+
+	bool eos() const;
+
+	size_t read(void *dataPtr, size_t dataSize);
+
+	size_t pos() const;
+	size_t size() const;
+
+	size_t seek(ptrdiff_t offset, Origin whence = kOriginBegin);
+
+private:
+	/** The size of the window the compressed input is read through. */
+	static const size_t kInputWindowSize = 16 * 1024;
+
+	struct Decoder;
+
+	std::unique_ptr<SeekableReadStream> _input;
+
+	size_t _inputStart; ///< Where the compressed data starts in the input stream.
+	size_t _inputSize;  ///< The size of the compressed data.
+	size_t _inputLeft;  ///< The number of compressed bytes not yet read.
+
+	size_t _outputSize;
+
+	std::unique_ptr<Decoder> _decoder;
+	std::unique_ptr<byte[]> _window;
+
+	size_t _pos;
+	bool _eos;
+
+	/** Start decompressing from the beginning. */
+	void restart();
+	/** Decompress the next bytes. */
+	void decompress(byte *data, size_t size);
+};
+
 } // End of namespace Common
 
 #endif // COMMON_LZMA_H
@@ -25,11 +25,20 @@
 #include <cstring>
 
 #include "src/common/md5.h"
+#include "src/common/util.h"
 #include "src/common/ustring.h"
+#include "src/common/endianness.h"
+#include "src/common/disposableptr.h"
 #include "src/common/readstream.h"
+#include "src/common/memreadstream.h"
 
 namespace Common {
 
+/** The number of streams hashMD5() hashes side by side. */
+static const size_t kMD5Lanes = 4;
+/** The size of the buffer each stream that doesn't live in memory is read into. */
+static const size_t kMD5BufferSize = 64 * 1024;
+
 /* .--- MD5, based on the implementation by Alexander Peslyak ---.
  *
  * This is an MD5 digesting implementation based on the implementation by
@@ -235,11 +244,147 @@ static const byte *md5Body(MD5Context &ctx, const byte *data, size_t size) {
 	return ptr;
 }
 
-static void md5Update(MD5Context &ctx, const byte *data, size_t size) {
+/*
+ * The same transformation, for kMD5Lanes independent contexts at once.
+ *
+ * The lanes don't depend on each other, so this keeps more of the CPU's
+ * execution units busy than a single dependency chain through one context,
+ * and lets the compiler use vector registers for the lanes.
+ */
+#define LANE_STEP(f, a, b, c, d, n, t, s) \
+	for (size_t l = 0; l < kMD5Lanes; l++) { \
+		STEP(f, a[l], b[l], c[l], d[l], x[(n)][l], t, s) \
+	}
+
+/*
+ * This processes the same number of 64-byte data blocks for each lane,
+ * advancing the lanes' data, but does NOT update the bit counters.
+ */
+static void md5BodyLanes(MD5Context *(&ctx)[kMD5Lanes], const byte *(&data)[kMD5Lanes], size_t blocks) {
+	uint32 a[kMD5Lanes], b[kMD5Lanes], c[kMD5Lanes], d[kMD5Lanes];
+	for (size_t l = 0; l < kMD5Lanes; l++) {
+		a[l] = ctx[l]->a;
+		b[l] = ctx[l]->b;
+		c[l] = ctx[l]->c;
+		d[l] = ctx[l]->d;
+	}
+
+	while (blocks-- > 0) {
+		uint32 saved_a[kMD5Lanes], saved_b[kMD5Lanes], saved_c[kMD5Lanes], saved_d[kMD5Lanes];
+		uint32 x[16][kMD5Lanes];
+
+		for (size_t l = 0; l < kMD5Lanes; l++) {
+			saved_a[l] = a[l];
+			saved_b[l] = b[l];
+			saved_c[l] = c[l];
+			saved_d[l] = d[l];
+
+			for (size_t n = 0; n < 16; n++)
+				x[n][l] = READ_LE_UINT32(data[l] + n * 4);
+
+			data[l] += 64;
+		}
+
+/* Round 1 */
+		LANE_STEP(F, a, b, c, d, 0, 0xD76AA478, 7)
+		LANE_STEP(F, d, a, b, c, 1, 0xE8C7B756, 12)
+		LANE_STEP(F, c, d, a, b, 2, 0x242070DB, 17)
+		LANE_STEP(F, b, c, d, a, 3, 0xC1BDCEEE, 22)
+		LANE_STEP(F, a, b, c, d, 4, 0xF57C0FAF, 7)
+		LANE_STEP(F, d, a, b, c, 5, 0x4787C62A, 12)
+		LANE_STEP(F, c, d, a, b, 6, 0xA8304613, 17)
+		LANE_STEP(F, b, c, d, a, 7, 0xFD469501, 22)
+		LANE_STEP(F, a, b, c, d, 8, 0x698098D8, 7)
+		LANE_STEP(F, d, a, b, c, 9, 0x8B44F7AF, 12)
+		LANE_STEP(F, c, d, a, b, 10, 0xFFFF5BB1, 17)
+		LANE_STEP(F, b, c, d, a, 11, 0x895CD7BE, 22)
+		LANE_STEP(F, a, b, c, d, 12, 0x6B901122, 7)
+		LANE_STEP(F, d, a, b, c, 13, 0xFD987193, 12)
+		LANE_STEP(F, c, d, a, b, 14, 0xA679438E, 17)
+		LANE_STEP(F, b, c, d, a, 15, 0x49B40821, 22)
+
+/* Round 2 */
+		LANE_STEP(G, a, b, c, d, 1, 0xF61E2562, 5)
+		LANE_STEP(G, d, a, b, c, 6, 0xC040B340, 9)
+		LANE_STEP(G, c, d, a, b, 11, 0x265E5A51, 14)
+		LANE_STEP(G, b, c, d, a, 0, 0xE9B6C7AA, 20)
+		LANE_STEP(G, a, b, c, d, 5, 0xD62F105D, 5)
+		LANE_STEP(G, d, a, b, c, 10, 0x02441453, 9)
+		LANE_STEP(G, c, d, a, b, 15, 0xD8A1E681, 14)
+		LANE_STEP(G, b, c, d, a, 4, 0xE7D3FBC8, 20)
+		LANE_STEP(G, a, b, c, d, 9, 0x21E1CDE6, 5)
+		LANE_STEP(G, d, a, b, c, 14, 0xC33707D6, 9)
+		LANE_STEP(G, c, d, a, b, 3, 0xF4D50D87, 14)
+		LANE_STEP(G, b, c, d, a, 8, 0x455A14ED, 20)
+		LANE_STEP(G, a, b, c, d, 13, 0xA9E3E905, 5)
+		LANE_STEP(G, d, a, b, c, 2, 0xFCEFA3F8, 9)
+		LANE_STEP(G, c, d, a, b, 7, 0x676F02D9, 14)
+		LANE_STEP(G, b, c, d, a, 12, 0x8D2A4C8A, 20)
+
+/* Round 3 */
+		LANE_STEP(H, a, b, c, d, 5, 0xFFFA3942, 4)
+		LANE_STEP(H2, d, a, b, c, 8, 0x8771F681, 11)
+		LANE_STEP(H, c, d, a, b, 11, 0x6D9D6122, 16)
+		LANE_STEP(H2, b, c, d, a, 14, 0xFDE5380C, 23)
+		LANE_STEP(H, a, b, c, d, 1, 0xA4BEEA44, 4)
+		LANE_STEP(H2, d, a, b, c, 4, 0x4BDECFA9, 11)
+		LANE_STEP(H, c, d, a, b, 7, 0xF6BB4B60, 16)
+		LANE_STEP(H2, b, c, d, a, 10, 0xBEBFBC70, 23)
+		LANE_STEP(H, a, b, c, d, 13, 0x289B7EC6, 4)
+		LANE_STEP(H2, d, a, b, c, 0, 0xEAA127FA, 11)
+		LANE_STEP(H, c, d, a, b, 3, 0xD4EF3085, 16)
+		LANE_STEP(H2, b, c, d, a, 6, 0x04881D05, 23)
+		LANE_STEP(H, a, b, c, d, 9, 0xD9D4D039, 4)
+		LANE_STEP(H2, d, a, b, c, 12, 0xE6DB99E5, 11)
+		LANE_STEP(H, c, d, a, b, 15, 0x1FA27CF8, 16)
+		LANE_STEP(H2, b, c, d, a, 2, 0xC4AC5665, 23)
+
+/* Round 4 */
+		LANE_STEP(I, a, b, c, d, 0, 0xF4292244, 6)
+		LANE_STEP(I, d, a, b, c, 7, 0x432AFF97, 10)
+		LANE_STEP(I, c, d, a, b, 14, 0xAB9423A7, 15)
+		LANE_STEP(I, b, c, d, a, 5, 0xFC93A039, 21)
+		LANE_STEP(I, a, b, c, d, 12, 0x655B59C3, 6)
+		LANE_STEP(I, d, a, b, c, 3, 0x8F0CCC92, 10)
+		LANE_STEP(I, c, d, a, b, 10, 0xFFEFF47D, 15)
+		LANE_STEP(I, b, c, d, a, 1, 0x85845DD1, 21)
+		LANE_STEP(I, a, b, c, d, 8, 0x6FA87E4F, 6)
+		LANE_STEP(I, d, a, b, c, 15, 0xFE2CE6E0, 10)
+		LANE_STEP(I, c, d, a, b, 6, 0xA3014314, 15)
+		LANE_STEP(I, b, c, d, a, 13, 0x4E0811A1, 21)
+		LANE_STEP(I, a, b, c, d, 4, 0xF7537E82, 6)
+		LANE_STEP(I, d, a, b, c, 11, 0xBD3AF235, 10)
+		LANE_STEP(I, c, d, a, b, 2, 0x2AD7D2BB, 15)
+		LANE_STEP(I, b, c, d, a, 9, 0xEB86D391, 21)
+
+		for (size_t l = 0; l < kMD5Lanes; l++) {
+			a[l] += saved_a[l];
+			b[l] += saved_b[l];
+			c[l] += saved_c[l];
+			d[l] += saved_d[l];
+		}
+	}
+
+	for (size_t l = 0; l < kMD5Lanes; l++) {
+		ctx[l]->a = a[l];
+		ctx[l]->b = b[l];
+		ctx[l]->c = c[l];
+		ctx[l]->d = d[l];
+	}
+}
+
+#undef LANE_STEP
+
+static void md5Count(MD5Context &ctx, size_t size) {
 	uint32 saved_lo = ctx.lo;
 	if ((ctx.lo = (saved_lo + size) & 0x1FFFFFFF) < saved_lo)
 		ctx.hi++;
 	ctx.hi += size >> 29;
+}
+
+static void md5Update(MD5Context &ctx, const byte *data, size_t size) {
+	uint32 saved_lo = ctx.lo;
+	md5Count(ctx, size);
 
 	size_t used = saved_lo & 0x3F;
 
@@ -313,15 +458,46 @@ static void md5Final(byte *result, MD5Context &ctx) {
 // '--- MD5, based on the implementation by Alexander Peslyak ---'
 
 
+/** Get the next chunk of data out of the stream.
+ *
+ *  A MemoryReadStream already holds all its data, so that is hashed right
+ *  where it is, without copying it anywhere. Any other stream is read into
+ *  the buffer, as much as fits.
+ *
+ *  @return The number of bytes in the chunk, 0 if the stream is exhausted.
+ */
+static size_t md5Fetch(ReadStream &stream, std::vector<byte> &buffer, const byte *&data) {
+	MemoryReadStream *memStream = dynamic_cast<MemoryReadStream *>(&stream);
+	if (memStream) {
+		const size_t pos  = memStream->pos();
+		const size_t size = memStream->size() - pos;
+
+		data = memStream->getData() + pos;
+		memStream->seek(0, MemoryReadStream::kOriginEnd);
+
+		return size;
+	}
+
+	buffer.resize(kMD5BufferSize);
+	data = &buffer[0];
+
+	// Fill the whole buffer, so that only the last chunk has a partial block
+	size_t size = 0;
+	while ((size < buffer.size()) && !stream.eos())
+		size += stream.read(&buffer[size], buffer.size() - size);
+
+	return size;
+}
+
 void hashMD5(ReadStream &stream, std::vector<byte> &digest) {
 	MD5Context ctx;
 
-	byte buf[4096];
-	while (!stream.eos()) {
-		size_t bufRead = stream.read(buf, 4096);
+	std::vector<byte> buffer;
+	const byte *data = 0;
 
-		md5Update(ctx, buf, bufRead);
-	}
+	size_t size;
+	while ((size = md5Fetch(stream, buffer, data)) > 0)
+		md5Update(ctx, data, size);
 
 	digest.resize(kMD5Length);
 	md5Final(&digest[0], ctx);
@@ -345,6 +521,137 @@ void hashMD5(const std::vector<byte> &data, std::vector<byte> &digest) {
 }
 
 
+/** A stream being hashed in one of the lanes of hashMD5(). */
+struct MD5Lane {
+	DisposablePtr<ReadStream> stream;
+	size_t index;
+
+	MD5Context ctx;
+
+	std::vector<byte> buffer;
+	const byte *data; ///< The current chunk of data, not yet hashed.
+	size_t size;      ///< The number of bytes left in the current chunk.
+
+	MD5Lane() : stream(0, false), index(0), data(0), size(0) {
+	}
+};
+
+/** Make sure the lane has at least a whole block to hash, on a block boundary.
+ *
+ *  Finished streams get their digest written, and the lane moves on to the
+ *  next stream to open. Partial blocks are hashed through the context's own
+ *  buffer, as usual.
+ *
+ *  @return false if the lane is idle, because all streams have been opened.
+ */
+static bool md5Prepare(MD5Lane &lane, size_t &next, size_t count, const MD5StreamOpener &open,
+                       bool dispose, std::vector< std::vector<byte> > &digests) {
+
+	while (true) {
+		if (!lane.stream) {
+			if (next >= count)
+				return false;
+
+			lane.index = next++;
+			lane.ctx   = MD5Context();
+			lane.size  = 0;
+
+			lane.stream.setDisposable(dispose);
+			lane.stream.reset(open(lane.index));
+
+			if (!lane.stream)
+				digests[lane.index].clear();
+
+			continue;
+		}
+
+		if ((lane.size >= 64) && ((lane.ctx.lo & 0x3F) == 0))
+			return true;
+
+		if (lane.size > 0) {
+			md5Update(lane.ctx, lane.data, lane.size);
+			lane.size = 0;
+		}
+
+		try {
+			lane.size = md5Fetch(*lane.stream, lane.buffer, lane.data);
+		} catch (...) {
+			// A stream that fails to read gets no digest, but doesn't stop the others
+			digests[lane.index].clear();
+			lane.stream.reset();
+			continue;
+		}
+
+		if (lane.size > 0)
+			continue;
+
+		digests[lane.index].resize(kMD5Length);
+		md5Final(&digests[lane.index][0], lane.ctx);
+
+		lane.stream.reset();
+	}
+}
+
+static void hashMD5(size_t count, const MD5StreamOpener &open, bool dispose,
+                    std::vector< std::vector<byte> > &digests) {
+
+	digests.resize(count);
+
+	MD5Lane lanes[kMD5Lanes];
+	size_t next = 0;
+
+	while (true) {
+		size_t active = 0;
+		for (size_t l = 0; l < kMD5Lanes; l++)
+			if (md5Prepare(lanes[l], next, count, open, dispose, digests))
+				active++;
+
+		if (active == 0)
+			break;
+
+		if (active < kMD5Lanes) {
+			// Not enough streams left to fill all lanes. Hash the rest one by one
+			for (size_t l = 0; l < kMD5Lanes; l++) {
+				if (lanes[l].stream && (lanes[l].size > 0)) {
+					md5Update(lanes[l].ctx, lanes[l].data, lanes[l].size);
+					lanes[l].size = 0;
+				}
+			}
+
+			continue;
+		}
+
+		size_t blocks = SIZE_MAX;
+		for (size_t l = 0; l < kMD5Lanes; l++)
+			blocks = MIN<size_t>(blocks, lanes[l].size / 64);
+
+		MD5Context *ctx[kMD5Lanes];
+		const byte *data[kMD5Lanes];
+		for (size_t l = 0; l < kMD5Lanes; l++) {
+			ctx [l] = &lanes[l].ctx;
+			data[l] = lanes[l].data;
+
+			md5Count(lanes[l].ctx, blocks * 64);
+		}
+
+		md5BodyLanes(ctx, data, blocks);
+
+		for (size_t l = 0; l < kMD5Lanes; l++) {
+			lanes[l].data  = data[l];
+			lanes[l].size -= blocks * 64;
+		}
+	}
+}
+
+void hashMD5(size_t count, const MD5StreamOpener &open, std::vector< std::vector<byte> > &digests) {
+	hashMD5(count, open, true, digests);
+}
+
+void hashMD5(const std::vector<ReadStream *> &streams, std::vector< std::vector<byte> > &digests) {
+	hashMD5(streams.size(), [&streams](size_t index) { return streams[index]; }, false, digests);
+}
+
+
 bool compareMD5Digest(ReadStream &stream, const std::vector<byte> &digest) {
 	if (digest.size() != kMD5Length)
 		return false;
@@ -26,6 +26,7 @@
 #define COMMON_MD5_H
 
 #include <vector>
+#include <functional>
 
 #include "src/common/types.h"
 
@@ -37,7 +38,13 @@ class ReadStream;
 /** The length of an MD5 digest in bytes. */
 static const size_t kMD5Length = 16;
 
-/** Hash the stream into an MD5 digest of 16 bytes. */
+/** Opens the stream with this index for hashing, returning 0 if it can't be opened. */
+typedef std::function<ReadStream *(size_t index)> MD5StreamOpener;
+
+/** Hash the stream into an MD5 digest of 16 bytes.
+ *
+ *  The data of a MemoryReadStream is hashed in place, without copying it.
+ */
 void hashMD5(ReadStream &stream, std::vector<byte> &digest);
 /** Hash the data into an MD5 digest of 16 bytes. */
 void hashMD5(const byte *data, size_t dataLength, std::vector<byte> &digest);
@@ -46,6 +53,21 @@ void hashMD5(const UString &string, std::vector<byte> &digest);
 /** Hash the array of data into an MD5 digest of 16 bytes. */
 void hashMD5(const std::vector<byte> &data, std::vector<byte> &digest);
 
+/** Hash several streams into MD5 digests of 16 bytes each.
+ *
+ *  The streams are hashed side by side, in several parallel lanes that run
+ *  through the MD5 rounds together. This is considerably faster than hashing
+ *  the streams one after the other.
+ *
+ *  The opener is called for each index from 0 to count - 1, in order, once a
+ *  lane is free for another stream. The streams are deleted after they have
+ *  been hashed. A stream that can't be opened, or that throws while being
+ *  read, gets an empty digest.
+ */
+void hashMD5(size_t count, const MD5StreamOpener &open, std::vector< std::vector<byte> > &digests);
+/** Hash several streams into MD5 digests of 16 bytes each, side by side in parallel lanes. */
+void hashMD5(const std::vector<ReadStream *> &streams, std::vector< std::vector<byte> > &digests);
+
 /** Hash the stream and compare the digests, returning true if they match. */
 bool compareMD5Digest(ReadStream &stream, const std::vector<byte> &digest);
 /** Hash the array of data and compare the digests, returning true if they match. */
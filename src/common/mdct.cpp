@@ -50,12 +50,17 @@
 
 #include "src/common/maths.h"
 #include "src/common/util.h"
+#include "src/common/cpu.h"
 #include "src/common/fft.h"
 #include "src/common/mdct.h"
 
+#ifdef PHAETHON_SIMD_X86
+	#include <emmintrin.h>
+#endif
+
 namespace Common {
 
-MDCT::MDCT(int bits, bool inverse, double scale) : _bits(bits) {
+MDCT::MDCT(int bits, bool inverse, double scale) : _bits(bits), _simd(false) {
 	_size = 1 << bits;
 
 	_fft = std::make_unique<FFT>(_bits - 2, inverse);
@@ -75,6 +80,9 @@ MDCT::MDCT(int bits, bool inverse, double scale) : _bits(bits) {
 		_tCos[i] = -cos(alpha) * scale;
 		_tSin[i] = -sin(alpha) * scale;
 	}
+
+	// The SIMD code paths work on 4 elements of the eighth-size rotations at once
+	_simd = hasCPUFeature(kCPUFeatureSSE2) && (_size >= 32);
 }
 
 MDCT::~MDCT() {
@@ -85,6 +93,107 @@ MDCT::~MDCT() {
 		(dim) = (are) * (bim) + (aim) * (bre);  \
 	} while (0)
 
+#ifdef PHAETHON_SIMD_X86
+
+/* SSE2 versions of the inverse MDCT rotations. The twiddle factors are already
+ * stored split into real (cosine) and imaginary (sine) arrays, and the complex
+ * data is split the same way while in registers. All operations happen in the
+ * same order as in CMUL(), so the results are bit-identical to the scalar code. */
+
+PHAETHON_TARGET_SSE2 static inline __m128 reverseSSE2(__m128 v) {
+	return _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 1, 2, 3));
+}
+
+/** Pre rotation of the half inverse MDCT, 4 elements at a time. */
+PHAETHON_TARGET_SSE2 static void imdctPreRotateSSE2(Complex *z, const float *input, const uint16 *revTab,
+                                                    const float *tCos, const float *tSin, int size2, int size4) {
+
+	float re[4], im[4];
+
+	for (int k = 0; k < size4; k += 4) {
+		// in1 walks the even inputs forwards, in2 the odd inputs backwards
+		const __m128 in1Lo = _mm_loadu_ps(input + 2 * k);
+		const __m128 in1Hi = _mm_loadu_ps(input + 2 * k + 4);
+		const __m128 in1   = _mm_shuffle_ps(in1Lo, in1Hi, _MM_SHUFFLE(2, 0, 2, 0));
+
+		const __m128 in2Lo = _mm_loadu_ps(input + size2 - 2 * k - 8);
+		const __m128 in2Hi = _mm_loadu_ps(input + size2 - 2 * k - 4);
+		const __m128 in2   = reverseSSE2(_mm_shuffle_ps(in2Lo, in2Hi, _MM_SHUFFLE(3, 1, 3, 1)));
+
+		const __m128 c = _mm_loadu_ps(tCos + k);
+		const __m128 s = _mm_loadu_ps(tSin + k);
+
+		_mm_storeu_ps(re, _mm_sub_ps(_mm_mul_ps(in2, c), _mm_mul_ps(in1, s)));
+		_mm_storeu_ps(im, _mm_add_ps(_mm_mul_ps(in2, s), _mm_mul_ps(in1, c)));
+
+		// Scatter into the FFT input permutation
+		for (int i = 0; i < 4; i++) {
+			Complex &dst = z[revTab[k + i]];
+
+			dst.re = re[i];
+			dst.im = im[i];
+		}
+	}
+}
+
+/** Post rotation and reordering of the half inverse MDCT, 4 elements at a time. */
+PHAETHON_TARGET_SSE2 static void imdctPostRotateSSE2(Complex *z, const float *tCos, const float *tSin, int size8) {
+	for (int k = 0; k < size8; k += 4) {
+		/* The "backward" elements are z[size8-k-4] to z[size8-k-1], the "forward"
+		 * elements z[size8+k] to z[size8+k+3]. Both are kept in memory order. */
+		Complex *zb = z + size8 - k - 4;
+		Complex *zf = z + size8 + k;
+
+		const __m128 bLo = _mm_loadu_ps(&zb[0].re);
+		const __m128 bHi = _mm_loadu_ps(&zb[2].re);
+		const __m128 fLo = _mm_loadu_ps(&zf[0].re);
+		const __m128 fHi = _mm_loadu_ps(&zf[2].re);
+
+		const __m128 bRe = _mm_shuffle_ps(bLo, bHi, _MM_SHUFFLE(2, 0, 2, 0));
+		const __m128 bIm = _mm_shuffle_ps(bLo, bHi, _MM_SHUFFLE(3, 1, 3, 1));
+		const __m128 fRe = _mm_shuffle_ps(fLo, fHi, _MM_SHUFFLE(2, 0, 2, 0));
+		const __m128 fIm = _mm_shuffle_ps(fLo, fHi, _MM_SHUFFLE(3, 1, 3, 1));
+
+		const __m128 bCos = _mm_loadu_ps(tCos + size8 - k - 4);
+		const __m128 bSin = _mm_loadu_ps(tSin + size8 - k - 4);
+		const __m128 fCos = _mm_loadu_ps(tCos + size8 + k);
+		const __m128 fSin = _mm_loadu_ps(tSin + size8 + k);
+
+		// CMUL(r0, i1, zb.im, zb.re, sin, cos) and CMUL(r1, i0, zf.im, zf.re, sin, cos)
+		const __m128 r0 = _mm_sub_ps(_mm_mul_ps(bIm, bSin), _mm_mul_ps(bRe, bCos));
+		const __m128 i1 = _mm_add_ps(_mm_mul_ps(bIm, bCos), _mm_mul_ps(bRe, bSin));
+		const __m128 r1 = _mm_sub_ps(_mm_mul_ps(fIm, fSin), _mm_mul_ps(fRe, fCos));
+		const __m128 i0 = _mm_add_ps(_mm_mul_ps(fIm, fCos), _mm_mul_ps(fRe, fSin));
+
+		// The backward and forward elements pair up in opposite order
+		const __m128 i0b = reverseSSE2(i0);
+		const __m128 i1f = reverseSSE2(i1);
+
+		_mm_storeu_ps(&zb[0].re, _mm_unpacklo_ps(r0, i0b));
+		_mm_storeu_ps(&zb[2].re, _mm_unpackhi_ps(r0, i0b));
+		_mm_storeu_ps(&zf[0].re, _mm_unpacklo_ps(r1, i1f));
+		_mm_storeu_ps(&zf[2].re, _mm_unpackhi_ps(r1, i1f));
+	}
+}
+
+/** Reconstruct the full inverse MDCT output from its middle half, by symmetry. */
+PHAETHON_TARGET_SSE2 static void imdctMirrorSSE2(float *output, int size) {
+	const int size2 = size >> 1;
+	const int size4 = size >> 2;
+
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+
+	for (int k = 0; k < size4; k += 4) {
+		const __m128 a = reverseSSE2(_mm_loadu_ps(output + size2 - k - 4));
+		const __m128 b = reverseSSE2(_mm_loadu_ps(output + size2 + k));
+
+		_mm_storeu_ps(output + k           , _mm_xor_ps(a, signMask));
+		_mm_storeu_ps(output + size - k - 4, b);
+	}
+}
+
+#endif // PHAETHON_SIMD_X86
+
 void MDCT::calcMDCT(float *output, const float *input) {
 	Complex *x = reinterpret_cast<Complex *>(output);
 
@@ -132,6 +241,13 @@ void MDCT::calcIMDCT(float *output, const float *input) {
 
 	calcHalfIMDCT(output + size4, input);
 
+#ifdef PHAETHON_SIMD_X86
+	if (_simd) {
+		imdctMirrorSSE2(output, _size);
+		return;
+	}
+#endif
+
 	for (int k = 0; k < size4; k++) {
 		output[        k    ] = -output[size2 - k - 1];
 		output[_size - k - 1] =  output[size2 + k    ];
@@ -147,6 +263,17 @@ void MDCT::calcHalfIMDCT(float *output, const float *input) {
 
 	const uint16 *revTab = _fft->getRevTab();
 
+#ifdef PHAETHON_SIMD_X86
+	if (_simd) {
+		imdctPreRotateSSE2(z, input, revTab, _tCos.get(), _tSin, size2, size4);
+
+		_fft->calc(z);
+
+		imdctPostRotateSSE2(z, _tCos.get(), _tSin, size8);
+		return;
+	}
+#endif
+
 	// Pre rotation
 	const float *in1 = input;
 	const float *in2 = input + size2 - 1;
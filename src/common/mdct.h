@@ -77,6 +77,8 @@ private:
 	int _bits;
 	int _size;
 
+	bool _simd; ///< Use the SSE2 rotations?
+
 	std::unique_ptr<float[]> _tCos;
 	float *_tSin;
 
@@ -0,0 +1,200 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Processing a sequence of data blocks on several threads, in order.
+ */
+
+#include <memory>
+#include <exception>
+#include <deque>
+#include <map>
+
+#include "src/common/orderedprocessor.h"
+#include "src/common/util.h"
+#include "src/common/mutex.h"
+#include "src/common/thread.h"
+
+namespace Common {
+
+/** A data block on its way through processOrdered(). */
+struct OrderedBlock {
+	size_t index;
+	std::vector<byte> data;
+
+	bool processed;
+	std::exception_ptr error;
+
+	OrderedBlock(size_t i) : index(i), processed(false) {
+	}
+};
+
+/** The state shared between processOrdered() and its workers. */
+struct OrderedQueue {
+	std::mutex mutex;
+
+	std::condition_variable blockRead;      ///< A new block is waiting to be processed.
+	std::condition_variable blockProcessed; ///< A block has been processed.
+
+	std::deque<OrderedBlock *> toProcess;
+
+	bool quit;
+
+	OrderedQueue() : quit(false) {
+	}
+};
+
+/** Process a block, keeping any exception for the writer. */
+static void processBlock(OrderedQueue &queue, OrderedBlock &block, const BlockFunction &process) {
+	try {
+		process(block.index, block.data);
+	} catch (...) {
+		block.error = std::current_exception();
+	}
+
+	std::lock_guard<std::mutex> lock(queue.mutex);
+
+	block.processed = true;
+	queue.blockProcessed.notify_all();
+}
+
+static void processBlocks(OrderedQueue &queue, const BlockFunction &process) {
+	while (true) {
+		OrderedBlock *block = 0;
+
+		{
+			std::unique_lock<std::mutex> lock(queue.mutex);
+			queue.blockRead.wait(lock, [&queue]() { return queue.quit || !queue.toProcess.empty(); });
+
+			if (queue.quit)
+				return;
+
+			block = queue.toProcess.front();
+			queue.toProcess.pop_front();
+		}
+
+		processBlock(queue, *block, process);
+	}
+}
+
+/** Read and write all blocks in order, handing them to the workers for processing in between. */
+static void readWriteBlocks(OrderedQueue &queue, std::map<size_t, std::unique_ptr<OrderedBlock> > &inFlight,
+                            size_t count, size_t maxInFlight, const BlockFunction &read,
+                            const BlockFunction &process, const BlockFunction &write) {
+
+	size_t nextRead = 0;
+	for (size_t nextWrite = 0; nextWrite < count; nextWrite++) {
+		for (; (nextRead < count) && ((nextRead - nextWrite) < maxInFlight); nextRead++) {
+			std::unique_ptr<OrderedBlock> block = std::make_unique<OrderedBlock>(nextRead);
+
+			read(nextRead, block->data);
+
+			std::lock_guard<std::mutex> lock(queue.mutex);
+
+			queue.toProcess.push_back(block.get());
+			queue.blockRead.notify_one();
+
+			inFlight[nextRead] = std::move(block);
+		}
+
+		std::unique_ptr<OrderedBlock> block = std::move(inFlight[nextWrite]);
+		inFlight.erase(nextWrite);
+
+		bool processHere = false;
+
+		{
+			std::unique_lock<std::mutex> lock(queue.mutex);
+
+			// If no worker has picked the block up yet, we process it ourselves instead of waiting
+			if (!queue.toProcess.empty() && (queue.toProcess.front() == block.get())) {
+				queue.toProcess.pop_front();
+				processHere = true;
+			} else
+				queue.blockProcessed.wait(lock, [&block]() { return block->processed; });
+		}
+
+		if (processHere)
+			processBlock(queue, *block, process);
+
+		if (block->error)
+			std::rethrow_exception(block->error);
+
+		write(nextWrite, block->data);
+	}
+}
+
+static void processOrderedSingle(size_t count, const BlockFunction &read, const BlockFunction &process,
+                                 const BlockFunction &write) {
+
+	std::vector<byte> data;
+	for (size_t i = 0; i < count; i++) {
+		data.clear();
+
+		read(i, data);
+		process(i, data);
+		write(i, data);
+	}
+}
+
+void processOrdered(size_t count, const BlockFunction &read, const BlockFunction &process,
+                    const BlockFunction &write, size_t threadCount) {
+
+	threadCount = MIN<size_t>(getThreadCount(threadCount), count);
+	if (threadCount <= 1) {
+		processOrderedSingle(count, read, process, write);
+		return;
+	}
+
+	// Keep every thread busy, with one block ready to go when it's done
+	const size_t maxInFlight = 2 * threadCount;
+
+	OrderedQueue queue;
+
+	/* The reordering buffer: all blocks that have been read, but not yet written.
+	 * It outlives the workers, which might still be processing blocks in it when
+	 * reading or writing fails. */
+	std::map<size_t, std::unique_ptr<OrderedBlock> > inFlight;
+
+	// The calling thread reads and writes, all others process
+	runThreads(threadCount + 1, [&](size_t thread) {
+		if (thread > 0) {
+			processBlocks(queue, process);
+			return;
+		}
+
+		auto stopWorkers = [&queue]() {
+			std::lock_guard<std::mutex> lock(queue.mutex);
+
+			queue.quit = true;
+			queue.blockRead.notify_all();
+		};
+
+		try {
+			readWriteBlocks(queue, inFlight, count, maxInFlight, read, process, write);
+		} catch (...) {
+			stopWorkers();
+			throw;
+		}
+
+		stopWorkers();
+	});
+}
+
+} // End of namespace Common
@@ -0,0 +1,66 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Processing a sequence of data blocks on several threads, in order.
+ */
+
+#ifndef COMMON_ORDEREDPROCESSOR_H
+#define COMMON_ORDEREDPROCESSOR_H
+
+#include <vector>
+#include <functional>
+
+#include "src/common/types.h"
+
+namespace Common {
+
+/** Reads, processes or writes the data block with this index. */
+typedef std::function<void(size_t index, std::vector<byte> &data)> BlockFunction;
+
+/** Process a sequence of data blocks on several threads, reading and writing them in order.
+ *
+ *  Each block is read, processed and written. Reading and writing happen on
+ *  the calling thread, strictly in index order, so they can use streams and
+ *  archives that aren't thread-safe. Only the processing, for example the
+ *  compression of a file, runs on a pool of worker threads. When the next
+ *  block to write hasn't been picked up by a worker yet, the calling thread
+ *  processes it itself.
+ *
+ *  Blocks that finish processing early wait in a reordering buffer until all
+ *  blocks before them have been written. Reading only stays a few blocks
+ *  ahead of writing, so the memory use is bounded by the number of threads,
+ *  not by the number of blocks.
+ *
+ *  If reading, processing or writing a block throws, the workers are stopped
+ *  and the exception is passed on once the blocks before it have been written.
+ *
+ *  @param count       The number of blocks.
+ *  @param read        Read the block with this index into the data.
+ *  @param process     Process the data of a block. Called from several threads at once.
+ *  @param write       Write the processed data of the block.
+ *  @param threadCount The number of threads to use. 0 for one per CPU core.
+ */
+void processOrdered(size_t count, const BlockFunction &read, const BlockFunction &process,
+                    const BlockFunction &write, size_t threadCount = 0);
+
+} // End of namespace Common
+
+#endif // COMMON_ORDEREDPROCESSOR_H
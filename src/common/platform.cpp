@@ -29,6 +29,7 @@
 	#include <windows.h>
 	#include <shellapi.h>
 	#include <wchar.h>
+	#include <io.h>
 #endif
 
 #if defined(UNIX)
@@ -106,11 +107,11 @@ std::FILE *Platform::openFile(const UString &fileName, FileMode mode) {
 	std::FILE *file = 0;
 
 #if defined(WIN32)
-	static const wchar_t * const modeStrings[kFileModeMAX] = { L"rb", L"wb" };
+	static const wchar_t * const modeStrings[kFileModeMAX] = { L"rb", L"wb", L"r+b" };
 
 	file = _wfopen(boost::filesystem::path(fileName.c_str()).c_str(), modeStrings[(uint) mode]);
 #else
-	static const char * const modeStrings[kFileModeMAX] = { "rb", "wb" };
+	static const char * const modeStrings[kFileModeMAX] = { "rb", "wb", "r+b" };
 
 	file = std::fopen(boost::filesystem::path(fileName.c_str()).c_str(), modeStrings[(uint) mode]);
 #endif
@@ -119,6 +120,21 @@ std::FILE *Platform::openFile(const UString &fileName, FileMode mode) {
 }
 // '--- openFile() ---'
 
+// .--- truncateFile() ---.
+bool Platform::truncateFile(std::FILE *file, size_t size) {
+	assert(file);
+
+	if (std::fflush(file) != 0)
+		return false;
+
+#if defined(WIN32)
+	return _chsize_s(_fileno(file), size) == 0;
+#else
+	return ftruncate(fileno(file), size) == 0;
+#endif
+}
+// '--- truncateFile() ---'
+
 // .--- Windows utility functions ---.
 #if defined(WIN32)
 
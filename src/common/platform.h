@@ -36,8 +36,9 @@ namespace Common {
 class Platform {
 public:
 	enum FileMode {
-		kFileModeRead = 0,
-		kFileModeWrite   ,
+		kFileModeRead      = 0,
+		kFileModeWrite        ,
+		kFileModeReadWrite    ,
 
 		kFileModeMAX
 	};
@@ -51,6 +52,9 @@ public:
 	/** Open a file with an UTF-8 encoded name. */
 	static std::FILE *openFile(const UString &fileName, FileMode mode);
 
+	/** Cut off an open file at this size, or extend it with zeroes. */
+	static bool truncateFile(std::FILE *file, size_t size);
+
 	/** Return the OS-specific path of the user's home directory. */
 	static UString getHomeDirectory();
 	/** Return the OS-specific path of the config directory. */
@@ -138,6 +138,14 @@ SeekableSubReadStream::SeekableSubReadStream(SeekableReadStream *parentStream, s
 SeekableSubReadStream::~SeekableSubReadStream() {
 }
 
+size_t SeekableSubReadStream::read(void *dataPtr, size_t dataSize) {
+	// Someone else might have moved the parent stream in the meantime
+	if (_parentStream->pos() != _pos)
+		_parentStream->seek(_pos);
+
+	return SubReadStream::read(dataPtr, dataSize);
+}
+
 size_t SeekableSubReadStream::pos() const {
 	return _pos - _begin;
 }
@@ -353,7 +353,9 @@ protected:
  *  the range [begin, end).
  *  The same caveats apply to SeekableSubReadStream as do to SeekableReadStream.
  *
- *  Manipulating the parent stream directly /will/ mess up a substream.
+ *  Unlike SubReadStream, a SeekableSubReadStream moves the parent stream back
+ *  to its own position before reading, so several substreams of the same
+ *  parent stream (and the parent stream itself) can be used alternately.
  *  @see SubReadStream
  */
 class SeekableSubReadStream : public SubReadStream, public SeekableReadStream {
@@ -362,6 +364,8 @@ public:
 	                      bool disposeParentStream = false);
 	~SeekableSubReadStream();
 
+	size_t read(void *dataPtr, size_t dataSize);
+
 	size_t pos() const;
 	size_t size() const;
 
@@ -377,8 +381,7 @@ protected:
 /** This is a wrapper around SeekableSubReadStream, but it adds non-endian
  *  read methods whose endianness is set on the stream creation.
  *
- *  Manipulating the parent stream directly /will/ mess up a substream.
- *  @see SubReadStream
+ *  @see SeekableSubReadStream
  */
 class SeekableSubReadStreamEndian : public SeekableSubReadStream {
 private:
@@ -0,0 +1,197 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Implementing the read/write stream interface for files.
+ */
+
+#include <cassert>
+
+#include "src/common/readwritefile.h"
+#include "src/common/util.h"
+#include "src/common/error.h"
+#include "src/common/ustring.h"
+#include "src/common/platform.h"
+
+namespace Common {
+
+ReadWriteFile::ReadWriteFile() : _handle(0), _size(kSizeInvalid), _writing(false) {
+}
+
+ReadWriteFile::ReadWriteFile(const UString &fileName) : _handle(0), _size(kSizeInvalid), _writing(false) {
+	if (!open(fileName))
+		throw Exception("Can't open file \"%s\" for updating", fileName.c_str());
+}
+
+ReadWriteFile::~ReadWriteFile() {
+	try {
+		close();
+	} catch (...) {
+	}
+}
+
+bool ReadWriteFile::open(const UString &fileName) {
+	close();
+
+	if (!(_handle = Platform::openFile(fileName, Platform::kFileModeReadWrite)))
+		return false;
+
+	long fileSize = -1;
+	if ((std::fseek(_handle, 0, SEEK_END) != 0) || ((fileSize = std::ftell(_handle)) < 0) ||
+	    (std::fseek(_handle, 0, SEEK_SET) != 0)) {
+
+		close();
+		return false;
+	}
+
+	if ((uint64)((unsigned long)fileSize) > (uint64)0x7FFFFFFFULL) {
+		warning("ReadWriteFile \"%s\" is too big", fileName.c_str());
+
+		close();
+		return false;
+	}
+
+	_size    = (size_t)fileSize;
+	_writing = false;
+
+	return true;
+}
+
+void ReadWriteFile::close() {
+	std::FILE *handle = _handle;
+
+	_handle = 0;
+	_size   = kSizeInvalid;
+
+	if (!handle)
+		return;
+
+	const bool flushed = std::fflush(handle) == 0;
+	std::fclose(handle);
+
+	if (!flushed)
+		throw Exception(kWriteError);
+}
+
+bool ReadWriteFile::isOpen() const {
+	return _handle != 0;
+}
+
+bool ReadWriteFile::eos() const {
+	if (!_handle)
+		return true;
+
+	return std::feof(_handle) != 0;
+}
+
+size_t ReadWriteFile::pos() const {
+	if (!_handle)
+		return kPositionInvalid;
+
+	return (size_t)std::ftell(_handle);
+}
+
+size_t ReadWriteFile::size() const {
+	return _size;
+}
+
+size_t ReadWriteFile::seek(ptrdiff_t offset, Origin whence) {
+	static const int kSeekToWhence[kOriginMAX] = { SEEK_SET, SEEK_CUR, SEEK_END };
+	if (((size_t) whence) >= kOriginMAX)
+		throw Exception(kSeekError);
+
+	if (!_handle)
+		throw Exception(kSeekError);
+
+	size_t oldPos = pos();
+
+	if (std::fseek(_handle, offset, kSeekToWhence[whence]) != 0)
+		throw Exception(kSeekError);
+
+	long p = std::ftell(_handle);
+	if ((p < 0) || ((size_t)p > _size))
+		throw Exception(kSeekError);
+
+	return oldPos;
+}
+
+void ReadWriteFile::switchDirection(bool writing) {
+	if (_writing == writing)
+		return;
+
+	// Switching between reading and writing requires a seek in between
+	if (std::fseek(_handle, 0, SEEK_CUR) != 0)
+		throw Exception(kSeekError);
+
+	_writing = writing;
+}
+
+size_t ReadWriteFile::read(void *dataPtr, size_t dataSize) {
+	if (!_handle)
+		return 0;
+
+	assert(dataPtr);
+
+	switchDirection(false);
+
+	return std::fread(dataPtr, 1, dataSize, _handle);
+}
+
+size_t ReadWriteFile::write(const void *dataPtr, size_t dataSize) {
+	if (!_handle)
+		return 0;
+
+	assert(dataPtr);
+
+	switchDirection(true);
+
+	const size_t written = std::fwrite(dataPtr, 1, dataSize, _handle);
+
+	long p = std::ftell(_handle);
+	if ((p >= 0) && ((size_t)p > _size))
+		_size = (size_t)p;
+
+	return written;
+}
+
+void ReadWriteFile::flush() {
+	if (!_handle)
+		return;
+
+	if (std::fflush(_handle) != 0)
+		throw Exception(kWriteError);
+}
+
+void ReadWriteFile::truncate(size_t size) {
+	if (!_handle)
+		throw Exception(kWriteError);
+
+	const size_t curPos = pos();
+
+	if (!Platform::truncateFile(_handle, size))
+		throw Exception(kWriteError);
+
+	_size = size;
+
+	if (std::fseek(_handle, MIN(curPos, size), SEEK_SET) != 0)
+		throw Exception(kSeekError);
+}
+
+} // End of namespace Common
@@ -0,0 +1,87 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Implementing the read/write stream interface for files.
+ */
+
+#ifndef COMMON_READWRITEFILE_H
+#define COMMON_READWRITEFILE_H
+
+#include <cstdio>
+
+#include <boost/noncopyable.hpp>
+
+#include "src/common/types.h"
+#include "src/common/readwritestream.h"
+
+namespace Common {
+
+class UString;
+
+/** A class for updating an existing file in place. */
+class ReadWriteFile : boost::noncopyable, public SeekableReadWriteStream {
+public:
+	ReadWriteFile();
+	ReadWriteFile(const UString &fileName);
+	~ReadWriteFile();
+
+	/** Try to open the existing file with the given fileName for reading and writing.
+	 *
+	 *  @param  fileName the name of the file to open
+	 *  @return true if file was opened successfully, false otherwise
+	 */
+	bool open(const UString &fileName);
+
+	/** Close the file, if open. */
+	void close();
+
+	/** Checks if the object opened a file successfully.
+	 *
+	 *  @return true if any file is opened, false otherwise.
+	 */
+	bool isOpen() const;
+
+	bool eos() const;
+
+	size_t pos() const;
+	size_t size() const;
+
+	size_t seek(ptrdiff_t offset, Origin whence = kOriginBegin);
+	size_t read(void *dataPtr, size_t dataSize);
+
+	size_t write(const void *dataPtr, size_t dataSize);
+	void flush();
+
+	void truncate(size_t size);
+
+protected:
+	std::FILE *_handle; ///< The actual file handle.
+	size_t _size;       ///< The file's size.
+
+	/** Was the last access a write? C stdio needs a seek before switching directions. */
+	bool _writing;
+
+	void switchDirection(bool writing);
+};
+
+} // End of namespace Common
+
+#endif // COMMON_READWRITEFILE_H
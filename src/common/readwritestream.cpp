@@ -0,0 +1,118 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Streams that can be read from and written to.
+ */
+
+#include <cassert>
+#include <cstring>
+
+#include "src/common/readwritestream.h"
+#include "src/common/util.h"
+#include "src/common/error.h"
+
+namespace Common {
+
+SeekableReadWriteStream::SeekableReadWriteStream() {
+}
+
+SeekableReadWriteStream::~SeekableReadWriteStream() {
+}
+
+
+MemoryReadWriteStream::MemoryReadWriteStream() : _pos(0), _eos(false) {
+}
+
+MemoryReadWriteStream::MemoryReadWriteStream(const byte *data, size_t size) :
+	_data(data, data + size), _pos(0), _eos(false) {
+
+}
+
+MemoryReadWriteStream::~MemoryReadWriteStream() {
+}
+
+const byte *MemoryReadWriteStream::getData() const {
+	return _data.empty() ? 0 : &_data[0];
+}
+
+bool MemoryReadWriteStream::eos() const {
+	return _eos;
+}
+
+size_t MemoryReadWriteStream::pos() const {
+	return _pos;
+}
+
+size_t MemoryReadWriteStream::size() const {
+	return _data.size();
+}
+
+size_t MemoryReadWriteStream::seek(ptrdiff_t offset, Origin whence) {
+	const size_t oldPos = _pos;
+	const size_t newPos = evalSeek(offset, whence, _pos, 0, size());
+	if (newPos > size())
+		throw Exception(kSeekError);
+
+	_pos = newPos;
+	_eos = false;
+
+	return oldPos;
+}
+
+size_t MemoryReadWriteStream::read(void *dataPtr, size_t dataSize) {
+	assert(dataPtr);
+
+	if (dataSize > (_data.size() - _pos)) {
+		dataSize = _data.size() - _pos;
+		_eos = true;
+	}
+
+	if (dataSize > 0)
+		std::memcpy(dataPtr, &_data[_pos], dataSize);
+
+	_pos += dataSize;
+
+	return dataSize;
+}
+
+size_t MemoryReadWriteStream::write(const void *dataPtr, size_t dataSize) {
+	assert(dataPtr);
+
+	if (dataSize == 0)
+		return 0;
+
+	if ((_pos + dataSize) > _data.size())
+		_data.resize(_pos + dataSize);
+
+	std::memcpy(&_data[_pos], dataPtr, dataSize);
+
+	_pos += dataSize;
+
+	return dataSize;
+}
+
+void MemoryReadWriteStream::truncate(size_t size) {
+	_data.resize(size);
+
+	_pos = MIN(_pos, size);
+}
+
+} // End of namespace Common
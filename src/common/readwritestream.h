@@ -0,0 +1,85 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Streams that can be read from and written to.
+ */
+
+#ifndef COMMON_READWRITESTREAM_H
+#define COMMON_READWRITESTREAM_H
+
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+
+#include "src/common/types.h"
+#include "src/common/readstream.h"
+#include "src/common/writestream.h"
+
+namespace Common {
+
+/** A stream that can be read from, written to and seeked in, like a file opened for updating.
+ *
+ *  Reading and writing share the same position. Writing past the end of the
+ *  stream extends it.
+ */
+class SeekableReadWriteStream : public SeekableReadStream, public WriteStream {
+public:
+	SeekableReadWriteStream();
+	~SeekableReadWriteStream();
+
+	/** Cut off the stream at this size, or extend it with zeroes. */
+	virtual void truncate(size_t size) = 0;
+};
+
+/** A read/write stream holding its data in memory. */
+class MemoryReadWriteStream : boost::noncopyable, public SeekableReadWriteStream {
+public:
+	/** Create an empty stream. */
+	MemoryReadWriteStream();
+	/** Create a stream holding a copy of this data. */
+	MemoryReadWriteStream(const byte *data, size_t size);
+	~MemoryReadWriteStream();
+
+	/** Return the stream's current data. */
+	const byte *getData() const;
+
+	bool eos() const;
+
+	size_t pos() const;
+	size_t size() const;
+
+	size_t seek(ptrdiff_t offset, Origin whence = kOriginBegin);
+	size_t read(void *dataPtr, size_t dataSize);
+
+	size_t write(const void *dataPtr, size_t dataSize);
+
+	void truncate(size_t size);
+
+private:
+	std::vector<byte> _data;
+
+	size_t _pos;
+	bool   _eos;
+};
+
+} // End of namespace Common
+
+#endif // COMMON_READWRITESTREAM_H
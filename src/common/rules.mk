@@ -47,21 +47,29 @@ src_common_libcommon_la_SOURCES += \
     src/common/ustring.h \
     src/common/hash.h \
     src/common/md5.h \
+    src/common/xxhash.h \
     src/common/blowfish.h \
     src/common/deflate.h \
     src/common/lzma.h \
     src/common/readfile.h \
     src/common/writefile.h \
+    src/common/readwritestream.h \
+    src/common/readwritefile.h \
     src/common/filepath.h \
     src/common/filelist.h \
     src/common/filetree.h \
+    src/common/filewatcher.h \
     src/common/zipfile.h \
+    src/common/zipwriter.h \
+    src/common/orderedprocessor.h \
     src/common/bitstream.h \
     src/common/huffman.h \
     src/common/sinewindows.h \
     src/common/cosinetables.h \
     src/common/fft.h \
     src/common/mdct.h \
+    src/common/cpu.h \
+    src/common/floatdsp.h \
     src/common/mutex.h \
     src/common/thread.h \
     src/common/binsearch.h \
@@ -79,6 +87,7 @@ src_common_libcommon_la_SOURCES += \
     src/common/memwritestream.cpp \
     src/common/maths.cpp \
     src/common/md5.cpp \
+    src/common/xxhash.cpp \
     src/common/blowfish.cpp \
     src/common/deflate.cpp \
     src/common/lzma.cpp \
@@ -86,15 +95,22 @@ src_common_libcommon_la_SOURCES += \
     src/common/ustring.cpp \
     src/common/readfile.cpp \
     src/common/writefile.cpp \
+    src/common/readwritestream.cpp \
+    src/common/readwritefile.cpp \
     src/common/filepath.cpp \
     src/common/filelist.cpp \
     src/common/filetree.cpp \
+    src/common/filewatcher.cpp \
     src/common/zipfile.cpp \
+    src/common/zipwriter.cpp \
+    src/common/orderedprocessor.cpp \
     src/common/huffman.cpp \
     src/common/sinewindows.cpp \
     src/common/cosinetables.cpp \
     src/common/fft.cpp \
     src/common/mdct.cpp \
+    src/common/cpu.cpp \
+    src/common/floatdsp.cpp \
     src/common/thread.cpp \
     src/common/streamtokenizer.cpp \
     $(EMPTY)
@@ -23,9 +23,12 @@
  */
 
 #include <system_error>
+#include <exception>
+#include <vector>
 
 #include "src/common/thread.h"
 #include "src/common/util.h"
+#include "src/common/mutex.h"
 
 namespace Common {
 
@@ -111,4 +114,68 @@ int Thread::threadHelper(void *obj) {
 	return 0;
 }
 
+
+size_t getThreadCount(size_t threadCount) {
+	if (threadCount == 0)
+		threadCount = std::thread::hardware_concurrency();
+
+	// hardware_concurrency() returns 0 if it doesn't know
+	return MAX<size_t>(1, threadCount);
+}
+
+void runThreads(size_t threadCount, const std::function<void(size_t thread)> &function) {
+	std::mutex errorMutex;
+	std::exception_ptr error;
+
+	auto run = [&](size_t thread) {
+		try {
+			function(thread);
+		} catch (...) {
+			std::lock_guard<std::mutex> lock(errorMutex);
+
+			if (!error)
+				error = std::current_exception();
+		}
+	};
+
+	std::vector<std::thread> threads;
+	threads.reserve(threadCount);
+
+	for (size_t i = 1; i < threadCount; i++) {
+		try {
+			threads.emplace_back(run, i);
+		} catch (const std::system_error &) {
+			// Make do with the threads we've got
+			break;
+		}
+	}
+
+	if (threadCount > 0)
+		run(0);
+
+	for (std::vector<std::thread>::iterator t = threads.begin(); t != threads.end(); ++t)
+		t->join();
+
+	if (error)
+		std::rethrow_exception(error);
+}
+
+void parallelFor(size_t count, const std::function<void(size_t index, size_t thread)> &function,
+                 size_t threadCount) {
+
+	std::atomic<size_t> next(0);
+	std::atomic<bool> failed(false);
+
+	runThreads(MIN<size_t>(getThreadCount(threadCount), count), [&](size_t thread) {
+		try {
+			for (size_t i = next++; (i < count) && !failed; i = next++)
+				function(i, thread);
+		} catch (...) {
+			// Don't start anything new, the exception ends the whole loop anyway
+			failed = true;
+			throw;
+		}
+	});
+}
+
 } // End of namespace Common
@@ -32,6 +32,7 @@
 #endif
 
 #include <atomic>
+#include <functional>
 
 #include <boost/noncopyable.hpp>
 
@@ -62,6 +63,34 @@ private:
 	static int threadHelper(void *obj);
 };
 
+/** Return the number of threads to use for this requested count, where 0 means one per CPU core. */
+size_t getThreadCount(size_t threadCount = 0);
+
+/** Run a function on several threads at once, and wait for all of them to finish.
+ *
+ *  The function is called with the number of the thread it runs on, from 0 to
+ *  threadCount - 1. Thread 0 is the calling thread. If not all threads can be
+ *  created, the function runs on fewer threads.
+ *
+ *  If the function throws, in any thread, the first exception is rethrown in
+ *  the calling thread once all threads have finished.
+ */
+void runThreads(size_t threadCount, const std::function<void(size_t thread)> &function);
+
+/** Call a function for every index from 0 to count - 1, spread over several threads.
+ *
+ *  The function is called with the index and the number of the thread it runs
+ *  on, like with runThreads(). Every thread takes the next index not yet taken,
+ *  so the indices are handed out roughly in order.
+ *
+ *  If the function throws, no further indices are started, and the first
+ *  exception is rethrown in the calling thread once all threads have finished.
+ *
+ *  If threadCount is 0, one thread per CPU core is used.
+ */
+void parallelFor(size_t count, const std::function<void(size_t index, size_t thread)> &function,
+                 size_t threadCount = 0);
+
 } // End of namespace Common
 
 #endif // COMMON_THREAD_H
@@ -0,0 +1,182 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Fast, non-cryptographic hashing of data using the xxHash64 algorithm.
+ */
+
+/* Based on the xxHash64 specification by Yann Collet
+ * (<https://github.com/Cyan4973/xxHash/blob/dev/doc/xxhash_spec.md>).
+ */
+
+#include <cstring>
+
+#include "src/common/xxhash.h"
+#include "src/common/util.h"
+#include "src/common/endianness.h"
+#include "src/common/readstream.h"
+
+namespace Common {
+
+static const uint64 kPrime1 = 0x9E3779B185EBCA87ULL;
+static const uint64 kPrime2 = 0xC2B2AE3D27D4EB4FULL;
+static const uint64 kPrime3 = 0x165667B19E3779F9ULL;
+static const uint64 kPrime4 = 0x85EBCA77C2B2AE63ULL;
+static const uint64 kPrime5 = 0x27D4EB2F165667C5ULL;
+
+static const size_t kStripeLength = 32;
+
+static inline uint64 rotl64(uint64 x, int r) {
+	return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64 xxh64Round(uint64 acc, uint64 input) {
+	acc += input * kPrime2;
+	acc  = rotl64(acc, 31);
+	acc *= kPrime1;
+
+	return acc;
+}
+
+static inline uint64 xxh64Merge(uint64 acc, uint64 val) {
+	acc ^= xxh64Round(0, val);
+	acc  = acc * kPrime1 + kPrime4;
+
+	return acc;
+}
+
+struct XXH64Context {
+	uint64 acc[4];
+
+	byte   buffer[kStripeLength]; ///< The start of a stripe we didn't get completely yet.
+	size_t bufferSize;
+
+	uint64 length;
+	uint64 seed;
+
+	XXH64Context(uint64 s) : bufferSize(0), length(0), seed(s) {
+		acc[0] = seed + kPrime1 + kPrime2;
+		acc[1] = seed + kPrime2;
+		acc[2] = seed;
+		acc[3] = seed - kPrime1;
+	}
+};
+
+static inline void xxh64Stripe(XXH64Context &ctx, const byte *data) {
+	ctx.acc[0] = xxh64Round(ctx.acc[0], READ_LE_UINT64(data     ));
+	ctx.acc[1] = xxh64Round(ctx.acc[1], READ_LE_UINT64(data +  8));
+	ctx.acc[2] = xxh64Round(ctx.acc[2], READ_LE_UINT64(data + 16));
+	ctx.acc[3] = xxh64Round(ctx.acc[3], READ_LE_UINT64(data + 24));
+}
+
+static void xxh64Update(XXH64Context &ctx, const byte *data, size_t size) {
+	ctx.length += size;
+
+	// Complete a stripe we started earlier
+	if (ctx.bufferSize > 0) {
+		const size_t n = MIN(size, kStripeLength - ctx.bufferSize);
+
+		std::memcpy(ctx.buffer + ctx.bufferSize, data, n);
+		ctx.bufferSize += n;
+
+		data += n;
+		size -= n;
+
+		if (ctx.bufferSize < kStripeLength)
+			return;
+
+		xxh64Stripe(ctx, ctx.buffer);
+		ctx.bufferSize = 0;
+	}
+
+	for (; size >= kStripeLength; data += kStripeLength, size -= kStripeLength)
+		xxh64Stripe(ctx, data);
+
+	std::memcpy(ctx.buffer, data, size);
+	ctx.bufferSize = size;
+}
+
+static uint64 xxh64Final(const XXH64Context &ctx) {
+	uint64 hash;
+
+	if (ctx.length >= kStripeLength) {
+		hash = rotl64(ctx.acc[0], 1) + rotl64(ctx.acc[1], 7) + rotl64(ctx.acc[2], 12) + rotl64(ctx.acc[3], 18);
+
+		hash = xxh64Merge(hash, ctx.acc[0]);
+		hash = xxh64Merge(hash, ctx.acc[1]);
+		hash = xxh64Merge(hash, ctx.acc[2]);
+		hash = xxh64Merge(hash, ctx.acc[3]);
+	} else
+		hash = ctx.seed + kPrime5;
+
+	hash += ctx.length;
+
+	const byte *data = ctx.buffer;
+	size_t      size = ctx.bufferSize;
+
+	for (; size >= 8; data += 8, size -= 8) {
+		hash ^= xxh64Round(0, READ_LE_UINT64(data));
+		hash  = rotl64(hash, 27) * kPrime1 + kPrime4;
+	}
+
+	if (size >= 4) {
+		hash ^= (uint64) READ_LE_UINT32(data) * kPrime1;
+		hash  = rotl64(hash, 23) * kPrime2 + kPrime3;
+
+		data += 4;
+		size -= 4;
+	}
+
+	for (; size > 0; data++, size--) {
+		hash ^= *data * kPrime5;
+		hash  = rotl64(hash, 11) * kPrime1;
+	}
+
+	hash ^= hash >> 33;
+	hash *= kPrime2;
+	hash ^= hash >> 29;
+	hash *= kPrime3;
+	hash ^= hash >> 32;
+
+	return hash;
+}
+
+uint64 hashXXH64(ReadStream &stream, uint64 seed) {
+	XXH64Context ctx(seed);
+
+	byte buf[4096];
+	while (!stream.eos()) {
+		size_t bufRead = stream.read(buf, 4096);
+
+		xxh64Update(ctx, buf, bufRead);
+	}
+
+	return xxh64Final(ctx);
+}
+
+uint64 hashXXH64(const byte *data, size_t dataLength, uint64 seed) {
+	XXH64Context ctx(seed);
+
+	xxh64Update(ctx, data, dataLength);
+
+	return xxh64Final(ctx);
+}
+
+} // End of namespace Common
@@ -0,0 +1,45 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Fast, non-cryptographic hashing of data using the xxHash64 algorithm.
+ */
+
+#ifndef COMMON_XXHASH_H
+#define COMMON_XXHASH_H
+
+#include "src/common/types.h"
+
+namespace Common {
+
+class ReadStream;
+
+/** Hash the stream using xxHash64.
+ *
+ *  xxHash64 is a lot faster than MD5, but it's not a cryptographic hash.
+ *  It's meant for finding data that's probably identical.
+ */
+uint64 hashXXH64(ReadStream &stream, uint64 seed = 0);
+/** Hash the data using xxHash64. */
+uint64 hashXXH64(const byte *data, size_t dataLength, uint64 seed = 0);
+
+} // End of namespace Common
+
+#endif // COMMON_XXHASH_H
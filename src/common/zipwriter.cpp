@@ -0,0 +1,228 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  ZIP file compression.
+ */
+
+#include <cassert>
+#include <cstring>
+
+#include <zlib.h>
+
+#include "src/common/zipwriter.h"
+#include "src/common/error.h"
+#include "src/common/util.h"
+#include "src/common/readstream.h"
+#include "src/common/writestream.h"
+#include "src/common/deflate.h"
+#include "src/common/orderedprocessor.h"
+
+namespace Common {
+
+static const uint32 kLocalHeaderTag   = 0x04034B50;
+static const uint32 kCentralHeaderTag = 0x02014B50;
+static const uint32 kEndRecordTag     = 0x06054B50;
+
+static const uint16 kVersionNeeded = 20; ///< ZIP 2.0, for DEFLATE.
+static const uint16 kFlagUTF8      = 0x0800;
+
+// We don't keep modification times around, so every file is from 1980-01-01, 00:00
+static const uint16 kDOSTime = 0x0000;
+static const uint16 kDOSDate = 0x0021;
+
+static const uint16 kMethodStore   = 0;
+static const uint16 kMethodDeflate = 8;
+
+ZipWriter::ZipWriter() : _compressionLevel(kCompressionLevelDefault) {
+}
+
+ZipWriter::~ZipWriter() {
+}
+
+void ZipWriter::setCompressionLevel(int level) {
+	_compressionLevel = level;
+}
+
+void ZipWriter::add(const UString &name, SeekableReadStream *data, bool compress) {
+	assert(data);
+
+	std::unique_ptr<SeekableReadStream> stream(data);
+
+	if (name.empty())
+		throw Exception("ZIP file names can't be empty");
+
+	if (std::strlen(name.c_str()) > 0xFFFF)
+		throw Exception("ZIP file name too long (\"%s\")", name.c_str());
+
+	if (_files.size() >= 0xFFFF)
+		throw Exception("Too many files for a ZIP without ZIP64");
+
+	if (stream->size() > 0xFFFFFFFF)
+		throw Exception("File \"%s\" too large for a ZIP without ZIP64", name.c_str());
+
+	_files.push_back(File());
+
+	_files.back().name     = name;
+	_files.back().data     = std::move(stream);
+	_files.back().compress = compress;
+}
+
+size_t ZipWriter::getFileCount() const {
+	return _files.size();
+}
+
+void ZipWriter::readFile(File &file, std::vector<byte> &data) const {
+	file.data->seek(0);
+
+	data.resize(file.data->size());
+	if (!data.empty() && (file.data->read(&data[0], data.size()) != data.size()))
+		throw Exception(kReadError);
+}
+
+void ZipWriter::packFile(File &file, std::vector<byte> &data) const {
+	file.size       = data.size();
+	file.packedSize = data.size();
+	file.method     = kMethodStore;
+
+	file.crc = crc32(0, data.empty() ? Z_NULL : &data[0], data.size());
+
+	if (!file.compress || data.empty())
+		return;
+
+	size_t packedSize = 0;
+	std::unique_ptr<byte[]> packed(compressDeflate(&data[0], data.size(), packedSize,
+	                                               kWindowBitsMaxRaw, _compressionLevel));
+
+	// Data that doesn't get any smaller is better off stored
+	if (packedSize >= data.size())
+		return;
+
+	file.packedSize = packedSize;
+	file.method     = kMethodDeflate;
+
+	data.assign(packed.get(), packed.get() + packedSize);
+}
+
+static uint16 getNameFlags(const UString &name) {
+	for (UString::iterator c = name.begin(); c != name.end(); ++c)
+		if (*c >= 0x80)
+			return kFlagUTF8;
+
+	return 0;
+}
+
+size_t ZipWriter::writeLocalHeader(WriteStream &zip, const File &file) {
+	const size_t nameLength = std::strlen(file.name.c_str());
+
+	zip.writeUint32LE(kLocalHeaderTag);
+	zip.writeUint16LE(kVersionNeeded);
+	zip.writeUint16LE(getNameFlags(file.name));
+	zip.writeUint16LE(file.method);
+	zip.writeUint16LE(kDOSTime);
+	zip.writeUint16LE(kDOSDate);
+	zip.writeUint32LE(file.crc);
+	zip.writeUint32LE(file.packedSize);
+	zip.writeUint32LE(file.size);
+	zip.writeUint16LE(nameLength);
+	zip.writeUint16LE(0); // Extra field length
+
+	zip.write(file.name.c_str(), nameLength);
+
+	return 30 + nameLength;
+}
+
+size_t ZipWriter::writeCentralHeader(WriteStream &zip, const File &file) {
+	const size_t nameLength = std::strlen(file.name.c_str());
+
+	zip.writeUint32LE(kCentralHeaderTag);
+	zip.writeUint16LE(kVersionNeeded); // Version made by
+	zip.writeUint16LE(kVersionNeeded);
+	zip.writeUint16LE(getNameFlags(file.name));
+	zip.writeUint16LE(file.method);
+	zip.writeUint16LE(kDOSTime);
+	zip.writeUint16LE(kDOSDate);
+	zip.writeUint32LE(file.crc);
+	zip.writeUint32LE(file.packedSize);
+	zip.writeUint32LE(file.size);
+	zip.writeUint16LE(nameLength);
+	zip.writeUint16LE(0); // Extra field length
+	zip.writeUint16LE(0); // Comment length
+	zip.writeUint16LE(0); // Disk number
+	zip.writeUint16LE(0); // Internal file attributes
+	zip.writeUint32LE(0); // External file attributes
+	zip.writeUint32LE(file.offset);
+
+	zip.write(file.name.c_str(), nameLength);
+
+	return 46 + nameLength;
+}
+
+void ZipWriter::write(WriteStream &zip, size_t threadCount) {
+	uint64 offset = 0;
+
+	processOrdered(_files.size(), [this](size_t index, std::vector<byte> &data) {
+		readFile(_files[index], data);
+	}, [this](size_t index, std::vector<byte> &data) {
+		packFile(_files[index], data);
+	}, [this, &zip, &offset](size_t index, std::vector<byte> &data) {
+		File &file = _files[index];
+
+		if (offset > 0xFFFFFFFF)
+			throw Exception("ZIP file too large without ZIP64");
+
+		file.offset = offset;
+
+		offset += writeLocalHeader(zip, file);
+
+		if (!data.empty() && (zip.write(&data[0], data.size()) != data.size()))
+			throw Exception(kWriteError);
+
+		offset += data.size();
+
+		// We're done with the source data
+		file.data.reset();
+	}, threadCount);
+
+	if (offset > 0xFFFFFFFF)
+		throw Exception("ZIP file too large without ZIP64");
+
+	const uint64 centralDirOffset = offset;
+
+	for (std::vector<File>::const_iterator f = _files.begin(); f != _files.end(); ++f)
+		offset += writeCentralHeader(zip, *f);
+
+	const uint64 centralDirSize = offset - centralDirOffset;
+
+	zip.writeUint32LE(kEndRecordTag);
+	zip.writeUint16LE(0); // Number of this disk
+	zip.writeUint16LE(0); // Disk with the central directory
+	zip.writeUint16LE(_files.size());
+	zip.writeUint16LE(_files.size());
+	zip.writeUint32LE(centralDirSize);
+	zip.writeUint32LE(centralDirOffset);
+	zip.writeUint16LE(0); // Comment length
+
+	zip.flush();
+
+	_files.clear();
+}
+
+} // End of namespace Common
@@ -0,0 +1,110 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  ZIP file compression.
+ */
+
+#ifndef COMMON_ZIPWRITER_H
+#define COMMON_ZIPWRITER_H
+
+#include <vector>
+#include <memory>
+
+#include <boost/noncopyable.hpp>
+
+#include "src/common/types.h"
+#include "src/common/ustring.h"
+
+namespace Common {
+
+class SeekableReadStream;
+class WriteStream;
+
+/** A class writing ZIP files.
+ *
+ *  The files are compressed on several threads at once, while the ZIP file
+ *  itself is written as one continuous stream, file after file, in the order
+ *  they were added. Only a few files are held in memory at any time.
+ *
+ *  ZIP64 isn't supported, so there can't be more than 65535 files, and
+ *  neither the files nor the ZIP file itself can be larger than 4GB.
+ */
+class ZipWriter : boost::noncopyable {
+public:
+	ZipWriter();
+	~ZipWriter();
+
+	/** Set the compression level to use, from kCompressionLevelNone to kCompressionLevelBest. */
+	void setCompressionLevel(int level);
+
+	/** Add a file to the ZIP.
+	 *
+	 *  The ZipWriter takes over the stream. It is only read when the ZIP is written.
+	 *
+	 *  @param name     The file's name, including its path within the ZIP.
+	 *  @param data     The file's contents.
+	 *  @param compress Compress the file? Otherwise, it's stored as-is. Files
+	 *                  that are already compressed, like Ogg Vorbis sound or
+	 *                  Bink videos, don't get any smaller anyway.
+	 */
+	void add(const UString &name, SeekableReadStream *data, bool compress = true);
+
+	/** Return the number of files added so far. */
+	size_t getFileCount() const;
+
+	/** Write the ZIP file into this stream.
+	 *
+	 *  All added files are written, and then removed from the ZipWriter.
+	 *
+	 *  @param zip         The stream to write the ZIP file into.
+	 *  @param threadCount The number of threads to compress on. 0 for one per CPU core.
+	 */
+	void write(WriteStream &zip, size_t threadCount = 0);
+
+private:
+	/** A file to write. */
+	struct File {
+		UString name;
+		std::unique_ptr<SeekableReadStream> data;
+
+		bool compress;
+
+		uint16 method;     ///< The compression method used. 0 for stored, 8 for DEFLATE.
+		uint32 crc;        ///< The CRC-32 of the uncompressed data.
+		uint32 size;       ///< The size of the uncompressed data.
+		uint32 packedSize; ///< The size of the data within the ZIP.
+		uint32 offset;     ///< The offset of the file's local header within the ZIP.
+	};
+
+	std::vector<File> _files;
+
+	int _compressionLevel;
+
+	void readFile(File &file, std::vector<byte> &data) const;
+	void packFile(File &file, std::vector<byte> &data) const;
+
+	static size_t writeLocalHeader(WriteStream &zip, const File &file);
+	static size_t writeCentralHeader(WriteStream &zip, const File &file);
+};
+
+} // End of namespace Common
+
+#endif // COMMON_ZIPWRITER_H
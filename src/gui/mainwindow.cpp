@@ -24,7 +24,10 @@
 
 #include <cassert>
 
+#include <algorithm>
 #include <deque>
+#include <map>
+#include <set>
 #include <memory>
 
 #include <QAction>
@@ -41,6 +44,9 @@
 #include <QFileDialog>
 #include <QStandardPaths>
 #include <QStatusBar>
+#include <QInputDialog>
+#include <QTimer>
+#include <QtConcurrentRun>
 
 #include <boost/scope_exit.hpp>
 
@@ -49,7 +55,20 @@
 #include "src/cline.h"
 
 #include "src/common/util.h"
+#include "src/common/error.h"
+#include "src/common/strutil.h"
+#include "src/common/hash.h"
+#include "src/common/filepath.h"
+#include "src/common/readfile.h"
 #include "src/common/writefile.h"
+#include "src/common/filewatcher.h"
+
+#include "src/aurora/util.h"
+#include "src/aurora/archive.h"
+#include "src/aurora/archiveloader.h"
+#include "src/aurora/directoryarchive.h"
+#include "src/aurora/duplicatefinder.h"
+#include "src/aurora/resourceextractor.h"
 
 #include "src/gui/mainwindow.h"
 #include "src/gui/panelresourceinfo.h"
@@ -74,7 +93,9 @@ W_OBJECT_IMPL(MainWindow)
 
 MainWindow::MainWindow(QWidget *parent, const char *title, const QSize &size, const char *path) :
 	QMainWindow(parent), _status(statusBar()), _panelManager(new PanelManager()),
-	_watcher(new QFutureWatcher<void>(this)) {
+	_watcher(new QFutureWatcher<void>(this)), _searchWatcher(new QFutureWatcher<void>(this)),
+	_duplicatesWatcher(new QFutureWatcher<void>(this)), _extractWatcher(new QFutureWatcher<void>(this)),
+	_fileWatchTimer(new QTimer(this)) {
 	/* Window setup. */
 	setWindowTitle(title);
 	resize(size);
@@ -85,6 +106,9 @@ MainWindow::MainWindow(QWidget *parent, const char *title, const QSize &size, co
 	_actionClose = new QAction(this);
 	_actionQuit = new QAction(this);
 	_actionAbout = new QAction(this);
+	_actionSearch = new QAction(this);
+	_actionFindDuplicates = new QAction(this);
+	_actionExtractArchive = new QAction(this);
 
 	_actionOpenDirectory->setText(tr("&Open directory"));
 	_actionOpenDirectory->setShortcut(QKeySequence(Qt::CTRL + Qt::Key_O));
@@ -93,6 +117,13 @@ MainWindow::MainWindow(QWidget *parent, const char *title, const QSize &size, co
 	_actionClose->setShortcut(QKeySequence(Qt::CTRL + Qt::Key_W));
 	_actionQuit->setText(tr("&Quit"));
 	_actionQuit->setShortcut(QKeySequence(Qt::CTRL + Qt::Key_Q));
+	_actionSearch->setText(tr("&Search..."));
+	_actionSearch->setShortcut(QKeySequence(Qt::CTRL + Qt::Key_F));
+	_actionSearch->setEnabled(false);
+	_actionFindDuplicates->setText(tr("Find &duplicates..."));
+	_actionFindDuplicates->setEnabled(false);
+	_actionExtractArchive->setText(tr("E&xtract archive..."));
+	_actionExtractArchive->setEnabled(false);
 	_actionAbout->setText(tr("&About"));
 	_actionAbout->setShortcut(QKeySequence(Qt::Key_F1));
 
@@ -108,6 +139,10 @@ MainWindow::MainWindow(QWidget *parent, const char *title, const QSize &size, co
 	_menuFile->addSeparator();
 	_menuFile->addAction(_actionClose);
 	_menuFile->addSeparator();
+	_menuFile->addAction(_actionSearch);
+	_menuFile->addAction(_actionFindDuplicates);
+	_menuFile->addAction(_actionExtractArchive);
+	_menuFile->addSeparator();
 	_menuFile->addAction(_actionQuit);
 	_menuFile->setTitle("&File");
 	_menuHelp->addAction(_actionAbout);
@@ -121,6 +156,15 @@ MainWindow::MainWindow(QWidget *parent, const char *title, const QSize &size, co
 	QObject::connect(_actionClose, &QAction::triggered, this, &MainWindow::slotClose);
 	QObject::connect(_actionQuit, &QAction::triggered, this, &MainWindow::slotQuit);
 	QObject::connect(_actionAbout, &QAction::triggered, this, &MainWindow::slotAbout);
+	QObject::connect(_actionSearch, &QAction::triggered, this, &MainWindow::slotSearch);
+	QObject::connect(_searchWatcher, &QFutureWatcher<void>::finished, this, &MainWindow::searchFinish);
+	QObject::connect(_actionFindDuplicates, &QAction::triggered, this, &MainWindow::slotFindDuplicates);
+	QObject::connect(_duplicatesWatcher, &QFutureWatcher<void>::finished, this, &MainWindow::findDuplicatesFinish);
+	QObject::connect(_actionExtractArchive, &QAction::triggered, this, &MainWindow::slotExtractArchive);
+	QObject::connect(_extractWatcher, &QFutureWatcher<void>::finished, this, &MainWindow::extractArchiveFinish);
+
+	_fileWatchTimer->setInterval(kFileWatchInterval);
+	QObject::connect(_fileWatchTimer, &QTimer::timeout, this, &MainWindow::applyFileChanges);
 
 	/* Layout. */
 	_centralWidget = new QWidget(this);
@@ -293,26 +337,28 @@ void MainWindow::open(const QString &path) {
 	// popped in openFinish
 	_status.push("Populating resource tree...");
 
-	try {
-		_files.readPath(Common::UString(path.toStdString()), -1);
-	} catch (Common::Exception &e) {
-		_status.pop();
+	_treeModel = std::make_unique<ResourceTree>(this, _treeView);
 
-		Common::printException(e, "WARNING: ");
-		return;
-	}
+	// Enters populate thread in here, which also reads the files from disk.
+	_treeModel->populate(_files, Common::UString(path.toStdString()));
+}
 
-	_treeModel = std::make_unique<ResourceTree>(this, _treeView);
+void MainWindow::openFinish() {
+	// The populate thread couldn't read the path
+	if (_files.isEmpty()) {
+		_treeModel.reset(nullptr);
+		_rootPath = "";
 
-	// Enters populate thread in here.
-	_treeModel->populate(_files.getRoot());
+		_status.pop();
+		return;
+	}
 
-	_log->append(tr("Set root: %1").arg(path));
+	_log->append(tr("Set root: %1").arg(_rootPath));
 
 	_actionClose->setEnabled(true);
-}
+	_actionSearch->setEnabled(true);
+	_actionFindDuplicates->setEnabled(true);
 
-void MainWindow::openFinish() {
 	_proxyModel->setSourceModel(_treeModel.get());
 	_proxyModel->sort(0);
 
@@ -325,11 +371,121 @@ void MainWindow::openFinish() {
 		this, &MainWindow::resourceSelect);
 
 	_status.pop();
+
+	// Keep the tree up to date with what happens on disk
+	if (Common::FileWatcher::isSupported() && _files.getRoot().isDirectory()) {
+		try {
+			_fileWatcher.watch(_files.getRoot().path.generic_string());
+			_fileWatchTimer->start();
+		} catch (Common::Exception &e) {
+			_fileWatcher.clear();
+
+			Common::printException(e, "WARNING: ");
+		}
+	}
+}
+
+void MainWindow::applyFileChanges() {
+	// The background tasks read the file tree, so we can't change it under their feet
+	if (_watcher->isRunning() || _searchWatcher->isRunning() || _duplicatesWatcher->isRunning())
+		return;
+
+	std::vector<Common::FileWatcher::Event> events;
+	_fileWatcher.getEvents(events);
+
+	for (std::vector<Common::FileWatcher::Event>::const_iterator e = events.begin(); e != events.end(); ++e) {
+		const QString path = QString::fromUtf8(e->path.c_str());
+		const boost::filesystem::path fsPath(e->path.c_str());
+
+		try {
+			switch (e->type) {
+				case Common::FileWatcher::kEventCreated: {
+						const bool existed = _files.findEntry(fsPath) != 0;
+
+						const Common::FileTree::Entry *entry = _files.addEntry(fsPath);
+						if (!entry)
+							break;
+
+						// Saving by renaming over an existing file only changes its contents
+						if (existed && !entry->isDirectory()) {
+							applyFileModified(*entry);
+							break;
+						}
+
+						if (existed)
+							_treeModel->removePath(path);
+
+						_treeModel->addPath(*entry);
+						_log->append(tr("Added: %1").arg(path));
+					}
+					break;
+
+				case Common::FileWatcher::kEventRemoved:
+					if (_files.removeEntry(fsPath)) {
+						_treeModel->removePath(path);
+						_log->append(tr("Removed: %1").arg(path));
+					}
+					break;
+
+				case Common::FileWatcher::kEventModified: {
+						const Common::FileTree::Entry *entry = _files.updateEntry(fsPath);
+						if (entry)
+							applyFileModified(*entry);
+					}
+					break;
+
+				case Common::FileWatcher::kEventOverflow: {
+						// We missed changes, so we have to read everything again
+						const QString rootPath = _rootPath;
+
+						_log->append(tr("Too many changes, reopening: %1").arg(rootPath));
+
+						close();
+						open(rootPath);
+					}
+					return;
+			}
+		} catch (Common::Exception &ex) {
+			ex.add("Failed to update \"%s\"", e->path.c_str());
+			Common::printException(ex, "WARNING: ");
+		}
+	}
+
+	// The search index needs to check the archives again
+	if (!events.empty())
+		_searchIndexReady = false;
+}
+
+void MainWindow::applyFileModified(const Common::FileTree::Entry &entry) {
+	// Show the new contents if this is the current item
+	if (_treeModel->updatePath(entry) == _currentItem) {
+		_panelResourceInfo->update(_currentItem);
+		_panelManager->setItem(nullptr);
+
+		if (!_currentItem->isDir() && !_currentItem->isArchive())
+			_panelManager->setItem(_currentItem);
+	}
 }
 
 void MainWindow::close() {
+	// The populate thread fills the file tree
+	_watcher->waitForFinished();
+
+	_fileWatchTimer->stop();
+	_fileWatcher.clear();
+
 	_panelManager->setItem(nullptr);
 
+	// The search index is built from the root path, so wait for it
+	_searchWatcher->waitForFinished();
+	_searchIndex.clear();
+	_searchIndexReady = false;
+	_searchQuery.clear();
+
+	// Same for the duplicates report
+	_duplicatesWatcher->waitForFinished();
+	_extractWatcher->waitForFinished();
+
 	_panelResourceInfo->setButtonsForClosedDir();
 	_panelResourceInfo->clearLabels();
 	_treeView->setModel(nullptr);
@@ -339,10 +495,324 @@ void MainWindow::close() {
 	_rootPath = "";
 
 	_actionClose->setEnabled(false);
+	_actionSearch->setEnabled(false);
+	_actionFindDuplicates->setEnabled(false);
+	_actionExtractArchive->setEnabled(false);
 
 	_status.pop();
 }
 
+void MainWindow::slotSearch() {
+	if (_rootPath.isEmpty())
+		return;
+
+	const QString query = QInputDialog::getText(this, tr("Search"),
+		tr("Find resources whose name, archive or contents contain:"));
+
+	if (query.isEmpty())
+		return;
+
+	if (_searchIndexReady) {
+		search(query);
+		return;
+	}
+
+	// Still building the index. Only the latest query is run once it's done
+	const bool building = !_searchQuery.isEmpty();
+
+	_searchQuery = query;
+	if (building)
+		return;
+
+	// popped in searchFinish
+	_status.push(tr("Indexing resources..."));
+
+	_searchWatcher->setFuture(QtConcurrent::run(this, &MainWindow::buildSearchIndex));
+}
+
+static void findArchives(const Common::FileTree::Entry &entry, std::vector<Common::UString> &archives) {
+	if (!entry.isDirectory()) {
+		if (Aurora::isArchiveType(TypeMan.getFileType(entry.name)))
+			archives.push_back(entry.path.generic_string());
+
+		return;
+	}
+
+	for (std::list<Common::FileTree::Entry>::const_iterator c = entry.children.begin();
+	     c != entry.children.end(); ++c)
+		findArchives(*c, archives);
+}
+
+void MainWindow::buildSearchIndex() {
+	std::vector<Common::UString> archives;
+	findArchives(_files.getRoot(), archives);
+
+	// The index is kept in a file unique to the root path
+	const Common::UString root(_rootPath.toStdString());
+	const Common::UString indexFile = Common::FilePath::getUserDataFile(
+		Common::UString::format("searchindex/%016llX.idx", (unsigned long long) Common::hashStringFNV64(root)));
+
+	try {
+		if (Common::FilePath::isRegularFile(indexFile)) {
+			Common::ReadFile file(indexFile);
+			_searchIndex.load(file);
+
+			if (_searchIndex.isCurrent(archives))
+				return;
+		}
+	} catch (Common::Exception &e) {
+		Common::printException(e, "WARNING: ");
+	}
+
+	_searchIndex.clear();
+	_searchIndex.addArchiveFiles(archives, true);
+
+	try {
+		Common::FilePath::createDirectories(Common::FilePath::getDirectory(indexFile));
+
+		Common::WriteFile file(indexFile);
+		_searchIndex.save(file);
+		file.flush();
+	} catch (Common::Exception &e) {
+		e.add("Failed to save the search index");
+		Common::printException(e, "WARNING: ");
+	}
+}
+
+void MainWindow::searchFinish() {
+	_status.pop();
+
+	// The root path was closed while we were building the index
+	if (_searchQuery.isEmpty())
+		return;
+
+	_searchIndexReady = true;
+
+	const QString query = _searchQuery;
+	_searchQuery.clear();
+
+	search(query);
+}
+
+void MainWindow::search(const QString &query) {
+	static const size_t kMaxHits = 1000;
+
+	const std::vector<Aurora::SearchIndex::Hit> hits =
+		_searchIndex.find(Common::UString(query.toStdString()), kMaxHits + 1);
+
+	_log->append(tr("Search \"%1\": %2 hit(s)").arg(query).arg(MIN(hits.size(), kMaxHits)));
+
+	for (size_t i = 0; i < MIN(hits.size(), kMaxHits); i++) {
+		const QString archive = QString::fromUtf8(hits[i].archive.c_str());
+		const QString name    = QString::fromUtf8(hits[i].name.c_str());
+
+		if (hits[i].inContents)
+			_log->append(tr("  %1: %2 (contents)").arg(archive).arg(name));
+		else
+			_log->append(tr("  %1: %2").arg(archive).arg(name));
+	}
+
+	if (hits.size() > kMaxHits)
+		_log->append(tr("  (more hits not shown)"));
+}
+
+void MainWindow::slotFindDuplicates() {
+	if (_rootPath.isEmpty() || _duplicatesWatcher->isRunning())
+		return;
+
+	const QString fileName = QFileDialog::getSaveFileName(this,
+		tr("Save duplicates report"),
+		"duplicates.txt",
+		tr("Text file (*.txt)"));
+
+	if (fileName.isEmpty())
+		return;
+
+	_duplicatesReport = fileName;
+
+	// popped in findDuplicatesFinish
+	_status.push(tr("Finding duplicate resources..."));
+
+	_duplicatesWatcher->setFuture(QtConcurrent::run(this, &MainWindow::findDuplicates));
+}
+
+static void findOverrides(const Common::FileTree::Entry &entry, std::vector<Common::UString> &overrides) {
+	if (!entry.isDirectory())
+		return;
+
+	if (entry.name.equalsIgnoreCase("override"))
+		overrides.push_back(entry.path.generic_string());
+
+	for (std::list<Common::FileTree::Entry>::const_iterator c = entry.children.begin();
+	     c != entry.children.end(); ++c)
+		findOverrides(*c, overrides);
+}
+
+void MainWindow::findDuplicates() {
+	std::vector<Common::UString> archives, overrides;
+	findArchives(_files.getRoot(), archives);
+	findOverrides(_files.getRoot(), overrides);
+
+	/* Order the sources roughly the way the games load them: KEY files
+	 * first, then all other archives, and override directories last. */
+	std::stable_partition(archives.begin(), archives.end(), [](const Common::UString &path) {
+		return TypeMan.getFileType(path) == Aurora::kFileTypeKEY;
+	});
+
+	std::vector< std::unique_ptr<Aurora::Archive> > sources;
+
+	Aurora::DuplicateFinder finder;
+	for (std::vector<Common::UString>::const_iterator a = archives.begin(); a != archives.end(); ++a) {
+		try {
+			sources.emplace_back(Aurora::openArchive(*a));
+			finder.addSource(*a, *sources.back());
+		} catch (Common::Exception &e) {
+			Common::printException(e, "WARNING: ");
+		}
+	}
+
+	for (std::vector<Common::UString>::const_iterator o = overrides.begin(); o != overrides.end(); ++o) {
+		try {
+			sources.emplace_back(std::make_unique<Aurora::DirectoryArchive>(*o, -1));
+			finder.addSource(*o, *sources.back());
+		} catch (Common::Exception &e) {
+			Common::printException(e, "WARNING: ");
+		}
+	}
+
+	finder.find(true);
+
+	try {
+		Common::WriteFile file(Common::UString(_duplicatesReport.toStdString()));
+		finder.writeReport(file);
+		file.flush();
+
+		_duplicatesResult = tr("Found %1 groups of identical and %2 shadowed resources, report written to %3")
+			.arg(finder.getDuplicates().size()).arg(finder.getShadowed().size()).arg(_duplicatesReport);
+
+	} catch (Common::Exception &e) {
+		e.add("Failed to write the duplicates report");
+		Common::printException(e, "WARNING: ");
+
+		_duplicatesResult = tr("Failed to write the duplicates report to %1").arg(_duplicatesReport);
+	}
+}
+
+void MainWindow::findDuplicatesFinish() {
+	_status.pop();
+
+	_log->append(_duplicatesResult);
+}
+
+void MainWindow::slotExtractArchive() {
+	if (!_currentItem || _extractWatcher->isRunning())
+		return;
+
+	// Only archives on disk can be opened by several threads
+	if (!_currentItem->isArchive() || (_currentItem->getSource() != Source::kSourceFile))
+		return;
+
+	const QString directory = QFileDialog::getExistingDirectory(this,
+		tr("Extract %1 to").arg(_currentItem->getName()));
+
+	if (directory.isEmpty())
+		return;
+
+	_extractArchive   = _currentItem->getPath();
+	_extractDirectory = directory;
+
+	// popped in extractArchiveFinish
+	_status.push(tr("Extracting \"%1\" to \"%2\"...").arg(_currentItem->getName()).arg(directory));
+
+	_extractWatcher->setFuture(QtConcurrent::run(this, &MainWindow::extractArchive));
+}
+
+/** Return the file name to extract this resource to, unique among all names taken so far. */
+static Common::UString getExtractFileName(const Aurora::Archive::Resource &resource,
+                                          std::set<Common::UString> &taken) {
+
+	Common::UString name = resource.name;
+	if (name.empty())
+		name = Common::composeString(resource.hash);
+
+	/* Archives can have several resources of the same name, which we
+	 * must not write into the same file. We also compare the names in
+	 * lower case, because not every file system tells cases apart. */
+	Common::UString fileName = TypeMan.setFileType(name, resource.type);
+	for (uint i = 1; !taken.insert(fileName.toLower()).second; i++)
+		fileName = TypeMan.setFileType(Common::UString::format("%s_%u", name.c_str(), i), resource.type);
+
+	return fileName;
+}
+
+void MainWindow::extractArchive() {
+	const Common::UString archivePath(_extractArchive.toStdString());
+	const Common::UString directory(_extractDirectory.toStdString());
+
+	// The file names of the resources, by index
+	std::map<uint32, Common::UString> fileNames;
+
+	std::unique_ptr<Aurora::Archive> archive;
+	try {
+		archive.reset(Aurora::openArchive(archivePath));
+
+		std::set<Common::UString> taken;
+
+		const Aurora::Archive::ResourceList &resources = archive->getResources();
+		for (Aurora::Archive::ResourceList::const_iterator r = resources.begin(); r != resources.end(); ++r)
+			fileNames[r->index] = directory + "/" + getExtractFileName(*r, taken);
+
+	} catch (Common::Exception &e) {
+		e.add("Failed to extract \"%s\"", archivePath.c_str());
+		Common::printException(e, "WARNING: ");
+
+		_extractResult = tr("Failed to extract %1").arg(_extractArchive);
+		return;
+	}
+
+	std::vector<uint32> indices;
+	for (std::map<uint32, Common::UString>::const_iterator f = fileNames.begin(); f != fileNames.end(); ++f)
+		indices.push_back(f->first);
+
+	Aurora::ResourceExtractor extractor([archivePath]() {
+		return Aurora::openArchive(archivePath);
+	});
+
+	try {
+		// Called from several threads, but only ever reads the file names, which are all different
+		extractor.extract(*archive, indices, [&fileNames](uint32 index, Common::SeekableReadStream &data) {
+			Common::WriteFile file(fileNames.at(index));
+
+			file.writeStream(data);
+			file.flush();
+		});
+
+	} catch (Common::Exception &e) {
+		e.add("Failed to extract \"%s\"", archivePath.c_str());
+		Common::printException(e, "WARNING: ");
+
+		_extractResult = tr("Failed to extract %1").arg(_extractArchive);
+		return;
+	}
+
+	const std::vector<Aurora::ResourceExtractor::Failure> &failures = extractor.getFailures();
+	for (std::vector<Aurora::ResourceExtractor::Failure>::const_iterator f = failures.begin(); f != failures.end(); ++f) {
+		Common::Exception e("%s", f->error.c_str());
+		e.add("Failed to extract \"%s\"", fileNames.at(f->index).c_str());
+
+		Common::printException(e, "WARNING: ");
+	}
+
+	_extractResult = tr("Extracted %1 of %2 resources from %3 to %4")
+		.arg(indices.size() - failures.size()).arg(indices.size()).arg(_extractArchive).arg(_extractDirectory);
+}
+
+void MainWindow::extractArchiveFinish() {
+	_status.pop();
+
+	_log->append(_extractResult);
+}
+
 void MainWindow::statusPush(const QString &text) {
 	_status.push(text);
 }
@@ -353,8 +823,24 @@ void MainWindow::statusPop() {
 
 void MainWindow::resourceSelect(const QItemSelection &selected, const QItemSelection &UNUSED(deselected)) {
 	const QModelIndexList index = _proxyModel->mapSelectionToSource(selected).indexes();
+
+	// The selected item was removed
+	if (index.isEmpty()) {
+		_currentItem = nullptr;
+
+		_panelResourceInfo->clearLabels();
+		_panelResourceInfo->setButtonsForClosedDir();
+		_panelManager->setItem(nullptr);
+
+		_actionExtractArchive->setEnabled(false);
+		return;
+	}
+
 	_currentItem = _treeModel->itemFromIndex(index.at(0));
 
+	_actionExtractArchive->setEnabled(_currentItem->isArchive() &&
+	                                  (_currentItem->getSource() == Source::kSourceFile));
+
 	_panelResourceInfo->update(_currentItem);
 
 	if (!_currentItem->isDir() && !_currentItem->isArchive())
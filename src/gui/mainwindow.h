@@ -29,8 +29,12 @@
 
 #include <QMainWindow>
 #include <QFutureWatcher>
+#include <QTimer>
 
 #include "src/common/filetree.h"
+#include "src/common/filewatcher.h"
+
+#include "src/aurora/searchindex.h"
 
 #include "src/gui/resourcetree.h"
 #include "src/gui/proxymodel.h"
@@ -79,6 +83,15 @@ private /*slots*/:
 	void slotAbout();
 	W_SLOT(slotAbout, W_Access::Private)
 
+	void slotSearch();
+	W_SLOT(slotSearch, W_Access::Private)
+
+	void slotFindDuplicates();
+	W_SLOT(slotFindDuplicates, W_Access::Private)
+
+	void slotExtractArchive();
+	W_SLOT(slotExtractArchive, W_Access::Private)
+
 	void saveItem();
 	W_SLOT(saveItem, W_Access::Private)
 
@@ -95,8 +108,26 @@ private:
 	void open(const QString &path);
 	void openFinish();
 
+	/** Apply the changes on disk since the last call to the file and resource trees. */
+	void applyFileChanges();
+	/** Update the resource tree for a file whose contents changed on disk. */
+	void applyFileModified(const Common::FileTree::Entry &entry);
+
 	void close();
 
+	/** Build or load the search index of all archives below the root path. */
+	void buildSearchIndex();
+	void searchFinish();
+	void search(const QString &query);
+
+	/** Write a report of duplicate and shadowed resources below the root path. */
+	void findDuplicates();
+	void findDuplicatesFinish();
+
+	/** Extract all resources of an archive file into a directory, in parallel. */
+	void extractArchive();
+	void extractArchiveFinish();
+
 	void statusPush(const QString &text);
 	void statusPop();
 
@@ -115,6 +146,9 @@ private:
 	QAction *_actionClose { nullptr };
 	QAction *_actionQuit { nullptr };
 	QAction *_actionAbout { nullptr };
+	QAction *_actionSearch { nullptr };
+	QAction *_actionFindDuplicates { nullptr };
+	QAction *_actionExtractArchive { nullptr };
 
 	QMenuBar *_menuBar { nullptr };
 	QMenu *_menuFile { nullptr };
@@ -142,6 +176,35 @@ private:
 
 	QFutureWatcher<void> *_watcher { nullptr };
 
+	Aurora::SearchIndex _searchIndex;
+	bool _searchIndexReady { false };
+	/** The query to run once the search index is ready. */
+	QString _searchQuery;
+
+	QFutureWatcher<void> *_searchWatcher { nullptr };
+
+	/** The file to write the duplicates report to. */
+	QString _duplicatesReport;
+	/** The result of findDuplicates(), to be logged once it's done. */
+	QString _duplicatesResult;
+
+	QFutureWatcher<void> *_duplicatesWatcher { nullptr };
+
+	/** The archive file to extract. */
+	QString _extractArchive;
+	/** The directory to extract the archive into. */
+	QString _extractDirectory;
+	/** The result of extractArchive(), to be logged once it's done. */
+	QString _extractResult;
+
+	QFutureWatcher<void> *_extractWatcher { nullptr };
+
+	/** How often to look for changes on disk, in milliseconds. */
+	static const int kFileWatchInterval = 1000;
+
+	Common::FileWatcher _fileWatcher;
+	QTimer *_fileWatchTimer { nullptr };
+
 	friend class ResourceTree;
 };
 
@@ -40,6 +40,11 @@ bool ProxyModel::lessThan(const QModelIndex &left, const QModelIndex &right) con
 	ResourceTreeItem *itemLeft = model->itemFromIndex(left);
 	ResourceTreeItem *itemRight = model->itemFromIndex(right);
 
+	// Archive members are already sorted by name when they're added
+	if (itemLeft->isArchiveMember() && itemRight->isArchiveMember() &&
+	    (itemLeft->getParent() == itemRight->getParent()))
+		return itemLeft->row() < itemRight->row();
+
 	bool compare = QString::compare(itemLeft->getName(), itemRight->getName(), Qt::CaseInsensitive) < 0;
 
 	bool leftDir = itemLeft->isDir();
@@ -22,7 +22,10 @@
  *  Phaethon's tree of game resource files.
  */
 
+#include <ctime>
 #include <memory>
+#include <algorithm>
+#include <set>
 
 #include <QDir>
 #include <QFuture>
@@ -30,24 +33,24 @@
 #include <QtConcurrentRun>
 #include <QFileInfo>
 #include <QModelIndex>
+#include <QStringList>
+#include <QImage>
+#include <QPixmap>
 #include <QVariant>
 
 #include <boost/scope_exit.hpp>
+#include <boost/filesystem.hpp>
 
 #include "external/verdigris/wobjectimpl.h"
 
-#include "src/aurora/biffile.h"
-#include "src/aurora/bzffile.h"
-#include "src/aurora/erffile.h"
 #include "src/aurora/keyfile.h"
-#include "src/aurora/rimfile.h"
-#include "src/aurora/zipfile.h"
-#include "src/aurora/herffile.h"
-#include "src/aurora/ndsrom.h"
+#include "src/aurora/archiveloader.h"
 
+#include "src/common/util.h"
+#include "src/common/system.h"
+#include "src/common/thread.h"
 #include "src/common/filepath.h"
 #include "src/common/readfile.h"
-#include "src/common/system.h"
 
 #include "src/gui/mainwindow.h"
 #include "src/gui/resourcetree.h"
@@ -62,35 +65,264 @@ ResourceTree::ResourceTree(MainWindow *mainWindow, QObject *parent) : QAbstractI
 	_mainWindow(mainWindow) {
 	_root = std::make_unique<ResourceTreeItem>("Filename");
 	_iconProvider = std::make_unique<QFileIconProvider>();
+
+	// Looking up icons is slow, so we do it once for every kind of item
+	_iconSound     = QIcon::fromTheme("audio-x-generic");
+	_iconImage     = QIcon::fromTheme("image");
+	_iconArchive   = QIcon::fromTheme("package-x-generic");
+	_iconFile      = _iconProvider->icon(QFileIconProvider::File);
+	_iconDirectory = _iconProvider->icon(QFileIconProvider::Folder);
+
+	_thumbnails = std::make_unique<Images::ThumbnailService>(Common::FilePath::getUserDataFile("thumbnails"));
+
+	_thumbnailTimer = new QTimer(this);
+	_thumbnailTimer->setInterval(100);
+	QObject::connect(_thumbnailTimer, &QTimer::timeout, this, &ResourceTree::updateThumbnails);
+}
+
+void ResourceTree::populate(Common::FileTree &files, const Common::UString &path) {
+	connect(_mainWindow->_watcher, &QFutureWatcher<void>::finished, _mainWindow, &MainWindow::openFinish);
+	QFuture<void> future = QtConcurrent::run(this, &ResourceTree::populateRoot, &files, path);
+	_mainWindow->_watcher->setFuture(future);
+}
+
+static void collectEntries(const Common::FileTree::Entry &entry, std::vector<const Common::FileTree::Entry *> &entries) {
+	for (std::list<Common::FileTree::Entry>::const_iterator c = entry.children.begin(); c != entry.children.end(); ++c) {
+		entries.push_back(&*c);
+		collectEntries(*c, entries);
+	}
+}
+
+/** Figure out the file types of all entries below this one, in depth-first order. */
+static std::vector<Aurora::FileType> classifyEntries(const Common::FileTree::Entry &rootEntry) {
+	/* Figuring out the type of tens of thousands of files adds up, so we do
+	 * that for all files in parallel first, and then build the items. */
+
+	std::vector<const Common::FileTree::Entry *> entries;
+	collectEntries(rootEntry, entries);
+
+	std::vector<Aurora::FileType> types(entries.size(), Aurora::kFileTypeNone);
+
+	// The type manager builds its lookup tables on first use, so do that before spawning threads
+	TypeMan.getFileType("");
+
+	static const size_t kBatchSize = 1024;
+
+	const size_t batchCount  = (entries.size() + kBatchSize - 1) / kBatchSize;
+	const size_t threadCount = MAX<size_t>(1, MIN<size_t>(Common::getThreadCount(), entries.size() / kBatchSize));
+
+	Common::parallelFor(batchCount, [&](size_t batch, size_t UNUSED(thread)) {
+		const size_t start = batch * kBatchSize;
+
+		for (size_t i = start; i < MIN(start + kBatchSize, entries.size()); i++)
+			if (!entries[i]->isDirectory())
+				types[i] = TypeMan.getFileType(entries[i]->name);
+	}, threadCount);
+
+	return types;
 }
 
-void ResourceTree::populate(const Common::FileTree::Entry &rootEntry) {
+void ResourceTree::populateRoot(Common::FileTree *files, const Common::UString &path) {
+	// Walking the directory stats every file, which can take a while on large trees
+	try {
+		files->readPath(path, -1);
+	} catch (Common::Exception &e) {
+		files->clear();
+
+		Common::printException(e, "WARNING: ");
+		return;
+	}
+
+	const Common::FileTree::Entry &rootEntry = files->getRoot();
+
 	ResourceTreeItem *treeRoot = new ResourceTreeItem(rootEntry);
 	_root->addChild(treeRoot);
 
-	connect(_mainWindow->_watcher, &QFutureWatcher<void>::finished, _mainWindow, &MainWindow::openFinish);
-	QFuture<void> future = QtConcurrent::run(this, &ResourceTree::populate, rootEntry, treeRoot);
-	_mainWindow->_watcher->setFuture(future);
+	const std::vector<Aurora::FileType> types = classifyEntries(rootEntry);
+
+	size_t index = 0;
+	populate(rootEntry, treeRoot, types, index);
 }
 
-void ResourceTree::populate(const Common::FileTree::Entry &entry, ResourceTreeItem *parent) {
+void ResourceTree::populate(const Common::FileTree::Entry &entry, ResourceTreeItem *parent,
+                            const std::vector<Aurora::FileType> &types, size_t &index) {
+
 	for (std::list<Common::FileTree::Entry>::const_iterator childIter = entry.children.begin();
 		 childIter != entry.children.end(); ++childIter) {
 
-		ResourceTreeItem *child = new ResourceTreeItem(*childIter);
+		ResourceTreeItem *child = new ResourceTreeItem(*childIter, types[index++]);
 
 		if (child->getFileType() == Aurora::kFileTypeKEY) {
 			_keys.push_back(child);
 		}
 
 		parent->addChild(child);
-		populate(*childIter, child);
+		populate(*childIter, child, types, index);
+	}
+}
+
+QModelIndex ResourceTree::getIndex(ResourceTreeItem &item) const {
+	if ((&item == _root.get()) || !item.getParent())
+		return QModelIndex();
+
+	return createIndex(item.row(), 0, &item);
+}
+
+ResourceTreeItem *ResourceTree::findItem(const QString &path) const {
+	ResourceTreeItem *item = _root->childAt(0);
+	if (!item)
+		return nullptr;
+
+	const QString rootPath = item->getPath();
+	if (path == rootPath)
+		return item;
+
+	if (!path.startsWith(rootPath + "/"))
+		return nullptr;
+
+	// Walk down the tree, one path component at a time
+	const QStringList names = path.mid(rootPath.size() + 1).split('/', QString::SkipEmptyParts);
+	for (const QString &name : names) {
+		ResourceTreeItem *child = nullptr;
+		for (int row = 0; !child && (row < item->childCount()); row++)
+			if (item->childAt(row)->getName() == name)
+				child = item->childAt(row);
+
+		if (!child)
+			return nullptr;
+
+		item = child;
+	}
+
+	return item;
+}
+
+void ResourceTree::addPath(const Common::FileTree::Entry &entry) {
+	const QString path = QString::fromUtf8(entry.path.string().c_str());
+	if (findItem(path))
+		return;
+
+	ResourceTreeItem *parent = findItem(QString::fromUtf8(entry.path.parent_path().string().c_str()));
+	if (!parent || !parent->isDir())
+		return;
+
+	ResourceTreeItem *item = new ResourceTreeItem(entry);
+
+	const std::vector<Aurora::FileType> types = classifyEntries(entry);
+
+	size_t index = 0;
+	populate(entry, item, types, index);
+
+	if (item->getFileType() == Aurora::kFileTypeKEY)
+		_keys.push_back(item);
+
+	beginInsertRows(getIndex(*parent), parent->childCount(), parent->childCount());
+	parent->addChild(item);
+	endInsertRows();
+}
+
+void ResourceTree::removePath(const QString &path) {
+	ResourceTreeItem *item = findItem(path);
+	if (!item || !item->getParent() || (item->getParent() == _root.get()))
+		return;
+
+	// Close all archives in or below this path
+	invalidateArchives(path);
+
+	// Forget about all KEY files that are going away
+	_keys.erase(std::remove_if(_keys.begin(), _keys.end(), [item](ResourceTreeItem *key) {
+		for (ResourceTreeItem *i = key; i; i = i->getParent())
+			if (i == item)
+				return true;
+
+		return false;
+	}), _keys.end());
+
+	ResourceTreeItem *parent = item->getParent();
+
+	beginRemoveRows(getIndex(*parent), item->row(), item->row());
+	parent->removeChild(item->row());
+	endRemoveRows();
+}
+
+ResourceTreeItem *ResourceTree::updatePath(const Common::FileTree::Entry &entry) {
+	const QString path = QString::fromUtf8(entry.path.string().c_str());
+
+	ResourceTreeItem *item = findItem(path);
+	if (!item || item->isDir())
+		return nullptr;
+
+	invalidateArchives(path);
+
+	// The KEY files might have this data file open
+	if ((item->getFileType() == Aurora::kFileTypeBIF) || (item->getFileType() == Aurora::kFileTypeBZF))
+		for (ResourceTreeItem *key : std::vector<ResourceTreeItem *>(_keys))
+			invalidateArchives(key->getPath());
+
+	item->updateFile(entry);
+
+	const QModelIndex index = getIndex(*item);
+	emit dataChanged(index, index);
+
+	return item;
+}
+
+void ResourceTree::invalidateArchives(const QString &path) {
+	// Changed files get new thumbnails
+	for (QHash<QString, uint64>::iterator f = _fingerprints.begin(); f != _fingerprints.end(); ) {
+		if ((f.key() == path) || f.key().startsWith(path + "/"))
+			f = _fingerprints.erase(f);
+		else
+			++f;
+	}
+
+	// All archives opened from this path, including those within archives within this path
+	std::vector<QString> paths;
+	std::set<Aurora::Archive *> archives;
+
+	for (const auto &archive : _archives) {
+		if ((archive.first == path) || archive.first.startsWith(path + "/")) {
+			paths.push_back(archive.first);
+			archives.insert(archive.second.get());
+		}
+	}
+
+	if (archives.empty())
+		return;
+
+	// Remove the items of their members
+	clearArchiveItems(*_root, archives);
+
+	for (Aurora::Archive *archive : archives)
+		_archiveCache.remove(*archive);
+
+	// Archives within archives read from their parents, so close those first
+	for (std::vector<QString>::reverse_iterator p = paths.rbegin(); p != paths.rend(); ++p)
+		_archives.erase(*p);
+}
+
+void ResourceTree::clearArchiveItems(ResourceTreeItem &item, const std::set<Aurora::Archive *> &archives) {
+	for (int row = 0; row < item.childCount(); row++) {
+		ResourceTreeItem &child = *item.childAt(row);
+
+		if (child.getArchiveData() && archives.count(child.getArchiveData())) {
+			if (child.childCount() > 0) {
+				beginRemoveRows(getIndex(child), 0, child.childCount() - 1);
+				child.clearArchiveMembers();
+				endRemoveRows();
+			} else
+				child.clearArchiveMembers();
+
+			continue;
+		}
+
+		if (child.childCount() > 0)
+			clearArchiveItems(child, archives);
 	}
 }
 
 ResourceTree::~ResourceTree() {
 	_archives.clear();
-	_keyDataFiles.clear();
 }
 
 ResourceTreeItem *ResourceTree::itemFromIndex(const QModelIndex &index) const {
@@ -132,22 +364,24 @@ QVariant ResourceTree::data(const QModelIndex &index, int role) const {
 	ResourceTreeItem *item = itemFromIndex(index);
 
 	if (role == Qt::DecorationRole) {
+		switch (item->getResourceType()) {
+			case Aurora::kResourceSound:
+				return _iconSound;
+			case Aurora::kResourceImage:
+				return getThumbnail(index, *item);
+			default:
+				break;
+		}
+
 		switch (item->getSource()) {
 			case Source::kSourceFile:
+				return getFileIcon(*item);
 			case Source::kSourceArchiveFile:
-				switch (item->getResourceType()) {
-					case Aurora::kResourceSound:
-						return QIcon::fromTheme("audio-x-generic");
-					case Aurora::kResourceImage:
-						return QIcon::fromTheme("image");
-					case Aurora::kResourceArchive:
-						return QIcon::fromTheme("package-x-generic");
-					default:
-						return _iconProvider->icon(QFileIconProvider::File);
-				}
-				break;
+				return (item->getResourceType() == Aurora::kResourceArchive) ? _iconArchive : _iconFile;
+			case Source::kSourceDirectory:
+				return _iconDirectory;
 			default:
-				return _iconProvider->icon(QFileInfo(item->getPath()));
+				return _iconFile;
 		}
 	}
 
@@ -157,6 +391,148 @@ QVariant ResourceTree::data(const QModelIndex &index, int role) const {
 	return QVariant();
 }
 
+QIcon ResourceTree::getFileIcon(const ResourceTreeItem &item) const {
+	/* The file icon provider asks the file system about each file, which
+	 * is slow on network drives. The icon only really depends on the
+	 * file's extension, though, so we ask only once per extension. */
+	const QString extension = QFileInfo(item.getName()).suffix().toLower();
+
+	QHash<QString, QIcon>::const_iterator icon = _fileIcons.constFind(extension);
+	if (icon != _fileIcons.constEnd())
+		return *icon;
+
+	return *_fileIcons.insert(extension, _iconProvider->icon(QFileInfo(item.getPath())));
+}
+
+bool ResourceTree::getThumbnailKey(const ResourceTreeItem &item, Images::ThumbnailService::Key &key) const {
+	// The file on disk this item is in
+	const ResourceTreeItem *file = &item;
+	while (file && (file->getSource() != Source::kSourceFile))
+		file = file->getParent();
+
+	if (!file)
+		return false;
+
+	// Archives within archives are told apart by their path
+	const QString path = item.isArchiveMember() ? item.getParent()->getPath() : item.getPath();
+
+	QHash<QString, uint64>::const_iterator fingerprint = _fingerprints.constFind(path);
+	if (fingerprint == _fingerprints.constEnd()) {
+		boost::system::error_code error;
+		const std::time_t modified = boost::filesystem::last_write_time(file->getPath().toStdString(), error);
+
+		fingerprint = _fingerprints.insert(path, Images::ThumbnailService::getFingerprint(USTR(path),
+		                                   file->getSize(), error ? 0 : static_cast<uint64>(modified)));
+	}
+
+	key.fingerprint = *fingerprint;
+	key.index       = item.getResourceIndex();
+
+	return true;
+}
+
+Images::ThumbnailService::ImageLoader ResourceTree::getThumbnailLoader(const ResourceTreeItem &item) const {
+	const Aurora::FileType type = item.getFileType();
+
+	if (item.getSource() == Source::kSourceFile) {
+		const Common::UString path = USTR(item.getPath());
+
+		return [path, type]() {
+			Common::ReadFile file(path);
+
+			return ResourceTreeItem::getImage(file, type);
+		};
+	}
+
+	std::shared_ptr<Common::SeekableReadStream> data(item.getResourceData());
+
+	return [data, type]() {
+		return ResourceTreeItem::getImage(*data, type);
+	};
+}
+
+QIcon ResourceTree::createThumbnailIcon(const Images::Thumbnail &thumbnail) const {
+	if ((thumbnail.width == 0) || (thumbnail.height == 0))
+		return _iconImage;
+
+	const QImage image(thumbnail.data.data(), thumbnail.width, thumbnail.height,
+	                   thumbnail.width * 4, QImage::Format_RGBA8888);
+
+	// Our images are upside down. This also copies the data
+	return QIcon(QPixmap::fromImage(image.mirrored()));
+}
+
+QIcon ResourceTree::getThumbnail(const QModelIndex &index, const ResourceTreeItem &item) const {
+	Images::ThumbnailService::Key key;
+	if (!getThumbnailKey(item, key))
+		return _iconImage;
+
+	std::map<Images::ThumbnailService::Key, QIcon>::const_iterator icon = _thumbnailIcons.find(key);
+	if (icon != _thumbnailIcons.end())
+		return icon->second;
+
+	// Still in the works
+	if (_thumbnailRequests.find(key) != _thumbnailRequests.end())
+		return _iconImage;
+
+	/* Reading an archive member can only happen here, and is wasted if the
+	 * thumbnail is in the cache directory. So we only look there first, and
+	 * read the data in updateThumbnails() if we have to. */
+	Images::ThumbnailService::ImageLoader loader;
+	if (item.getSource() == Source::kSourceFile)
+		loader = getThumbnailLoader(item);
+
+	const Images::Thumbnail *thumbnail = _thumbnails->get(key.fingerprint, key.index, loader);
+
+	if (thumbnail)
+		return _thumbnailIcons[key] = createThumbnailIcon(*thumbnail);
+
+	_thumbnailRequests[key] = QPersistentModelIndex(index);
+	if (!_thumbnailTimer->isActive())
+		_thumbnailTimer->start();
+
+	return _iconImage;
+}
+
+void ResourceTree::updateThumbnails() {
+	std::vector<Images::ThumbnailService::Key> keys;
+	_thumbnails->collectFinished(keys);
+
+	for (const Images::ThumbnailService::Key &key : keys) {
+		std::map<Images::ThumbnailService::Key, QPersistentModelIndex>::iterator request = _thumbnailRequests.find(key);
+		if (request == _thumbnailRequests.end())
+			continue;
+
+		// Without a loader, this never queues anything
+		const Images::Thumbnail *thumbnail = _thumbnails->get(key.fingerprint, key.index,
+		                                                      Images::ThumbnailService::ImageLoader());
+
+		if (!thumbnail && request->second.isValid()) {
+			// It's not in the cache directory, so we have to create it after all
+			try {
+				_thumbnails->get(key.fingerprint, key.index, getThumbnailLoader(*itemFromIndex(request->second)));
+				continue;
+			} catch (Common::Exception &) {
+				_thumbnailIcons[key] = _iconImage;
+			}
+		}
+
+		if (thumbnail)
+			_thumbnailIcons[key] = createThumbnailIcon(*thumbnail);
+
+		// The item might have been removed in the meantime
+		if (request->second.isValid()) {
+			const QModelIndex index = request->second;
+			emit dataChanged(index, index);
+		}
+
+		_thumbnailRequests.erase(request);
+	}
+
+	if (!_thumbnails->isBusy())
+		_thumbnailTimer->stop();
+}
+
 QVariant ResourceTree::headerData(int UNUSED(section), Qt::Orientation orientation, int role) const {
 	if (orientation == Qt::Horizontal && role == Qt::DisplayRole)
 		return _root->getName();
@@ -227,37 +603,29 @@ bool ResourceTree::hasChildren(const QModelIndex &index) const {
 	return itemFromIndex(index)->hasChildren();
 }
 
-void ResourceTree::insertItemsFromArchive(Archive &archive, const ResourceTreeItem &item,
+void ResourceTree::insertItemsFromArchive(Archive &archive, ResourceTreeItem &item,
                                           const QModelIndex &parentIndex) {
-	QList<ResourceTreeItem *> items;
+	std::vector<const Aurora::Archive::Resource *> resList;
 
 	if (item.getFileType() == Aurora::kFileTypeBIF) {
 		const QString localArchivePath = item.getParent()->getName() + "/" + item.getName();
-		auto resList = static_cast<Aurora::KEYFile *>(archive.data)->getResourceListForDataFile(localArchivePath.toStdString().c_str());
-		for (auto res : resList) {
-			items.push_back(new ResourceTreeItem(archive.data, localArchivePath, *res));
-		}
+		resList = static_cast<Aurora::KEYFile *>(archive.data)->getResourceListForDataFile(localArchivePath.toStdString().c_str());
 	} else {
-		auto &resources = archive.data->getResources();
-		for (auto r = resources.begin(); r != resources.end(); ++r) {
-			items.push_back(new ResourceTreeItem(archive.data, item.getPath(), *r));
-		}
+		const Aurora::Archive::ResourceList &resources = archive.data->getResources();
+
+		resList.reserve(resources.size());
+		for (Aurora::Archive::ResourceList::const_iterator r = resources.begin(); r != resources.end(); ++r)
+			resList.push_back(&*r);
 	}
 	archive.addedMembers = true;
 
-	insertItems(0, items, parentIndex);
-}
-
-void ResourceTree::insertItems(size_t position, QList<ResourceTreeItem*> &items, const QModelIndex &parent) {
-	ResourceTreeItem *parentItem = itemFromIndex(parent);
-
-	beginInsertRows(parent, position, position + items.size() - 1);
+	if (resList.empty())
+		return;
 
-	for (const auto &item : items)
-	{
-		parentItem->addChild(item);
-	}
+	const int position = item.childCount();
 
+	beginInsertRows(parentIndex, position, position + resList.size() - 1);
+	item.addArchiveMembers(archive.data, resList);
 	endInsertRows();
 }
 
@@ -266,102 +634,18 @@ Aurora::Archive *ResourceTree::getArchive(ResourceTreeItem &item) {
 	if (archiveIter != _archives.end())
 		return archiveIter->second.get();
 
-	std::unique_ptr<Common::SeekableReadStream> stream(item.getResourceData());
-
-	Aurora::Archive *arch = nullptr;
-	switch (item.getFileType()) {
-		case Aurora::kFileTypeZIP:
-			arch = new Aurora::ZIPFile(stream.release());
-			break;
-
-		case Aurora::kFileTypeERF:
-		case Aurora::kFileTypeMOD:
-		case Aurora::kFileTypeNWM:
-		case Aurora::kFileTypeSAV:
-		case Aurora::kFileTypeHAK:
-			arch = new Aurora::ERFFile(stream.release());
-			break;
-
-		case Aurora::kFileTypeRIM: {
-			const bool isERF = Aurora::ERFFile::isERFID(stream->readUint32BE());
-			stream->seek(0);
-
-			if (isERF)
-				arch = new Aurora::ERFFile(stream.release());
-			else
-				arch = new Aurora::RIMFile(stream.release());
-			break;
-		}
+	if (!Aurora::isArchiveType(item.getFileType()))
+		throw Common::Exception("Invalid archive file \"%s\"", item.getPath().toStdString().c_str());
 
-		case Aurora::kFileTypeKEY: {
-			Aurora::KEYFile *key = new Aurora::KEYFile(stream.release());
-			loadKEYDataFiles(*key);
-
-			arch = key;
-			break;
-		}
+	// Archives within archives read their data straight out of the outer archive
+	std::unique_ptr<Common::SeekableReadStream> stream(item.getResourceData(_archiveCache));
 
-		case Aurora::kFileTypeHERF:
-			arch = new Aurora::HERFFile(stream.release());
-			break;
-
-		case Aurora::kFileTypeNDS:
-			arch = new Aurora::NDSFile(stream.release());
-			break;
-
-		default:
-			throw Common::Exception("Invalid archive file \"%s\"", item.getPath().toStdString().c_str());
-	}
+	// KEY files index data files relative to the game's root directory
+	Aurora::Archive *arch = Aurora::openArchive(stream.release(), item.getFileType(),
+	                                            USTR(_root->childAt(0)->getPath()));
 
 	_archives.insert(std::make_pair(item.getPath(), std::unique_ptr<Aurora::Archive>(arch)));
 	return arch;
 }
 
-Aurora::KEYDataFile *ResourceTree::getKEYDataFile(const QString &file) {
-	auto keyDataFileIter = _keyDataFiles.find(file);
-	if (keyDataFileIter != _keyDataFiles.end())
-		return keyDataFileIter->second.get();
-
-	Common::UString path = Common::FilePath::normalize(USTR(_root->childAt(0)->getPath() + "/" + file));
-	if (path.empty())
-		throw Common::Exception("No such file or directory \"%s\"", (_root->getPath() + "/" + file).toStdString().c_str());
-
-	Aurora::FileType type = TypeMan.getFileType(file.toStdString().c_str());
-
-	Aurora::KEYDataFile *dataFile = nullptr;
-	switch (type) {
-		case Aurora::kFileTypeBIF:
-			dataFile = new Aurora::BIFFile(new Common::ReadFile(path));
-			break;
-
-		case Aurora::kFileTypeBZF:
-			dataFile = new Aurora::BZFFile(new Common::ReadFile(path));
-			break;
-
-		default:
-			throw Common::Exception("Unknown KEY data file type %d\n", type);
-	}
-
-	_keyDataFiles.insert(std::make_pair(file, std::unique_ptr<Aurora::KEYDataFile>(dataFile)));
-	return dataFile;
-}
-
-void ResourceTree::loadKEYDataFiles(Aurora::KEYFile &key) {
-	const std::vector<Common::UString> dataFiles = key.getDataFileList();
-	for (size_t i = 0; i < dataFiles.size(); i++) {
-		try {
-			_mainWindow->statusPush(tr("Loading data file") + QString::fromUtf8(dataFiles[i].c_str()) + "...");
-
-			Aurora::KEYDataFile *dataFile = getKEYDataFile(QString::fromUtf8(dataFiles[i].c_str()));
-			key.addDataFile(i, dataFile);
-
-			_mainWindow->statusPop();
-		} catch (Common::Exception &e) {
-			e.add("Failed to load KEY data file \"%s\"", dataFiles[i].c_str());
-			_mainWindow->statusPop();
-			Common::printException(e, "WARNING: ");
-		}
-	}
-}
-
 } // End of namespace GUI
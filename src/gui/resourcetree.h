@@ -25,14 +25,22 @@
 #ifndef GUI_RESOURCETREE_H
 #define GUI_RESOURCETREE_H
 
+#include <map>
 #include <memory>
+#include <vector>
+#include <set>
 
 #include <QAbstractItemModel>
 #include <QFileIconProvider>
+#include <QHash>
+#include <QIcon>
+#include <QPersistentModelIndex>
+#include <QTimer>
 
 #include "external/verdigris/wobjectdefs.h"
 
 #include "src/aurora/archive.h"
+#include "src/aurora/archivecache.h"
 #include "src/aurora/util.h"
 
 #include "src/common/filetree.h"
@@ -40,6 +48,7 @@
 #include "src/gui/resourcetreeitem.h"
 
 #include "src/images/decoder.h"
+#include "src/images/thumbnailservice.h"
 
 namespace Common {
 	class SeekableReadStream;
@@ -70,15 +79,22 @@ public:
 	ResourceTree(MainWindow *mainWindow, QObject *parent = 0);
 	~ResourceTree();
 
-	void populate(const Common::FileTree::Entry &rootEntry);
-	void populate(const Common::FileTree::Entry &rootEntry, ResourceTreeItem *parent);
+	/** Read the files below this path into the tree and populate it, in the populate thread.
+	 *
+	 *  The file tree is cleared again if the path can't be read.
+	 */
+	void populate(Common::FileTree &files, const Common::UString &path);
 
-	void insertItemsFromArchive(Archive &archive, const ResourceTreeItem &item, const QModelIndex &parentIndex);
-	void insertItems(size_t position, QList<ResourceTreeItem *> &items, const QModelIndex &parentIndex);
+	/** Add the item for a file or directory that was created on disk. */
+	void addPath(const Common::FileTree::Entry &entry);
+	/** Remove the item for a file or directory that was removed from disk. */
+	void removePath(const QString &path);
+	/** Update the item for a file that was modified on disk, and return it. */
+	ResourceTreeItem *updatePath(const Common::FileTree::Entry &entry);
+
+	void insertItemsFromArchive(Archive &archive, ResourceTreeItem &item, const QModelIndex &parentIndex);
 
 	Aurora::Archive     *getArchive(ResourceTreeItem &item);
-	Aurora::KEYDataFile *getKEYDataFile(const QString &file);
-	void                loadKEYDataFiles(Aurora::KEYFile &key);
 
 	/** Return the item in the tree structure that corresponds to the given index. */
 	ResourceTreeItem *itemFromIndex(const QModelIndex &index) const;
@@ -113,15 +129,72 @@ public:
 	void fetchMore(const QModelIndex &index);
 
 private:
+	/** Read the files and populate the tree below the root, in the populate thread. */
+	void populateRoot(Common::FileTree *files, const Common::UString &path);
+	/** Add the items for the entry's children, with their file types in depth-first order. */
+	void populate(const Common::FileTree::Entry &entry, ResourceTreeItem *parent,
+	              const std::vector<Aurora::FileType> &types, size_t &index);
+
+	QModelIndex getIndex(ResourceTreeItem &item) const;
+	/** Return the item of this file or directory on disk. */
+	ResourceTreeItem *findItem(const QString &path) const;
+
+	/** Close all archives opened from this path or from within it. */
+	void invalidateArchives(const QString &path);
+	/** Remove the members of all items below this one that show one of these archives. */
+	void clearArchiveItems(ResourceTreeItem &item, const std::set<Aurora::Archive *> &archives);
+
+	/** Return the thumbnail of an image item as its icon, requesting it if necessary. */
+	QIcon getThumbnail(const QModelIndex &index, const ResourceTreeItem &item) const;
+	/** Figure out what identifies the thumbnail of an image item. */
+	bool getThumbnailKey(const ResourceTreeItem &item, Images::ThumbnailService::Key &key) const;
+	/** Return the function decoding the image of an item to create its thumbnail.
+	 *
+	 *  Archives can't be read from several threads at once, so the data of
+	 *  archive members is read right here. Files on disk are read later, by
+	 *  the thumbnail service's worker threads.
+	 */
+	Images::ThumbnailService::ImageLoader getThumbnailLoader(const ResourceTreeItem &item) const;
+	/** Turn a finished thumbnail into an icon. Empty thumbnails of broken images get the generic icon. */
+	QIcon createThumbnailIcon(const Images::Thumbnail &thumbnail) const;
+	/** Show the thumbnails that became ready. */
+	void updateThumbnails();
+
 	std::unique_ptr<ResourceTreeItem> _root { nullptr };
 	MainWindow *_mainWindow { nullptr };
 
 	std::unique_ptr<QFileIconProvider> _iconProvider { nullptr };
 
+	QIcon _iconSound;
+	QIcon _iconImage;
+	QIcon _iconArchive;
+	QIcon _iconFile;
+	QIcon _iconDirectory;
+
+	/** Creates thumbnails of images in the background, and keeps them on disk. */
+	std::unique_ptr<Images::ThumbnailService> _thumbnails;
+	/** Polls the thumbnail service while thumbnails are being created. */
+	QTimer *_thumbnailTimer { nullptr };
+
+	/** The items whose thumbnails are being created. */
+	mutable std::map<Images::ThumbnailService::Key, QPersistentModelIndex> _thumbnailRequests;
+	/** The thumbnails we've already turned into icons. */
+	mutable std::map<Images::ThumbnailService::Key, QIcon> _thumbnailIcons;
+	/** The fingerprints of archives and files on disk, by path. */
+	mutable QHash<QString, uint64> _fingerprints;
+
+	/** The icons of files on disk, by their lower-case extension. */
+	mutable QHash<QString, QIcon> _fileIcons;
+
+	/** Return the icon of a file on disk. */
+	QIcon getFileIcon(const ResourceTreeItem &item) const;
+
 	std::vector<ResourceTreeItem *> _keys;
 
+	/** The decompressed data of archives within archives. */
+	Aurora::ArchiveCache _archiveCache;
+
 	std::map<QString, std::unique_ptr<Aurora::Archive> > _archives;
-	std::map<QString, std::unique_ptr<Aurora::KEYDataFile> > _keyDataFiles;
 };
 
 } // End of namespace GUI
@@ -25,7 +25,9 @@
 #include <cassert>
 
 #include <memory>
+#include <algorithm>
 
+#include "src/common/error.h"
 #include "src/common/strutil.h"
 #include "src/common/readfile.h"
 
@@ -33,110 +35,259 @@
 
 namespace GUI {
 
+struct ResourceTreeItem::Details {
+	QString name; ///< The filename. This is what the tree view displays.
+	QString path;
+
+	/** Children of directories, created one by one. */
+	std::vector<std::unique_ptr<ResourceTreeItem> > children;
+	/** Children of archives, created in blocks of all members at once. */
+	std::vector<std::vector<ResourceTreeItem> > members;
+
+	Archive archive;
+};
+
 ResourceTreeItem::ResourceTreeItem(const Common::FileTree::Entry &entry) :
-	_name(QString::fromUtf8(entry.name.c_str())),
+	ResourceTreeItem(entry, entry.isDirectory() ? Aurora::kFileTypeNone : TypeMan.getFileType(entry.name)) {
+
+}
+
+ResourceTreeItem::ResourceTreeItem(const Common::FileTree::Entry &entry, Aurora::FileType fileType) :
+	_details(std::make_unique<Details>()),
 	_source(entry.isDirectory() ? kSourceDirectory : kSourceFile) {
 
-	_path = QString::fromUtf8(entry.path.string().c_str());
+	_details->name = QString::fromUtf8(entry.name.c_str());
+	_details->path = QString::fromUtf8(entry.path.string().c_str());
 
-	if (_source == kSourceFile)
-		_size = Common::FilePath::getFileSize(entry.path.generic_string().c_str());
+	if (_source == kSourceFile) {
+		_size = entry.size;
 
-	if (_source != kSourceDirectory) {
-		_fileType = TypeMan.getFileType(_name.toStdString());
-		_resourceType = TypeMan.getResourceType(_name.toStdString());
+		_fileType = fileType;
+		_resourceType = TypeMan.getResourceType(fileType);
 	}
 
+	_triedSize = true;
+
+	_triedDuration = getResourceType() != Aurora::kResourceSound;
+}
+
+ResourceTreeItem::ResourceTreeItem(Aurora::Archive *archive, const Aurora::Archive::Resource &resource,
+                                   Aurora::FileType fileType, Aurora::ResourceType resourceType) :
+	_owner(archive), _resource(&resource), _source(kSourceArchiveFile),
+	_fileType(fileType), _resourceType(resourceType) {
+
 	_triedDuration = getResourceType() != Aurora::kResourceSound;
 }
 
-ResourceTreeItem::ResourceTreeItem(Aurora::Archive *archive, const QString &archivePath,
-                                   const Aurora::Archive::Resource &resource) :
-	_name(QString::fromUtf8(TypeMan.setFileType(resource.name, resource.type).c_str())),
-	_source(kSourceArchiveFile) {
+ResourceTreeItem::ResourceTreeItem(const QString &data) : _details(std::make_unique<Details>()) {
+	_details->name = data;
+	_triedSize = true;
+}
+
+ResourceTreeItem::~ResourceTreeItem() {
+}
+
+ResourceTreeItem::Details &ResourceTreeItem::getDetails() {
+	if (!_details)
+		_details = std::make_unique<Details>();
 
+	return *_details;
+}
+
+QString ResourceTreeItem::createName(const Aurora::Archive::Resource &resource) {
 	Common::UString resName = resource.name;
 	if (resName.empty())
 		resName = Common::composeString(resource.hash);
 
-	resName = TypeMan.setFileType(resName, resource.type);
-	_name = QString::fromUtf8(resName.c_str());
+	return QString::fromUtf8(TypeMan.setFileType(resName, resource.type).c_str());
+}
 
-	_archive.owner = archive;
-	_archive.index = resource.index;
+void ResourceTreeItem::addChild(ResourceTreeItem *child) {
+	Details &details = getDetails();
 
-	_path = archivePath + "/" + _name;
+	child->_parent = this;
+	child->_row    = details.children.size();
 
-	_size = archive->getResourceSize(resource.index);
+	details.children.push_back(std::unique_ptr<ResourceTreeItem>(child));
 
-	if (_source != kSourceDirectory) {
-		_fileType = TypeMan.getFileType(_name.toStdString());
-		_resourceType = TypeMan.getResourceType(_name.toStdString());
-	}
+	// The archive members come after the children, so they all moved down a row
+	renumberMembers();
+}
 
-	_triedDuration = getResourceType() != Aurora::kResourceSound;
+void ResourceTreeItem::removeChild(int row) {
+	if (!_details || (row < 0) || ((size_t) row >= _details->children.size()))
+		return;
+
+	_details->children.erase(_details->children.begin() + row);
+
+	// All following children and the archive members moved up a row
+	for (size_t i = row; i < _details->children.size(); i++)
+		_details->children[i]->_row = i;
+
+	renumberMembers();
 }
 
-ResourceTreeItem::ResourceTreeItem(const QString &data) : _name(data) {
+void ResourceTreeItem::renumberMembers() {
+	uint32 row = _details->children.size();
+
+	for (std::vector<std::vector<ResourceTreeItem> >::iterator b = _details->members.begin();
+	     b != _details->members.end(); ++b)
+		for (std::vector<ResourceTreeItem>::iterator m = b->begin(); m != b->end(); ++m)
+			m->_row = row++;
 }
 
-void ResourceTreeItem::addChild(ResourceTreeItem *child) {
-	child->setParent(this);
-	_children.push_back(std::unique_ptr<ResourceTreeItem>(child));
+void ResourceTreeItem::clearArchiveMembers() {
+	if (!_details)
+		return;
+
+	_details->members.clear();
+	_details->archive = Archive();
 }
 
-bool ResourceTreeItem::insertChild(size_t position, ResourceTreeItem *child) {
-	if (position >= _children.size())
-		return false;
+void ResourceTreeItem::updateFile(const Common::FileTree::Entry &entry) {
+	if (_source != kSourceFile)
+		return;
+
+	_size = entry.size;
+
+	_triedDuration = getResourceType() != Aurora::kResourceSound;
+	_duration = Sound::RewindableAudioStream::kInvalidLength;
+}
+
+void ResourceTreeItem::addArchiveMembers(Aurora::Archive *archive,
+                                         const std::vector<const Aurora::Archive::Resource *> &resources) {
+
+	if (resources.empty())
+		return;
+
+	// The names are only needed for sorting, so they're thrown away afterwards
+	struct Member {
+		QString name;
+		const Aurora::Archive::Resource *resource;
+	};
+
+	std::vector<Member> sorted;
+	sorted.reserve(resources.size());
+
+	for (std::vector<const Aurora::Archive::Resource *>::const_iterator r = resources.begin(); r != resources.end(); ++r)
+		sorted.push_back({ createName(**r), *r });
+
+	std::stable_sort(sorted.begin(), sorted.end(), [](const Member &a, const Member &b) {
+		return QString::compare(a.name, b.name, Qt::CaseInsensitive) < 0;
+	});
+
+	const uint32 firstRow = childCount();
 
-	_children.insert(_children.begin() + position, std::unique_ptr<ResourceTreeItem>(child));
+	Details &details = getDetails();
 
-	return true;
+	// Reserve up front: the items must never move once they're in the model
+	details.members.emplace_back();
+	std::vector<ResourceTreeItem> &block = details.members.back();
+	block.reserve(sorted.size());
+
+	for (std::vector<Member>::const_iterator m = sorted.begin(); m != sorted.end(); ++m) {
+		const Common::UString name = m->name.toStdString();
+
+		block.emplace_back(archive, *m->resource, TypeMan.getFileType(name), TypeMan.getResourceType(name));
+
+		block.back()._parent = this;
+		block.back()._row    = firstRow + block.size() - 1;
+	}
 }
 
 ResourceTreeItem *ResourceTreeItem::childAt(int row) const {
-	return _children[row].get();
+	if (!_details || (row < 0))
+		return nullptr;
+
+	size_t index = row;
+	if (index < _details->children.size())
+		return _details->children[index].get();
+
+	index -= _details->children.size();
+
+	// Usually, there's only one block of members
+	for (std::vector<std::vector<ResourceTreeItem> >::iterator b = _details->members.begin();
+	     b != _details->members.end(); ++b) {
+
+		if (index < b->size())
+			return &(*b)[index];
+
+		index -= b->size();
+	}
+
+	return nullptr;
 }
 
 int ResourceTreeItem::childCount() const {
-	return _children.size();
+	if (!_details)
+		return 0;
+
+	size_t count = _details->children.size();
+	for (std::vector<std::vector<ResourceTreeItem> >::const_iterator b = _details->members.begin();
+	     b != _details->members.end(); ++b)
+		count += b->size();
+
+	return count;
 }
 
 int ResourceTreeItem::row() const {
-	if (_parent) {
-		for (size_t i = 0; i < _parent->_children.size(); i++) {
-			if (_parent->_children[i].get() == this)
-				return i;
-		}
-	}
-	return 0;
+	return _row;
 }
 
 ResourceTreeItem *ResourceTreeItem::getParent() const {
 	return _parent;
 }
 
-void ResourceTreeItem::setParent(ResourceTreeItem *parent) {
-	_parent = parent;
+bool ResourceTreeItem::hasChildren() const {
+	return childCount() > 0;
 }
 
-bool ResourceTreeItem::hasChildren() const {
-	return _children.size();
+bool ResourceTreeItem::isArchiveMember() const {
+	return _resource != nullptr;
 }
 
-const QString &ResourceTreeItem::getName() const {
-	return _name;
+uint32 ResourceTreeItem::getResourceIndex() const {
+	return _resource ? _resource->index : 0;
+}
+
+QString ResourceTreeItem::getName() const {
+	if (_resource) {
+		// The view asks for the name of every visible row on every repaint
+		if (_name.isNull())
+			_name = createName(*_resource);
+
+		return _name;
+	}
+
+	return _details->name;
 }
 
 bool ResourceTreeItem::isDir() const {
 	return _source == kSourceDirectory;
 }
 
-const QString &ResourceTreeItem::getPath() const {
-	return _path;
+QString ResourceTreeItem::getPath() const {
+	if (_resource)
+		return (_parent ? _parent->getPath() : QString()) + "/" + getName();
+
+	return _details->path;
 }
 
 qint64 ResourceTreeItem::getSize() const {
+	if (!_triedSize) {
+		_triedSize = true;
+
+		if (_owner && _resource) {
+			try {
+				_size = _owner->getResourceSize(_resource->index);
+			} catch (Common::Exception &e) {
+				// Archives might only open the files that hold the data now
+				e.add("Failed to get the size of \"%s\"", getName().toStdString().c_str());
+				Common::printException(e, "WARNING: ");
+			}
+		}
+	}
+
 	return _size;
 }
 
@@ -159,18 +310,18 @@ Common::SeekableReadStream *ResourceTreeItem::getResourceData() const {
 				throw Common::Exception("Can't get file data of a directory");
 
 			case kSourceFile:
-				return new Common::ReadFile(_path.toStdString().c_str());
+				return new Common::ReadFile(_details->path.toStdString().c_str());
 
 			case kSourceArchiveFile:
-				if (!_archive.owner)
+				if (!_owner)
 					throw Common::Exception("No archive opened");
 
-				return _archive.owner->getResource(_archive.index);
+				return _owner->getResource(_resource->index);
 			default:
 				throw Common::Exception("kSourceArchive is not handled by getResourceData");
 		}
 	} catch (Common::Exception &e) {
-		e.add("Failed to get resource data for resource \"%s\"", _name.toStdString().c_str());
+		e.add("Failed to get resource data for resource \"%s\"", getName().toStdString().c_str());
 		throw;
 	}
 
@@ -178,6 +329,18 @@ Common::SeekableReadStream *ResourceTreeItem::getResourceData() const {
 	return nullptr;
 }
 
+Common::SeekableReadStream *ResourceTreeItem::getResourceData(Aurora::ArchiveCache &cache) const {
+	if ((_source != kSourceArchiveFile) || !_owner)
+		return getResourceData();
+
+	try {
+		return cache.open(*_owner, _resource->index);
+	} catch (Common::Exception &e) {
+		e.add("Failed to get resource data for resource \"%s\"", getName().toStdString().c_str());
+		throw;
+	}
+}
+
 Images::Decoder *ResourceTreeItem::getImage() const {
 	if (getResourceType() != Aurora::kResourceImage)
 		throw Common::Exception("\"%s\" is not an image resource", getName().toStdString().c_str());
@@ -195,7 +358,7 @@ Images::Decoder *ResourceTreeItem::getImage() const {
 	return img;
 }
 
-Images::Decoder *ResourceTreeItem::getImage(Common::SeekableReadStream &res, Aurora::FileType type) const {
+Images::Decoder *ResourceTreeItem::getImage(Common::SeekableReadStream &res, Aurora::FileType type) {
 	Images::Decoder *img = nullptr;
 	switch (type) {
 		case Aurora::kFileTypeDDS:
@@ -246,7 +409,11 @@ Images::Decoder *ResourceTreeItem::getImage(Common::SeekableReadStream &res, Aur
 }
 
 Archive &ResourceTreeItem::getArchive() {
-	return _archive;
+	return getDetails().archive;
+}
+
+Aurora::Archive *ResourceTreeItem::getArchiveData() const {
+	return _details ? _details->archive.data : nullptr;
 }
 
 uint64 ResourceTreeItem::getSoundDuration() const {
@@ -269,7 +436,7 @@ uint64 ResourceTreeItem::getSoundDuration() const {
 
 Sound::AudioStream *ResourceTreeItem::getAudioStream() const {
 	if (_resourceType != Aurora::kResourceSound)
-		throw Common::Exception("\"%s\" is not a sound resource", _name.toStdString().c_str());
+		throw Common::Exception("\"%s\" is not a sound resource", getName().toStdString().c_str());
 
 	std::unique_ptr<Common::SeekableReadStream> res(getResourceData());
 
@@ -277,7 +444,7 @@ Sound::AudioStream *ResourceTreeItem::getAudioStream() const {
 	try {
 		sound = SoundMan.makeAudioStream(res.get());
 	} catch (Common::Exception &e) {
-		e.add("Failed to get audio stream from \"%s\"", _name.toStdString().c_str());
+		e.add("Failed to get audio stream from \"%s\"", getName().toStdString().c_str());
 		throw;
 	}
 
@@ -26,10 +26,12 @@
 #define GUI_RESOURCETREEITEM_H
 
 #include <memory>
+#include <vector>
 
 #include <QString>
 
 #include "src/aurora/archive.h"
+#include "src/aurora/archivecache.h"
 #include "src/aurora/util.h"
 
 #include "src/common/filepath.h"
@@ -56,73 +58,126 @@ enum Source {
 };
 
 struct Archive {
-	Aurora::Archive *owner { nullptr };
 	Aurora::Archive *data { nullptr };
 	bool addedMembers { false };
-	uint32 index { 0xFFFFFFFF };
 };
 
+/** An item in the resource tree.
+ *
+ *  Archives can easily hold tens of thousands of resources, so the items for
+ *  archive members are kept small: they only point to their resource in the
+ *  archive's resource list. Their name is created on first use and kept, their
+ *  path is created when asked for, and their size is only read from the
+ *  archive on first use. They are
+ *  stored by value in one array per archive, and all items know their row
+ *  within their parent.
+ */
 class ResourceTreeItem {
 public:
 	/** Filesystem item constructor. */
 	ResourceTreeItem(const Common::FileTree::Entry &entry);
+	/** Filesystem item constructor, with the file type already known. */
+	ResourceTreeItem(const Common::FileTree::Entry &entry, Aurora::FileType fileType);
 
 	/** Archive item constructor */
-	ResourceTreeItem(Aurora::Archive *archive, const QString &archivePath,
-	                 const Aurora::Archive::Resource &resource);
+	ResourceTreeItem(Aurora::Archive *archive, const Aurora::Archive::Resource &resource,
+	                 Aurora::FileType fileType, Aurora::ResourceType resourceType);
 
 	/** Root item constructor. */
 	ResourceTreeItem(const QString &data);
 
-	inline bool isArchive() {
-		return TypeMan.getResourceType(_fileType) == Aurora::kResourceArchive;
+	ResourceTreeItem(ResourceTreeItem &&) = default;
+	~ResourceTreeItem();
+
+	inline bool isArchive() const {
+		return _resourceType == Aurora::kResourceArchive;
 	}
 
 	// Model structure
 	bool             hasChildren() const;
-	bool             insertChild(size_t position, ResourceTreeItem *child);
 	int              childCount() const;
 	int              row() const;
 	ResourceTreeItem *childAt(int row) const;
 	ResourceTreeItem *getParent() const;
 	void             addChild(ResourceTreeItem *child);
-	void             setParent(ResourceTreeItem *parent);
+	/** Remove and delete a child of a directory. */
+	void             removeChild(int row);
+
+	/** Add the items for these resources of an archive as children.
+	 *
+	 *  The new items are sorted by name, so that they appear in the same order
+	 *  the tree view sorts them into, and they can then be sorted by row.
+	 */
+	void addArchiveMembers(Aurora::Archive *archive, const std::vector<const Aurora::Archive::Resource *> &resources);
+
+	/** Remove all archive member children and forget the opened archive. */
+	void clearArchiveMembers();
+
+	/** Is this an item for a resource within an archive? */
+	bool isArchiveMember() const;
+	/** Return the index of this archive member within its archive. */
+	uint32 getResourceIndex() const;
+
+	/** Update the file information of a file on disk that has changed. */
+	void updateFile(const Common::FileTree::Entry &entry);
 
 	// Both model and file info
-	const QString &getName() const; ///< Doubles as filename.
+	QString getName() const; ///< Doubles as filename.
 
 	// File info
 	Aurora::FileType     getFileType() const;
 	Aurora::ResourceType getResourceType() const;
 	bool                 isDir() const;
 	qint64               getSize() const;
-	const QString       &getPath() const;
+	QString              getPath() const;
 	Source               getSource() const;
 
 	// Resource information
 	Archive                    &getArchive();
+	/** Return the opened archive of this item, if any. */
+	Aurora::Archive            *getArchiveData() const;
 	Common::SeekableReadStream *getResourceData() const;
+	/** Return the resource data, reading archive members through this cache. */
+	Common::SeekableReadStream *getResourceData(Aurora::ArchiveCache &cache) const;
 	Images::Decoder            *getImage() const;
-	Images::Decoder            *getImage(Common::SeekableReadStream &res, Aurora::FileType type) const;
+	/** Decode an image of this type. Doesn't touch any item, so it's safe to call from any thread. */
+	static Images::Decoder     *getImage(Common::SeekableReadStream &res, Aurora::FileType type);
 	Sound::AudioStream         *getAudioStream() const;
 	uint64                      getSoundDuration() const;
 
 private:
+	/** Information only items for files, directories and opened archives need. */
+	struct Details;
+
 	ResourceTreeItem *_parent { nullptr };
-	std::vector<std::unique_ptr<ResourceTreeItem> > _children;
-	QString _name; ///< The filename. This is what the tree view displays.
+	uint32 _row { 0 }; ///< Our index within our parent's children.
+
+	/** The archive this resource is in, if this is an archive member. */
+	Aurora::Archive *_owner { nullptr };
+	/** The resource within the archive, if this is an archive member. */
+	const Aurora::Archive::Resource *_resource { nullptr };
+
+	std::unique_ptr<Details> _details;
+
+	/** The name of an archive member, created on first use. */
+	mutable QString _name;
 
-	QString _path;
-	size_t _size { Common::kFileInvalid };
+	mutable size_t _size { Common::kFileInvalid };
+	mutable bool _triedSize { false };
 
 	mutable bool _triedDuration { false };
 	mutable uint64 _duration { Sound::RewindableAudioStream::kInvalidLength };
 
-	Archive _archive;
-
 	Source _source { kSourceNone };
 	Aurora::FileType _fileType { Aurora::kFileTypeNone };
 	Aurora::ResourceType _resourceType { Aurora::kResourceNone };
+
+	Details &getDetails();
+	/** Number the rows of the archive members, which follow the other children. */
+	void renumberMembers();
+
+	/** Create the name of an archive member. */
+	static QString createName(const Aurora::Archive::Resource &resource);
 };
 
 } // End of namespace GUI
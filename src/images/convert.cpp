@@ -0,0 +1,308 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Converting image data into 32-bit RGBA/BGRA.
+ */
+
+#include <cstring>
+
+#include "src/common/error.h"
+#include "src/common/endianness.h"
+#include "src/common/cpu.h"
+
+#include "src/images/convert.h"
+#include "src/images/util.h"
+
+#ifdef PHAETHON_SIMD_X86
+	#include <immintrin.h>
+#endif
+
+namespace Images {
+
+// .--- Generic implementation
+static void convertC(byte *dst, const byte *src, PixelFormat format, size_t count, bool bgra) {
+	// Position of the red and blue components in the output pixels
+	const int r = bgra ? 2 : 0;
+	const int b = bgra ? 0 : 2;
+
+	switch (format) {
+		case kPixelFormatR8G8B8:
+			for (; count-- > 0; dst += 4, src += 3) {
+				dst[r] = src[0];
+				dst[1] = src[1];
+				dst[b] = src[2];
+				dst[3] = 0xFF;
+			}
+			break;
+
+		case kPixelFormatB8G8R8:
+			for (; count-- > 0; dst += 4, src += 3) {
+				dst[r] = src[2];
+				dst[1] = src[1];
+				dst[b] = src[0];
+				dst[3] = 0xFF;
+			}
+			break;
+
+		case kPixelFormatR8G8B8A8:
+			for (; count-- > 0; dst += 4, src += 4) {
+				dst[r] = src[0];
+				dst[1] = src[1];
+				dst[b] = src[2];
+				dst[3] = src[3];
+			}
+			break;
+
+		case kPixelFormatB8G8R8A8:
+			for (; count-- > 0; dst += 4, src += 4) {
+				dst[r] = src[2];
+				dst[1] = src[1];
+				dst[b] = src[0];
+				dst[3] = src[3];
+			}
+			break;
+
+		case kPixelFormatR5G6B5:
+			for (; count-- > 0; dst += 4, src += 2) {
+				const uint16 color = READ_LE_UINT16(src);
+
+				dst[r] = (color & 0xF800) >> 11;
+				dst[1] = (color & 0x07E0) >>  5;
+				dst[b] =  color & 0x001F;
+				dst[3] = 0xFF;
+			}
+			break;
+
+		case kPixelFormatA1R5G5B5:
+			for (; count-- > 0; dst += 4, src += 2) {
+				const uint16 color = READ_LE_UINT16(src);
+
+				dst[r] = (color & 0x7C00) >> 10;
+				dst[1] = (color & 0x03E0) >>  5;
+				dst[b] =  color & 0x001F;
+				dst[3] = (color & 0x8000) ? 0xFF : 0x00;
+			}
+			break;
+
+		case kPixelFormatDepth16:
+			for (; count-- > 0; dst += 4, src += 2) {
+				const uint16 depth = READ_LE_UINT16(src);
+
+				dst[0] = dst[1] = dst[2] = depth / 128;
+				dst[3] = (depth >= 0x7FFF) ? 0x00 : 0xFF;
+			}
+			break;
+
+		default:
+			throw Common::Exception("Unsupported pixel format: %d", (int) format);
+	}
+}
+// '---
+
+#ifdef PHAETHON_SIMD_X86
+
+/* The SIMD versions convert as many whole vectors of pixels as they can
+ * and return how many pixels that was. The rest is left to convertC(). */
+
+// .--- SSSE3 implementation, for the formats with one byte per component
+/** Build a shuffle mask that moves the components of 4 pixels into RGBA/BGRA order.
+ *
+ *  The c parameters are the offsets of the output components within a
+ *  source pixel, or -1 for components that should be zeroed.
+ */
+static void buildShuffleMask(byte *mask, int bpp, int c0, int c1, int c2, int c3) {
+	const int c[4] = { c0, c1, c2, c3 };
+
+	for (int i = 0; i < 4; i++)
+		for (int j = 0; j < 4; j++)
+			mask[i * 4 + j] = (c[j] < 0) ? 0x80 : (i * bpp + c[j]);
+}
+
+PHAETHON_TARGET_SSSE3 static size_t convertBytesSSSE3(byte *dst, const byte *src, size_t count,
+                                                      int bpp, const byte *mask, bool opaque) {
+
+	const __m128i shuffle = _mm_loadu_si128(reinterpret_cast<const __m128i *>(mask));
+	const __m128i alpha   = _mm_set1_epi32(opaque ? (int) 0xFF000000 : 0);
+
+	// We always load 16 bytes, which is more than 4 pixels in the 3-byte formats
+	size_t i = 0;
+	for (; (count - i) * bpp >= 16; i += 4, src += 4 * bpp, dst += 16) {
+		const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(dst), _mm_or_si128(_mm_shuffle_epi8(pixels, shuffle), alpha));
+	}
+
+	return i;
+}
+
+static size_t convertBytesSIMD(byte *dst, const byte *src, PixelFormat format, size_t count, bool bgra) {
+	if (!Common::hasCPUFeature(Common::kCPUFeatureSSSE3))
+		return 0;
+
+	// Source offsets of the red and blue components
+	const bool swapped = (format == kPixelFormatB8G8R8) || (format == kPixelFormatB8G8R8A8);
+
+	const int r = swapped ? 2 : 0;
+	const int b = swapped ? 0 : 2;
+
+	const int  bpp    = getBPP(format);
+	const bool opaque = bpp == 3;
+
+	byte mask[16];
+	if (bgra)
+		buildShuffleMask(mask, bpp, b, 1, r, opaque ? -1 : 3);
+	else
+		buildShuffleMask(mask, bpp, r, 1, b, opaque ? -1 : 3);
+
+	return convertBytesSSSE3(dst, src, count, bpp, mask, opaque);
+}
+// '---
+
+// .--- SSE2 implementations, for the 16-bit formats
+/** Interleave 8 pixels worth of components in 16-bit lanes into RGBA/BGRA bytes. */
+PHAETHON_TARGET_SSE2 static inline void storeComponentsSSE2(byte *dst, __m128i r, __m128i g,
+                                                            __m128i b, __m128i a, bool bgra) {
+
+	const __m128i first  = bgra ? b : r;
+	const __m128i second = bgra ? r : b;
+
+	const __m128i lo = _mm_or_si128(first , _mm_slli_epi16(g, 8));
+	const __m128i hi = _mm_or_si128(second, _mm_slli_epi16(a, 8));
+
+	_mm_storeu_si128(reinterpret_cast<__m128i *>(dst     ), _mm_unpacklo_epi16(lo, hi));
+	_mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 16), _mm_unpackhi_epi16(lo, hi));
+}
+
+PHAETHON_TARGET_SSE2 static size_t convertR5G6B5SSE2(byte *dst, const byte *src, size_t count, bool bgra) {
+	const __m128i mask5 = _mm_set1_epi16(0x1F);
+	const __m128i mask6 = _mm_set1_epi16(0x3F);
+	const __m128i alpha = _mm_set1_epi16(0xFF);
+
+	size_t i = 0;
+	for (; (count - i) >= 8; i += 8, src += 16, dst += 32) {
+		const __m128i color = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+
+		const __m128i r = _mm_srli_epi16(color, 11);
+		const __m128i g = _mm_and_si128(_mm_srli_epi16(color, 5), mask6);
+		const __m128i b = _mm_and_si128(color, mask5);
+
+		storeComponentsSSE2(dst, r, g, b, alpha, bgra);
+	}
+
+	return i;
+}
+
+PHAETHON_TARGET_SSE2 static size_t convertA1R5G5B5SSE2(byte *dst, const byte *src, size_t count, bool bgra) {
+	const __m128i mask5 = _mm_set1_epi16(0x1F);
+	const __m128i mask8 = _mm_set1_epi16(0xFF);
+
+	size_t i = 0;
+	for (; (count - i) >= 8; i += 8, src += 16, dst += 32) {
+		const __m128i color = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+
+		const __m128i r = _mm_and_si128(_mm_srli_epi16(color, 10), mask5);
+		const __m128i g = _mm_and_si128(_mm_srli_epi16(color,  5), mask5);
+		const __m128i b = _mm_and_si128(color, mask5);
+		const __m128i a = _mm_and_si128(_mm_srai_epi16(color, 15), mask8);
+
+		storeComponentsSSE2(dst, r, g, b, a, bgra);
+	}
+
+	return i;
+}
+
+PHAETHON_TARGET_SSE2 static size_t convertDepth16SSE2(byte *dst, const byte *src, size_t count) {
+	const __m128i mask8 = _mm_set1_epi16(0xFF);
+
+	// Unsigned depth >= 0x7FFF, as a signed compare with the sign bits flipped
+	const __m128i sign  = _mm_set1_epi16((short) 0x8000);
+	const __m128i limit = _mm_set1_epi16((short) (0x7FFE ^ 0x8000));
+
+	size_t i = 0;
+	for (; (count - i) >= 8; i += 8, src += 16, dst += 32) {
+		const __m128i depth = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+
+		const __m128i grey = _mm_and_si128(_mm_srli_epi16(depth, 7), mask8);
+		const __m128i far  = _mm_cmpgt_epi16(_mm_xor_si128(depth, sign), limit);
+		const __m128i a    = _mm_andnot_si128(far, mask8);
+
+		storeComponentsSSE2(dst, grey, grey, grey, a, false);
+	}
+
+	return i;
+}
+
+static size_t convertShortsSIMD(byte *dst, const byte *src, PixelFormat format, size_t count, bool bgra) {
+	if (!Common::hasCPUFeature(Common::kCPUFeatureSSE2))
+		return 0;
+
+	switch (format) {
+		case kPixelFormatR5G6B5:
+			return convertR5G6B5SSE2(dst, src, count, bgra);
+
+		case kPixelFormatA1R5G5B5:
+			return convertA1R5G5B5SSE2(dst, src, count, bgra);
+
+		case kPixelFormatDepth16:
+			return convertDepth16SSE2(dst, src, count);
+
+		default:
+			break;
+	}
+
+	return 0;
+}
+// '---
+
+#endif // PHAETHON_SIMD_X86
+
+static void convert(byte *dst, const byte *src, PixelFormat format, size_t count, bool bgra) {
+	const int bpp = getBPP(format);
+	if (bpp == 0)
+		throw Common::Exception("Unsupported pixel format: %d", (int) format);
+
+	// Already in the right order
+	if (((format == kPixelFormatR8G8B8A8) && !bgra) || ((format == kPixelFormatB8G8R8A8) && bgra)) {
+		std::memcpy(dst, src, count * 4);
+		return;
+	}
+
+	size_t done = 0;
+
+#ifdef PHAETHON_SIMD_X86
+	if (bpp == 2)
+		done = convertShortsSIMD(dst, src, format, count, bgra);
+	else
+		done = convertBytesSIMD(dst, src, format, count, bgra);
+#endif
+
+	convertC(dst + done * 4, src + done * bpp, format, count - done, bgra);
+}
+
+void convertToRGBA8(byte *dst, const byte *src, PixelFormat format, size_t count) {
+	convert(dst, src, format, count, false);
+}
+
+void convertToBGRA8(byte *dst, const byte *src, PixelFormat format, size_t count) {
+	convert(dst, src, format, count, true);
+}
+
+} // End of namespace Images
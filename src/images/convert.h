@@ -0,0 +1,59 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Converting image data into 32-bit RGBA/BGRA.
+ */
+
+#ifndef IMAGES_CONVERT_H
+#define IMAGES_CONVERT_H
+
+#include <cstddef>
+
+#include "src/common/types.h"
+
+#include "src/images/types.h"
+
+namespace Images {
+
+/** Convert uncompressed pixels into 32-bit RGBA, one byte per component.
+ *
+ *  Supported source formats are R8G8B8, B8G8R8, R8G8B8A8, B8G8R8A8, A1R5G5B5,
+ *  R5G6B5 and Depth16. The 16-bit formats are read as little endian. Their
+ *  color components are stored unscaled, and Depth16 values are reduced to
+ *  their bits 7 to 14, as grey.
+ *
+ *  @param dst    The output buffer, with room for count * 4 bytes.
+ *  @param src    The input pixels.
+ *  @param format The pixel format of the input pixels.
+ *  @param count  The number of pixels to convert.
+ */
+void convertToRGBA8(byte *dst, const byte *src, PixelFormat format, size_t count);
+
+/** Convert uncompressed pixels into 32-bit BGRA, one byte per component.
+ *
+ *  This is the byte order of 32-bit TGA files. Otherwise, this works
+ *  exactly like convertToRGBA8().
+ */
+void convertToBGRA8(byte *dst, const byte *src, PixelFormat format, size_t count);
+
+} // End of namespace Images
+
+#endif // IMAGES_CONVERT_H
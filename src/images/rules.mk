@@ -25,6 +25,7 @@ src_images_libimages_la_SOURCES =
 src_images_libimages_la_SOURCES += \
     src/images/types.h \
     src/images/util.h \
+    src/images/convert.h \
     src/images/s3tc.h \
     src/images/decoder.h \
     src/images/dumptga.h \
@@ -34,9 +35,12 @@ src_images_libimages_la_SOURCES += \
     src/images/tpc.h \
     src/images/txb.h \
     src/images/sbm.h \
+    src/images/thumbnail.h \
+    src/images/thumbnailservice.h \
     $(EMPTY)
 
 src_images_libimages_la_SOURCES += \
+    src/images/convert.cpp \
     src/images/s3tc.cpp \
     src/images/decoder.cpp \
     src/images/dumptga.cpp \
@@ -46,4 +50,6 @@ src_images_libimages_la_SOURCES += \
     src/images/tpc.cpp \
     src/images/txb.cpp \
     src/images/sbm.cpp \
+    src/images/thumbnail.cpp \
+    src/images/thumbnailservice.cpp \
     $(EMPTY)
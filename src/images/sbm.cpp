@@ -78,6 +78,13 @@ void SBM::readData(Common::SeekableReadStream &sbm, bool deswizzle) {
 	static const int masks [4] = { 0x03, 0x0C, 0x30, 0xC0 };
 	static const int shifts[4] = {    0,    2,    4,    6 };
 
+	// De-swizzled offsets into a character's data, by column and row
+	uint32 offsetX[32], offsetY[32];
+	for (uint32 i = 0; i < 32; i++) {
+		offsetX[i] = deswizzle ? deSwizzleOffset(i, 0, 32, rowCount) : i;
+		offsetY[i] = deswizzle ? deSwizzleOffset(0, i, 32, rowCount) : (i * 32);
+	}
+
 	byte *data = _mipMaps[0]->data.get();
 	byte buffer[1024];
 	for (size_t c = 0; c < rowCount; c++) {
@@ -88,7 +95,7 @@ void SBM::readData(Common::SeekableReadStream &sbm, bool deswizzle) {
 		for (int y = 0; y < 32; y++) {
 			for (int plane = 0; plane < 4; plane++) {
 				for (int x = 0; x < 32; x++) {
-					const uint32 offset = deswizzle ? deSwizzleOffset(x, y, 32, rowCount) : (y * 32 + x);
+					const uint32 offset = offsetY[y] | offsetX[x];
 
 					const byte a = ((buffer[offset] & masks[plane]) >> shifts[plane]) * 0x55;
 
@@ -0,0 +1,122 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Creating small preview images.
+ */
+
+#include <cassert>
+
+#include "src/common/util.h"
+#include "src/common/error.h"
+
+#include "src/images/thumbnail.h"
+#include "src/images/decoder.h"
+#include "src/images/convert.h"
+
+namespace Images {
+
+Thumbnail::Thumbnail() : width(0), height(0) {
+}
+
+size_t findThumbnailMipMap(const Decoder &image, uint32 size) {
+	// Mip maps get smaller and smaller, so the last big enough one is the smallest
+	size_t mipMap = 0;
+
+	for (size_t i = 1; i < image.getMipMapCount(); i++) {
+		const Decoder::MipMap &m = image.getMipMap(i);
+		if ((uint32) MAX(m.width, m.height) < size)
+			break;
+
+		mipMap = i;
+	}
+
+	return mipMap;
+}
+
+void createThumbnail(const Decoder &image, uint32 size, Thumbnail &thumbnail) {
+	if ((image.getMipMapCount() == 0) || (image.getLayerCount() == 0) || (size == 0))
+		throw Common::Exception("No image data to create a thumbnail from");
+
+	const Decoder::MipMap &mipMap = image.getMipMap(findThumbnailMipMap(image, size));
+	if ((mipMap.width <= 0) || (mipMap.height <= 0))
+		throw Common::Exception("Invalid image dimensions (%d x %d)", mipMap.width, mipMap.height);
+
+	const uint32 width  = mipMap.width;
+	const uint32 height = mipMap.height;
+
+	std::vector<byte> rgba(width * height * 4);
+	convertToRGBA8(&rgba[0], mipMap.data.get(), image.getFormat(), width * height);
+
+	if ((width <= size) && (height <= size)) {
+		thumbnail.width  = width;
+		thumbnail.height = height;
+		thumbnail.data.swap(rgba);
+		return;
+	}
+
+	// Fit the longer side into the thumbnail, keeping the aspect ratio
+	if (width >= height) {
+		thumbnail.width  = size;
+		thumbnail.height = MAX<uint32>(1, (uint64) height * size / width);
+	} else {
+		thumbnail.width  = MAX<uint32>(1, (uint64) width * size / height);
+		thumbnail.height = size;
+	}
+
+	thumbnail.data.resize(thumbnail.width * thumbnail.height * 4);
+
+	scaleDownRGBA8(&rgba[0], width, height, &thumbnail.data[0], thumbnail.width, thumbnail.height);
+}
+
+void scaleDownRGBA8(const byte *src, uint32 srcWidth, uint32 srcHeight,
+                    byte *dst, uint32 dstWidth, uint32 dstHeight) {
+
+	assert((dstWidth <= srcWidth) && (dstHeight <= srcHeight) && (dstWidth > 0) && (dstHeight > 0));
+
+	for (uint32 y = 0; y < dstHeight; y++) {
+		const uint32 y0 = (uint64) y       * srcHeight / dstHeight;
+		const uint32 y1 = (uint64) (y + 1) * srcHeight / dstHeight;
+
+		for (uint32 x = 0; x < dstWidth; x++) {
+			const uint32 x0 = (uint64) x       * srcWidth / dstWidth;
+			const uint32 x1 = (uint64) (x + 1) * srcWidth / dstWidth;
+
+			uint32 sum[4] = { 0, 0, 0, 0 };
+
+			for (uint32 sy = y0; sy < y1; sy++) {
+				const byte *s = src + (sy * srcWidth + x0) * 4;
+
+				for (uint32 sx = x0; sx < x1; sx++, s += 4) {
+					sum[0] += s[0];
+					sum[1] += s[1];
+					sum[2] += s[2];
+					sum[3] += s[3];
+				}
+			}
+
+			const uint32 count = (y1 - y0) * (x1 - x0);
+			for (int i = 0; i < 4; i++)
+				*dst++ = (sum[i] + count / 2) / count;
+		}
+	}
+}
+
+} // End of namespace Images
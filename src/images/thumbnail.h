@@ -0,0 +1,73 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Creating small preview images.
+ */
+
+#ifndef IMAGES_THUMBNAIL_H
+#define IMAGES_THUMBNAIL_H
+
+#include <vector>
+
+#include "src/common/types.h"
+
+namespace Images {
+
+class Decoder;
+
+/** A small preview of an image, as 32-bit RGBA.
+ *
+ *  The rows are in the same order as the rows of the image it was created from.
+ */
+struct Thumbnail {
+	uint32 width;  ///< The thumbnail's width, 0 if it couldn't be created.
+	uint32 height; ///< The thumbnail's height, 0 if it couldn't be created.
+
+	std::vector<byte> data; ///< The pixels, width * height * 4 bytes.
+
+	Thumbnail();
+};
+
+/** Find the smallest mip map of an image that is at least this big in one dimension.
+ *
+ *  If no mip map is that big, this is the biggest mip map, 0.
+ */
+size_t findThumbnailMipMap(const Decoder &image, uint32 size);
+
+/** Create a thumbnail of an image that fits into size * size pixels.
+ *
+ *  The thumbnail is scaled down from the smallest adequate mip map of
+ *  the image's first layer, keeping the aspect ratio. Images that are
+ *  already small enough aren't scaled at all.
+ */
+void createThumbnail(const Decoder &image, uint32 size, Thumbnail &thumbnail);
+
+/** Scale down 32-bit RGBA pixels with a box filter.
+ *
+ *  Every destination pixel is the average of the source pixels it covers.
+ *  The destination can't be bigger than the source.
+ */
+void scaleDownRGBA8(const byte *src, uint32 srcWidth, uint32 srcHeight,
+                    byte *dst, uint32 dstWidth, uint32 dstHeight);
+
+} // End of namespace Images
+
+#endif // IMAGES_THUMBNAIL_H
@@ -0,0 +1,270 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Creating and caching thumbnails in the background.
+ */
+
+#include <memory>
+
+#include "src/common/util.h"
+#include "src/common/error.h"
+#include "src/common/hash.h"
+#include "src/common/filepath.h"
+#include "src/common/readfile.h"
+#include "src/common/writefile.h"
+
+#include "src/images/thumbnailservice.h"
+#include "src/images/decoder.h"
+
+namespace Images {
+
+static const uint32 kThumbnailID = MKTAG('P', 'T', 'H', 'M');
+static const uint32 kVersion1    = MKTAG('V', '1', '.', '0');
+
+bool ThumbnailService::Key::operator<(const Key &key) const {
+	if (fingerprint != key.fingerprint)
+		return fingerprint < key.fingerprint;
+
+	return index < key.index;
+}
+
+
+ThumbnailService::ThumbnailService(const Common::UString &cacheDirectory, uint32 size, size_t threadCount) :
+	_cacheDirectory(cacheDirectory), _size(size), _working(0), _stop(false) {
+
+	threadCount = Common::getThreadCount(threadCount);
+
+	for (size_t i = 0; i < threadCount; i++)
+		_threads.emplace_back(&ThumbnailService::work, this);
+}
+
+ThumbnailService::~ThumbnailService() {
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		_stop = true;
+		_queue.clear();
+	}
+
+	_queueChanged.notify_all();
+
+	for (std::vector<std::thread>::iterator t = _threads.begin(); t != _threads.end(); ++t)
+		t->join();
+}
+
+uint64 ThumbnailService::getFingerprint(const Common::UString &path, uint64 size, uint64 modificationTime) {
+	return Common::hashStringFNV64(Common::UString::format("%s|%llu|%llu", path.c_str(),
+	                               (unsigned long long) size, (unsigned long long) modificationTime));
+}
+
+const Thumbnail *ThumbnailService::get(uint64 fingerprint, uint32 index, const ImageLoader &loader) {
+	const Key key = { fingerprint, index };
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		std::map<Key, std::unique_ptr<Thumbnail> >::const_iterator t = _thumbnails.find(key);
+		if (t != _thumbnails.end())
+			return t->second.get();
+
+		// We already know it's not in the cache directory
+		if (!loader && (_uncached.find(key) != _uncached.end()))
+			return nullptr;
+
+		_uncached.erase(key);
+
+		// Mark the thumbnail as being in the works
+		_thumbnails[key];
+
+		const Request request = { key, loader };
+		_queue.push_back(request);
+	}
+
+	_queueChanged.notify_one();
+	return nullptr;
+}
+
+void ThumbnailService::cancel() {
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	// Forget about the cancelled thumbnails, so that they can be requested again
+	for (std::list<Request>::const_iterator r = _queue.begin(); r != _queue.end(); ++r)
+		_thumbnails.erase(r->key);
+
+	_queue.clear();
+}
+
+bool ThumbnailService::collectFinished(std::vector<Key> &keys) {
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	if (_finished.empty())
+		return false;
+
+	keys.insert(keys.end(), _finished.begin(), _finished.end());
+	_finished.clear();
+
+	return true;
+}
+
+bool ThumbnailService::isBusy() const {
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	return !_queue.empty() || (_working > 0);
+}
+
+void ThumbnailService::work() {
+	while (true) {
+		Request request;
+
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_queueChanged.wait(lock, [this]() { return _stop || !_queue.empty(); });
+
+			if (_stop)
+				return;
+
+			request = _queue.front();
+			_queue.pop_front();
+
+			_working++;
+		}
+
+		std::unique_ptr<Thumbnail> thumbnail = std::make_unique<Thumbnail>();
+		const bool created = create(request, *thumbnail);
+
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+
+			if (created) {
+				_thumbnails[request.key] = std::move(thumbnail);
+			} else {
+				_thumbnails.erase(request.key);
+				_uncached.insert(request.key);
+			}
+
+			_finished.push_back(request.key);
+
+			_working--;
+		}
+	}
+}
+
+bool ThumbnailService::create(const Request &request, Thumbnail &thumbnail) const {
+	if (loadCached(request.key, thumbnail))
+		return true;
+
+	if (!request.loader)
+		return false;
+
+	try {
+		std::unique_ptr<Decoder> image(request.loader());
+		if (!image)
+			throw Common::Exception("No image");
+
+		createThumbnail(*image, _size, thumbnail);
+
+	} catch (...) {
+		/* Remember that this image is broken, so that we don't try again in
+		 * this session. The data might just have failed to read, though, so
+		 * we don't put that into the cache directory. */
+		thumbnail = Thumbnail();
+		return true;
+	}
+
+	saveCached(request.key, thumbnail);
+	return true;
+}
+
+Common::UString ThumbnailService::getCacheFile(const Key &key) const {
+	return _cacheDirectory + "/" + Common::UString::format("%016llX_%08X_%u.thm",
+	       (unsigned long long) key.fingerprint, (uint) key.index, (uint) _size);
+}
+
+bool ThumbnailService::loadCached(const Key &key, Thumbnail &thumbnail) const {
+	if (_cacheDirectory.empty())
+		return false;
+
+	const Common::UString cacheFile = getCacheFile(key);
+	if (!Common::FilePath::isRegularFile(cacheFile))
+		return false;
+
+	try {
+		Common::ReadFile file(cacheFile);
+
+		if ((file.readUint32BE() != kThumbnailID) || (file.readUint32BE() != kVersion1))
+			throw Common::Exception("Not a thumbnail file");
+
+		const uint32 width  = file.readUint32LE();
+		const uint32 height = file.readUint32LE();
+		if ((width > _size) || (height > _size))
+			throw Common::Exception("Invalid thumbnail dimensions (%u x %u)", width, height);
+
+		// Older versions saved failures, which we want to try again
+		if ((width == 0) || (height == 0))
+			return false;
+
+		thumbnail.width  = width;
+		thumbnail.height = height;
+		thumbnail.data.resize(width * height * 4);
+
+		if (!thumbnail.data.empty() && (file.read(&thumbnail.data[0], thumbnail.data.size()) != thumbnail.data.size()))
+			throw Common::Exception(Common::kReadError);
+
+	} catch (Common::Exception &e) {
+		e.add("Failed to load thumbnail \"%s\"", cacheFile.c_str());
+		Common::printException(e, "WARNING: ");
+
+		thumbnail = Thumbnail();
+		return false;
+	}
+
+	return true;
+}
+
+void ThumbnailService::saveCached(const Key &key, const Thumbnail &thumbnail) const {
+	if (_cacheDirectory.empty())
+		return;
+
+	const Common::UString cacheFile = getCacheFile(key);
+
+	try {
+		Common::FilePath::createDirectories(_cacheDirectory);
+
+		Common::WriteFile file(cacheFile);
+
+		file.writeUint32BE(kThumbnailID);
+		file.writeUint32BE(kVersion1);
+
+		file.writeUint32LE(thumbnail.width);
+		file.writeUint32LE(thumbnail.height);
+
+		if (!thumbnail.data.empty())
+			file.write(&thumbnail.data[0], thumbnail.data.size());
+
+		file.flush();
+
+	} catch (Common::Exception &e) {
+		e.add("Failed to save thumbnail \"%s\"", cacheFile.c_str());
+		Common::printException(e, "WARNING: ");
+	}
+}
+
+} // End of namespace Images
@@ -0,0 +1,152 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Creating and caching thumbnails in the background.
+ */
+
+#ifndef IMAGES_THUMBNAILSERVICE_H
+#define IMAGES_THUMBNAILSERVICE_H
+
+#include <vector>
+#include <list>
+#include <map>
+#include <set>
+#include <functional>
+
+#include <boost/noncopyable.hpp>
+
+#include "src/common/types.h"
+#include "src/common/ustring.h"
+#include "src/common/mutex.h"
+#include "src/common/thread.h"
+
+#include "src/images/thumbnail.h"
+
+namespace Images {
+
+class Decoder;
+
+/** Create thumbnails of images on a pool of threads, and keep them around.
+ *
+ *  A thumbnail is identified by the fingerprint of the archive (or file)
+ *  containing the image, and the image's index within it. Finished
+ *  thumbnails are kept in memory and, if a cache directory is given, on
+ *  disk, so that they don't need to be created again in later sessions.
+ *
+ *  Requesting a thumbnail never blocks. Instead, the thumbnail is created
+ *  in the background, and collectFinished() tells which thumbnails became
+ *  ready since the last time.
+ */
+class ThumbnailService : boost::noncopyable {
+public:
+	/** The default size of thumbnails, in pixels. */
+	static const uint32 kDefaultSize = 64;
+
+	/** A function decoding the image to create a thumbnail of.
+	 *
+	 *  Called on a worker thread, and only if the thumbnail isn't in the cache directory.
+	 */
+	typedef std::function<Decoder *()> ImageLoader;
+
+	/** Identifies a thumbnail. */
+	struct Key {
+		uint64 fingerprint; ///< The fingerprint of the archive or file containing the image.
+		uint32 index;       ///< The index of the image within the archive.
+
+		bool operator<(const Key &key) const;
+	};
+
+	/** Create a thumbnail service.
+	 *
+	 *  @param cacheDirectory The directory to keep thumbnails in. If empty, thumbnails are only kept in memory.
+	 *  @param size The maximum width and height of the thumbnails.
+	 *  @param threadCount The number of threads to use. 0 for one per CPU core.
+	 */
+	ThumbnailService(const Common::UString &cacheDirectory = "", uint32 size = kDefaultSize, size_t threadCount = 0);
+	~ThumbnailService();
+
+	/** Return the fingerprint of a file, from its path, size and modification time. */
+	static uint64 getFingerprint(const Common::UString &path, uint64 size, uint64 modificationTime);
+
+	/** Return the thumbnail, if it's ready.
+	 *
+	 *  If it's not ready yet, its creation is queued, and nullptr is returned.
+	 *  If the thumbnail couldn't be created, an empty thumbnail is returned.
+	 *  Such failures are not written to the cache directory, so that they're
+	 *  tried again in later sessions.
+	 *
+	 *  Without a loader, the thumbnail is only looked up in the cache
+	 *  directory. If it's not in there, the key is still reported by
+	 *  collectFinished(), but get() keeps returning nullptr until it's
+	 *  called again with a loader.
+	 *
+	 *  Thumbnails are never removed, so the returned pointer stays valid.
+	 */
+	const Thumbnail *get(uint64 fingerprint, uint32 index, const ImageLoader &loader);
+
+	/** Drop all queued requests that haven't been started yet. */
+	void cancel();
+
+	/** Add the keys of all thumbnails that became ready since the last call.
+	 *
+	 *  @return true if any thumbnails became ready.
+	 */
+	bool collectFinished(std::vector<Key> &keys);
+
+	/** Are any thumbnails still being created? */
+	bool isBusy() const;
+
+private:
+	struct Request {
+		Key key;
+		ImageLoader loader;
+	};
+
+	Common::UString _cacheDirectory;
+	uint32 _size;
+
+	mutable std::mutex _mutex;
+	std::condition_variable _queueChanged;
+
+	std::list<Request> _queue;   ///< Requests not yet started.
+	size_t _working;             ///< Number of requests being worked on.
+	std::vector<Key> _finished;  ///< Thumbnails that became ready since the last collectFinished().
+
+	/** All thumbnails we know about. Entries without a thumbnail are in the works. */
+	std::map<Key, std::unique_ptr<Thumbnail> > _thumbnails;
+	/** Thumbnails that were looked up without a loader, but weren't in the cache directory. */
+	std::set<Key> _uncached;
+
+	bool _stop;
+	std::vector<std::thread> _threads;
+
+	void work();
+	/** Create the thumbnail. Return false if it's not cached and there's no loader. */
+	bool create(const Request &request, Thumbnail &thumbnail) const;
+
+	Common::UString getCacheFile(const Key &key) const;
+	bool loadCached(const Key &key, Thumbnail &thumbnail) const;
+	void saveCached(const Key &key, const Thumbnail &thumbnail) const;
+};
+
+} // End of namespace Images
+
+#endif // IMAGES_THUMBNAILSERVICE_H
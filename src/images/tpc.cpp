@@ -250,20 +250,11 @@ bool TPC::checkCubeMap(uint32 &width, uint32 &height) {
 	return true;
 }
 
-void TPC::deSwizzle(byte *dst, const byte *src, uint32 width, uint32 height) {
-	for (uint32 y = 0; y < height; y++) {
-		for (uint32 x = 0; x < width; x++) {
-			const uint32 offset = deSwizzleOffset(x, y, width, height) * 4;
-
-			*dst++ = src[offset + 0];
-			*dst++ = src[offset + 1];
-			*dst++ = src[offset + 2];
-			*dst++ = src[offset + 3];
-		}
-	}
-}
-
 void TPC::readData(Common::SeekableReadStream &tpc, byte encoding) {
+	// Swizzled data is read in here first, and de-swizzled directly into the mip map
+	std::unique_ptr<byte[]> swizzledData;
+	size_t swizzledSize = 0;
+
 	for (MipMaps::iterator mipMap = _mipMaps.begin(); mipMap != _mipMaps.end(); ++mipMap) {
 
 		// If the texture width is a power of two, the texture memory layout is "swizzled"
@@ -273,12 +264,16 @@ void TPC::readData(Common::SeekableReadStream &tpc, byte encoding) {
 		(*mipMap)->data = std::make_unique<byte[]>((*mipMap)->size);
 
 		if (swizzled) {
-			std::vector<byte> tmp((*mipMap)->size);
+			// Mip maps only ever get smaller, so this is usually only allocated once
+			if (swizzledSize < (*mipMap)->size) {
+				swizzledSize = (*mipMap)->size;
+				swizzledData.reset(new byte[swizzledSize]);
+			}
 
-			if (tpc.read(&tmp[0], (*mipMap)->size) != (*mipMap)->size)
+			if (tpc.read(swizzledData.get(), (*mipMap)->size) != (*mipMap)->size)
 				throw Common::Exception(Common::kReadError);
 
-			deSwizzle((*mipMap)->data.get(), &tmp[0], (*mipMap)->width, (*mipMap)->height);
+			::Images::deSwizzle((*mipMap)->data.get(), swizzledData.get(), (*mipMap)->width, (*mipMap)->height, 4);
 
 		} else {
 			if (tpc.read((*mipMap)->data.get(), (*mipMap)->size) != (*mipMap)->size)
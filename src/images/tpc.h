@@ -56,8 +56,6 @@ private:
 
 	bool checkCubeMap(uint32 &width, uint32 &height);
 	void fixupCubeMap();
-
-	static void deSwizzle(byte *dst, const byte *src, uint32 width, uint32 height);
 };
 
 } // End of namespace Images
@@ -159,18 +159,11 @@ void TXB::readHeader(Common::SeekableReadStream &txb, byte &encoding) {
 		throw Common::Exception("Couldn't read any mip maps");
 }
 
-void TXB::deSwizzle(byte *dst, const byte *src, uint32 width, uint32 height, uint8 bpp) {
-	for (uint32 y = 0; y < height; y++) {
-		for (uint32 x = 0; x < width; x++) {
-			const uint32 offset = deSwizzleOffset(x, y, width, height) * bpp;
-
-			for (uint8 p = 0; p < bpp; p++)
-				*dst++ = src[offset + p];
-		}
-	}
-}
-
 void TXB::readData(Common::SeekableReadStream &txb, byte encoding) {
+	// Swizzled data is read in here first, and de-swizzled directly into the mip map
+	std::unique_ptr<byte[]> swizzledData;
+	size_t swizzledSize = 0;
+
 	for (MipMaps::iterator mipMap = _mipMaps.begin(); mipMap != _mipMaps.end(); ++mipMap) {
 		const bool needDeSwizzle = (encoding == kEncodingBGRA) || (encoding == kEncodingGray);
 
@@ -179,35 +172,38 @@ void TXB::readData(Common::SeekableReadStream &txb, byte encoding) {
 		const bool swizzled = needDeSwizzle && widthPOT;
 
 		(*mipMap)->data = std::make_unique<byte[]>((*mipMap)->size);
-		if (txb.read((*mipMap)->data.get(), (*mipMap)->size) != (*mipMap)->size)
-			throw Common::Exception(Common::kReadError);
 
-		if (encoding == kEncodingGray) {
-			// Convert grayscale into BGR
+		if (swizzled) {
+			// Mip maps only ever get smaller, so this is usually only allocated once
+			if (swizzledSize < (*mipMap)->size) {
+				swizzledSize = (*mipMap)->size;
+				swizzledData.reset(new byte[swizzledSize]);
+			}
 
-			const uint32 oldSize = (*mipMap)->size;
-			const uint32 newSize = (*mipMap)->size * 3;
+			if (txb.read(swizzledData.get(), (*mipMap)->size) != (*mipMap)->size)
+				throw Common::Exception(Common::kReadError);
 
-			std::unique_ptr<byte[]> tmp1 = std::make_unique<byte[]>(newSize);
-			for (uint32 i = 0; i < oldSize; i++)
-				tmp1[i * 3 + 0] = tmp1[i * 3 + 1] = tmp1[i * 3 + 2] = (*mipMap)->data[i];
+			const uint32 bpp = (encoding == kEncodingGray) ? 1 : 4;
 
-			if (swizzled) {
-				std::unique_ptr<byte[]> tmp2 = std::make_unique<byte[]>(newSize);
-				deSwizzle(tmp2.get(), tmp1.get(), (*mipMap)->width, (*mipMap)->height, 3);
+			::Images::deSwizzle((*mipMap)->data.get(), swizzledData.get(), (*mipMap)->width, (*mipMap)->height, bpp);
 
-				tmp1.swap(tmp2);
-			}
+		} else {
+			if (txb.read((*mipMap)->data.get(), (*mipMap)->size) != (*mipMap)->size)
+				throw Common::Exception(Common::kReadError);
+		}
 
-			(*mipMap)->data.swap(tmp1);
-			(*mipMap)->size = newSize;
+		if (encoding == kEncodingGray) {
+			// Convert grayscale into BGR
 
-		} else if (swizzled) {
-			std::unique_ptr<byte[]> tmp = std::make_unique<byte[]>((*mipMap)->size);
+			const uint32 oldSize = (*mipMap)->size;
+			const uint32 newSize = (*mipMap)->size * 3;
 
-			deSwizzle(tmp.get(), (*mipMap)->data.get(), (*mipMap)->width, (*mipMap)->height, 4);
+			std::unique_ptr<byte[]> tmp = std::make_unique<byte[]>(newSize);
+			for (uint32 i = 0; i < oldSize; i++)
+				tmp[i * 3 + 0] = tmp[i * 3 + 1] = tmp[i * 3 + 2] = (*mipMap)->data[i];
 
 			(*mipMap)->data.swap(tmp);
+			(*mipMap)->size = newSize;
 		}
 
 	}
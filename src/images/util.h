@@ -234,6 +234,82 @@ static inline uint32 deSwizzleOffset(uint32 x, uint32 y, uint32 width, uint32 he
 	return offset;
 }
 
+/** Copy a texture out of the swizzled source in 2x2 pixel tiles. */
+template<uint32 kBPP>
+static inline void deSwizzleTiles(byte *dst, const byte *src, const uint32 *offsetX, const uint32 *offsetY,
+                                  uint32 width, uint32 height) {
+
+	const size_t pitch = width * kBPP;
+
+	for (uint32 y = 0; y < height; y += 2) {
+		byte *dst0 = dst + y * pitch;
+		byte *dst1 = dst0 + pitch;
+
+		const byte *src0 = src + offsetY[y];
+		const byte *src1 = src + offsetY[MIN(y + 1, height - 1)];
+
+		for (uint32 x = 0; x < width; x += 2, dst0 += 2 * kBPP, dst1 += 2 * kBPP) {
+			std::memcpy(dst0, src0 + offsetX[x], 2 * kBPP);
+
+			if ((y + 1) < height)
+				std::memcpy(dst1, src1 + offsetX[x], 2 * kBPP);
+		}
+	}
+}
+
+/** De-"swizzle" a whole texture with pixels of bpp bytes each.
+ *
+ *  This gives the same result as looking up each pixel with deSwizzleOffset().
+ *  But the swizzled offset of a pixel is just the x part and the y part of it
+ *  ORed together, so we look those up in tables made once per column and row.
+ *  And since the lowest bit of x is the lowest bit of the offset, pixel pairs
+ *  starting at an even x are next to each other in the source as well. We copy
+ *  two such pairs from two rows at once, which usually form one 2x2 tile that
+ *  lies in one piece in the source.
+ */
+static inline void deSwizzle(byte *dst, const byte *src, uint32 width, uint32 height, uint32 bpp) {
+	if ((width == 0) || (height == 0))
+		return;
+
+	std::unique_ptr<uint32[]> offsetX = std::make_unique<uint32[]>(width);
+	std::unique_ptr<uint32[]> offsetY = std::make_unique<uint32[]>(height);
+
+	for (uint32 x = 0; x < width; x++)
+		offsetX[x] = deSwizzleOffset(x, 0, width, height) * bpp;
+	for (uint32 y = 0; y < height; y++)
+		offsetY[y] = deSwizzleOffset(0, y, width, height) * bpp;
+
+	if ((width >= 2) && ((width % 2) == 0)) {
+		switch (bpp) {
+			case 1:
+				deSwizzleTiles<1>(dst, src, offsetX.get(), offsetY.get(), width, height);
+				return;
+
+			case 2:
+				deSwizzleTiles<2>(dst, src, offsetX.get(), offsetY.get(), width, height);
+				return;
+
+			case 3:
+				deSwizzleTiles<3>(dst, src, offsetX.get(), offsetY.get(), width, height);
+				return;
+
+			case 4:
+				deSwizzleTiles<4>(dst, src, offsetX.get(), offsetY.get(), width, height);
+				return;
+
+			default:
+				break;
+		}
+	}
+
+	for (uint32 y = 0; y < height; y++) {
+		const byte *row = src + offsetY[y];
+
+		for (uint32 x = 0; x < width; x++, dst += bpp)
+			std::memcpy(dst, row + offsetX[x], bpp);
+	}
+}
+
 } // End of namespace Images
 
 #endif // IMAGES_UTIL_H
@@ -30,13 +30,30 @@
 
 #include <cstdio>
 
+#include <memory>
+#include <vector>
+
+#include <boost/scope_exit.hpp>
+#include <boost/filesystem.hpp>
+
 #include <QApplication>
 
 #include "src/version/version.h"
 
 #include "src/common/util.h"
+#include "src/common/strutil.h"
 #include "src/common/error.h"
 #include "src/common/ustring.h"
+#include "src/common/readfile.h"
+#include "src/common/writefile.h"
+#include "src/common/readwritefile.h"
+#include "src/common/filepath.h"
+
+#include "src/aurora/util.h"
+#include "src/aurora/archivepatcher.h"
+#include "src/aurora/archiveloader.h"
+#include "src/aurora/keyfile.h"
+#include "src/aurora/keypatcher.h"
 
 #include "src/gui/icons.h"
 #include "src/gui/mainwindow.h"
@@ -48,6 +65,8 @@
 void initPlatform();
 
 void openGamePath(const Common::UString &path);
+void renderSound(const Common::UString &file, const Common::UString &output);
+void compactArchive(const Common::UString &file);
 
 int main(int argc, char **argv) {
 	initPlatform();
@@ -73,6 +92,14 @@ int main(int argc, char **argv) {
 				openGamePath(job.path);
 				break;
 
+			case kOperationRenderSound:
+				renderSound(job.path, job.output);
+				break;
+
+			case kOperationCompactArchive:
+				compactArchive(job.path);
+				break;
+
 			case kOperationInvalid:
 			default:
 				std::printf("%s\n", createHelpText(args[0]).c_str());
@@ -163,6 +190,123 @@ void openGamePath(const Common::UString &path) {
 	Phaethon phaethon(path);
 }
 
+void renderSound(const Common::UString &file, const Common::UString &output) {
+	SoundMan.initOffline();
+
+	BOOST_SCOPE_EXIT(void) {
+		SoundMan.deinit();
+
+		Sound::SoundManager::destroy();
+	} BOOST_SCOPE_EXIT_END
+
+	std::unique_ptr<Common::WriteFile> outputFile;
+	if (!output.empty())
+		outputFile = std::make_unique<Common::WriteFile>(output);
+
+	Sound::ChannelHandle channel = SoundMan.playSoundFile(new Common::ReadFile(file), Sound::kSoundTypeUnknown);
+
+	const Sound::RenderStatistics stats = SoundMan.renderChannel(channel, outputFile.get());
+
+	if (outputFile)
+		outputFile->flush();
+
+	std::printf("%s: %d channel(s), %d Hz, %s samples (%s bytes) in %.3fs\n", file.c_str(),
+	            stats.channels, stats.rate, Common::composeString(stats.samples).c_str(),
+	            Common::composeString(stats.bytes).c_str(), stats.seconds);
+	std::printf("%.0f samples/s, %.1fx real time\n", stats.getSamplesPerSecond(), stats.getRealTimeFactor());
+}
+
+/** A copy of a file, patched to replace the original. */
+typedef std::pair<Common::UString, Common::UString> PatchCopy;
+
+/** Copy a file, so that the copy can be patched without touching the original. */
+static Common::UString createPatchCopy(const Common::UString &file, std::vector<PatchCopy> &copies) {
+	copies.push_back(std::make_pair(file + ".tmp", file));
+
+	Common::ReadFile  original(file);
+	Common::WriteFile patched(copies.back().first);
+
+	patched.writeStream(original);
+	patched.flush();
+
+	return copies.back().first;
+}
+
+/** Compact a copy of an archive file, returning the size of the compacted copy. */
+static size_t compactCopy(const Common::UString &file, const Common::UString &copy) {
+	std::unique_ptr<Aurora::ArchivePatcher> archive(
+		Aurora::openArchivePatcher(new Common::ReadWriteFile(copy), TypeMan.getFileType(file)));
+
+	const size_t oldSize = archive->getSize();
+	const double fragmentation = archive->getFragmentation();
+
+	archive->compact();
+
+	std::printf("%s: %s bytes (%.1f%% unused) compacted to %s bytes\n", file.c_str(),
+	            Common::composeString(oldSize).c_str(), fragmentation * 100.0,
+	            Common::composeString(archive->getSize()).c_str());
+
+	return archive->getSize();
+}
+
+/** Compact copies of all BIFs indexed by a KEY, and update their sizes within a copy of the KEY. */
+static void compactKEY(const Common::UString &file, std::vector<PatchCopy> &copies) {
+	std::vector<Common::UString> dataFiles;
+	{
+		Aurora::KEYFile key(new Common::ReadFile(file));
+		dataFiles = key.getDataFileList();
+	}
+
+	Aurora::KEYPatcher key(new Common::ReadWriteFile(createPatchCopy(file, copies)));
+
+	const Common::UString dataPath = Common::FilePath::getDirectory(file);
+	for (size_t i = 0; i < dataFiles.size(); i++) {
+		const Common::UString path = Common::FilePath::normalize(dataPath + "/" + dataFiles[i]);
+
+		// Only BIFs can be patched in place, and missing ones have nothing to compact
+		if (path.empty() || (TypeMan.getFileType(path) != Aurora::kFileTypeBIF))
+			continue;
+
+		key.setDataFileSize(i, compactCopy(path, createPatchCopy(path, copies)));
+	}
+
+	key.flush();
+}
+
+void compactArchive(const Common::UString &file) {
+	/* Compacting moves resource data the old tables still point to, so an
+	 * interrupted compact() would break the archive. We therefore compact
+	 * copies, and only replace the originals once all of them are done. */
+	std::vector<PatchCopy> copies;
+
+	try {
+		switch (TypeMan.getFileType(file)) {
+			case Aurora::kFileTypeBIF:
+				throw Common::Exception("The KEY file indexing a BIF records its size. Compact the KEY file instead");
+
+			case Aurora::kFileTypeKEY:
+				compactKEY(file, copies);
+				break;
+
+			default:
+				compactCopy(file, createPatchCopy(file, copies));
+				break;
+		}
+
+	} catch (...) {
+		for (std::vector<PatchCopy>::const_iterator c = copies.begin(); c != copies.end(); ++c) {
+			boost::system::error_code error;
+			boost::filesystem::remove(c->first.c_str(), error);
+		}
+
+		throw;
+	}
+
+	// Replace the originals in reverse, so that a KEY is only replaced after the BIFs it describes
+	for (std::vector<PatchCopy>::const_reverse_iterator c = copies.rbegin(); c != copies.rend(); ++c)
+		boost::filesystem::rename(c->first.c_str(), c->second.c_str());
+}
+
 #ifdef WIN32
 #ifdef UNICODE
 	int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PWSTR pCmdLine, int nCmdShow) {
@@ -50,6 +50,7 @@
 #include <memory>
 
 #include "src/common/disposableptr.h"
+#include "src/common/ptrvector.h"
 #include "src/common/util.h"
 #include "src/common/error.h"
 #include "src/common/memreadstream.h"
@@ -119,6 +120,9 @@ public:
 
 	bool rewind();
 
+	/** Decode all remaining packets at once, using several threads. */
+	RewindableAudioStream *decodeAll();
+
 private:
 	// Packet data
 	struct Packet {
@@ -149,6 +153,7 @@ private:
 	void parseFileHeader();
 	Packet *readPacket();
 	PacketizedAudioStream *createAudioStream();
+	Common::SeekableReadStream *readAudioData();
 	void feedAudioData();
 	bool allDataLoaded() const;
 
@@ -418,34 +423,52 @@ PacketizedAudioStream *ASFStream::createAudioStream() {
 	return 0;
 }
 
-void ASFStream::feedAudioData() {
+Common::SeekableReadStream *ASFStream::readAudioData() {
 	std::unique_ptr<Packet> packet(readPacket());
 
 	// TODO
 	if (packet->segments.size() != 1)
-		throw Common::Exception("ASFStream::feedAudioData(): Only single segment packets supported");
+		throw Common::Exception("ASFStream::readAudioData(): Only single segment packets supported");
 
 	Packet::Segment &segment = packet->segments[0];
 
 	// We should only have one stream in a ASF audio file
 	if (segment.streamID != _streamID)
-		throw Common::Exception("ASFStream::feedAudioData(): Packet stream ID mismatch");
+		throw Common::Exception("ASFStream::readAudioData(): Packet stream ID mismatch");
 
 	// TODO
 	if (segment.sequenceNumber != _curSequenceNumber)
-		throw Common::Exception("ASFStream::feedAudioData(): Only one sequence number per packet supported");
+		throw Common::Exception("ASFStream::readAudioData(): Only one sequence number per packet supported");
 
 	// This can overflow and needs to overflow!
 	_curSequenceNumber++;
 
 	// TODO
 	if (segment.data.size() != 1)
-		throw Common::Exception("ASFStream::feedAudioData(): Packet grouping not supported");
+		throw Common::Exception("ASFStream::readAudioData(): Packet grouping not supported");
 
-	_curAudioStream->queuePacket(segment.data[0]);
-
-	// The PacketizedAudioStream has taken ownership of the pointer; reset it here
+	// The caller takes ownership of the pointer; reset it here
+	Common::SeekableReadStream *data = segment.data[0];
 	segment.data[0] = 0;
+
+	return data;
+}
+
+void ASFStream::feedAudioData() {
+	_curAudioStream->queuePacket(readAudioData());
+}
+
+RewindableAudioStream *ASFStream::decodeAll() {
+	Common::PtrVector<Common::SeekableReadStream> packets;
+	while (!allDataLoaded())
+		packets.push_back(readAudioData());
+
+	switch (_compression) {
+	case kWaveWMAv2:
+		return decodeWMAStream(2, _sampleRate, _channels, _bitRate, _blockAlign, *_extraData, packets);
+	default:
+		throw Common::Exception("ASFStream::decodeAll(): Unknown compression 0x%04x", _compression);
+	}
 }
 
 size_t ASFStream::readBuffer(int16 *buffer, const size_t numSamples) {
@@ -479,8 +502,12 @@ bool ASFStream::endOfData() const {
 	return allDataLoaded() && _curAudioStream->endOfData();
 }
 
-RewindableAudioStream *makeASFStream(Common::SeekableReadStream *stream, bool disposeAfterUse) {
-	return new ASFStream(stream, disposeAfterUse);
+RewindableAudioStream *makeASFStream(Common::SeekableReadStream *stream, bool disposeAfterUse, bool offline) {
+	std::unique_ptr<ASFStream> asf = std::make_unique<ASFStream>(stream, disposeAfterUse);
+	if (!offline)
+		return asf.release();
+
+	return asf->decodeAll();
 }
 
 } // End of namespace Sound
@@ -33,13 +33,15 @@ namespace Sound {
  *
  * @param stream          The SeekableReadStream from which to read the ASF data.
  * @param disposeAfterUse Whether to delete the stream after use.
+ * @param offline         Decode the whole stream up front, on several threads,
+ *                        instead of packet by packet while playing.
  *
  * @return A new RewindableAudioStream, or 0, if an error occurred.
  */
 
 RewindableAudioStream *makeASFStream(
 	Common::SeekableReadStream *stream,
-	bool disposeAfterUse = true);
+	bool disposeAfterUse = true, bool offline = false);
 
 } // End of namespace Sound
 
@@ -53,6 +53,8 @@
 
 #include <vector>
 #include <memory>
+#include <exception>
+#include <functional>
 
 #include "src/common/util.h"
 #include "src/common/maths.h"
@@ -60,10 +62,12 @@
 #include "src/common/error.h"
 #include "src/common/memreadstream.h"
 #include "src/common/mdct.h"
+#include "src/common/floatdsp.h"
 #include "src/common/bitstream.h"
 #include "src/common/huffman.h"
 #include "src/common/types.h"
 #include "src/common/ptrvector.h"
+#include "src/common/thread.h"
 
 #include "src/sound/audiostream.h"
 
@@ -74,29 +78,6 @@
 
 namespace Sound {
 
-static inline void butterflyFloats(float *v1, float *v2, int len) {
-	while (len-- > 0) {
-		float t = *v1 - *v2;
-
-		*v1++ += *v2;
-		*v2++  = t;
-	}
-}
-
-static inline void vectorFMulAdd(float *dst, const float *src0,
-                          const float *src1, const float *src2, int len) {
-	while (len-- > 0)
-		*dst++ = *src0++ * *src1++ + *src2++;
-}
-
-static inline void vectorFMulReverse(float *dst, const float *src0,
-                                     const float *src1, int len) {
-	src1 += len - 1;
-
-	while (len-- > 0)
-		*dst++ = *src0++ * *src1--;
-}
-
 struct WMACoefHuffmanParam;
 
 class WMACodec : public PacketizedAudioStream {
@@ -117,6 +98,40 @@ public:
 	bool isFinished() const { return _audStream->isFinished(); }
 	void queuePacket(Common::SeekableReadStream *data);
 
+	// Offline decoding
+
+	/** All decoder state that carries over from one superframe into the next. */
+	struct State {
+		bool resetBlockLengths;
+
+		int blockLen;
+		int blockLenBits;
+		int nextBlockLenBits;
+		int prevBlockLenBits;
+
+		int noiseIndex;
+
+		std::vector<int>   exponentsBSize;
+		std::vector<float> maxExponent;
+
+		/** Only the part of the exponents the next block can reference. */
+		std::vector< std::vector<float> > exponents;
+
+		std::vector<byte> lastSuperframe;
+		int lastBitoffset;
+
+		std::vector< std::vector<float> > frameOut;
+
+		/** Bit-wise comparison: equal states produce equal output from equal input. */
+		bool operator==(const State &state) const;
+	};
+
+	void getState(State &state) const;
+	void setState(const State &state);
+
+	/** Decode one packet directly into interleaved PCM data, bypassing the queue. */
+	Common::SeekableReadStream *decodePacket(Common::SeekableReadStream &data);
+
 private:
 	static const int kChannelsMax = 2; ///< Max number of channels we support.
 
@@ -298,7 +313,7 @@ WMACodec::WMACodec(int version, uint32 sampleRate, uint8 channels,
 	_bitRate(bitRate), _blockAlign(blockAlign), _audioFlags(0),
 	_resetBlockLengths(true), _curFrame(0), _frameLen(0), _frameLenBits(0),
 	_blockSizeCount(0), _framePos(0), _curBlock(0), _blockLen(0), _blockLenBits(0),
-	_nextBlockLenBits(0), _prevBlockLenBits(0), _byteOffsetBits(0),
+	_nextBlockLenBits(0), _prevBlockLenBits(0), _byteOffsetBits(0), _noiseIndex(0),
 	_lastSuperframeLen(0), _lastBitoffset(0) {
 
 	for (int i = 0; i < 2; i++)
@@ -362,6 +377,11 @@ void WMACodec::init(Common::SeekableReadStream *extraData) {
 	// Init exponent codes
 	initExponents();
 
+	// Clear the exponents
+	std::memset(_exponentsBSize, 0, sizeof(_exponentsBSize));
+	std::memset(_exponents     , 0, sizeof(_exponents));
+	std::memset(_maxExponent   , 0, sizeof(_maxExponent));
+
 	// Clear the sample output buffers
 	std::memset(_output  , 0, sizeof(_output));
 	std::memset(_frameOut, 0, sizeof(_frameOut));
@@ -1002,7 +1022,7 @@ bool WMACodec::decodeChannels(Common::BitStream &bits, int bSize,
 			hasChannel[0] = true;
 		}
 
-		butterflyFloats(_coefs[0], _coefs[1], _blockLen);
+		Common::butterflyFloats(_coefs[0], _coefs[1], _blockLen);
 	}
 
 	return true;
@@ -1617,7 +1637,7 @@ void WMACodec::window(float *out) const {
 
 		const int bSize = _frameLenBits - _blockLenBits;
 
-		vectorFMulAdd(out, in, _mdctWindow[bSize], out, _blockLen);
+		Common::vectorFMulAdd(out, in, _mdctWindow[bSize], out, _blockLen);
 
 	} else {
 
@@ -1626,7 +1646,7 @@ void WMACodec::window(float *out) const {
 
 		const int bSize = _frameLenBits - _prevBlockLenBits;
 
-		vectorFMulAdd(out + n, in + n, _mdctWindow[bSize], out + n, blockLen);
+		Common::vectorFMulAdd(out + n, in + n, _mdctWindow[bSize], out + n, blockLen);
 
 		std::memcpy(out + n + blockLen, in + n + blockLen, n * sizeof(float));
 	}
@@ -1639,7 +1659,7 @@ void WMACodec::window(float *out) const {
 
 		const int bSize = _frameLenBits - _blockLenBits;
 
-		vectorFMulReverse(out, in, _mdctWindow[bSize], _blockLen);
+		Common::vectorFMulReverse(out, in, _mdctWindow[bSize], _blockLen);
 
 	} else {
 
@@ -1650,7 +1670,7 @@ void WMACodec::window(float *out) const {
 
 		std::memcpy(out, in, n*sizeof(float));
 
-		vectorFMulReverse(out + n, in + n, _mdctWindow[bSize], blockLen);
+		Common::vectorFMulReverse(out + n, in + n, _mdctWindow[bSize], blockLen);
 
 		std::memset(out + n + blockLen, 0, n * sizeof(float));
 	}
@@ -1722,8 +1742,240 @@ void WMACodec::queuePacket(Common::SeekableReadStream *data) {
 		_audStream->queueAudioStream(stream);
 }
 
+Common::SeekableReadStream *WMACodec::decodePacket(Common::SeekableReadStream &data) {
+	return decodeSuperFrame(data);
+}
+
+template<typename T>
+static bool equalBits(const std::vector<T> &a, const std::vector<T> &b) {
+	if (a.size() != b.size())
+		return false;
+
+	return a.empty() || !std::memcmp(&a[0], &b[0], a.size() * sizeof(T));
+}
+
+bool WMACodec::State::operator==(const State &state) const {
+	if ((resetBlockLengths != state.resetBlockLengths) ||
+	    (blockLen          != state.blockLen)          ||
+	    (blockLenBits      != state.blockLenBits)      ||
+	    (nextBlockLenBits  != state.nextBlockLenBits)  ||
+	    (prevBlockLenBits  != state.prevBlockLenBits)  ||
+	    (noiseIndex        != state.noiseIndex)        ||
+	    (lastBitoffset     != state.lastBitoffset))
+		return false;
+
+	if (!equalBits(exponentsBSize, state.exponentsBSize) ||
+	    !equalBits(maxExponent   , state.maxExponent)    ||
+	    !equalBits(lastSuperframe, state.lastSuperframe))
+		return false;
+
+	if ((exponents.size() != state.exponents.size()) || (frameOut.size() != state.frameOut.size()))
+		return false;
+
+	for (size_t i = 0; i < exponents.size(); i++)
+		if (!equalBits(exponents[i], state.exponents[i]))
+			return false;
+
+	for (size_t i = 0; i < frameOut.size(); i++)
+		if (!equalBits(frameOut[i], state.frameOut[i]))
+			return false;
+
+	return true;
+}
+
+void WMACodec::getState(State &state) const {
+	state.resetBlockLengths = _resetBlockLengths;
+
+	state.blockLen         = _blockLen;
+	state.blockLenBits     = _blockLenBits;
+	state.nextBlockLenBits = _nextBlockLenBits;
+	state.prevBlockLenBits = _prevBlockLenBits;
+
+	// Without noise coding, the noise index is never touched
+	state.noiseIndex = _useNoiseCoding ? _noiseIndex : 0;
+
+	state.exponentsBSize.assign(_exponentsBSize, _exponentsBSize + _channels);
+	state.maxExponent.assign(_maxExponent, _maxExponent + _channels);
+
+	state.exponents.resize(_channels);
+	state.frameOut.resize(_channels);
+
+	for (int i = 0; i < _channels; i++) {
+		// Exponents are only ever indexed up to the frame length scaled down to their block size
+		const int expCount = _frameLen >> _exponentsBSize[i];
+
+		state.exponents[i].assign(_exponents[i], _exponents[i] + expCount);
+		state.frameOut[i].assign(_frameOut[i], _frameOut[i] + 2 * _frameLen);
+	}
+
+	state.lastSuperframe.assign(_lastSuperframe, _lastSuperframe + _lastSuperframeLen);
+	state.lastBitoffset = _lastBitoffset;
+}
+
+void WMACodec::setState(const State &state) {
+	assert((state.exponents.size() == (size_t) _channels) && (state.frameOut.size() == (size_t) _channels));
+
+	_resetBlockLengths = state.resetBlockLengths;
+
+	_blockLen         = state.blockLen;
+	_blockLenBits     = state.blockLenBits;
+	_nextBlockLenBits = state.nextBlockLenBits;
+	_prevBlockLenBits = state.prevBlockLenBits;
+
+	if (_useNoiseCoding)
+		_noiseIndex = state.noiseIndex;
+
+	for (int i = 0; i < _channels; i++) {
+		_exponentsBSize[i] = state.exponentsBSize[i];
+		_maxExponent[i]    = state.maxExponent[i];
+
+		std::memcpy(_exponents[i], &state.exponents[i][0], state.exponents[i].size() * sizeof(float));
+		std::memcpy(_frameOut[i] , &state.frameOut[i][0] , state.frameOut[i].size()  * sizeof(float));
+	}
+
+	_lastSuperframeLen = state.lastSuperframe.size();
+	if (!state.lastSuperframe.empty())
+		std::memcpy(_lastSuperframe, &state.lastSuperframe[0], _lastSuperframeLen);
+
+	_lastBitoffset = state.lastBitoffset;
+}
+
 PacketizedAudioStream *makeWMAStream(int version, uint32 sampleRate, uint8 channels, uint32 bitRate, uint32 blockAlign, Common::SeekableReadStream &extraData) {
 	return new WMACodec(version, sampleRate, channels, bitRate, blockAlign, &extraData);
 }
 
+
+/** Number of packets decoded, and thrown away, in front of a segment to resync the decoder. */
+static const size_t kWMAResyncPackets = 2;
+/** Minimum number of packets in a segment worth decoding on its own thread. */
+static const size_t kWMASegmentPacketsMin = 32;
+
+namespace {
+
+/** A run of consecutive packets decoded by its own WMACodec. */
+struct WMASegment {
+	std::unique_ptr<WMACodec> codec;
+
+	size_t start; ///< Index of the first packet of this segment.
+	size_t end;   ///< Index one past the last packet of this segment.
+
+	WMACodec::State startState; ///< The decoder state right before the first packet.
+	WMACodec::State endState;   ///< The decoder state right after the last packet.
+
+	Common::PtrVector<Common::SeekableReadStream> pcm; ///< Decoded PCM data, one per packet.
+
+	std::exception_ptr error;
+};
+
+}
+
+static void decodeWMASegment(WMASegment &segment, const std::vector< std::vector<byte> > &packets,
+                             size_t resyncStart) {
+
+	try {
+		segment.pcm.clear();
+
+		// Warm up: bit reservoir overhang, block lengths, exponents and the overlap-add buffer
+		for (size_t i = resyncStart; i < segment.start; i++) {
+			Common::MemoryReadStream packet(packets[i].data(), packets[i].size());
+			delete segment.codec->decodePacket(packet);
+		}
+
+		segment.codec->getState(segment.startState);
+
+		for (size_t i = segment.start; i < segment.end; i++) {
+			Common::MemoryReadStream packet(packets[i].data(), packets[i].size());
+			segment.pcm.push_back(segment.codec->decodePacket(packet));
+		}
+
+		segment.codec->getState(segment.endState);
+
+	} catch (...) {
+		segment.error = std::current_exception();
+	}
+}
+
+RewindableAudioStream *decodeWMAStream(int version, uint32 sampleRate, uint8 channels,
+		uint32 bitRate, uint32 blockAlign, Common::SeekableReadStream &extraData,
+		const std::vector<Common::SeekableReadStream *> &packets, size_t threadCount) {
+
+	const size_t segmentCount = MAX<size_t>(1, MIN<size_t>(Common::getThreadCount(threadCount),
+	                                                       packets.size() / kWMASegmentPacketsMin));
+
+	// Take private copies of the packet data, so that threads can share them freely
+	std::vector< std::vector<byte> > packetData(packets.size());
+	for (size_t i = 0; i < packets.size(); i++) {
+		packets[i]->seek(0);
+
+		packetData[i].resize(packets[i]->size());
+		if (packets[i]->read(packetData[i].data(), packetData[i].size()) != packetData[i].size())
+			throw Common::Exception(Common::kReadError);
+	}
+
+	// The codecs read the extra data on creation, so create them all here
+	std::vector<WMASegment> segments(segmentCount);
+	for (size_t i = 0; i < segmentCount; i++) {
+		segments[i].codec = std::make_unique<WMACodec>(version, sampleRate, channels, bitRate, blockAlign, &extraData);
+
+		segments[i].start = (packets.size() *  i     ) / segmentCount;
+		segments[i].end   = (packets.size() * (i + 1)) / segmentCount;
+	}
+
+	/* Decode all segments speculatively in parallel. Every segment but the first
+	 * starts with a fresh codec that first decodes a few packets in front of it,
+	 * which usually recreates the exact decoder state the serial decode would have
+	 * at that point. */
+	Common::parallelFor(segmentCount, [&](size_t i, size_t UNUSED(thread)) {
+		const size_t resyncStart = segments[i].start - MIN(segments[i].start, kWMAResyncPackets);
+
+		decodeWMASegment(segments[i], packetData, resyncStart);
+	}, segmentCount);
+
+	/* Reconcile the segment boundaries. The first segment is exact; each following
+	 * one is only correct if it started from the state the previous one ended with.
+	 * If it didn't (for example because the noise table index depends on the whole
+	 * stream so far), decode that segment again from the correct state. */
+	for (size_t i = 0; i < segmentCount; i++) {
+		if ((i > 0) && !segments[i].error && (segments[i].startState == segments[i - 1].endState))
+			continue;
+
+		if (i > 0) {
+			segments[i].error = std::exception_ptr();
+			segments[i].codec->setState(segments[i - 1].endState);
+
+			decodeWMASegment(segments[i], packetData, segments[i].start);
+		}
+
+		if (segments[i].error)
+			std::rethrow_exception(segments[i].error);
+	}
+
+	// Glue the PCM data of all packets together
+
+	size_t size = 0;
+	for (std::vector<WMASegment>::const_iterator s = segments.begin(); s != segments.end(); ++s)
+		for (std::vector<Common::SeekableReadStream *>::const_iterator p = s->pcm.begin(); p != s->pcm.end(); ++p)
+			if (*p)
+				size += (*p)->size();
+
+	std::unique_ptr<byte[]> data = std::make_unique<byte[]>(size);
+
+	byte *out = data.get();
+	for (std::vector<WMASegment>::const_iterator s = segments.begin(); s != segments.end(); ++s) {
+		for (std::vector<Common::SeekableReadStream *>::const_iterator p = s->pcm.begin(); p != s->pcm.end(); ++p) {
+			if (!*p)
+				continue;
+
+			out += (*p)->read(out, (*p)->size());
+		}
+	}
+
+	byte flags = FLAG_16BITS;
+#ifdef PHAETHON_LITTLE_ENDIAN
+	flags |= FLAG_LITTLE_ENDIAN;
+#endif
+
+	return makePCMStream(new Common::MemoryReadStream(data.release(), size, true), sampleRate, flags, channels, true);
+}
+
 } // End of namespace Sound
@@ -25,6 +25,8 @@
 #ifndef SOUND_DECODERS_WMA_H
 #define SOUND_DECODERS_WMA_H
 
+#include <vector>
+
 #include "src/common/types.h"
 
 namespace Common {
@@ -34,6 +36,7 @@ class SeekableReadStream;
 namespace Sound {
 
 class PacketizedAudioStream;
+class RewindableAudioStream;
 
 /**
  * Create a PacketizedAudioStream that decodes WMA sound
@@ -44,6 +47,24 @@ class PacketizedAudioStream;
 PacketizedAudioStream *makeWMAStream(int version, uint32 sampleRate, uint8 channels,
 	uint32 bitRate, uint32 blockAlign, Common::SeekableReadStream &extraData);
 
+/**
+ * Decode a complete sequence of WMA packets in one go, splitting the work
+ * across several threads.
+ *
+ * The packets are cut into consecutive segments that are decoded in parallel,
+ * each resyncing on a few packets in front of it. The decoder state at every
+ * segment boundary is then checked against the state the previous segment
+ * ended with, and segments that don't match are decoded again. The output is
+ * therefore identical to feeding the packets one by one into makeWMAStream().
+ *
+ * @param packets      The WMA packets, in order. They are only read from.
+ * @param threadCount  The maximum number of threads to use, 0 for one per core.
+ * @return             A new RewindableAudioStream with the decoded PCM data.
+ */
+RewindableAudioStream *decodeWMAStream(int version, uint32 sampleRate, uint8 channels,
+	uint32 bitRate, uint32 blockAlign, Common::SeekableReadStream &extraData,
+	const std::vector<Common::SeekableReadStream *> &packets, size_t threadCount = 0);
+
 } // End of namespace Sound
 
 #endif // SOUND_DECODERS_WMA_H
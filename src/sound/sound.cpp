@@ -25,10 +25,13 @@
 #include <cassert>
 #include <cstring>
 
+#include <chrono>
+
 #include <boost/scope_exit.hpp>
 
 #include "src/common/util.h"
 #include "src/common/readstream.h"
+#include "src/common/writestream.h"
 #include "src/common/strutil.h"
 #include "src/common/error.h"
 
@@ -59,12 +62,13 @@ namespace Sound {
 SoundManager::Channel::Channel(uint32 i, size_t idx, SoundType t,
                                const TypeList::iterator &ti, AudioStream *s, bool d) :
 	id(i), index(idx), state(AL_PAUSED), stream(s, d), source(0),
-	type(t), typeIt(ti), finishedBuffers(0), gain(1.0f) {
+	type(t), typeIt(ti), finishedBuffers(0), offlineOutput(0), gain(1.0f) {
 
 }
 
 
-SoundManager::SoundManager() : _ready(false), _hasSound(false), _hasMultiChannel(false), _format51(0) {
+SoundManager::SoundManager() : _ready(false), _hasSound(false), _offline(false),
+	_hasMultiChannel(false), _format51(0) {
 }
 
 SoundManager::~SoundManager() {
@@ -79,6 +83,7 @@ void SoundManager::init() {
 	_ctx = 0;
 
 	_hasSound = false;
+	_offline  = false;
 
 	_hasMultiChannel = false;
 	_format51        = 0;
@@ -121,6 +126,24 @@ void SoundManager::init() {
 		setTypeGain((SoundType) i, 1.0);
 }
 
+void SoundManager::initOffline() {
+	for (size_t i = 0; i < kSoundTypeMAX; i++)
+		_types[i].gain = 1.0f;
+
+	_curID = 1;
+
+	_dev = 0;
+	_ctx = 0;
+
+	_hasSound = false;
+	_offline  = true;
+
+	_hasMultiChannel = false;
+	_format51        = 0;
+
+	_ready = true;
+}
+
 void SoundManager::deinit() {
 	if (!_ready)
 		return;
@@ -136,13 +159,18 @@ void SoundManager::deinit() {
 		alcCloseDevice(_dev);
 	}
 
-	_ready = false;
+	_offline = false;
+	_ready   = false;
 }
 
 bool SoundManager::ready() const {
 	return _ready;
 }
 
+bool SoundManager::isOffline() const {
+	return _offline;
+}
+
 void SoundManager::triggerUpdate() {
 	checkReady();
 
@@ -175,6 +203,11 @@ bool SoundManager::isPlaying(size_t channel) const {
 	if ((channel >= kChannelCount) || !_channels[channel])
 		return false;
 
+	// Offline, a channel plays for as long as there's data queued or left in the stream
+	if (_offline)
+		return !_channels[channel]->offlineQueue.empty() ||
+		       (_channels[channel]->stream && !_channels[channel]->stream->endOfStream());
+
 	// TODO: This might pose a problem should we ever need to wait
 	//       for sounds to finish (for syncing, ...). We need to
 	//       add a way for audio streams to tell us how long they are
@@ -229,7 +262,7 @@ bool SoundManager::isPaused(const ChannelHandle &handle) {
 	return _channels[handle.channel]->state == AL_PAUSED;
 }
 
-AudioStream *SoundManager::makeAudioStream(Common::SeekableReadStream *stream) {
+AudioStream *SoundManager::makeAudioStream(Common::SeekableReadStream *stream, bool offline) {
 	bool isMP3 = false;
 	uint32 tag = stream->readUint32BE();
 
@@ -283,7 +316,7 @@ AudioStream *SoundManager::makeAudioStream(Common::SeekableReadStream *stream) {
 
 		// ASF (most probably with WMAv2)
 		stream->seek(0);
-		return makeASFStream(stream, true);
+		return makeASFStream(stream, true, offline);
 
 	} else if (((tag & 0xFFFFFF00) | 0x20) == MKTAG('I', 'D', '3', ' ')) {
 
@@ -335,7 +368,20 @@ ChannelHandle SoundManager::playAudioStream(AudioStream *audStream, SoundType ty
 
 	ALenum error = AL_NO_ERROR;
 
-	if (_hasSound) {
+	if (_offline) {
+		// Create all needed buffers. Offline, a buffer is only an ID into our own storage
+		for (size_t i = 0; i < kOpenALBufferCount; i++) {
+			const ALuint buffer = i + 1;
+
+			if (fillBuffer(channel, buffer, channel.stream.get(), channel.bufferSize[buffer]))
+				queueBuffer(channel, buffer);
+			else
+				channel.freeBuffers.push_back(buffer);
+
+			channel.buffers.push_back(buffer);
+		}
+
+	} else if (_hasSound) {
 		// Create the source
 		alGenSources(1, &channel.source);
 		if ((error = alGetError()) != AL_NO_ERROR)
@@ -381,7 +427,7 @@ ChannelHandle SoundManager::playSoundFile(Common::SeekableReadStream *wavStream,
 	if (!wavStream)
 		throw Common::Exception("No stream");
 
-	AudioStream *audioStream = makeAudioStream(wavStream);
+	AudioStream *audioStream = makeAudioStream(wavStream, _offline);
 
 	if (!audioStream)
 		throw Common::Exception("No audio stream");
@@ -549,8 +595,9 @@ uint64 SoundManager::getChannelSamplesPlayed(const ChannelHandle &handle) {
 	bufferData(*channel);
 
 	// The position within the currently playing buffer
-	ALint currentPosition;
-	alGetSourcei(channel->source, AL_BYTE_OFFSET, &currentPosition);
+	ALint currentPosition = 0;
+	if (_hasSound)
+		alGetSourcei(channel->source, AL_BYTE_OFFSET, &currentPosition);
 
 	// Total number of bytes processed
 	uint64 byteCount = channel->finishedBuffers + currentPosition;
@@ -586,7 +633,45 @@ void SoundManager::setTypeGain(SoundType type, float gain) {
 	}
 }
 
-bool SoundManager::fillBuffer(const Channel &channel, ALuint alBuffer,
+RenderStatistics SoundManager::renderChannel(ChannelHandle &handle, Common::WriteStream *output) {
+	std::lock_guard<std::recursive_mutex> lock(_mutex);
+
+	if (!_offline)
+		throw Common::Exception("SoundManager::renderChannel(): Not in offline mode");
+
+	Channel *channel = getChannel(handle);
+	if (!channel || !channel->stream)
+		throw Common::Exception("Invalid channel");
+
+	RenderStatistics stats;
+	stats.channels = channel->stream->getChannels();
+	stats.rate     = channel->stream->getRate();
+
+	channel->state         = AL_PLAYING;
+	channel->offlineOutput = output;
+
+	const uint64 startBytes = channel->finishedBuffers;
+	const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+	/* Each round "plays" all queued buffers and refills them. Once a round couldn't
+	 * queue anything new, all data the stream had available has been rendered. */
+	do {
+		bufferData(*channel);
+	} while (!channel->offlineQueue.empty());
+
+	const std::chrono::steady_clock::time_point endTime = std::chrono::steady_clock::now();
+
+	stats.bytes   = channel->finishedBuffers - startBytes;
+	stats.samples = (stats.channels > 0) ? (stats.bytes / stats.channels / 2) : 0;
+	stats.seconds = std::chrono::duration<double>(endTime - startTime).count();
+
+	channel->offlineOutput = 0;
+	freeChannel(handle);
+
+	return stats;
+}
+
+bool SoundManager::fillBuffer(Channel &channel, ALuint alBuffer,
                               AudioStream *stream, ALsizei &bufferedSize) const {
 
 	bufferedSize = 0;
@@ -594,7 +679,7 @@ bool SoundManager::fillBuffer(const Channel &channel, ALuint alBuffer,
 	if (!stream)
 		throw Common::Exception("No stream in %s", formatChannel(&channel).c_str());
 
-	if (!_hasSound)
+	if (!_hasSound && !_offline)
 		return true;
 
 	if (stream->endOfData())
@@ -608,7 +693,7 @@ bool SoundManager::fillBuffer(const Channel &channel, ALuint alBuffer,
 	} else if (channelCount == 2) {
 		format = AL_FORMAT_STEREO16;
 	} else if (channelCount == 6) {
-		if (!_hasMultiChannel) {
+		if (!_hasMultiChannel && !_offline) {
 			warning("SoundManager::fillBuffer(): TODO: !_hasMultiChannel in %s",
 			        formatChannel(&channel).c_str());
 			return false;
@@ -635,6 +720,12 @@ bool SoundManager::fillBuffer(const Channel &channel, ALuint alBuffer,
 	}
 
 	bufferedSize = numSamples * 2;
+
+	if (_offline) {
+		channel.offlineData[alBuffer].assign(buffer.get(), buffer.get() + bufferedSize);
+		return true;
+	}
+
 	alBufferData(alBuffer, format, buffer.get(), bufferedSize, stream->getRate());
 
 	ALenum error = alGetError();
@@ -657,9 +748,56 @@ void SoundManager::bufferData(Channel &channel) {
 	if (!channel.stream)
 		return;
 
-	if (!_hasSound)
+	if (!_hasSound && !_offline)
 		return;
 
+	unqueueBuffers(channel);
+
+	// Buffer as long as we still have data and free buffers
+	std::list<ALuint>::iterator buffer = channel.freeBuffers.begin();
+	while (buffer != channel.freeBuffers.end()) {
+		if (!fillBuffer(channel, *buffer, channel.stream.get(), channel.bufferSize[*buffer]))
+			break;
+
+		queueBuffer(channel, *buffer);
+
+		buffer = channel.freeBuffers.erase(buffer);
+	}
+}
+
+void SoundManager::queueBuffer(Channel &channel, ALuint alBuffer) {
+	if (_offline) {
+		channel.offlineQueue.push_back(alBuffer);
+		return;
+	}
+
+	alSourceQueueBuffers(channel.source, 1, &alBuffer);
+
+	ALenum error = alGetError();
+	if (error != AL_NO_ERROR)
+		throw Common::Exception("OpenAL error while queueing buffers in %s: 0x%X",
+		                        formatChannel(&channel).c_str(), error);
+}
+
+void SoundManager::unqueueBuffers(Channel &channel) {
+	if (_offline) {
+		// Offline, all queued buffers are "played" immediately, in order
+		for (std::list<ALuint>::iterator buffer = channel.offlineQueue.begin();
+		     buffer != channel.offlineQueue.end(); ++buffer) {
+
+			const std::vector<byte> &data = channel.offlineData[*buffer];
+			if (channel.offlineOutput && !data.empty())
+				channel.offlineOutput->write(&data[0], data.size());
+
+			channel.freeBuffers.push_back(*buffer);
+
+			channel.finishedBuffers += channel.bufferSize[*buffer];
+		}
+
+		channel.offlineQueue.clear();
+		return;
+	}
+
 	ALenum error = AL_NO_ERROR;
 
 	// Get the number of buffers that have been processed
@@ -688,20 +826,6 @@ void SoundManager::bufferData(Channel &channel) {
 
 		channel.finishedBuffers += channel.bufferSize[freeBuffers[i]];
 	}
-
-	// Buffer as long as we still have data and free buffers
-	std::list<ALuint>::iterator buffer = channel.freeBuffers.begin();
-	while (buffer != channel.freeBuffers.end()) {
-		if (!fillBuffer(channel, *buffer, channel.stream.get(), channel.bufferSize[*buffer]))
-			break;
-
-		alSourceQueueBuffers(channel.source, 1, &*buffer);
-		if ((error = alGetError()) != AL_NO_ERROR)
-			throw Common::Exception("OpenAL error while queueing buffers in %s: 0x%X",
-			                        formatChannel(&channel).c_str(), error);
-
-		buffer = channel.freeBuffers.erase(buffer);
-	}
 }
 
 void SoundManager::checkReady() {
@@ -37,6 +37,7 @@
 
 #include <list>
 #include <map>
+#include <vector>
 #include <memory>
 
 #include "src/common/types.h"
@@ -50,6 +51,7 @@
 
 namespace Common {
 	class SeekableReadStream;
+	class WriteStream;
 }
 
 namespace Sound {
@@ -64,12 +66,22 @@ public:
 
 	/** Initialize the sound subsystem. */
 	void init();
+	/** Initialize the sound subsystem for offline rendering.
+	 *
+	 *  No OpenAL device is opened and no update thread is started. Instead,
+	 *  channels are rendered at faster than real time with renderChannel(),
+	 *  through the same channel and buffer logic that feeds OpenAL.
+	 */
+	void initOffline();
 	/** Deinitialize the sound subsystem. */
 	void deinit();
 
 	/** Was the sound subsystem successfully initialized? */
 	bool ready() const;
 
+	/** Are we rendering offline instead of playing through OpenAL? */
+	bool isOffline() const;
+
 
 	/** Signal that one of streams currently being played has changed and should be updated immediately. */
 	void triggerUpdate();
@@ -131,6 +143,19 @@ public:
 	void stopChannel(ChannelHandle &handle);
 	// '---
 
+	// .--- Offline rendering
+	/** Render a channel as fast as possible, until its stream runs out of data.
+	 *
+	 *  Only available after initOffline(). The channel is started, rendered
+	 *  and then freed.
+	 *
+	 *  @param  handle The channel to render.
+	 *  @param  output If not 0, the rendered 16-bit PCM data is written into this stream.
+	 *  @return Statistics about the rendering, including its throughput.
+	 */
+	RenderStatistics renderChannel(ChannelHandle &handle, Common::WriteStream *output = 0);
+	// '---
+
 	// .--- Pausing/Stopping all channels
 	/** Pause all channels. */
 	void pauseAll(bool pause);
@@ -169,8 +194,11 @@ public:
 	 *
 	 *  The ownership of the data stream is transferred to the audio stream
 	 *  if one was created without an exception being thrown.
+	 *
+	 *  If offline is true, formats that support it are decoded completely
+	 *  up front, trading latency for using several threads.
 	 */
-	static AudioStream *makeAudioStream(Common::SeekableReadStream *stream);
+	static AudioStream *makeAudioStream(Common::SeekableReadStream *stream, bool offline = false);
 
 	/** Return a string representing the channel referenced by this handle. */
 	Common::UString formatChannel(const ChannelHandle &handle) const;
@@ -210,6 +238,13 @@ private:
 		/** Number of bytes in all buffers that finished playing and were unqueued. */
 		uint64 finishedBuffers;
 
+		/** Offline mode: list of buffers queued for rendering, in order. */
+		std::list<ALuint> offlineQueue;
+		/** Offline mode: the data of each buffer. */
+		std::map<ALuint, std::vector<byte>> offlineData;
+		/** Offline mode: stream the rendered data is written into. */
+		Common::WriteStream *offlineOutput;
+
 		float gain; ///< The channel's gain.
 
 		Channel(uint32 i, size_t idx, SoundType t, const TypeList::iterator &ti, AudioStream *s, bool d);
@@ -218,6 +253,7 @@ private:
 	bool _ready; ///< Was the sound subsystem successfully initialized?
 
 	bool _hasSound; ///< Do we have working sound output?
+	bool _offline;  ///< Are we rendering offline, without OpenAL?
 
 	bool _hasMultiChannel; ///< Do we have the multi-channel extension?
 	ALenum _format51; ///< The value for the 5.1 multi-channel format.
@@ -271,9 +307,14 @@ private:
 	void threadMethod();
 
 	/** Fill the buffer with data from the audio stream. */
-	bool fillBuffer(const Channel &channel, ALuint alBuffer,
+	bool fillBuffer(Channel &channel, ALuint alBuffer,
 	                AudioStream *stream, ALsizei &bufferedSize) const;
 
+	/** Queue a filled buffer for playback. */
+	void queueBuffer(Channel &channel, ALuint alBuffer);
+	/** Unqueue all buffers that finished playing, returning them to the free list. */
+	void unqueueBuffers(Channel &channel);
+
 	/** Return a string representing this channel. */
 	Common::UString formatChannel(const Channel *channel) const;
 };
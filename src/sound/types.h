@@ -50,6 +50,27 @@ enum SoundType {
 	kSoundTypeMAX
 };
 
+/** Statistics about rendering a sound channel offline. */
+struct RenderStatistics {
+	int channels;   ///< The number of audio channels of the rendered stream.
+	int rate;       ///< The sample rate of the rendered stream.
+	uint64 samples; ///< The number of samples per audio channel rendered.
+	uint64 bytes;   ///< The number of bytes of 16-bit PCM data rendered.
+	double seconds; ///< The wall-clock time the rendering took.
+
+	RenderStatistics() : channels(0), rate(0), samples(0), bytes(0), seconds(0.0) { }
+
+	/** Return the rendering throughput in samples per audio channel per second. */
+	double getSamplesPerSecond() const {
+		return (seconds > 0.0) ? (samples / seconds) : 0.0;
+	}
+
+	/** Return how many times faster than real time the rendering was. */
+	double getRealTimeFactor() const {
+		return (rate > 0) ? (getSamplesPerSecond() / rate) : 0.0;
+	}
+};
+
 } // End of namespace Sound
 
 #endif // SOUND_TYPES_H
@@ -0,0 +1,123 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for our cache of archive members.
+ */
+
+#include <cstring>
+
+#include <memory>
+
+#include "gtest/gtest.h"
+
+#include "src/common/util.h"
+#include "src/common/memreadstream.h"
+
+#include "src/aurora/archive.h"
+#include "src/aurora/archivecache.h"
+
+static const char *kFileData[2] = { "Ozymandias", "The Masque of Anarchy" };
+
+/** An archive with compressed resources, always returning copies. */
+class TestArchive : public Aurora::Archive {
+public:
+	mutable size_t _readCount { 0 };
+
+	const ResourceList &getResources() const {
+		return _resources;
+	}
+
+	Common::SeekableReadStream *getResource(uint32 index, bool UNUSED(tryNoCopy) = false) const {
+		_readCount++;
+
+		return new Common::MemoryReadStream(reinterpret_cast<const byte *>(kFileData[index]), strlen(kFileData[index]));
+	}
+
+private:
+	ResourceList _resources;
+};
+
+static void checkStream(Common::SeekableReadStream &stream, const char *data) {
+	ASSERT_EQ(stream.size(), strlen(data));
+
+	for (size_t i = 0; i < strlen(data); i++)
+		EXPECT_EQ(stream.readByte(), data[i]) << "At index " << i;
+
+	byte end;
+	EXPECT_EQ(stream.read(&end, 1), 0);
+	EXPECT_TRUE(stream.eos());
+}
+
+GTEST_TEST(ArchiveCache, sharedData) {
+	TestArchive archive;
+	Aurora::ArchiveCache cache;
+
+	std::unique_ptr<Common::SeekableReadStream> stream1(cache.open(archive, 0));
+	std::unique_ptr<Common::SeekableReadStream> stream2(cache.open(archive, 0));
+
+	EXPECT_EQ(archive._readCount, 1);
+	EXPECT_EQ(cache.getSize(), strlen(kFileData[0]));
+
+	stream1->seek(4);
+	EXPECT_EQ(stream2->readByte(), kFileData[0][0]);
+	EXPECT_EQ(stream1->readByte(), kFileData[0][4]);
+
+	stream2->seek(0);
+	checkStream(*stream2, kFileData[0]);
+
+	EXPECT_EQ(archive._readCount, 1);
+}
+
+GTEST_TEST(ArchiveCache, evict) {
+	TestArchive archive;
+	Aurora::ArchiveCache cache(strlen(kFileData[1]));
+
+	std::unique_ptr<Common::SeekableReadStream> stream0(cache.open(archive, 0));
+	std::unique_ptr<Common::SeekableReadStream> stream1(cache.open(archive, 1));
+
+	EXPECT_EQ(archive._readCount, 2);
+	EXPECT_EQ(cache.getSize(), strlen(kFileData[1]));
+
+	checkStream(*stream1, kFileData[1]);
+	EXPECT_EQ(archive._readCount, 2);
+
+	// Member 0 was evicted and needs to be read again
+	checkStream(*stream0, kFileData[0]);
+	EXPECT_EQ(archive._readCount, 3);
+	EXPECT_EQ(cache.getSize(), strlen(kFileData[0]));
+}
+
+GTEST_TEST(ArchiveCache, remove) {
+	TestArchive archive1, archive2;
+	Aurora::ArchiveCache cache;
+
+	std::unique_ptr<Common::SeekableReadStream> stream1(cache.open(archive1, 0));
+	std::unique_ptr<Common::SeekableReadStream> stream2(cache.open(archive2, 1));
+
+	EXPECT_EQ(cache.getSize(), strlen(kFileData[0]) + strlen(kFileData[1]));
+
+	cache.remove(archive1);
+	EXPECT_EQ(cache.getSize(), strlen(kFileData[1]));
+
+	// The data of archive1 is read again on demand
+	checkStream(*stream1, kFileData[0]);
+	EXPECT_EQ(archive1._readCount, 2);
+}
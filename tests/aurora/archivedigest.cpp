@@ -0,0 +1,185 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for hashing and verifying archive resources with MD5.
+ */
+
+#include <cstring>
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "src/common/util.h"
+#include "src/common/error.h"
+#include "src/common/md5.h"
+#include "src/common/memreadstream.h"
+
+#include "src/aurora/archive.h"
+#include "src/aurora/archivedigest.h"
+
+static const char * const kResources[] = {
+	"I met a traveller from an antique land",
+	"Who said: Two vast and trunkless legs of stone",
+	"Stand in the desert. Near them, on the sand,",
+	"Half sunk, a shattered visage lies, whose frown,",
+	"And wrinkled lip, and sneer of cold command,",
+	0
+};
+
+static const uint32 kBrokenResource = ARRAYSIZE(kResources) - 1;
+static const uint32 kFailingResource = 2;
+
+/** A stream that fails to read halfway through, like a resource with broken compressed data. */
+class FailingReadStream : public Common::SeekableReadStream {
+public:
+	FailingReadStream(const char *data) : _stream(data) {
+	}
+
+	bool eos() const {
+		return _stream.eos();
+	}
+
+	size_t read(void *dataPtr, size_t dataSize) {
+		if ((pos() + dataSize) > (size() / 2))
+			throw Common::Exception(Common::kReadError);
+
+		return _stream.read(dataPtr, dataSize);
+	}
+
+	size_t pos() const {
+		return _stream.pos();
+	}
+
+	size_t size() const {
+		return _stream.size();
+	}
+
+	size_t seek(ptrdiff_t offset, Origin whence = kOriginBegin) {
+		return _stream.seek(offset, whence);
+	}
+
+private:
+	Common::MemoryReadStream _stream;
+};
+
+/** An archive of test resources. The null resource is broken and can't be read. */
+class TestArchive : public Aurora::Archive {
+public:
+	TestArchive() {
+		for (size_t i = 0; i < ARRAYSIZE(kResources); i++) {
+			_resources.push_back(Resource());
+
+			_resources.back().name  = Common::UString::format("line%u", (uint)i);
+			_resources.back().type  = Aurora::kFileTypeTXT;
+			_resources.back().index = i;
+		}
+	}
+
+	const ResourceList &getResources() const {
+		return _resources;
+	}
+
+	Common::SeekableReadStream *getResource(uint32 index, bool UNUSED(tryNoCopy) = false) const {
+		if (!kResources[index])
+			throw Common::Exception("Broken resource");
+
+		return new Common::MemoryReadStream(kResources[index]);
+	}
+
+	Common::SeekableReadStream *getResourceStream(uint32 index) const {
+		if (index == kFailingResource)
+			return new FailingReadStream(kResources[index]);
+
+		return getResource(index, true);
+	}
+
+private:
+	ResourceList _resources;
+};
+
+static void hashLine(uint32 index, std::vector<byte> &digest) {
+	Common::hashMD5(Common::UString(kResources[index]), digest);
+}
+
+GTEST_TEST(ArchiveDigest, hashIndices) {
+	TestArchive archive;
+
+	const std::vector<uint32> indices = { 3, kBrokenResource, 0 };
+
+	std::vector< std::vector<byte> > digests;
+	Aurora::hashMD5(archive, indices, digests);
+
+	ASSERT_EQ(digests.size(), 3);
+
+	std::vector<byte> expected;
+
+	hashLine(3, expected);
+	EXPECT_EQ(digests[0], expected);
+
+	EXPECT_TRUE(digests[1].empty());
+
+	hashLine(0, expected);
+	EXPECT_EQ(digests[2], expected);
+}
+
+GTEST_TEST(ArchiveDigest, hashAll) {
+	TestArchive archive;
+
+	Aurora::ResourceDigests digests;
+	Aurora::hashMD5(archive, digests);
+
+	ASSERT_EQ(digests.size(), ARRAYSIZE(kResources));
+
+	for (uint32 i = 0; i < kBrokenResource; i++) {
+		const Common::UString name = Common::UString::format("line%u.txt", (uint)i);
+		ASSERT_EQ(digests.count(name), 1) << "At index " << i;
+
+		// Failing halfway through doesn't keep the other resources from being hashed
+		std::vector<byte> expected;
+		if (i != kFailingResource)
+			hashLine(i, expected);
+
+		EXPECT_EQ(digests[name], expected) << "At index " << i;
+	}
+
+	EXPECT_TRUE(digests[Common::UString::format("line%u.txt", (uint)kBrokenResource)].empty());
+}
+
+GTEST_TEST(ArchiveDigest, verify) {
+	TestArchive archive;
+
+	Aurora::ResourceDigests digests;
+
+	hashLine(0, digests["line0.txt"]);
+	hashLine(1, digests["LINE1.TXT"]);
+	hashLine(1, digests["line2.txt"]);
+	hashLine(3, digests["line3.txt"]);
+	hashLine(0, digests[Common::UString::format("line%u.txt", (uint)kBrokenResource)]);
+	hashLine(0, digests["missing.txt"]);
+
+	const std::vector<Common::UString> mismatches = Aurora::verifyMD5(archive, digests);
+
+	ASSERT_EQ(mismatches.size(), 3);
+	EXPECT_STREQ(mismatches[0].c_str(), "line2.txt");
+	EXPECT_STREQ(mismatches[1].c_str(), Common::UString::format("line%u.txt", (uint)kBrokenResource).c_str());
+	EXPECT_STREQ(mismatches[2].c_str(), "missing.txt");
+}
@@ -0,0 +1,123 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for our bookkeeping of space within archives patched in place.
+ */
+
+#include "gtest/gtest.h"
+
+#include "src/common/error.h"
+
+#include "src/aurora/archivepatcher.h"
+
+GTEST_TEST(ArchiveSpace, use) {
+	Aurora::ArchiveSpace space;
+
+	EXPECT_EQ(space.getEnd(), 0);
+	EXPECT_EQ(space.getFreeSize(), 0);
+
+	space.use(0, 10);
+	space.use(20, 10);
+
+	EXPECT_EQ(space.getEnd(), 30);
+	EXPECT_EQ(space.getFreeSize(), 10);
+
+	// Overlapping areas
+	space.use(5, 20);
+
+	EXPECT_EQ(space.getEnd(), 30);
+	EXPECT_EQ(space.getFreeSize(), 0);
+}
+
+GTEST_TEST(ArchiveSpace, release) {
+	Aurora::ArchiveSpace space;
+
+	space.use( 0, 10);
+	space.use(10, 10);
+	space.use(20, 10);
+
+	space.release(10, 10);
+	EXPECT_EQ(space.getFreeSize(), 10);
+
+	// Neighbouring gaps merge into one
+	space.release(20, 10);
+	EXPECT_EQ(space.getFreeSize(), 20);
+
+	EXPECT_EQ(space.allocate(20), 10);
+	EXPECT_EQ(space.getFreeSize(), 0);
+
+	EXPECT_THROW(space.release(10, 5), Common::Exception);
+	EXPECT_THROW(space.release(40, 5), Common::Exception);
+}
+
+GTEST_TEST(ArchiveSpace, releaseShared) {
+	Aurora::ArchiveSpace space;
+
+	// The same area, used twice, and an area overlapping it
+	space.use(0, 10);
+	space.use(0, 10);
+	space.use(5, 10);
+
+	space.release(0, 10);
+	EXPECT_EQ(space.getFreeSize(), 0);
+
+	space.release(0, 10);
+	EXPECT_EQ(space.getFreeSize(), 5);
+
+	space.release(5, 10);
+	EXPECT_EQ(space.getFreeSize(), 15);
+}
+
+GTEST_TEST(ArchiveSpace, allocate) {
+	Aurora::ArchiveSpace space;
+
+	space.use( 0, 10);
+	space.use(20, 10); // Gap of 10 in front
+	space.use(35, 10); // Gap of 5 in front
+	space.use(60, 10); // Gap of 15 in front
+
+	EXPECT_EQ(space.getFreeSize(), 30);
+
+	// The smallest gap it fits into
+	EXPECT_EQ(space.allocate( 4), 30);
+	EXPECT_EQ(space.allocate( 8), 10);
+	EXPECT_EQ(space.allocate(12), 45);
+
+	// Doesn't fit anywhere
+	EXPECT_EQ(space.allocate(20), 70);
+	EXPECT_EQ(space.getEnd(), 90);
+
+	EXPECT_EQ(space.getFreeSize(), 6);
+}
+
+GTEST_TEST(ArchiveSpace, allocateEnd) {
+	Aurora::ArchiveSpace space;
+
+	space.use( 0, 10);
+	space.use(10, 10);
+
+	space.release(10, 10);
+
+	// The gap at the end grows to fit
+	EXPECT_EQ(space.allocate(15), 10);
+	EXPECT_EQ(space.getEnd(), 25);
+	EXPECT_EQ(space.getFreeSize(), 0);
+}
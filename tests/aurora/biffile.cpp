@@ -22,10 +22,15 @@
  *  Unit tests for our BIF file archive class.
  */
 
+#include <memory>
+#include <atomic>
+#include <vector>
+
 #include "gtest/gtest.h"
 
 #include "src/common/error.h"
 #include "src/common/memreadstream.h"
+#include "src/common/thread.h"
 
 #include "src/aurora/biffile.h"
 #include "src/aurora/keyfile.h"
@@ -158,6 +163,117 @@ GTEST_TEST(BIFFile10, mergeKEY) {
 	delete bif;
 }
 
+GTEST_TEST(BIFFile10, mergeKEYOnDemand) {
+	Aurora::KEYFile key(new Common::MemoryReadStream(kKEYFile));
+
+	size_t opened = 0;
+	key.addDataFile(0, [&opened]() {
+		opened++;
+		return new Aurora::BIFFile(new Common::MemoryReadStream(kBIF10File));
+	});
+
+	EXPECT_TRUE(key.haveDataFile(0));
+	EXPECT_EQ(opened, 0);
+
+	EXPECT_EQ(key.getResourceSize(0), strlen(kFileData));
+	EXPECT_EQ(opened, 1);
+
+	std::unique_ptr<Common::SeekableReadStream> file(key.getResource(0));
+	ASSERT_EQ(file->size(), strlen(kFileData));
+
+	for (size_t i = 0; i < strlen(kFileData); i++)
+		EXPECT_EQ(file->readByte(), kFileData[i]) << "At index " << i;
+
+	EXPECT_EQ(opened, 1);
+}
+
+/** A BIF file counting its destruction. */
+class CountedBIFFile : public Aurora::BIFFile {
+public:
+	CountedBIFFile(std::atomic<size_t> &destroyed) :
+		Aurora::BIFFile(new Common::MemoryReadStream(kBIF10File)), _destroyed(&destroyed) {
+	}
+
+	~CountedBIFFile() {
+		(*_destroyed)++;
+	}
+
+private:
+	std::atomic<size_t> *_destroyed;
+};
+
+GTEST_TEST(BIFFile10, mergeKEYOnDemandClosed) {
+	Aurora::KEYFile key(new Common::MemoryReadStream(kKEYFile));
+
+	std::atomic<size_t> destroyed(0);
+	key.addDataFile(0, [&destroyed]() { return new CountedBIFFile(destroyed); });
+
+	std::unique_ptr<Common::SeekableReadStream> file(key.getResource(0, true));
+	ASSERT_EQ(file->size(), strlen(kFileData));
+
+	// Replacing the data file closes the one we opened, but the stream still reads from it
+	key.addDataFile(0, [&destroyed]() { return new CountedBIFFile(destroyed); });
+	EXPECT_EQ(destroyed, 0);
+
+	for (size_t i = 0; i < strlen(kFileData); i++)
+		EXPECT_EQ(file->readByte(), kFileData[i]) << "At index " << i;
+
+	file.reset();
+	EXPECT_EQ(destroyed, 1);
+}
+
+GTEST_TEST(BIFFile10, mergeKEYOnDemandResourceStream) {
+	Aurora::KEYFile key(new Common::MemoryReadStream(kKEYFile));
+
+	std::atomic<size_t> destroyed(0);
+	key.addDataFile(0, [&destroyed]() { return new CountedBIFFile(destroyed); });
+
+	std::unique_ptr<Common::SeekableReadStream> file(key.getResourceStream(0));
+	ASSERT_EQ(file->size(), strlen(kFileData));
+
+	// Like a view, a stream for sequential reading keeps a closed data file alive
+	key.addDataFile(0, [&destroyed]() { return new CountedBIFFile(destroyed); });
+	EXPECT_EQ(destroyed, 0);
+
+	for (size_t i = 0; i < strlen(kFileData); i++)
+		EXPECT_EQ(file->readByte(), kFileData[i]) << "At index " << i;
+
+	file.reset();
+	EXPECT_EQ(destroyed, 1);
+}
+
+GTEST_TEST(BIFFile10, mergeKEYOnDemandThreads) {
+	Aurora::KEYFile key(new Common::MemoryReadStream(kKEYFile));
+
+	std::atomic<size_t> destroyed(0);
+	const Aurora::KEYFile::DataFileOpener opener = [&destroyed]() { return new CountedBIFFile(destroyed); };
+
+	key.addDataFile(0, opener);
+
+	std::atomic<size_t> failures(0);
+
+	std::vector<std::thread> threads;
+	for (size_t i = 0; i < 4; i++) {
+		threads.emplace_back([&key, &failures]() {
+			for (size_t j = 0; j < 200; j++) {
+				std::unique_ptr<Common::SeekableReadStream> file(key.getResource(0));
+
+				if ((file->size() != strlen(kFileData)) || (file->readByte() != kFileData[0]))
+					failures++;
+			}
+		});
+	}
+
+	// Keep closing the data file the other threads read from
+	for (size_t i = 0; i < 200; i++)
+		key.addDataFile(0, opener);
+
+	for (std::vector<std::thread>::iterator t = threads.begin(); t != threads.end(); ++t)
+		t->join();
+
+	EXPECT_EQ(failures, 0);
+}
+
 // --- BIF V1.1 ---
 
 // Percy Bysshe Shelley's "Ozymandias", within a BIF V1.1 file
@@ -130,6 +130,44 @@ GTEST_TEST(BZFFile, getResource) {
 	delete file;
 }
 
+GTEST_TEST(BZFFile, getResourceNoCopy) {
+	Common::MemoryReadStream *stream =
+		new Common::MemoryReadStream(kBZFFile);
+
+	const Aurora::BZFFile bzf(stream);
+
+	// Still decompressed whole, so that it can be read in any order
+	Common::SeekableReadStream *file = bzf.getResource(0, true);
+	ASSERT_NE(dynamic_cast<Common::MemoryReadStream *>(file), static_cast<Common::MemoryReadStream *>(0));
+
+	ASSERT_EQ(file->size(), strlen(kFileData));
+
+	file->seek(strlen(kFileData) - 2);
+	EXPECT_EQ(file->readByte(), kFileData[strlen(kFileData) - 2]);
+
+	file->seek(0);
+	EXPECT_EQ(file->readByte(), kFileData[0]);
+
+	delete file;
+}
+
+GTEST_TEST(BZFFile, getResourceStream) {
+	Common::MemoryReadStream *stream =
+		new Common::MemoryReadStream(kBZFFile);
+
+	const Aurora::BZFFile bzf(stream);
+
+	Common::SeekableReadStream *file = bzf.getResourceStream(0);
+	ASSERT_NE(file, static_cast<Common::SeekableReadStream *>(0));
+
+	ASSERT_EQ(file->size(), strlen(kFileData));
+
+	for (size_t i = 0; i < strlen(kFileData); i++)
+		EXPECT_EQ(file->readByte(), kFileData[i]) << "At index " << i;
+
+	delete file;
+}
+
 GTEST_TEST(BZFFile, mergeKEY) {
 	Aurora::KEYFile key(new Common::MemoryReadStream(kKEYFile));
 
@@ -143,3 +181,23 @@ GTEST_TEST(BZFFile, mergeKEY) {
 
 	delete bzf;
 }
+
+GTEST_TEST(BZFFile, mergeKEYResourceStream) {
+	Aurora::KEYFile key(new Common::MemoryReadStream(kKEYFile));
+
+	Aurora::BZFFile *bzf =
+		new Aurora::BZFFile(new Common::MemoryReadStream(kBZFFile));
+
+	key.addDataFile(0, bzf);
+
+	Common::SeekableReadStream *file = key.getResourceStream(0);
+	ASSERT_NE(file, static_cast<Common::SeekableReadStream *>(0));
+
+	ASSERT_EQ(file->size(), strlen(kFileData));
+
+	for (size_t i = 0; i < strlen(kFileData); i++)
+		EXPECT_EQ(file->readByte(), kFileData[i]) << "At index " << i;
+
+	delete file;
+	delete bzf;
+}
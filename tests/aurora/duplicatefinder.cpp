@@ -0,0 +1,161 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for our duplicate resource finder.
+ */
+
+#include <cstring>
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "src/common/util.h"
+#include "src/common/memreadstream.h"
+#include "src/common/memwritestream.h"
+
+#include "src/aurora/archive.h"
+#include "src/aurora/duplicatefinder.h"
+
+struct TestResource {
+	const char *name;
+	Aurora::FileType type;
+	const char *data;
+};
+
+static const TestResource kBaseResources[] = {
+	{ "ozymandias", Aurora::kFileTypeTXT, "same data" },
+	{ "traveller" , Aurora::kFileTypeTXT, "other"     },
+	{ "antique"   , Aurora::kFileTypeTGA, "same data" },
+	{ "land"      , Aurora::kFileTypeTGA, ""          },
+	{ "sand"      , Aurora::kFileTypeTGA, ""          }
+};
+
+static const TestResource kOverrideResources[] = {
+	{ "ozymandias", Aurora::kFileTypeTXT, "different" },
+	{ "traveller" , Aurora::kFileTypeTXT, "other"     }
+};
+
+/** An archive holding a list of test resources. */
+class TestArchive : public Aurora::Archive {
+public:
+	TestArchive(const TestResource *resources, size_t count) : _data(resources) {
+		for (size_t i = 0; i < count; i++) {
+			_resources.push_back(Resource());
+
+			_resources.back().name  = resources[i].name;
+			_resources.back().type  = resources[i].type;
+			_resources.back().index = i;
+		}
+	}
+
+	const ResourceList &getResources() const {
+		return _resources;
+	}
+
+	uint32 getResourceSize(uint32 index) const {
+		return strlen(_data[index].data);
+	}
+
+	Common::SeekableReadStream *getResource(uint32 index, bool UNUSED(tryNoCopy) = false) const {
+		return new Common::MemoryReadStream(reinterpret_cast<const byte *>(_data[index].data),
+		                                    strlen(_data[index].data));
+	}
+
+private:
+	const TestResource *_data;
+
+	ResourceList _resources;
+};
+
+GTEST_TEST(DuplicateFinder, findDuplicates) {
+	TestArchive base(kBaseResources, ARRAYSIZE(kBaseResources));
+	TestArchive override(kOverrideResources, ARRAYSIZE(kOverrideResources));
+
+	Aurora::DuplicateFinder finder;
+	finder.addSource("base.erf", base);
+	finder.addSource("override", override);
+
+	finder.find(true, 2);
+
+	const std::vector<Aurora::DuplicateFinder::DuplicateGroup> &duplicates = finder.getDuplicates();
+	ASSERT_EQ(duplicates.size(), 2);
+
+	EXPECT_EQ(duplicates[0].size, 5);
+	ASSERT_EQ(duplicates[0].copies.size(), 2);
+	EXPECT_EQ(duplicates[0].copies[0].source, 0);
+	EXPECT_STREQ(duplicates[0].copies[0].name.c_str(), "traveller.txt");
+	EXPECT_EQ(duplicates[0].copies[1].source, 1);
+	EXPECT_STREQ(duplicates[0].copies[1].name.c_str(), "traveller.txt");
+
+	EXPECT_EQ(duplicates[1].size, 9);
+	ASSERT_EQ(duplicates[1].copies.size(), 2);
+	EXPECT_EQ(duplicates[1].copies[0].source, 0);
+	EXPECT_EQ(duplicates[1].copies[1].source, 0);
+	EXPECT_NE(duplicates[1].copies[0].index, duplicates[1].copies[1].index);
+}
+
+GTEST_TEST(DuplicateFinder, findShadowed) {
+	TestArchive base(kBaseResources, ARRAYSIZE(kBaseResources));
+	TestArchive override(kOverrideResources, ARRAYSIZE(kOverrideResources));
+
+	Aurora::DuplicateFinder finder;
+	finder.addSource("base.erf", base);
+	finder.addSource("override", override);
+
+	finder.find();
+
+	const std::vector<Aurora::DuplicateFinder::ShadowGroup> &shadowed = finder.getShadowed();
+	ASSERT_EQ(shadowed.size(), 2);
+
+	ASSERT_EQ(shadowed[0].versions.size(), 2);
+	EXPECT_STREQ(shadowed[0].versions[0].name.c_str(), "ozymandias.txt");
+	EXPECT_EQ(shadowed[0].versions[0].source, 0);
+	EXPECT_EQ(shadowed[0].versions[1].source, 1);
+	EXPECT_FALSE(shadowed[0].identical[0]);
+	EXPECT_TRUE(shadowed[0].identical[1]);
+
+	ASSERT_EQ(shadowed[1].versions.size(), 2);
+	EXPECT_STREQ(shadowed[1].versions[0].name.c_str(), "traveller.txt");
+	EXPECT_TRUE(shadowed[1].identical[0]);
+	EXPECT_TRUE(shadowed[1].identical[1]);
+}
+
+GTEST_TEST(DuplicateFinder, writeReport) {
+	TestArchive base(kBaseResources, ARRAYSIZE(kBaseResources));
+	TestArchive override(kOverrideResources, ARRAYSIZE(kOverrideResources));
+
+	Aurora::DuplicateFinder finder;
+	finder.addSource("base.erf", base);
+	finder.addSource("override", override);
+
+	finder.find();
+
+	Common::MemoryWriteStreamDynamic report(true);
+	finder.writeReport(report);
+
+	const Common::UString text(reinterpret_cast<const char *>(report.getData()), report.size());
+
+	EXPECT_TRUE(text.contains("2 groups of identical resources"));
+	EXPECT_TRUE(text.contains("override (used)"));
+	EXPECT_TRUE(text.contains("base.erf (shadowed, different)"));
+	EXPECT_TRUE(text.contains("base.erf (shadowed, identical)"));
+}
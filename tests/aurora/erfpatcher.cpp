@@ -0,0 +1,264 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for patching ERF archives in place.
+ */
+
+#include <cstring>
+
+#include <memory>
+
+#include "gtest/gtest.h"
+
+#include "src/common/error.h"
+#include "src/common/strutil.h"
+#include "src/common/memreadstream.h"
+#include "src/common/memwritestream.h"
+#include "src/common/readwritestream.h"
+
+#include "src/aurora/erffile.h"
+#include "src/aurora/erfwriter.h"
+#include "src/aurora/erfpatcher.h"
+
+// Percy Bysshe Shelley's "Ozymandias"
+static const char *kFileData =
+	"I met a traveller from an antique land\n"
+	"Who said: Two vast and trunkless legs of stone\n"
+	"Stand in the desert. Near them, on the sand,\n"
+	"Half sunk, a shattered visage lies, whose frown,\n"
+	"And wrinkled lip, and sneer of cold command,\n"
+	"Tell that its sculptor well those passions read\n"
+	"Which yet survive, stamped on these lifeless things,\n"
+	"The hand that mocked them and the heart that fed:\n"
+	"And on the pedestal these words appear:\n"
+	"'My name is Ozymandias, king of kings:\n"
+	"Look on my works, ye Mighty, and despair!'\n"
+	"Nothing beside remains. Round the decay\n"
+	"Of that colossal wreck, boundless and bare\n"
+	"The lone and level sands stretch far away.";
+
+static const size_t kResourceCount = 8;
+
+static Common::UString createString(size_t index, size_t repeat) {
+	Common::UString data = Common::composeString(index) + "\n";
+	for (size_t i = 0; i < repeat; i++)
+		data += kFileData;
+
+	return data;
+}
+
+static Common::SeekableReadStream *createData(const Common::UString &data) {
+	byte *buffer = new byte[data.size()];
+	std::memcpy(buffer, data.c_str(), data.size());
+
+	return new Common::MemoryReadStream(buffer, data.size(), true);
+}
+
+static Common::UString createName(size_t index) {
+	return Common::UString::format("ozymandias%u", (uint)index);
+}
+
+/** Write an ERF with kResourceCount resources into a stream we can patch. */
+static Common::MemoryReadWriteStream *createERF(Aurora::ERFWriter::Version version,
+                                                Aurora::ERFWriter::Compression compression) {
+
+	Aurora::ERFWriter writer(version, MKTAG('E', 'R', 'F', ' '), compression);
+	for (size_t i = 0; i < kResourceCount; i++)
+		writer.add(createName(i), Aurora::kFileTypeTXT, createData(createString(i, 1 + (i % 2))));
+
+	Common::MemoryWriteStreamDynamic output(true);
+	writer.write(output, 1);
+
+	return new Common::MemoryReadWriteStream(output.getData(), output.size());
+}
+
+/** Make sure the ERF within the stream contains exactly these resources. */
+static void checkERF(const Common::MemoryReadWriteStream &stream, const std::vector<Common::UString> &names,
+                     const std::vector<Common::UString> &contents) {
+
+	const Aurora::ERFFile erf(new Common::MemoryReadStream(stream.getData(), stream.size()));
+
+	const Aurora::ERFFile::ResourceList &resources = erf.getResources();
+	ASSERT_EQ(resources.size(), names.size());
+
+	size_t index = 0;
+	for (Aurora::ERFFile::ResourceList::const_iterator r = resources.begin(); r != resources.end(); ++r, ++index) {
+		EXPECT_STREQ(r->name.c_str(), names[index].c_str());
+		EXPECT_EQ(r->type, Aurora::kFileTypeTXT);
+		EXPECT_EQ(r->index, index);
+
+		std::unique_ptr<Common::SeekableReadStream> file(erf.getResource(index));
+		ASSERT_EQ(file->size(), contents[index].size()) << "At resource " << index;
+
+		std::vector<byte> data(file->size());
+		ASSERT_EQ(file->read(&data[0], data.size()), data.size());
+
+		EXPECT_EQ(std::memcmp(&data[0], contents[index].c_str(), data.size()), 0) << "At resource " << index;
+	}
+}
+
+static void createContents(std::vector<Common::UString> &names, std::vector<Common::UString> &contents) {
+	for (size_t i = 0; i < kResourceCount; i++) {
+		names.push_back(createName(i));
+		contents.push_back(createString(i, 1 + (i % 2)));
+	}
+}
+
+static void testPatch(Aurora::ERFWriter::Version version, Aurora::ERFWriter::Compression compression) {
+	Common::MemoryReadWriteStream *stream = createERF(version, compression);
+	Aurora::ERFPatcher erf(stream);
+
+	std::vector<Common::UString> names, contents;
+	createContents(names, contents);
+
+	ASSERT_EQ(erf.getResourceCount(), kResourceCount);
+	EXPECT_EQ(erf.getFreeSize(), 0);
+
+	EXPECT_EQ(erf.findResource(createName(3), Aurora::kFileTypeTXT), 3);
+	EXPECT_EQ(erf.findResource(createName(3), Aurora::kFileTypeBMP), 0xFFFFFFFF);
+
+	// Replacing a resource with larger data appends it
+	contents[3] = createString(3, 3);
+
+	std::unique_ptr<Common::SeekableReadStream> data(createData(contents[3]));
+	erf.replace(3, *data);
+	erf.flush();
+
+	checkERF(*stream, names, contents);
+
+	// The old data of that resource is now unused, and smaller data fits in there
+	const size_t size = erf.getSize();
+	EXPECT_GT(erf.getFreeSize(), 0);
+
+	contents[5] = createString(5, 0);
+
+	data.reset(createData(contents[5]));
+	erf.replace(5, *data);
+	erf.flush();
+
+	EXPECT_EQ(erf.getSize(), size);
+
+	checkERF(*stream, names, contents);
+
+	// Adding a resource makes the tables grow
+	names.push_back("newresource");
+	contents.push_back(createString(kResourceCount, 2));
+
+	data.reset(createData(contents.back()));
+	EXPECT_EQ(erf.add(names.back(), Aurora::kFileTypeTXT, *data), kResourceCount);
+	erf.flush();
+
+	EXPECT_EQ(erf.getResourceCount(), kResourceCount + 1);
+	EXPECT_EQ(erf.findResource("newresource", Aurora::kFileTypeTXT), kResourceCount);
+
+	checkERF(*stream, names, contents);
+
+	erf.remove(1);
+	erf.flush();
+
+	names.erase(names.begin() + 1);
+	contents.erase(contents.begin() + 1);
+
+	EXPECT_EQ(erf.findResource("newresource", Aurora::kFileTypeTXT), kResourceCount - 1);
+
+	checkERF(*stream, names, contents);
+
+	// Compacting gets rid of all unused gaps
+	EXPECT_GT(erf.getFragmentation(), 0.0);
+
+	erf.compact();
+
+	EXPECT_EQ(erf.getFreeSize(), 0);
+	EXPECT_EQ(erf.getFragmentation(), 0.0);
+	EXPECT_LT(erf.getSize(), size);
+
+	checkERF(*stream, names, contents);
+
+	EXPECT_FALSE(erf.compact(0.5));
+
+	// And the patcher still works on the compacted ERF
+	contents[0] = createString(0, 2);
+
+	data.reset(createData(contents[0]));
+	erf.replace(0, *data);
+	erf.flush();
+
+	checkERF(*stream, names, contents);
+}
+
+GTEST_TEST(ERFPatcher, patch10) {
+	testPatch(Aurora::ERFWriter::kVersion10, Aurora::ERFWriter::kCompressionNone);
+}
+
+GTEST_TEST(ERFPatcher, patch20) {
+	testPatch(Aurora::ERFWriter::kVersion20, Aurora::ERFWriter::kCompressionNone);
+}
+
+GTEST_TEST(ERFPatcher, patch22) {
+	testPatch(Aurora::ERFWriter::kVersion22, Aurora::ERFWriter::kCompressionNone);
+}
+
+GTEST_TEST(ERFPatcher, patch22BioWareZlib) {
+	testPatch(Aurora::ERFWriter::kVersion22, Aurora::ERFWriter::kCompressionBioWareZlib);
+}
+
+GTEST_TEST(ERFPatcher, patch30) {
+	testPatch(Aurora::ERFWriter::kVersion30, Aurora::ERFWriter::kCompressionNone);
+}
+
+GTEST_TEST(ERFPatcher, patch30HeaderlessZlib) {
+	testPatch(Aurora::ERFWriter::kVersion30, Aurora::ERFWriter::kCompressionHeaderlessZlib);
+}
+
+GTEST_TEST(ERFPatcher, keepUnchanged) {
+	Common::MemoryReadWriteStream *stream = createERF(Aurora::ERFWriter::kVersion10,
+	                                                  Aurora::ERFWriter::kCompressionNone);
+
+	const std::vector<byte> original(stream->getData(), stream->getData() + stream->size());
+
+	Aurora::ERFPatcher erf(stream);
+
+	const Common::UString replacement = createString(2, 3);
+
+	std::unique_ptr<Common::SeekableReadStream> data(createData(replacement));
+	erf.replace(2, *data);
+
+	// Nothing is touched before flushing, except for the appended data
+	ASSERT_EQ(stream->size(), original.size() + replacement.size());
+	EXPECT_EQ(std::memcmp(stream->getData(), &original[0], original.size()), 0);
+
+	erf.flush();
+
+	// Flushing only rewrites the resource list, everything in front of it stays the same
+	const Aurora::ERFFile erfFile(new Common::MemoryReadStream(stream->getData(), stream->size()));
+	const size_t offResList = READ_LE_UINT32(&original[0x1C]);
+
+	EXPECT_EQ(std::memcmp(stream->getData(), &original[0], offResList), 0);
+	EXPECT_EQ(erfFile.getResourceSize(2), replacement.size());
+}
+
+GTEST_TEST(ERFPatcher, notERF) {
+	EXPECT_THROW(Aurora::ERFPatcher erf(new Common::MemoryReadWriteStream()), Common::Exception);
+
+	static const byte kData[] = { 'N', 'O', 'P', 'E', 'V', '1', '.', '0' };
+	EXPECT_THROW(Aurora::ERFPatcher erf(new Common::MemoryReadWriteStream(kData, sizeof(kData))),
+	             Common::Exception);
+}
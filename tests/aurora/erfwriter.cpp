@@ -0,0 +1,245 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for our ERF file archive writer.
+ */
+
+#include <cstring>
+
+#include <memory>
+
+#include "gtest/gtest.h"
+
+#include "src/common/error.h"
+#include "src/common/hash.h"
+#include "src/common/strutil.h"
+#include "src/common/memreadstream.h"
+#include "src/common/memwritestream.h"
+#include "src/common/deflate.h"
+
+#include "src/aurora/locstring.h"
+#include "src/aurora/language.h"
+#include "src/aurora/erffile.h"
+#include "src/aurora/erfwriter.h"
+
+// Percy Bysshe Shelley's "Ozymandias"
+static const char *kFileData =
+	"I met a traveller from an antique land\n"
+	"Who said: Two vast and trunkless legs of stone\n"
+	"Stand in the desert. Near them, on the sand,\n"
+	"Half sunk, a shattered visage lies, whose frown,\n"
+	"And wrinkled lip, and sneer of cold command,\n"
+	"Tell that its sculptor well those passions read\n"
+	"Which yet survive, stamped on these lifeless things,\n"
+	"The hand that mocked them and the heart that fed:\n"
+	"And on the pedestal these words appear:\n"
+	"'My name is Ozymandias, king of kings:\n"
+	"Look on my works, ye Mighty, and despair!'\n"
+	"Nothing beside remains. Round the decay\n"
+	"Of that colossal wreck, boundless and bare\n"
+	"The lone and level sands stretch far away.";
+
+static const size_t kResourceCount = 20;
+
+static Common::SeekableReadStream *createData(size_t index) {
+	// Make every resource a bit different, and some of them a bit larger
+	Common::UString data = Common::composeString(index) + "\n";
+	for (size_t i = 0; i <= (index % 4); i++)
+		data += kFileData;
+
+	byte *buffer = new byte[data.size()];
+	std::memcpy(buffer, data.c_str(), data.size());
+
+	return new Common::MemoryReadStream(buffer, data.size(), true);
+}
+
+static Common::UString createName(size_t index) {
+	return Common::UString::format("ozymandias%u", (uint)index);
+}
+
+static Aurora::FileType createType(size_t index) {
+	// Sprinkle in a few resources of an already compressed type
+	return ((index % 5) == 0) ? Aurora::kFileTypeOGG : Aurora::kFileTypeTXT;
+}
+
+static void testRoundTrip(Aurora::ERFWriter::Version version, Aurora::ERFWriter::Compression compression,
+                          size_t threadCount = 4) {
+
+	Aurora::ERFWriter writer(version, MKTAG('E', 'R', 'F', ' '), compression);
+	writer.setBuildDate(2016, 42);
+
+	for (size_t i = 0; i < kResourceCount; i++)
+		writer.add(createName(i), createType(i), createData(i));
+
+	ASSERT_EQ(writer.getResourceCount(), kResourceCount);
+
+	Common::MemoryWriteStreamDynamic output(true);
+	writer.write(output, threadCount);
+
+	EXPECT_EQ(writer.getResourceCount(), 0);
+
+	const Aurora::ERFFile erf(new Common::MemoryReadStream(output.getData(), output.size()));
+
+	if (version != Aurora::ERFWriter::kVersion30) {
+		EXPECT_EQ(erf.getBuildYear(), 2016);
+		EXPECT_EQ(erf.getBuildDay(), 42);
+	}
+
+	const Aurora::ERFFile::ResourceList &resources = erf.getResources();
+	ASSERT_EQ(resources.size(), kResourceCount);
+
+	size_t index = 0;
+	for (Aurora::ERFFile::ResourceList::const_iterator r = resources.begin(); r != resources.end(); ++r, ++index) {
+		EXPECT_STREQ(r->name.c_str(), createName(index).c_str());
+		EXPECT_EQ(r->type, createType(index));
+		EXPECT_EQ(r->index, index);
+
+		std::unique_ptr<Common::SeekableReadStream> expected(createData(index));
+		std::unique_ptr<Common::SeekableReadStream> file(erf.getResource(index));
+
+		ASSERT_EQ(erf.getResourceSize(index), expected->size()) << "At resource " << index;
+		ASSERT_EQ(file->size(), expected->size()) << "At resource " << index;
+
+		for (size_t i = 0; i < expected->size(); i++)
+			ASSERT_EQ(file->readByte(), expected->readByte()) << "At resource " << index << ", index " << i;
+	}
+}
+
+GTEST_TEST(ERFWriter, roundTrip10) {
+	testRoundTrip(Aurora::ERFWriter::kVersion10, Aurora::ERFWriter::kCompressionNone);
+}
+
+GTEST_TEST(ERFWriter, roundTrip20) {
+	testRoundTrip(Aurora::ERFWriter::kVersion20, Aurora::ERFWriter::kCompressionNone);
+}
+
+GTEST_TEST(ERFWriter, roundTrip22) {
+	testRoundTrip(Aurora::ERFWriter::kVersion22, Aurora::ERFWriter::kCompressionNone);
+}
+
+GTEST_TEST(ERFWriter, roundTrip22BioWareZlib) {
+	testRoundTrip(Aurora::ERFWriter::kVersion22, Aurora::ERFWriter::kCompressionBioWareZlib);
+}
+
+GTEST_TEST(ERFWriter, roundTrip22HeaderlessZlib) {
+	testRoundTrip(Aurora::ERFWriter::kVersion22, Aurora::ERFWriter::kCompressionHeaderlessZlib);
+}
+
+GTEST_TEST(ERFWriter, roundTrip22SingleThread) {
+	testRoundTrip(Aurora::ERFWriter::kVersion22, Aurora::ERFWriter::kCompressionBioWareZlib, 1);
+}
+
+GTEST_TEST(ERFWriter, roundTrip30) {
+	testRoundTrip(Aurora::ERFWriter::kVersion30, Aurora::ERFWriter::kCompressionNone);
+}
+
+GTEST_TEST(ERFWriter, roundTrip30BioWareZlib) {
+	testRoundTrip(Aurora::ERFWriter::kVersion30, Aurora::ERFWriter::kCompressionBioWareZlib);
+}
+
+GTEST_TEST(ERFWriter, roundTrip30HeaderlessZlib) {
+	testRoundTrip(Aurora::ERFWriter::kVersion30, Aurora::ERFWriter::kCompressionHeaderlessZlib);
+}
+
+GTEST_TEST(ERFWriter, description10) {
+	LangMan.addLanguage(Aurora::kLanguageEnglish, 0, Common::kEncodingUTF8);
+
+	Aurora::LocString description;
+	description.setID(0);
+	description.setString(Aurora::kLanguageEnglish, Aurora::kLanguageGenderMale, "xoreos unit test");
+
+	Aurora::ERFWriter writer(Aurora::ERFWriter::kVersion10);
+	writer.setBuildDate(2000, 23);
+	writer.setDescription(description);
+
+	writer.add("ozymandias", Aurora::kFileTypeTXT,
+	           new Common::MemoryReadStream(reinterpret_cast<const byte *>(kFileData), std::strlen(kFileData)));
+
+	Common::MemoryWriteStreamDynamic output(true);
+	writer.write(output);
+
+	// The header of this ERF is the same as the one of the ERF V1.0 in the ERFFile tests
+	const byte *data = output.getData();
+	ASSERT_EQ(output.size(), 0xD8 + std::strlen(kFileData));
+
+	EXPECT_EQ(std::memcmp(data, "ERF V1.0", 8), 0);
+
+	EXPECT_EQ(READ_LE_UINT32(data + 0x08), 1);    // Language count
+	EXPECT_EQ(READ_LE_UINT32(data + 0x0C), 0x18); // Description size
+	EXPECT_EQ(READ_LE_UINT32(data + 0x10), 1);    // Resource count
+	EXPECT_EQ(READ_LE_UINT32(data + 0x14), 0xA0); // Description offset
+	EXPECT_EQ(READ_LE_UINT32(data + 0x18), 0xB8); // Key list offset
+	EXPECT_EQ(READ_LE_UINT32(data + 0x1C), 0xD0); // Resource list offset
+	EXPECT_EQ(READ_LE_UINT32(data + 0x20), 100);  // Build year
+	EXPECT_EQ(READ_LE_UINT32(data + 0x24), 23);   // Build day
+	EXPECT_EQ(READ_LE_UINT32(data + 0x28), 0);    // Description StrRef
+
+	EXPECT_EQ(READ_LE_UINT32(data + 0xD0), 0xD8);
+	EXPECT_EQ(READ_LE_UINT32(data + 0xD4), std::strlen(kFileData));
+
+	const Aurora::ERFFile erf(new Common::MemoryReadStream(output.getData(), output.size()));
+
+	EXPECT_EQ(erf.getDescription().getID(), 0);
+	EXPECT_STREQ(erf.getDescription().getString().c_str(), "xoreos unit test");
+
+	Aurora::LanguageManager::destroy();
+}
+
+GTEST_TEST(ERFWriter, hashes30) {
+	Aurora::ERFWriter writer(Aurora::ERFWriter::kVersion30);
+
+	writer.add("ozymandias", Aurora::kFileTypeTXT,
+	           new Common::MemoryReadStream(reinterpret_cast<const byte *>(kFileData), std::strlen(kFileData)));
+
+	Common::MemoryWriteStreamDynamic output(true);
+	writer.write(output);
+
+	const byte *data = output.getData();
+
+	// String table, right after the header
+	EXPECT_EQ(READ_LE_UINT32(data + 0x10), 0x0F);
+	EXPECT_STREQ(reinterpret_cast<const char *>(data + 0x30), "ozymandias.txt");
+
+	// Name hash and type hash, the same as in the ERF V3.0 in the ERFFile tests
+	static const byte kHashes[] = { 0xEA,0x54,0xB9,0xC3,0xF9,0x70,0x3C,0x67, 0x5F,0xAB,0x6C,0x2B };
+	EXPECT_EQ(std::memcmp(data + 0x30 + 0x0F + 4, kHashes, sizeof(kHashes)), 0);
+
+	const Aurora::ERFFile erf(new Common::MemoryReadStream(output.getData(), output.size()));
+
+	EXPECT_EQ(erf.getNameHashAlgo(), Common::kHashFNV64);
+	ASSERT_EQ(erf.getResources().size(), 1);
+	EXPECT_EQ(erf.getResources().begin()->hash, Common::hashString("ozymandias.txt", Common::kHashFNV64));
+}
+
+GTEST_TEST(ERFWriter, limits) {
+	Aurora::ERFWriter writer10(Aurora::ERFWriter::kVersion10);
+	EXPECT_THROW(writer10.add("ozymandias_king_of_kings", Aurora::kFileTypeTXT,
+	             new Common::MemoryReadStream(reinterpret_cast<const byte *>(kFileData), 1)), Common::Exception);
+	EXPECT_EQ(writer10.getResourceCount(), 0);
+
+	Aurora::ERFWriter writer20(Aurora::ERFWriter::kVersion20);
+	EXPECT_THROW(writer20.add("ozymandias_king_of_kings_look_on_my_works", Aurora::kFileTypeTXT,
+	             new Common::MemoryReadStream(reinterpret_cast<const byte *>(kFileData), 1)), Common::Exception);
+	EXPECT_EQ(writer20.getResourceCount(), 0);
+
+	EXPECT_THROW(Aurora::ERFWriter(Aurora::ERFWriter::kVersion10, MKTAG('E', 'R', 'F', ' '),
+	                               Aurora::ERFWriter::kCompressionBioWareZlib), Common::Exception);
+}
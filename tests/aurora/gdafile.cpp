@@ -0,0 +1,341 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for our GDA file reader.
+ */
+
+#include <cstring>
+
+#include <memory>
+
+#include "gtest/gtest.h"
+
+#include "src/common/util.h"
+#include "src/common/error.h"
+#include "src/common/hash.h"
+#include "src/common/memreadstream.h"
+#include "src/common/memwritestream.h"
+
+#include "src/aurora/2dafile.h"
+#include "src/aurora/gdafile.h"
+#include "src/aurora/gdaheaders.h"
+#include "src/aurora/gff4fields.h"
+
+struct TestRow {
+	int32 id;
+	const char *name;
+	float value;
+	bool usable;
+};
+
+static const TestRow kRows1[] = {
+	{ 100, "Sword"  , 1.5f , true  },
+	{   5, "Axe"    , 2.0f , false },
+	{  42, "Mace"   , 0.5f , true  }
+};
+
+static const TestRow kRows2[] = {
+	{   7, "Dagger" , 0.25f, false },
+	{   5, "Spear"  , 3.0f , true  }
+};
+
+static const char * const kColumnNames[] = { "ID", "Name", "Value", "Usable" };
+
+static uint32 hashColumnName(const char *name) {
+	return Common::hashStringCRC32(Common::UString(name).toLower(), Common::kEncodingUTF16LE);
+}
+
+static void writeFieldDeclaration(Common::WriteStream &stream, uint32 label, uint32 typeAndFlags, uint32 offset) {
+	stream.writeUint32LE(label);
+	stream.writeUint32LE(typeAndFlags);
+	stream.writeUint32LE(offset);
+}
+
+/** Create a G2DA GFF4 with the columns ID (int), Name (string), Value (float) and Usable (bool). */
+static Common::SeekableReadStream *createGDA(const TestRow *rows, size_t count) {
+	static const uint32 kTemplateStart = 28;
+	static const uint32 kFieldStart    = kTemplateStart + 3 * 16;
+	static const uint32 kDataOffset    = kFieldStart + 8 * 12;
+
+	static const uint32 kColumnListStart = 8;
+	static const uint32 kRowListStart    = kColumnListStart + 4 + ARRAYSIZE(kColumnNames) * 8;
+
+	const uint32 stringStart = kRowListStart + 4 + count * 16;
+
+	Common::MemoryWriteStreamDynamic stream(true);
+
+	stream.writeUint32BE(MKTAG('G', 'F', 'F', ' '));
+	stream.writeUint32BE(MKTAG('V', '4', '.', '0'));
+	stream.writeUint32BE(MKTAG('P', 'C', ' ', ' '));
+	stream.writeUint32BE(MKTAG('G', '2', 'D', 'A'));
+	stream.writeUint32BE(MKTAG('V', '0', '.', '2'));
+	stream.writeUint32LE(3);
+	stream.writeUint32LE(kDataOffset);
+
+	// Struct templates: top-level, column and row
+
+	stream.writeUint32BE(MKTAG('G', 'T', 'O', 'P'));
+	stream.writeUint32LE(2);
+	stream.writeUint32LE(kFieldStart);
+	stream.writeUint32LE(8);
+
+	stream.writeUint32BE(MKTAG('G', 'C', 'O', 'L'));
+	stream.writeUint32LE(2);
+	stream.writeUint32LE(kFieldStart + 2 * 12);
+	stream.writeUint32LE(8);
+
+	stream.writeUint32BE(MKTAG('G', 'R', 'O', 'W'));
+	stream.writeUint32LE(4);
+	stream.writeUint32LE(kFieldStart + 4 * 12);
+	stream.writeUint32LE(16);
+
+	writeFieldDeclaration(stream, Aurora::kGFF4G2DAColumnList, 0xC0000001, 0);
+	writeFieldDeclaration(stream, Aurora::kGFF4G2DARowList   , 0xC0000002, 4);
+
+	writeFieldDeclaration(stream, Aurora::kGFF4G2DAColumnHash, 4, 0);
+	writeFieldDeclaration(stream, Aurora::kGFF4G2DAColumnType, 0, 4);
+
+	writeFieldDeclaration(stream, Aurora::kGFF4G2DAColumn1,  5, 0);
+	writeFieldDeclaration(stream, Aurora::kGFF4G2DAColumn2, 14, 4);
+	writeFieldDeclaration(stream, Aurora::kGFF4G2DAColumn3,  8, 8);
+	writeFieldDeclaration(stream, Aurora::kGFF4G2DAColumn4,  0, 12);
+
+	// Data: top-level struct, column list, row list and strings
+
+	stream.writeUint32LE(kColumnListStart);
+	stream.writeUint32LE(kRowListStart);
+
+	static const byte kColumnTypes[] = {
+		Aurora::GDAFile::kTypeInt, Aurora::GDAFile::kTypeString, Aurora::GDAFile::kTypeFloat,
+		Aurora::GDAFile::kTypeBool
+	};
+
+	stream.writeUint32LE(ARRAYSIZE(kColumnNames));
+	for (size_t i = 0; i < ARRAYSIZE(kColumnNames); i++) {
+		stream.writeUint32LE(hashColumnName(kColumnNames[i]));
+		stream.writeUint32LE(kColumnTypes[i]);
+	}
+
+	uint32 stringOffset = stringStart;
+
+	stream.writeUint32LE(count);
+	for (size_t i = 0; i < count; i++) {
+		stream.writeSint32LE(rows[i].id);
+		stream.writeUint32LE(stringOffset);
+		stream.writeIEEEFloatLE(rows[i].value);
+		stream.writeUint32LE(rows[i].usable ? 1 : 0);
+
+		stringOffset += 4 + 2 * strlen(rows[i].name);
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		const size_t length = strlen(rows[i].name);
+
+		stream.writeUint32LE(length);
+		for (size_t j = 0; j < length; j++)
+			stream.writeUint16LE(rows[i].name[j]);
+	}
+
+	stream.setDisposable(false);
+	return new Common::MemoryReadStream(stream.getData(), stream.size(), true);
+}
+
+GTEST_TEST(GDAFile, getHeaders) {
+	Aurora::GDAFile gda(createGDA(kRows1, ARRAYSIZE(kRows1)));
+
+	EXPECT_EQ(gda.getColumnCount(), ARRAYSIZE(kColumnNames));
+	EXPECT_EQ(gda.getRowCount(), ARRAYSIZE(kRows1));
+
+	const Aurora::GDAFile::Headers &headers = gda.getHeaders();
+	ASSERT_EQ(headers.size(), ARRAYSIZE(kColumnNames));
+
+	EXPECT_EQ(headers[0].hash, hashColumnName("ID"));
+	EXPECT_EQ(headers[0].type, Aurora::GDAFile::kTypeInt);
+	EXPECT_EQ(headers[1].hash, hashColumnName("Name"));
+	EXPECT_EQ(headers[1].type, Aurora::GDAFile::kTypeString);
+	EXPECT_EQ(headers[2].hash, hashColumnName("Value"));
+	EXPECT_EQ(headers[2].type, Aurora::GDAFile::kTypeFloat);
+	EXPECT_EQ(headers[3].hash, hashColumnName("Usable"));
+	EXPECT_EQ(headers[3].type, Aurora::GDAFile::kTypeBool);
+}
+
+GTEST_TEST(GDAFile, findColumn) {
+	Aurora::GDAFile gda(createGDA(kRows1, ARRAYSIZE(kRows1)));
+
+	EXPECT_EQ(gda.findColumn("ID")   , Aurora::kGFF4G2DAColumn1);
+	EXPECT_EQ(gda.findColumn("name") , Aurora::kGFF4G2DAColumn2);
+	EXPECT_EQ(gda.findColumn("Value"), Aurora::kGFF4G2DAColumn3);
+
+	EXPECT_EQ(gda.findColumn(hashColumnName("Value")), Aurora::kGFF4G2DAColumn3);
+
+	EXPECT_EQ(gda.findColumn("Nope"), Aurora::GDAFile::kInvalidColumn);
+	EXPECT_EQ(gda.findColumn(0xDEADBEEF), Aurora::GDAFile::kInvalidColumn);
+}
+
+GTEST_TEST(GDAFile, getValues) {
+	Aurora::GDAFile gda(createGDA(kRows1, ARRAYSIZE(kRows1)));
+
+	for (size_t i = 0; i < ARRAYSIZE(kRows1); i++) {
+		EXPECT_EQ(gda.getInt   (i, "ID")   , kRows1[i].id)    << "At index " << i;
+		EXPECT_EQ(gda.getString(i, "Name") , kRows1[i].name)  << "At index " << i;
+		EXPECT_EQ(gda.getFloat (i, "Value"), kRows1[i].value) << "At index " << i;
+
+		EXPECT_EQ(gda.getInt   (i, "Usable"), kRows1[i].usable) << "At index " << i;
+
+		EXPECT_EQ(gda.getInt(i, hashColumnName("ID")), kRows1[i].id) << "At index " << i;
+	}
+
+	EXPECT_EQ(gda.getInt(ARRAYSIZE(kRows1), "ID", 23), 23);
+	EXPECT_EQ(gda.getInt(0, "Nope", 23), 23);
+	EXPECT_EQ(gda.getString(0, "Nope", "Foo"), "Foo");
+}
+
+GTEST_TEST(GDAFile, findRow) {
+	Aurora::GDAFile gda(createGDA(kRows1, ARRAYSIZE(kRows1)));
+
+	EXPECT_EQ(gda.findRow(100), 0);
+	EXPECT_EQ(gda.findRow(  5), 1);
+	EXPECT_EQ(gda.findRow( 42), 2);
+	EXPECT_EQ(gda.findRow(  7), Aurora::GDAFile::kInvalidRow);
+
+	gda.add(createGDA(kRows2, ARRAYSIZE(kRows2)));
+
+	ASSERT_EQ(gda.getRowCount(), ARRAYSIZE(kRows1) + ARRAYSIZE(kRows2));
+
+	// The first row with an ID wins
+	EXPECT_EQ(gda.findRow(  5), 1);
+	EXPECT_EQ(gda.findRow(  7), 3);
+	EXPECT_EQ(gda.findRow(100), 0);
+
+	EXPECT_EQ(gda.getString(gda.findRow(7), "Name"), "Dagger");
+	EXPECT_EQ(gda.getString(4, "Name"), "Spear");
+}
+
+GTEST_TEST(GDAFile, columnar) {
+	Aurora::GDAFile gda(createGDA(kRows1, ARRAYSIZE(kRows1)), true);
+	ASSERT_TRUE(gda.isColumnar());
+
+	for (size_t i = 0; i < ARRAYSIZE(kRows1); i++) {
+		EXPECT_EQ(gda.getInt   (i, "ID")    , kRows1[i].id)     << "At index " << i;
+		EXPECT_EQ(gda.getString(i, "Name")  , kRows1[i].name)   << "At index " << i;
+		EXPECT_EQ(gda.getFloat (i, "Value") , kRows1[i].value)  << "At index " << i;
+		EXPECT_EQ(gda.getInt   (i, "Usable"), kRows1[i].usable) << "At index " << i;
+	}
+
+	EXPECT_EQ(gda.getInt(ARRAYSIZE(kRows1), "ID", 23), 23);
+	EXPECT_EQ(gda.getInt(0, "Nope", 23), 23);
+	EXPECT_EQ(gda.getString(0, "Nope", "Foo"), "Foo");
+
+	EXPECT_THROW(gda.getFloat(0, "ID"), Common::Exception);
+	EXPECT_THROW(gda.getInt(0, "Name"), Common::Exception);
+
+	EXPECT_EQ(gda.findRow(42), 2);
+}
+
+GTEST_TEST(GDAFile, columnarArrays) {
+	Aurora::GDAFile gda(createGDA(kRows1, ARRAYSIZE(kRows1)), true);
+
+	gda.add(createGDA(kRows2, ARRAYSIZE(kRows2)));
+
+	const size_t rowCount = ARRAYSIZE(kRows1) + ARRAYSIZE(kRows2);
+	ASSERT_EQ(gda.getRowCount(), rowCount);
+
+	const std::vector<int32>  &ids    = gda.getIntColumn   ("ID");
+	const std::vector<uint32> &names  = gda.getStringColumn("Name");
+	const std::vector<float>  &values = gda.getFloatColumn (hashColumnName("Value"));
+	const std::vector<uint8>  &usable = gda.getBoolColumn  ("Usable");
+
+	ASSERT_EQ(ids.size()   , rowCount);
+	ASSERT_EQ(names.size() , rowCount);
+	ASSERT_EQ(values.size(), rowCount);
+	ASSERT_EQ(usable.size(), rowCount);
+
+	for (size_t i = 0; i < rowCount; i++) {
+		const TestRow &row = (i < ARRAYSIZE(kRows1)) ? kRows1[i] : kRows2[i - ARRAYSIZE(kRows1)];
+
+		EXPECT_EQ(ids[i], row.id) << "At index " << i;
+		EXPECT_STREQ(gda.getColumnString(names[i]), row.name) << "At index " << i;
+		EXPECT_EQ(values[i], row.value) << "At index " << i;
+		EXPECT_EQ(usable[i] != 0, row.usable) << "At index " << i;
+
+		EXPECT_EQ(gda.getString(i, "Name"), row.name) << "At index " << i;
+	}
+
+	EXPECT_THROW(gda.getIntColumn("Name"), Common::Exception);
+	EXPECT_THROW(gda.getFloatColumn("Nope"), Common::Exception);
+}
+
+GTEST_TEST(GDAFile, columnarRows) {
+	Aurora::GDAFile gda(createGDA(kRows1, ARRAYSIZE(kRows1)), true);
+
+	gda.add(createGDA(kRows2, ARRAYSIZE(kRows2)));
+
+	const size_t rowCount = ARRAYSIZE(kRows1) + ARRAYSIZE(kRows2);
+	ASSERT_EQ(gda.getRowCount(), rowCount);
+	ASSERT_EQ(gda.getColumnCount(), 4);
+
+	// The GFF4s are gone, but the rows still exist
+	for (size_t i = 0; i < rowCount; i++) {
+		EXPECT_TRUE(gda.hasRow(i)) << "At index " << i;
+		EXPECT_EQ(gda.getRow(i), static_cast<const Aurora::GFF4Struct *>(0)) << "At index " << i;
+	}
+
+	EXPECT_FALSE(gda.hasRow(rowCount));
+
+	EXPECT_EQ(gda.findRow(7), 3);
+}
+
+GTEST_TEST(GDAFile, columnarTwoDA) {
+	Aurora::GDAFile gda(createGDA(kRows1, ARRAYSIZE(kRows1)));
+	Aurora::GDAFile gdaColumnar(createGDA(kRows1, ARRAYSIZE(kRows1)), true);
+
+	gda.add(createGDA(kRows2, ARRAYSIZE(kRows2)));
+	gdaColumnar.add(createGDA(kRows2, ARRAYSIZE(kRows2)));
+
+	const Aurora::TwoDAFile twoDA(gda);
+	const Aurora::TwoDAFile twoDAColumnar(gdaColumnar);
+
+	ASSERT_EQ(twoDAColumnar.getRowCount(), twoDA.getRowCount());
+	ASSERT_EQ(twoDAColumnar.getColumnCount(), twoDA.getColumnCount());
+
+	for (size_t i = 0; i < twoDA.getRowCount(); i++)
+		for (size_t j = 0; j < twoDA.getColumnCount(); j++)
+			EXPECT_EQ(twoDAColumnar.getRow(i).getString(j), twoDA.getRow(i).getString(j)) <<
+				"At " << i << ", " << j;
+}
+
+GTEST_TEST(GDAFile, notColumnar) {
+	Aurora::GDAFile gda(createGDA(kRows1, ARRAYSIZE(kRows1)));
+
+	EXPECT_FALSE(gda.isColumnar());
+	EXPECT_THROW(gda.getIntColumn("ID"), Common::Exception);
+}
+
+GTEST_TEST(GDAFile, findGDAHeader) {
+	EXPECT_STREQ(Aurora::findGDAHeader(1421660U), "AttackScatter");
+	EXPECT_STREQ(Aurora::findGDAHeader(4294639615U), "CameraOffset");
+
+	EXPECT_STREQ(Aurora::findGDAHeader(hashColumnName("ID")), "ID");
+	EXPECT_STREQ(Aurora::findGDAHeader(hashColumnName("Name")), "Name");
+
+	EXPECT_EQ(Aurora::findGDAHeader(0), static_cast<const char *>(0));
+	EXPECT_EQ(Aurora::findGDAHeader(1421661U), static_cast<const char *>(0));
+}
@@ -0,0 +1,175 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for our GFF4 file reader.
+ */
+
+#include <cstring>
+
+#include <memory>
+
+#include "gtest/gtest.h"
+
+#include "src/common/util.h"
+#include "src/common/error.h"
+#include "src/common/memreadstream.h"
+
+#include "src/aurora/gff4file.h"
+
+// A top-level struct with a value, an inline struct, a list of structs and a generic
+static const byte kGFF4File[] = {
+	'G','F','F',' ','V','4','.','0','P','C',' ',' ','T','E','S','T','V','1','.','0',
+	0x02,0x00,0x00,0x00,0x78,0x00,0x00,0x00,
+	// Struct templates
+	'T','O','P',' ',0x04,0x00,0x00,0x00,0x3C,0x00,0x00,0x00,0x14,0x00,0x00,0x00,
+	'S','U','B',' ',0x01,0x00,0x00,0x00,0x6C,0x00,0x00,0x00,0x04,0x00,0x00,0x00,
+	// Field declarations of struct template 0
+	0x01,0x00,0x00,0x00,0x04,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+	0x02,0x00,0x00,0x00,0x01,0x00,0x00,0x40,0x04,0x00,0x00,0x00,
+	0x03,0x00,0x00,0x00,0x01,0x00,0x00,0xC0,0x08,0x00,0x00,0x00,
+	0x04,0x00,0x00,0x00,0xFF,0xFF,0x00,0x00,0x0C,0x00,0x00,0x00,
+	// Field declarations of struct template 1
+	0x0A,0x00,0x00,0x00,0x04,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+	// Top-level struct
+	0x2A,0x00,0x00,0x00,0x07,0x00,0x00,0x00,0x14,0x00,0x00,0x00,
+	0x04,0x00,0x00,0x00,0x63,0x00,0x00,0x00,
+	// List of structs
+	0x02,0x00,0x00,0x00,0x64,0x00,0x00,0x00,0xC8,0x00,0x00,0x00
+};
+
+static const size_t kSubLabelOffset = 44;
+
+static Aurora::GFF4File *openGFF4(const byte *data, size_t size, bool lazy,
+                                  Aurora::GFF4File::TemplateCache *templates = 0) {
+
+	return new Aurora::GFF4File(new Common::MemoryReadStream(data, size), MKTAG('T', 'E', 'S', 'T'),
+	                            lazy, templates);
+}
+
+static void checkGFF4(const Aurora::GFF4File &gff4) {
+	const Aurora::GFF4Struct &top = gff4.getTopLevel();
+
+	EXPECT_EQ(top.getLabel(), MKTAG('T', 'O', 'P', ' '));
+	EXPECT_EQ(top.getFieldCount(), 4);
+
+	EXPECT_EQ(top.getUint(1), 42);
+
+	const Aurora::GFF4Struct *sub = top.getStruct(2);
+	ASSERT_NE(sub, static_cast<const Aurora::GFF4Struct *>(0));
+
+	EXPECT_EQ(sub->getLabel(), MKTAG('S', 'U', 'B', ' '));
+	EXPECT_EQ(sub->getUint(10), 7);
+
+	const Aurora::GFF4List &list = top.getList(3);
+	ASSERT_EQ(list.size(), 2);
+
+	ASSERT_NE(list[0], static_cast<const Aurora::GFF4Struct *>(0));
+	ASSERT_NE(list[1], static_cast<const Aurora::GFF4Struct *>(0));
+	EXPECT_EQ(list[0]->getUint(10), 100);
+	EXPECT_EQ(list[1]->getUint(10), 200);
+
+	const Aurora::GFF4Struct *generic = top.getGeneric(4);
+	ASSERT_NE(generic, static_cast<const Aurora::GFF4Struct *>(0));
+
+	EXPECT_EQ(generic->getUint(0), 99);
+}
+
+GTEST_TEST(GFF4File, load) {
+	std::unique_ptr<Aurora::GFF4File> gff4(openGFF4(kGFF4File, sizeof(kGFF4File), false));
+
+	EXPECT_EQ(gff4->getType(), MKTAG('T', 'E', 'S', 'T'));
+	EXPECT_EQ(gff4->getTypeVersion(), MKTAG('V', '1', '.', '0'));
+	EXPECT_FALSE(gff4->isBigEndian());
+
+	checkGFF4(*gff4);
+
+	EXPECT_EQ(gff4->getTopLevel().getRefCount(), 1);
+	EXPECT_EQ(gff4->getTopLevel().getStruct(2)->getRefCount(), 1);
+}
+
+GTEST_TEST(GFF4File, loadLazy) {
+	std::unique_ptr<Aurora::GFF4File> gff4(openGFF4(kGFF4File, sizeof(kGFF4File), true));
+
+	checkGFF4(*gff4);
+
+	// Accessing the same fields again gives the same structs
+	const Aurora::GFF4Struct &top = gff4->getTopLevel();
+
+	EXPECT_EQ(top.getStruct(2), top.getStruct(2));
+	EXPECT_EQ(top.getList(3)[1], top.getList(3)[1]);
+	EXPECT_EQ(top.getStruct(2)->getRefCount(), 1);
+
+	checkGFF4(*gff4);
+}
+
+GTEST_TEST(GFF4File, loadWrongType) {
+	EXPECT_THROW(Aurora::GFF4File(new Common::MemoryReadStream(kGFF4File, sizeof(kGFF4File)),
+	                              MKTAG('G', 'D', 'A', ' ')), Common::Exception);
+}
+
+GTEST_TEST(GFF4File, templateCache) {
+	byte otherGFF4File[sizeof(kGFF4File)];
+	std::memcpy(otherGFF4File, kGFF4File, sizeof(kGFF4File));
+	otherGFF4File[kSubLabelOffset + 2] = 'X';
+
+	Aurora::GFF4File::TemplateCache templates;
+	EXPECT_EQ(templates.getSize(), 0);
+
+	std::unique_ptr<Aurora::GFF4File> gff4a(openGFF4(kGFF4File, sizeof(kGFF4File), true, &templates));
+	std::unique_ptr<Aurora::GFF4File> gff4b(openGFF4(kGFF4File, sizeof(kGFF4File), false, &templates));
+
+	EXPECT_EQ(templates.getSize(), 1);
+
+	checkGFF4(*gff4a);
+	checkGFF4(*gff4b);
+
+	std::unique_ptr<Aurora::GFF4File> gff4c(openGFF4(otherGFF4File, sizeof(otherGFF4File), true, &templates));
+
+	EXPECT_EQ(templates.getSize(), 2);
+
+	EXPECT_EQ(gff4c->getTopLevel().getStruct(2)->getLabel(), MKTAG('S', 'U', 'X', ' '));
+	EXPECT_EQ(gff4c->getTopLevel().getStruct(2)->getUint(10), 7);
+
+	templates.clear();
+	EXPECT_EQ(templates.getSize(), 0);
+
+	// The GFF4s still hold on to their templates
+	checkGFF4(*gff4a);
+}
+
+GTEST_TEST(GFF4File, templateCacheStructCount) {
+	// The same raw template data, but only the first struct template is used
+	byte otherGFF4File[sizeof(kGFF4File)];
+	std::memcpy(otherGFF4File, kGFF4File, sizeof(kGFF4File));
+	otherGFF4File[20] = 0x01;
+
+	Aurora::GFF4File::TemplateCache templates;
+
+	std::unique_ptr<Aurora::GFF4File> gff4a(openGFF4(kGFF4File, sizeof(kGFF4File), true, &templates));
+	EXPECT_EQ(templates.getSize(), 1);
+
+	std::unique_ptr<Aurora::GFF4File> gff4b(openGFF4(otherGFF4File, sizeof(otherGFF4File), true, &templates));
+
+	// The templates of the first GFF4 don't fit the second one
+	EXPECT_EQ(templates.getSize(), 2);
+
+	checkGFF4(*gff4a);
+}
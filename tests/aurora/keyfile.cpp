@@ -61,6 +61,18 @@ GTEST_TEST(KEYFile10, haveDataFile) {
 	EXPECT_THROW(key.haveDataFile(1), Common::Exception);
 }
 
+GTEST_TEST(KEYFile10, getResourceListForDataFile) {
+	Aurora::KEYFile key(new Common::MemoryReadStream(kKEY10File));
+
+	const std::vector<const Aurora::Archive::Resource *> res = key.getResourceListForDataFile("data/xoreos.bif");
+	ASSERT_EQ(res.size(), 1);
+
+	EXPECT_STREQ(res[0]->name.c_str(), "ozymandias");
+	EXPECT_EQ(res[0]->index, 0);
+
+	EXPECT_TRUE(key.getResourceListForDataFile("data/nope.bif").empty());
+}
+
 GTEST_TEST(KEYFile10, getResources) {
 	Aurora::KEYFile key(new Common::MemoryReadStream(kKEY10File));
 
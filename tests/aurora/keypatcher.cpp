@@ -0,0 +1,185 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for patching KEY/BIF archives in place.
+ */
+
+#include <cstring>
+
+#include <memory>
+
+#include "gtest/gtest.h"
+
+#include "src/common/error.h"
+#include "src/common/memreadstream.h"
+#include "src/common/memwritestream.h"
+#include "src/common/readwritestream.h"
+
+#include "src/aurora/keyfile.h"
+#include "src/aurora/biffile.h"
+#include "src/aurora/keypatcher.h"
+#include "src/aurora/bifpatcher.h"
+
+// A KEY V1 indexing one resource, "ozymandias.txt", in "xoreos.bif"
+static const byte kKEYFile[] = {
+	0x4B,0x45,0x59,0x20,0x56,0x31,0x20,0x20,0x01,0x00,0x00,0x00,0x01,0x00,0x00,0x00,
+	0x40,0x00,0x00,0x00,0x56,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+	0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+	0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+	0x00,0x00,0x00,0x00,0x4C,0x00,0x00,0x00,0x0A,0x00,0x00,0x00,0x78,0x6F,0x72,0x65,
+	0x6F,0x73,0x2E,0x62,0x69,0x66,0x6F,0x7A,0x79,0x6D,0x61,0x6E,0x64,0x69,0x61,0x73,
+	0x00,0x00,0x00,0x00,0x00,0x00,0x0A,0x00,0x00,0x00,0x00,0x00
+};
+
+static const char *kFileData1 = "I met a traveller from an antique land";
+static const char *kFileData2 = "Who said: Two vast and trunkless legs of stone";
+static const char *kFileData3 = "Stand in the desert.";
+
+/** Write a BIF V1 with one text resource, the same as indexed by kKEYFile. */
+static Common::MemoryReadWriteStream *createBIF() {
+	Common::MemoryWriteStreamDynamic bif(true);
+
+	bif.writeString("BIFFV1  ");
+	bif.writeUint32LE(1);    // Variable resource count
+	bif.writeUint32LE(0);    // Fixed resource count
+	bif.writeUint32LE(0x14); // Offset to the variable resource table
+
+	bif.writeUint32LE(0);    // ID
+	bif.writeUint32LE(0x24); // Offset
+	bif.writeUint32LE(std::strlen(kFileData1));
+	bif.writeUint32LE(Aurora::kFileTypeTXT);
+
+	bif.writeString(kFileData1);
+
+	return new Common::MemoryReadWriteStream(bif.getData(), bif.size());
+}
+
+static Common::MemoryReadStream *createStream(const char *data) {
+	return new Common::MemoryReadStream(reinterpret_cast<const byte *>(data), std::strlen(data));
+}
+
+static void checkResource(const Aurora::KEYFile &key, uint32 index, const char *data) {
+	std::unique_ptr<Common::SeekableReadStream> file(key.getResource(index));
+	ASSERT_EQ(file->size(), std::strlen(data));
+
+	std::vector<byte> contents(file->size());
+	ASSERT_EQ(file->read(&contents[0], contents.size()), contents.size());
+
+	EXPECT_EQ(std::memcmp(&contents[0], data, contents.size()), 0);
+}
+
+static void testAdd(const std::vector<byte> &keyData) {
+	Common::MemoryReadWriteStream *bifStream = createBIF();
+	Common::MemoryReadWriteStream *keyStream = new Common::MemoryReadWriteStream(&keyData[0], keyData.size());
+
+	Aurora::BIFPatcher bifPatcher(bifStream);
+	Aurora::KEYPatcher keyPatcher(keyStream);
+
+	ASSERT_EQ(bifPatcher.getResourceCount(), 1);
+	ASSERT_EQ(keyPatcher.getResourceCount(), 1);
+	ASSERT_EQ(keyPatcher.getDataFileCount(), 1);
+
+	std::unique_ptr<Common::SeekableReadStream> data(createStream(kFileData2));
+	const uint32 index = bifPatcher.add(Aurora::kFileTypeTXT, *data);
+	bifPatcher.flush();
+
+	EXPECT_EQ(index, 1);
+	EXPECT_EQ(bifPatcher.getResourceType(index), Aurora::kFileTypeTXT);
+
+	keyPatcher.add("newresource", Aurora::kFileTypeTXT, 0, index);
+	keyPatcher.setDataFileSize(0, bifPatcher.getSize());
+	keyPatcher.flush();
+
+	EXPECT_EQ(keyPatcher.getResourceCount(), 2);
+	EXPECT_EQ(READ_LE_UINT32(keyStream->getData() + 0x40), bifPatcher.getSize());
+
+	Aurora::KEYFile key(new Common::MemoryReadStream(keyStream->getData(), keyStream->size()));
+	Aurora::BIFFile bif(new Common::MemoryReadStream(bifStream->getData(), bifStream->size()));
+
+	key.addDataFile(0, &bif);
+
+	EXPECT_EQ(key.findResource("ozymandias" , Aurora::kFileTypeTXT), 0);
+	EXPECT_EQ(key.findResource("newresource", Aurora::kFileTypeTXT), 1);
+
+	checkResource(key, 0, kFileData1);
+	checkResource(key, 1, kFileData2);
+}
+
+GTEST_TEST(KEYPatcher, add) {
+	testAdd(std::vector<byte>(kKEYFile, kKEYFile + sizeof(kKEYFile)));
+}
+
+GTEST_TEST(KEYPatcher, addMoveTable) {
+	// Something following the resource table, so that the table has to move
+	std::vector<byte> keyData(kKEYFile, kKEYFile + sizeof(kKEYFile));
+	keyData.resize(keyData.size() + 4, 0xFF);
+
+	testAdd(keyData);
+}
+
+GTEST_TEST(KEYPatcher, addInvalid) {
+	Aurora::KEYPatcher key(new Common::MemoryReadWriteStream(kKEYFile, sizeof(kKEYFile)));
+
+	EXPECT_THROW(key.add("newresource", Aurora::kFileTypeTXT, 1, 0), Common::Exception);
+	EXPECT_THROW(key.add("waytoolongresourcename", Aurora::kFileTypeTXT, 0, 0), Common::Exception);
+	EXPECT_THROW(key.add("newresource", Aurora::kFileTypeTXT, 0, 0x100000), Common::Exception);
+
+	EXPECT_THROW(key.setDataFileSize(1, 0), Common::Exception);
+
+	EXPECT_EQ(key.getResourceCount(), 1);
+}
+
+GTEST_TEST(BIFPatcher, replace) {
+	Common::MemoryReadWriteStream *bifStream = createBIF();
+	Aurora::BIFPatcher bifPatcher(bifStream);
+
+	std::unique_ptr<Common::SeekableReadStream> data(createStream(kFileData2));
+	bifPatcher.replace(0, *data);
+	bifPatcher.flush();
+
+	EXPECT_GT(bifPatcher.getFreeSize(), 0);
+
+	// The shorter data fits into the gap left by the original data
+	const size_t size = bifPatcher.getSize();
+
+	data.reset(createStream(kFileData3));
+	bifPatcher.replace(0, *data);
+	bifPatcher.flush();
+
+	EXPECT_EQ(bifPatcher.getSize(), size);
+
+	bifPatcher.compact();
+
+	EXPECT_EQ(bifPatcher.getFreeSize(), 0);
+	EXPECT_EQ(bifPatcher.getSize(), 0x24 + std::strlen(kFileData3));
+
+	Aurora::KEYFile key(new Common::MemoryReadStream(kKEYFile));
+	Aurora::BIFFile bif(new Common::MemoryReadStream(bifStream->getData(), bifStream->size()));
+
+	key.addDataFile(0, &bif);
+
+	checkResource(key, 0, kFileData3);
+}
+
+GTEST_TEST(BIFPatcher, notBIF) {
+	EXPECT_THROW(Aurora::BIFPatcher bif(new Common::MemoryReadWriteStream(kKEYFile, sizeof(kKEYFile))),
+	             Common::Exception);
+}
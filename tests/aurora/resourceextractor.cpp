@@ -0,0 +1,197 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for our parallel resource extractor.
+ */
+
+#include <cstring>
+
+#include <vector>
+#include <map>
+#include <atomic>
+
+#include "gtest/gtest.h"
+
+#include "src/common/util.h"
+#include "src/common/error.h"
+#include "src/common/mutex.h"
+#include "src/common/memreadstream.h"
+
+#include "src/aurora/archive.h"
+#include "src/aurora/resourceextractor.h"
+
+static const char * const kResources[] = {
+	"I met a traveller from an antique land",
+	"Who said: Two vast and trunkless legs of stone",
+	"Stand in the desert. Near them, on the sand,",
+	"Half sunk, a shattered visage lies, whose frown,",
+	"And wrinkled lip, and sneer of cold command,",
+	"Tell that its sculptor well those passions read",
+	"Which yet survive, stamped on these lifeless things,",
+	"The hand that mocked them and the heart that fed:",
+	0
+};
+
+static const uint32 kBrokenResource = ARRAYSIZE(kResources) - 1;
+
+/** An archive of test resources. The null resource is broken and can't be read. */
+class TestArchive : public Aurora::Archive {
+public:
+	TestArchive() {
+		for (size_t i = 0; i < ARRAYSIZE(kResources); i++) {
+			_resources.push_back(Resource());
+
+			_resources.back().name  = Common::UString::format("line%u", (uint)i);
+			_resources.back().type  = Aurora::kFileTypeTXT;
+			_resources.back().index = i;
+		}
+	}
+
+	const ResourceList &getResources() const {
+		return _resources;
+	}
+
+	uint32 getResourceSize(uint32 index) const {
+		return kResources[index] ? strlen(kResources[index]) : 0;
+	}
+
+	Common::SeekableReadStream *getResource(uint32 index, bool UNUSED(tryNoCopy) = false) const {
+		if (!kResources[index])
+			throw Common::Exception("Broken resource");
+
+		return new Common::MemoryReadStream(reinterpret_cast<const byte *>(kResources[index]),
+		                                    strlen(kResources[index]));
+	}
+
+private:
+	ResourceList _resources;
+};
+
+/** Collects the extracted resources. */
+struct TestSink {
+	std::mutex mutex;
+	std::map<uint32, Common::UString> extracted;
+
+	void operator()(uint32 index, Common::SeekableReadStream &data) {
+		std::vector<char> buffer(data.size());
+		if (data.read(buffer.data(), buffer.size()) != buffer.size())
+			throw Common::Exception(Common::kReadError);
+
+		std::lock_guard<std::mutex> lock(mutex);
+		extracted[index] = Common::UString(buffer.data(), buffer.size());
+	}
+};
+
+static void checkExtracted(const TestSink &sink, const Aurora::ResourceExtractor &extractor) {
+	ASSERT_EQ(sink.extracted.size(), ARRAYSIZE(kResources) - 1);
+
+	for (uint32 i = 0; i < kBrokenResource; i++) {
+		std::map<uint32, Common::UString>::const_iterator e = sink.extracted.find(i);
+
+		ASSERT_NE(e, sink.extracted.end()) << "At index " << i;
+		EXPECT_STREQ(e->second.c_str(), kResources[i]) << "At index " << i;
+	}
+
+	ASSERT_EQ(extractor.getFailures().size(), 1);
+	EXPECT_EQ(extractor.getFailures()[0].index, kBrokenResource);
+}
+
+GTEST_TEST(ResourceExtractor, extractAllSingleThread) {
+	std::atomic<size_t> opened(0);
+
+	Aurora::ResourceExtractor extractor([&opened]() {
+		opened++;
+		return new TestArchive;
+	});
+
+	TestSink sink;
+	extractor.extractAll(std::ref(sink), 1);
+
+	EXPECT_EQ(opened, 1);
+
+	checkExtracted(sink, extractor);
+}
+
+GTEST_TEST(ResourceExtractor, extractAllThreads) {
+	std::atomic<size_t> opened(0);
+
+	Aurora::ResourceExtractor extractor([&opened]() {
+		opened++;
+		return new TestArchive;
+	});
+
+	TestSink sink;
+	extractor.extractAll(std::ref(sink), 4);
+
+	// Every thread opens the archive on its own
+	EXPECT_EQ(opened, 4);
+
+	checkExtracted(sink, extractor);
+}
+
+GTEST_TEST(ResourceExtractor, extractSome) {
+	Aurora::ResourceExtractor extractor([]() {
+		return new TestArchive;
+	});
+
+	const std::vector<uint32> indices = { 1, 5 };
+
+	TestSink sink;
+	extractor.extract(indices, std::ref(sink), 2);
+
+	ASSERT_EQ(sink.extracted.size(), 2);
+	EXPECT_STREQ(sink.extracted[1].c_str(), kResources[1]);
+	EXPECT_STREQ(sink.extracted[5].c_str(), kResources[5]);
+
+	EXPECT_TRUE(extractor.getFailures().empty());
+}
+
+GTEST_TEST(ResourceExtractor, openFail) {
+	Aurora::ResourceExtractor extractor([]() -> Aurora::Archive * {
+		throw Common::Exception("Can't open");
+	});
+
+	TestSink sink;
+	EXPECT_THROW(extractor.extractAll(std::ref(sink)), Common::Exception);
+}
+
+GTEST_TEST(ResourceExtractor, extractOpened) {
+	std::atomic<size_t> opened(0);
+
+	Aurora::ResourceExtractor extractor([&opened]() {
+		opened++;
+		return new TestArchive;
+	});
+
+	TestArchive archive;
+
+	std::vector<uint32> indices;
+	for (uint32 i = 0; i < ARRAYSIZE(kResources); i++)
+		indices.push_back(i);
+
+	TestSink sink;
+	extractor.extract(archive, indices, std::ref(sink), 4);
+
+	// The calling thread extracts out of the archive it was given
+	EXPECT_EQ(opened, 3);
+
+	checkExtracted(sink, extractor);
+}
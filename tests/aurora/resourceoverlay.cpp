@@ -0,0 +1,183 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for our resource overlay.
+ */
+
+#include <cstring>
+
+#include <memory>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "src/common/util.h"
+#include "src/common/memreadstream.h"
+
+#include "src/aurora/archive.h"
+#include "src/aurora/resourceoverlay.h"
+
+struct TestResource {
+	const char *name;
+	Aurora::FileType type;
+	const char *data;
+};
+
+static const TestResource kBaseResources[] = {
+	{ "ozymandias", Aurora::kFileTypeTXT, "base"  },
+	{ "traveller" , Aurora::kFileTypeTXT, "base"  },
+	{ "traveller" , Aurora::kFileTypeTGA, "image" }
+};
+
+static const TestResource kModuleResources[] = {
+	{ "Ozymandias", Aurora::kFileTypeTXT, "module" }
+};
+
+static const TestResource kOverrideResources[] = {
+	{ "ozymandias", Aurora::kFileTypeTXT, "override" },
+	{ "land"      , Aurora::kFileTypeTXT, "override" }
+};
+
+/** An archive holding a list of test resources. */
+class TestArchive : public Aurora::Archive {
+public:
+	TestArchive(const TestResource *resources, size_t count) : _data(resources) {
+		for (size_t i = 0; i < count; i++) {
+			_resources.push_back(Resource());
+
+			_resources.back().name  = resources[i].name;
+			_resources.back().type  = resources[i].type;
+			_resources.back().index = i;
+		}
+	}
+
+	const ResourceList &getResources() const {
+		return _resources;
+	}
+
+	uint32 getResourceSize(uint32 index) const {
+		return strlen(_data[index].data);
+	}
+
+	Common::SeekableReadStream *getResource(uint32 index, bool UNUSED(tryNoCopy) = false) const {
+		return new Common::MemoryReadStream(reinterpret_cast<const byte *>(_data[index].data),
+		                                    strlen(_data[index].data));
+	}
+
+private:
+	const TestResource *_data;
+
+	ResourceList _resources;
+};
+
+GTEST_TEST(ResourceOverlay, find) {
+	TestArchive base(kBaseResources, ARRAYSIZE(kBaseResources));
+
+	Aurora::ResourceOverlay overlay;
+	overlay.addArchive(base, Aurora::ResourceOverlay::kPriorityKEY);
+
+	EXPECT_EQ(overlay.getArchiveCount(), 1);
+	EXPECT_EQ(overlay.getResourceCount(), 3);
+
+	const Aurora::ResourceOverlay::Location *location = overlay.find("TRAVELLER", Aurora::kFileTypeTGA);
+	ASSERT_NE(location, static_cast<const Aurora::ResourceOverlay::Location *>(0));
+
+	EXPECT_EQ(location->archive, &base);
+	EXPECT_EQ(location->index, 2);
+
+	EXPECT_EQ(overlay.find("traveller", Aurora::kFileTypeNSS), static_cast<const Aurora::ResourceOverlay::Location *>(0));
+	EXPECT_EQ(overlay.find("land", Aurora::kFileTypeTXT), static_cast<const Aurora::ResourceOverlay::Location *>(0));
+}
+
+GTEST_TEST(ResourceOverlay, shadowing) {
+	TestArchive base(kBaseResources, ARRAYSIZE(kBaseResources));
+	TestArchive module(kModuleResources, ARRAYSIZE(kModuleResources));
+	TestArchive override(kOverrideResources, ARRAYSIZE(kOverrideResources));
+
+	Aurora::ResourceOverlay overlay;
+	overlay.addArchive(override, Aurora::ResourceOverlay::kPriorityOverride);
+	overlay.addArchive(base, Aurora::ResourceOverlay::kPriorityKEY);
+	overlay.addArchive(module, Aurora::ResourceOverlay::kPriorityModule);
+
+	EXPECT_EQ(overlay.getResourceCount(), 4);
+
+	const std::vector<Aurora::ResourceOverlay::Location> versions = overlay.findAll("ozymandias", Aurora::kFileTypeTXT);
+	ASSERT_EQ(versions.size(), 3);
+	EXPECT_EQ(versions[0].archive, &base);
+	EXPECT_EQ(versions[1].archive, &module);
+	EXPECT_EQ(versions[2].archive, &override);
+
+	std::unique_ptr<Common::SeekableReadStream> stream(overlay.getResource("ozymandias", Aurora::kFileTypeTXT));
+	ASSERT_TRUE(stream);
+	EXPECT_EQ(stream->size(), strlen("override"));
+}
+
+GTEST_TEST(ResourceOverlay, samePriority) {
+	TestArchive base(kBaseResources, ARRAYSIZE(kBaseResources));
+	TestArchive module(kModuleResources, ARRAYSIZE(kModuleResources));
+
+	Aurora::ResourceOverlay overlay;
+	overlay.addArchive(module, Aurora::ResourceOverlay::kPriorityArchive);
+	overlay.addArchive(base, Aurora::ResourceOverlay::kPriorityArchive);
+
+	// With the same priority, the archive added later wins
+	EXPECT_EQ(overlay.find("ozymandias", Aurora::kFileTypeTXT)->archive, &base);
+
+	// Adding an archive again changes its priority
+	overlay.addArchive(module, Aurora::ResourceOverlay::kPriorityArchive);
+	EXPECT_EQ(overlay.getArchiveCount(), 2);
+	EXPECT_EQ(overlay.find("ozymandias", Aurora::kFileTypeTXT)->archive, &module);
+	EXPECT_EQ(overlay.findAll("ozymandias", Aurora::kFileTypeTXT).size(), 2);
+}
+
+GTEST_TEST(ResourceOverlay, removeArchive) {
+	TestArchive base(kBaseResources, ARRAYSIZE(kBaseResources));
+	TestArchive override(kOverrideResources, ARRAYSIZE(kOverrideResources));
+
+	Aurora::ResourceOverlay overlay;
+	overlay.addArchive(base, Aurora::ResourceOverlay::kPriorityKEY);
+	overlay.addArchive(override, Aurora::ResourceOverlay::kPriorityOverride);
+
+	EXPECT_EQ(overlay.find("ozymandias", Aurora::kFileTypeTXT)->archive, &override);
+
+	overlay.removeArchive(override);
+
+	EXPECT_FALSE(overlay.hasArchive(override));
+	EXPECT_EQ(overlay.getResourceCount(), 3);
+	EXPECT_EQ(overlay.find("ozymandias", Aurora::kFileTypeTXT)->archive, &base);
+	EXPECT_EQ(overlay.find("land", Aurora::kFileTypeTXT), static_cast<const Aurora::ResourceOverlay::Location *>(0));
+
+	overlay.clear();
+
+	EXPECT_EQ(overlay.getArchiveCount(), 0);
+	EXPECT_EQ(overlay.getResourceCount(), 0);
+}
+
+GTEST_TEST(ResourceOverlay, getDefaultPriority) {
+	EXPECT_LT(Aurora::ResourceOverlay::getDefaultPriority(Aurora::kFileTypeKEY),
+	          Aurora::ResourceOverlay::getDefaultPriority(Aurora::kFileTypeERF));
+	EXPECT_LT(Aurora::ResourceOverlay::getDefaultPriority(Aurora::kFileTypeERF),
+	          Aurora::ResourceOverlay::getDefaultPriority(Aurora::kFileTypeMOD));
+	EXPECT_LT(Aurora::ResourceOverlay::getDefaultPriority(Aurora::kFileTypeMOD),
+	          Aurora::ResourceOverlay::getDefaultPriority(Aurora::kFileTypeHAK));
+	EXPECT_LT(Aurora::ResourceOverlay::getDefaultPriority(Aurora::kFileTypeHAK),
+	          Aurora::ResourceOverlay::getDefaultPriority(Aurora::kFileTypeNone));
+}
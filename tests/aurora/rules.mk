@@ -70,3 +70,63 @@ check_PROGRAMS                    += tests/aurora/test_erffile
 tests_aurora_test_erffile_SOURCES  = tests/aurora/erffile.cpp
 tests_aurora_test_erffile_LDADD    = $(aurora_LIBS)
 tests_aurora_test_erffile_CXXFLAGS = $(test_CXXFLAGS)
+
+check_PROGRAMS                      += tests/aurora/test_erfwriter
+tests_aurora_test_erfwriter_SOURCES  = tests/aurora/erfwriter.cpp
+tests_aurora_test_erfwriter_LDADD    = $(aurora_LIBS)
+tests_aurora_test_erfwriter_CXXFLAGS = $(test_CXXFLAGS)
+
+check_PROGRAMS                           += tests/aurora/test_archivepatcher
+tests_aurora_test_archivepatcher_SOURCES  = tests/aurora/archivepatcher.cpp
+tests_aurora_test_archivepatcher_LDADD    = $(aurora_LIBS)
+tests_aurora_test_archivepatcher_CXXFLAGS = $(test_CXXFLAGS)
+
+check_PROGRAMS                       += tests/aurora/test_erfpatcher
+tests_aurora_test_erfpatcher_SOURCES  = tests/aurora/erfpatcher.cpp
+tests_aurora_test_erfpatcher_LDADD    = $(aurora_LIBS)
+tests_aurora_test_erfpatcher_CXXFLAGS = $(test_CXXFLAGS)
+
+check_PROGRAMS                       += tests/aurora/test_keypatcher
+tests_aurora_test_keypatcher_SOURCES  = tests/aurora/keypatcher.cpp
+tests_aurora_test_keypatcher_LDADD    = $(aurora_LIBS)
+tests_aurora_test_keypatcher_CXXFLAGS = $(test_CXXFLAGS)
+
+check_PROGRAMS                     += tests/aurora/test_gff4file
+tests_aurora_test_gff4file_SOURCES  = tests/aurora/gff4file.cpp
+tests_aurora_test_gff4file_LDADD    = $(aurora_LIBS)
+tests_aurora_test_gff4file_CXXFLAGS = $(test_CXXFLAGS)
+
+check_PROGRAMS                    += tests/aurora/test_gdafile
+tests_aurora_test_gdafile_SOURCES  = tests/aurora/gdafile.cpp
+tests_aurora_test_gdafile_LDADD    = $(aurora_LIBS)
+tests_aurora_test_gdafile_CXXFLAGS = $(test_CXXFLAGS)
+
+check_PROGRAMS                         += tests/aurora/test_archivecache
+tests_aurora_test_archivecache_SOURCES  = tests/aurora/archivecache.cpp
+tests_aurora_test_archivecache_LDADD    = $(aurora_LIBS)
+tests_aurora_test_archivecache_CXXFLAGS = $(test_CXXFLAGS)
+
+check_PROGRAMS                        += tests/aurora/test_searchindex
+tests_aurora_test_searchindex_SOURCES  = tests/aurora/searchindex.cpp
+tests_aurora_test_searchindex_LDADD    = $(aurora_LIBS)
+tests_aurora_test_searchindex_CXXFLAGS = $(test_CXXFLAGS)
+
+check_PROGRAMS                            += tests/aurora/test_duplicatefinder
+tests_aurora_test_duplicatefinder_SOURCES  = tests/aurora/duplicatefinder.cpp
+tests_aurora_test_duplicatefinder_LDADD    = $(aurora_LIBS)
+tests_aurora_test_duplicatefinder_CXXFLAGS = $(test_CXXFLAGS)
+
+check_PROGRAMS                            += tests/aurora/test_resourceoverlay
+tests_aurora_test_resourceoverlay_SOURCES  = tests/aurora/resourceoverlay.cpp
+tests_aurora_test_resourceoverlay_LDADD    = $(aurora_LIBS)
+tests_aurora_test_resourceoverlay_CXXFLAGS = $(test_CXXFLAGS)
+
+check_PROGRAMS                              += tests/aurora/test_resourceextractor
+tests_aurora_test_resourceextractor_SOURCES  = tests/aurora/resourceextractor.cpp
+tests_aurora_test_resourceextractor_LDADD    = $(aurora_LIBS)
+tests_aurora_test_resourceextractor_CXXFLAGS = $(test_CXXFLAGS)
+
+check_PROGRAMS                          += tests/aurora/test_archivedigest
+tests_aurora_test_archivedigest_SOURCES  = tests/aurora/archivedigest.cpp
+tests_aurora_test_archivedigest_LDADD    = $(aurora_LIBS)
+tests_aurora_test_archivedigest_CXXFLAGS = $(test_CXXFLAGS)
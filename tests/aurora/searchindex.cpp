@@ -0,0 +1,210 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for our resource search index.
+ */
+
+#include <cstring>
+
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+
+#include "gtest/gtest.h"
+
+#include "src/common/util.h"
+#include "src/common/memreadstream.h"
+#include "src/common/memwritestream.h"
+
+#include "src/aurora/archive.h"
+#include "src/aurora/searchindex.h"
+
+struct TestResource {
+	const char *name;
+	Aurora::FileType type;
+	const char *data;
+};
+
+static const TestResource kResources[] = {
+	{ "ozymandias" , Aurora::kFileTypeTXT, "I met a traveller from an antique land" },
+	{ "c_dragon"   , Aurora::kFileTypeTGA, "" },
+	{ "nw_c2_dragn", Aurora::kFileTypeNSS, "void main() { CreateObject(c_dragon); }" }
+};
+
+/** An archive holding the resources above. */
+class TestArchive : public Aurora::Archive {
+public:
+	TestArchive() {
+		for (size_t i = 0; i < ARRAYSIZE(kResources); i++) {
+			_resources.push_back(Resource());
+
+			_resources.back().name  = kResources[i].name;
+			_resources.back().type  = kResources[i].type;
+			_resources.back().index = i;
+		}
+	}
+
+	const ResourceList &getResources() const {
+		return _resources;
+	}
+
+	uint32 getResourceSize(uint32 index) const {
+		return strlen(kResources[index].data);
+	}
+
+	Common::SeekableReadStream *getResource(uint32 index, bool UNUSED(tryNoCopy) = false) const {
+		return new Common::MemoryReadStream(reinterpret_cast<const byte *>(kResources[index].data),
+		                                    strlen(kResources[index].data));
+	}
+
+private:
+	ResourceList _resources;
+};
+
+/** Open the test archive again, for verifying hits in the contents. */
+static Aurora::Archive *openTestArchive(const Common::UString &UNUSED(path)) {
+	return new TestArchive;
+}
+
+GTEST_TEST(SearchIndex, findName) {
+	TestArchive archive;
+
+	Aurora::SearchIndex index;
+	index.addArchive("data/test.erf", archive);
+
+	EXPECT_EQ(index.getResourceCount(), ARRAYSIZE(kResources));
+
+	const std::vector<Aurora::SearchIndex::Hit> hits = index.find("DRAGON");
+	ASSERT_EQ(hits.size(), 1);
+
+	EXPECT_STREQ(hits[0].archive.c_str(), "data/test.erf");
+	EXPECT_STREQ(hits[0].name.c_str(), "c_dragon.tga");
+	EXPECT_EQ(hits[0].type, Aurora::kFileTypeTGA);
+	EXPECT_EQ(hits[0].index, 1);
+	EXPECT_FALSE(hits[0].inContents);
+
+	EXPECT_EQ(index.find(".nss").size(), 1);
+	EXPECT_EQ(index.find("test.erf").size(), ARRAYSIZE(kResources));
+	EXPECT_EQ(index.find("_d").size(), 2);
+	EXPECT_TRUE(index.find("nodragon").empty());
+	EXPECT_TRUE(index.find("nogard").empty());
+}
+
+GTEST_TEST(SearchIndex, findContents) {
+	TestArchive archive;
+
+	Aurora::SearchIndex index;
+	index.addArchive("data/test.erf", archive, true);
+
+	const std::vector<Aurora::SearchIndex::Hit> hits = index.find("c_dragon", SIZE_MAX, openTestArchive);
+	ASSERT_EQ(hits.size(), 2);
+
+	EXPECT_STREQ(hits[0].name.c_str(), "c_dragon.tga");
+	EXPECT_FALSE(hits[0].inContents);
+	EXPECT_STREQ(hits[1].name.c_str(), "nw_c2_dragn.nss");
+	EXPECT_TRUE(hits[1].inContents);
+
+	EXPECT_EQ(index.find("antique", SIZE_MAX, openTestArchive).size(), 1);
+	EXPECT_EQ(index.find("c_dragon", 1, openTestArchive).size(), 1);
+}
+
+GTEST_TEST(SearchIndex, findContentsVerified) {
+	TestArchive archive;
+
+	Aurora::SearchIndex index;
+	index.addArchive("data/test.erf", archive, true);
+
+	// All trigrams of the query are in "from an antique land", but the query isn't
+	EXPECT_TRUE(index.find("an an an", SIZE_MAX, openTestArchive).empty());
+
+	EXPECT_EQ(index.find("an antique land", SIZE_MAX, openTestArchive).size(), 1);
+}
+
+GTEST_TEST(SearchIndex, findContentsUnreadable) {
+	TestArchive archive;
+
+	Aurora::SearchIndex index;
+	index.addArchive("data/test.erf", archive, true);
+
+	// Without the archive, the contents can't be checked
+	const std::vector<Aurora::SearchIndex::Hit> hits =
+		index.find("c_dragon", SIZE_MAX, [](const Common::UString &) -> Aurora::Archive * { return 0; });
+
+	ASSERT_EQ(hits.size(), 1);
+	EXPECT_FALSE(hits[0].inContents);
+}
+
+GTEST_TEST(SearchIndex, saveLoad) {
+	TestArchive archive;
+
+	Aurora::SearchIndex index;
+	index.addArchive("data/test.erf", archive, true, 23, 5);
+	index.addArchive("data/test2.erf", archive, false, 42, 7);
+
+	Common::MemoryWriteStreamDynamic stream(true);
+	index.save(stream);
+
+	Common::MemoryReadStream readStream(stream.getData(), stream.size());
+
+	Aurora::SearchIndex loaded;
+	loaded.load(readStream);
+
+	ASSERT_EQ(loaded.getArchives().size(), 2);
+	EXPECT_STREQ(loaded.getArchives()[1].c_str(), "data/test2.erf");
+	EXPECT_EQ(loaded.getResourceCount(), 2 * ARRAYSIZE(kResources));
+
+	const std::vector<Aurora::SearchIndex::Hit> hits = loaded.find("c_dragon", SIZE_MAX, openTestArchive);
+	ASSERT_EQ(hits.size(), 3);
+
+	EXPECT_STREQ(hits[2].archive.c_str(), "data/test2.erf");
+	EXPECT_TRUE(hits[1].inContents);
+}
+
+static void writeFile(const boost::filesystem::path &path, const char *data) {
+	boost::filesystem::ofstream file(path, std::ofstream::binary);
+
+	file << data;
+}
+
+GTEST_TEST(SearchIndex, isCurrentSameSize) {
+	const boost::filesystem::path path = boost::filesystem::temp_directory_path() /
+		boost::filesystem::unique_path("%%%%_%%%%_%%%%_%%%%.erf");
+
+	writeFile(path, "Not an archive");
+
+	const std::vector<Common::UString> paths(1, path.generic_string());
+
+	Aurora::SearchIndex index;
+	index.addArchiveFiles(paths);
+
+	EXPECT_TRUE(index.isCurrent(paths));
+
+	// Rewrite the file with the same size, a bit later
+	const std::time_t modified = boost::filesystem::last_write_time(path);
+
+	writeFile(path, "Not a resource");
+	boost::filesystem::last_write_time(path, modified + 10);
+
+	EXPECT_FALSE(index.isCurrent(paths));
+
+	boost::filesystem::remove(path);
+}
@@ -22,7 +22,10 @@
  *  Unit tests for our Blowfish implementation.
  */
 
+#include <cstring>
+
 #include <vector>
+#include <memory>
 
 #include "gtest/gtest.h"
 
@@ -81,3 +84,119 @@ GTEST_TEST(Blowfish, misalign) {
 
 	EXPECT_THROW(Common::decryptBlowfishEBC(cipherText, key), Common::Exception);
 }
+
+GTEST_TEST(Blowfish, encryptInPlace) {
+	std::vector<byte> key;
+	createKey(key);
+
+	byte data[ARRAYSIZE(kCypherText)] = { 0 };
+	std::memcpy(data, kClearText, ARRAYSIZE(kClearText));
+
+	const Common::Blowfish blowfish(key);
+	blowfish.encrypt(data, sizeof(data));
+
+	for (size_t i = 0; i < ARRAYSIZE(kCypherText); i++)
+		EXPECT_EQ(data[i], kCypherText[i]) << "At index " << i;
+}
+
+GTEST_TEST(Blowfish, decryptInPlace) {
+	std::vector<byte> key;
+	createKey(key);
+
+	byte data[ARRAYSIZE(kCypherText)];
+	std::memcpy(data, kCypherText, ARRAYSIZE(kCypherText));
+
+	const Common::Blowfish blowfish(key);
+
+	// Decrypting block by block with the same context gives the same result
+	for (size_t i = 0; i < sizeof(data); i += Common::Blowfish::kBlockSize)
+		blowfish.decrypt(data + i, Common::Blowfish::kBlockSize);
+
+	for (size_t i = 0; i < ARRAYSIZE(kClearText); i++)
+		EXPECT_EQ(data[i], kClearText[i]) << "At index " << i;
+}
+
+GTEST_TEST(Blowfish, misalignInPlace) {
+	std::vector<byte> key;
+	createKey(key);
+
+	byte data[ARRAYSIZE(kCypherText)];
+	std::memcpy(data, kCypherText, ARRAYSIZE(kCypherText));
+
+	const Common::Blowfish blowfish(key);
+
+	EXPECT_THROW(blowfish.decrypt(data, 7), Common::Exception);
+}
+
+static void createLargeBuffer(std::vector<byte> &data, size_t size) {
+	data.resize(size);
+
+	uint32 x = 0x12345678;
+	for (size_t i = 0; i < size; i++) {
+		x = x * 1103515245 + 12345;
+		data[i] = x >> 24;
+	}
+}
+
+GTEST_TEST(Blowfish, encryptLarge) {
+	std::vector<byte> key;
+	createKey(key);
+
+	// Not a multiple of the number of blocks processed at once
+	std::vector<byte> clearText;
+	createLargeBuffer(clearText, 8 * 1027);
+
+	const Common::Blowfish blowfish(key);
+
+	std::vector<byte> bulk = clearText;
+	blowfish.encrypt(bulk.data(), bulk.size());
+
+	std::vector<byte> single = clearText;
+	for (size_t i = 0; i < single.size(); i += Common::Blowfish::kBlockSize)
+		blowfish.encrypt(single.data() + i, Common::Blowfish::kBlockSize);
+
+	for (size_t i = 0; i < bulk.size(); i++)
+		ASSERT_EQ(bulk[i], single[i]) << "At index " << i;
+}
+
+GTEST_TEST(Blowfish, decryptLarge) {
+	std::vector<byte> key;
+	createKey(key);
+
+	std::vector<byte> clearText;
+	createLargeBuffer(clearText, 8 * 1027);
+
+	const Common::Blowfish blowfish(key);
+
+	std::vector<byte> data = clearText;
+	blowfish.encrypt(data.data(), data.size());
+
+	std::vector<byte> single = data;
+	for (size_t i = 0; i < single.size(); i += Common::Blowfish::kBlockSize)
+		blowfish.decrypt(single.data() + i, Common::Blowfish::kBlockSize);
+
+	blowfish.decrypt(data.data(), data.size());
+
+	for (size_t i = 0; i < data.size(); i++) {
+		ASSERT_EQ(data[i]  , clearText[i]) << "At index " << i;
+		ASSERT_EQ(single[i], clearText[i]) << "At index " << i;
+	}
+}
+
+GTEST_TEST(Blowfish, decryptLargeStream) {
+	std::vector<byte> key;
+	createKey(key);
+
+	std::vector<byte> clearText;
+	createLargeBuffer(clearText, 8 * 1027);
+
+	Common::MemoryReadStream clearStream(clearText.data(), clearText.size());
+	std::unique_ptr<Common::MemoryReadStream> cipherText(Common::encryptBlowfishEBC(clearStream, key));
+	ASSERT_EQ(cipherText->size(), clearText.size());
+
+	std::unique_ptr<Common::MemoryReadStream> decrypted(Common::decryptBlowfishEBC(*cipherText, key));
+	ASSERT_EQ(decrypted->size(), clearText.size());
+
+	for (size_t i = 0; i < clearText.size(); i++)
+		ASSERT_EQ(decrypted->readByte(), clearText[i]) << "At index " << i;
+}
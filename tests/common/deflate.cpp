@@ -19,11 +19,14 @@
  */
 
 /** @file
- *  Unit tests for our DEFLATE decompressor (which uses zlib).
+ *  Unit tests for our DEFLATE compressor and decompressor (which use zlib).
  */
 
+#include <memory>
+
 #include "gtest/gtest.h"
 
+#include "src/common/util.h"
 #include "src/common/deflate.h"
 #include "src/common/memreadstream.h"
 #include "src/common/error.h"
@@ -266,3 +269,88 @@ GTEST_TEST(DEFLATE, decompressChunked) {
 
 	delete[] output;
 }
+
+GTEST_TEST(DEFLATE, decompressBlocks) {
+	static const size_t kSizeCompressed   = sizeof(kDataCompressed);
+	static const size_t kSizeDecompressed = strlen(kDataUncompressed);
+
+	std::unique_ptr<byte[]> decompressed = std::make_unique<byte[]>(kSizeDecompressed);
+
+	Common::BlockInflater inflater(Common::kWindowBitsMaxRaw, decompressed.get(), kSizeDecompressed);
+
+	// Feed the input in small, odd-sized blocks
+	bool ended = false;
+	for (size_t i = 0; (i < kSizeCompressed) && !ended; i += 7)
+		ended = inflater.inflate(kDataCompressed + i, MIN<size_t>(7, kSizeCompressed - i));
+
+	EXPECT_TRUE(ended);
+	EXPECT_NO_THROW(inflater.finish());
+
+	for (size_t i = 0; i < kSizeDecompressed; i++)
+		EXPECT_EQ(decompressed[i], kDataUncompressed[i]) << "At index " << i;
+}
+
+GTEST_TEST(DEFLATE, decompressBlocksFailInputCut) {
+	static const size_t kSizeCompressed   = sizeof(kDataCompressed) / 2;
+	static const size_t kSizeDecompressed = strlen(kDataUncompressed);
+
+	std::unique_ptr<byte[]> decompressed = std::make_unique<byte[]>(kSizeDecompressed);
+
+	Common::BlockInflater inflater(Common::kWindowBitsMaxRaw, decompressed.get(), kSizeDecompressed);
+
+	EXPECT_FALSE(inflater.inflate(kDataCompressed, kSizeCompressed));
+	EXPECT_THROW(inflater.finish(), Common::Exception);
+}
+
+GTEST_TEST(DEFLATE, decompressBlocksFailOutputSmall) {
+	static const size_t kSizeCompressed   = sizeof(kDataCompressed);
+	static const size_t kSizeDecompressed = strlen(kDataUncompressed) / 2;
+
+	std::unique_ptr<byte[]> decompressed = std::make_unique<byte[]>(kSizeDecompressed);
+
+	Common::BlockInflater inflater(Common::kWindowBitsMaxRaw, decompressed.get(), kSizeDecompressed);
+
+	EXPECT_FALSE(inflater.inflate(kDataCompressed, kSizeCompressed));
+	EXPECT_THROW(inflater.finish(), Common::Exception);
+}
+
+static void testCompressRoundTrip(int windowBits, int level) {
+	const byte  *data = reinterpret_cast<const byte *>(kDataUncompressed);
+	const size_t size = strlen(kDataUncompressed);
+
+	size_t compressedSize = 0;
+	std::unique_ptr<byte[]> compressed(Common::compressDeflate(data, size, compressedSize, windowBits, level));
+
+	ASSERT_NE(compressed.get(), static_cast<const byte *>(0));
+	ASSERT_GT(compressedSize, 0);
+
+	if (level == Common::kCompressionLevelNone)
+		EXPECT_GT(compressedSize, size);
+	else
+		EXPECT_LT(compressedSize, size);
+
+	std::unique_ptr<byte[]> decompressed(Common::decompressDeflate(compressed.get(), compressedSize, size, windowBits));
+
+	for (size_t i = 0; i < size; i++)
+		EXPECT_EQ(decompressed[i], data[i]) << "At index " << i;
+}
+
+GTEST_TEST(DEFLATE, compressRaw) {
+	testCompressRoundTrip(Common::kWindowBitsMaxRaw, Common::kCompressionLevelDefault);
+}
+
+GTEST_TEST(DEFLATE, compressZlib) {
+	testCompressRoundTrip(Common::kWindowBitsMax, Common::kCompressionLevelDefault);
+}
+
+GTEST_TEST(DEFLATE, compressBest) {
+	testCompressRoundTrip(Common::kWindowBitsMaxRaw, Common::kCompressionLevelBest);
+}
+
+GTEST_TEST(DEFLATE, compressStore) {
+	testCompressRoundTrip(Common::kWindowBitsMaxRaw, Common::kCompressionLevelNone);
+}
+
+GTEST_TEST(DEFLATE, compressSmallWindow) {
+	testCompressRoundTrip(-9, Common::kCompressionLevelDefault);
+}
@@ -0,0 +1,122 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for our (I)FFT and (I)MDCT, comparing the SIMD against the generic code paths.
+ */
+
+#include <memory>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "src/common/maths.h"
+#include "src/common/cpu.h"
+#include "src/common/fft.h"
+#include "src/common/mdct.h"
+
+/** Deterministic pseudo-random floats in [-1.0, 1.0]. */
+static void fillRandom(float *data, size_t count, uint32 seed) {
+	for (size_t i = 0; i < count; i++) {
+		seed = seed * 1664525 + 1013904223;
+
+		data[i] = ((seed >> 8) / (float) 0x7FFFFF) - 1.0f;
+	}
+}
+
+/** Disable or re-enable all SIMD code paths. */
+static void setSIMD(bool enabled) {
+	Common::setCPUFeatureEnabled(Common::kCPUFeatureSSE2, enabled);
+	Common::setCPUFeatureEnabled(Common::kCPUFeatureAVX , enabled);
+}
+
+static void testFFT(int bits, bool inverse) {
+	const size_t n = 1 << bits;
+
+	std::vector<Common::Complex> generic(n), simd(n);
+	fillRandom(&generic[0].re, 2 * n, bits);
+
+	simd = generic;
+
+	setSIMD(false);
+	Common::FFT fftGeneric(bits, inverse);
+
+	setSIMD(true);
+	Common::FFT fftSIMD(bits, inverse);
+
+	fftGeneric.permute(&generic[0]);
+	fftGeneric.calc(&generic[0]);
+
+	fftSIMD.permute(&simd[0]);
+	fftSIMD.calc(&simd[0]);
+
+	for (size_t i = 0; i < n; i++) {
+		EXPECT_FLOAT_EQ(simd[i].re, generic[i].re) << "At bits " << bits << ", index " << i;
+		EXPECT_FLOAT_EQ(simd[i].im, generic[i].im) << "At bits " << bits << ", index " << i;
+	}
+}
+
+static void testIMDCT(int bits) {
+	const size_t n = 1 << bits;
+
+	std::vector<float> input(n / 2), generic(n), simd(n);
+	fillRandom(&input[0], n / 2, bits);
+
+	setSIMD(false);
+	Common::MDCT mdctGeneric(bits, true, 1.0);
+
+	setSIMD(true);
+	Common::MDCT mdctSIMD(bits, true, 1.0);
+
+	mdctGeneric.calcIMDCT(&generic[0], &input[0]);
+	mdctSIMD.calcIMDCT(&simd[0], &input[0]);
+
+	for (size_t i = 0; i < n; i++)
+		EXPECT_FLOAT_EQ(simd[i], generic[i]) << "At bits " << bits << ", index " << i;
+}
+
+GTEST_TEST(FFT, calcSIMD) {
+	for (int bits = 2; bits <= 12; bits++) {
+		testFFT(bits, false);
+		testFFT(bits, true);
+	}
+}
+
+GTEST_TEST(FFT, calcKnown) {
+	// The FFT of a unit impulse is flat
+	std::vector<Common::Complex> data(16);
+	data[0].re = 1.0f;
+
+	Common::FFT fft(4, false);
+
+	fft.permute(&data[0]);
+	fft.calc(&data[0]);
+
+	for (size_t i = 0; i < data.size(); i++) {
+		EXPECT_FLOAT_EQ(data[i].re, 1.0f) << "At index " << i;
+		EXPECT_NEAR(data[i].im, 0.0f, 1e-6) << "At index " << i;
+	}
+}
+
+GTEST_TEST(MDCT, calcIMDCTSIMD) {
+	// The WMA decoder uses sizes from 2^7 to 2^12
+	for (int bits = 4; bits <= 12; bits++)
+		testIMDCT(bits);
+}
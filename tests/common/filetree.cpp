@@ -0,0 +1,164 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for the FileTree class.
+ */
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+
+#include "gtest/gtest.h"
+
+#include "src/common/util.h"
+#include "src/common/platform.h"
+#include "src/common/filepath.h"
+#include "src/common/filetree.h"
+
+boost::filesystem::path kDirectoryPath;
+
+static void writeFile(const boost::filesystem::path &path, const char *data) {
+	boost::filesystem::ofstream file(path, std::ofstream::binary);
+	file << data;
+}
+
+class FileTree: public ::testing::Test {
+protected:
+	void SetUp() {
+		Common::Platform::init();
+
+		kDirectoryPath = boost::filesystem::temp_directory_path() /
+		                 boost::filesystem::unique_path("%%%%_%%%%_%%%%_%%%%.xoreos");
+
+		kDirectoryPath = Common::FilePath::normalize(kDirectoryPath.generic_string()).c_str();
+
+		boost::filesystem::create_directories(kDirectoryPath / "override");
+
+		writeFile(kDirectoryPath / "chitin.key", "KEY");
+		writeFile(kDirectoryPath / "override" / "foo.tga", "Foobar");
+	}
+
+	void TearDown() {
+		if (!kDirectoryPath.empty())
+			boost::filesystem::remove_all(kDirectoryPath);
+	}
+};
+
+GTEST_TEST_F(FileTree, readPath) {
+	Common::FileTree tree;
+	tree.readPath(kDirectoryPath, -1);
+
+	const Common::FileTree::Entry &root = tree.getRoot();
+	EXPECT_TRUE(root.isDirectory());
+	EXPECT_EQ(root.children.size(), 2);
+
+	const Common::FileTree::Entry *key = tree.findEntry(kDirectoryPath / "chitin.key");
+	ASSERT_NE(key, static_cast<const Common::FileTree::Entry *>(0));
+	EXPECT_FALSE(key->isDirectory());
+	EXPECT_EQ(key->size, 3);
+
+	const Common::FileTree::Entry *override = tree.findEntry(kDirectoryPath / "override");
+	ASSERT_NE(override, static_cast<const Common::FileTree::Entry *>(0));
+	EXPECT_TRUE(override->isDirectory());
+	EXPECT_EQ(override->size, Common::kFileInvalid);
+	EXPECT_EQ(override->children.size(), 1);
+
+	EXPECT_EQ(tree.findEntry(kDirectoryPath / "nope"), static_cast<const Common::FileTree::Entry *>(0));
+	EXPECT_EQ(tree.findEntry(kDirectoryPath.parent_path()), static_cast<const Common::FileTree::Entry *>(0));
+}
+
+GTEST_TEST_F(FileTree, addEntry) {
+	Common::FileTree tree;
+	tree.readPath(kDirectoryPath, -1);
+
+	boost::filesystem::create_directories(kDirectoryPath / "modules");
+	writeFile(kDirectoryPath / "modules" / "foo.mod", "MOD V1.0");
+
+	const Common::FileTree::Entry *modules = tree.addEntry(kDirectoryPath / "modules");
+	ASSERT_NE(modules, static_cast<const Common::FileTree::Entry *>(0));
+	EXPECT_TRUE(modules->isDirectory());
+	ASSERT_EQ(modules->children.size(), 1);
+	EXPECT_EQ(modules->children.front().size, 8);
+
+	EXPECT_EQ(tree.getRoot().children.size(), 3);
+
+	writeFile(kDirectoryPath / "override" / "bar.tga", "Bar");
+
+	const Common::FileTree::Entry *bar = tree.addEntry(kDirectoryPath / "override" / "bar.tga");
+	ASSERT_NE(bar, static_cast<const Common::FileTree::Entry *>(0));
+	EXPECT_EQ(bar->size, 3);
+
+	EXPECT_EQ(tree.findEntry(kDirectoryPath / "override")->children.size(), 2);
+
+	EXPECT_EQ(tree.addEntry(kDirectoryPath / "nope" / "bar.tga"), static_cast<const Common::FileTree::Entry *>(0));
+}
+
+GTEST_TEST_F(FileTree, removeEntry) {
+	Common::FileTree tree;
+	tree.readPath(kDirectoryPath, -1);
+
+	EXPECT_TRUE(tree.removeEntry(kDirectoryPath / "override"));
+	EXPECT_FALSE(tree.removeEntry(kDirectoryPath / "override"));
+
+	EXPECT_EQ(tree.getRoot().children.size(), 1);
+	EXPECT_EQ(tree.findEntry(kDirectoryPath / "override" / "foo.tga"), static_cast<const Common::FileTree::Entry *>(0));
+}
+
+GTEST_TEST_F(FileTree, updateEntry) {
+	Common::FileTree tree;
+	tree.readPath(kDirectoryPath, -1);
+
+	writeFile(kDirectoryPath / "override" / "foo.tga", "Foobar and more");
+
+	const Common::FileTree::Entry *foo = tree.updateEntry(kDirectoryPath / "override" / "foo.tga");
+	ASSERT_NE(foo, static_cast<const Common::FileTree::Entry *>(0));
+	EXPECT_EQ(foo->size, 15);
+}
+
+GTEST_TEST_F(FileTree, addEntryRenamedOver) {
+	Common::FileTree tree;
+	tree.readPath(kDirectoryPath, -1);
+
+	// Saving atomically writes a new file and renames it over the old one
+	writeFile(kDirectoryPath / "override" / "foo.tga.tmp", "Foobar and more");
+	boost::filesystem::rename(kDirectoryPath / "override" / "foo.tga.tmp", kDirectoryPath / "override" / "foo.tga");
+
+	const Common::FileTree::Entry *foo = tree.addEntry(kDirectoryPath / "override" / "foo.tga");
+	ASSERT_NE(foo, static_cast<const Common::FileTree::Entry *>(0));
+	EXPECT_EQ(foo->size, 15);
+
+	EXPECT_EQ(tree.findEntry(kDirectoryPath / "override")->children.size(), 1);
+
+	// Moving a directory over an empty one replaces its contents
+	boost::filesystem::create_directories(kDirectoryPath / "modules");
+	tree.addEntry(kDirectoryPath / "modules");
+
+	boost::filesystem::create_directories(kDirectoryPath / "modules.tmp");
+	writeFile(kDirectoryPath / "modules.tmp" / "foo.mod", "MOD V1.0");
+	boost::filesystem::remove(kDirectoryPath / "modules");
+	boost::filesystem::rename(kDirectoryPath / "modules.tmp", kDirectoryPath / "modules");
+
+	const Common::FileTree::Entry *modules = tree.addEntry(kDirectoryPath / "modules");
+	ASSERT_NE(modules, static_cast<const Common::FileTree::Entry *>(0));
+	ASSERT_EQ(modules->children.size(), 1);
+	EXPECT_EQ(modules->children.front().size, 8);
+
+	EXPECT_EQ(tree.getRoot().children.size(), 3);
+}
@@ -0,0 +1,141 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for the FileWatcher class.
+ */
+
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+
+#include "gtest/gtest.h"
+
+#include "src/common/util.h"
+#include "src/common/platform.h"
+#include "src/common/filewatcher.h"
+
+boost::filesystem::path kDirectoryPath;
+
+static void writeFile(const boost::filesystem::path &path, const char *data) {
+	boost::filesystem::ofstream file(path, std::ofstream::binary);
+	file << data;
+}
+
+static bool hasEvent(const std::vector<Common::FileWatcher::Event> &events,
+                     Common::FileWatcher::EventType type, const boost::filesystem::path &path) {
+
+	for (std::vector<Common::FileWatcher::Event>::const_iterator e = events.begin(); e != events.end(); ++e)
+		if ((e->type == type) && (e->path == path.generic_string()))
+			return true;
+
+	return false;
+}
+
+class FileWatcher: public ::testing::Test {
+protected:
+	void SetUp() {
+		Common::Platform::init();
+
+		kDirectoryPath = boost::filesystem::temp_directory_path() /
+		                 boost::filesystem::unique_path("%%%%_%%%%_%%%%_%%%%.xoreos");
+
+		boost::filesystem::create_directories(kDirectoryPath / "override");
+	}
+
+	void TearDown() {
+		if (!kDirectoryPath.empty())
+			boost::filesystem::remove_all(kDirectoryPath);
+	}
+};
+
+GTEST_TEST_F(FileWatcher, events) {
+	if (!Common::FileWatcher::isSupported())
+		return;
+
+	Common::FileWatcher watcher;
+	watcher.watch(kDirectoryPath.generic_string());
+
+	EXPECT_TRUE(watcher.isWatching());
+
+	writeFile(kDirectoryPath / "override" / "foo.tga", "Foobar");
+	boost::filesystem::remove(kDirectoryPath / "override" / "foo.tga");
+
+	std::vector<Common::FileWatcher::Event> events;
+	watcher.getEvents(events);
+
+	EXPECT_TRUE(hasEvent(events, Common::FileWatcher::kEventCreated , kDirectoryPath / "override" / "foo.tga"));
+	EXPECT_TRUE(hasEvent(events, Common::FileWatcher::kEventModified, kDirectoryPath / "override" / "foo.tga"));
+	EXPECT_TRUE(hasEvent(events, Common::FileWatcher::kEventRemoved , kDirectoryPath / "override" / "foo.tga"));
+
+	events.clear();
+	watcher.getEvents(events);
+
+	EXPECT_TRUE(events.empty());
+}
+
+GTEST_TEST_F(FileWatcher, renamedOver) {
+	if (!Common::FileWatcher::isSupported())
+		return;
+
+	writeFile(kDirectoryPath / "override" / "foo.tga", "Foobar");
+
+	Common::FileWatcher watcher;
+	watcher.watch(kDirectoryPath.generic_string());
+
+	// Saving atomically writes a new file and renames it over the old one
+	writeFile(kDirectoryPath / "override" / "foo.tga.tmp", "Foobar and more");
+	boost::filesystem::rename(kDirectoryPath / "override" / "foo.tga.tmp", kDirectoryPath / "override" / "foo.tga");
+
+	std::vector<Common::FileWatcher::Event> events;
+	watcher.getEvents(events);
+
+	EXPECT_TRUE(hasEvent(events, Common::FileWatcher::kEventRemoved, kDirectoryPath / "override" / "foo.tga.tmp"));
+	EXPECT_TRUE(hasEvent(events, Common::FileWatcher::kEventCreated, kDirectoryPath / "override" / "foo.tga"));
+	EXPECT_FALSE(hasEvent(events, Common::FileWatcher::kEventRemoved, kDirectoryPath / "override" / "foo.tga"));
+}
+
+GTEST_TEST_F(FileWatcher, newDirectories) {
+	if (!Common::FileWatcher::isSupported())
+		return;
+
+	Common::FileWatcher watcher;
+	watcher.watch(kDirectoryPath.generic_string());
+
+	boost::filesystem::create_directories(kDirectoryPath / "modules");
+
+	// Collecting the events starts watching the new directory
+	std::vector<Common::FileWatcher::Event> events;
+	watcher.getEvents(events);
+
+	ASSERT_TRUE(hasEvent(events, Common::FileWatcher::kEventCreated, kDirectoryPath / "modules"));
+	EXPECT_TRUE(events.back().directory);
+
+	writeFile(kDirectoryPath / "modules" / "foo.mod", "MOD V1.0");
+
+	events.clear();
+	watcher.getEvents(events);
+
+	EXPECT_TRUE(hasEvent(events, Common::FileWatcher::kEventModified, kDirectoryPath / "modules" / "foo.mod"));
+
+	watcher.clear();
+	EXPECT_FALSE(watcher.isWatching());
+}
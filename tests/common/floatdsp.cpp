@@ -0,0 +1,120 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for our float vector operations, comparing the SIMD against the generic code paths.
+ */
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "src/common/types.h"
+#include "src/common/cpu.h"
+#include "src/common/floatdsp.h"
+
+// Not a multiple of any vector size, to also exercise the tail handling
+static const int kLength = 1027;
+
+static std::vector<float> createRandom(uint32 seed) {
+	std::vector<float> data(kLength);
+
+	for (size_t i = 0; i < data.size(); i++) {
+		seed = seed * 1664525 + 1013904223;
+
+		data[i] = ((seed >> 8) / (float) 0x7FFFFF) - 1.0f;
+	}
+
+	return data;
+}
+
+/** Run a test function once for every code path: generic, SSE2 and AVX. */
+template<typename F>
+static void compareCodePaths(F func) {
+	Common::setCPUFeatureEnabled(Common::kCPUFeatureSSE2, false);
+	Common::setCPUFeatureEnabled(Common::kCPUFeatureAVX , false);
+	const std::vector<float> generic = func();
+
+	Common::setCPUFeatureEnabled(Common::kCPUFeatureSSE2, true);
+	const std::vector<float> sse2 = func();
+
+	Common::setCPUFeatureEnabled(Common::kCPUFeatureAVX , true);
+	const std::vector<float> avx = func();
+
+	ASSERT_EQ(generic.size(), sse2.size());
+	ASSERT_EQ(generic.size(), avx.size());
+
+	for (size_t i = 0; i < generic.size(); i++) {
+		EXPECT_FLOAT_EQ(sse2[i], generic[i]) << "At index " << i;
+		EXPECT_FLOAT_EQ(avx [i], generic[i]) << "At index " << i;
+	}
+}
+
+GTEST_TEST(FloatDSP, vectorFMulAdd) {
+	const std::vector<float> src0 = createRandom(1), src1 = createRandom(2), src2 = createRandom(3);
+
+	std::vector<float> dst(kLength);
+	Common::vectorFMulAdd(&dst[0], &src0[0], &src1[0], &src2[0], kLength);
+
+	for (int i = 0; i < kLength; i++)
+		EXPECT_FLOAT_EQ(dst[i], src0[i] * src1[i] + src2[i]) << "At index " << i;
+
+	compareCodePaths([&]() {
+		std::vector<float> out(kLength);
+		Common::vectorFMulAdd(&out[0], &src0[0], &src1[0], &src2[0], kLength);
+		return out;
+	});
+}
+
+GTEST_TEST(FloatDSP, vectorFMulAddInPlace) {
+	const std::vector<float> src0 = createRandom(1), src1 = createRandom(2);
+
+	compareCodePaths([&]() {
+		std::vector<float> dst = createRandom(3);
+		Common::vectorFMulAdd(&dst[0], &src0[0], &src1[0], &dst[0], kLength);
+		return dst;
+	});
+}
+
+GTEST_TEST(FloatDSP, vectorFMulReverse) {
+	const std::vector<float> src0 = createRandom(4), src1 = createRandom(5);
+
+	std::vector<float> dst(kLength);
+	Common::vectorFMulReverse(&dst[0], &src0[0], &src1[0], kLength);
+
+	for (int i = 0; i < kLength; i++)
+		EXPECT_FLOAT_EQ(dst[i], src0[i] * src1[kLength - 1 - i]) << "At index " << i;
+
+	compareCodePaths([&]() {
+		std::vector<float> out(kLength);
+		Common::vectorFMulReverse(&out[0], &src0[0], &src1[0], kLength);
+		return out;
+	});
+}
+
+GTEST_TEST(FloatDSP, butterflyFloats) {
+	compareCodePaths([&]() {
+		std::vector<float> v1 = createRandom(6), v2 = createRandom(7);
+		Common::butterflyFloats(&v1[0], &v2[0], kLength);
+
+		v1.insert(v1.end(), v2.begin(), v2.end());
+		return v1;
+	});
+}
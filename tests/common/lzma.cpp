@@ -22,6 +22,8 @@
  *  Unit tests for our LZMA decompressor (which uses lzma).
  */
 
+#include <vector>
+
 #include "gtest/gtest.h"
 
 #include "src/common/lzma.h"
@@ -132,3 +134,87 @@ GTEST_TEST(LZMA1, decompressFailInputCut) {
 	EXPECT_THROW(Common::decompressLZMA1(kDataCompressed, kSizeCompressed, kSizeDecompressed),
 	             Common::Exception);
 }
+
+GTEST_TEST(LZMA1, readStream) {
+	static const size_t kSizeCompressed   = sizeof(kDataCompressed);
+	static const size_t kSizeDecompressed = strlen(kDataUncompressed);
+
+	Common::LZMA1ReadStream decompressed(new Common::MemoryReadStream(kDataCompressed),
+	                                     kSizeCompressed, kSizeDecompressed);
+
+	ASSERT_EQ(decompressed.size(), kSizeDecompressed);
+
+	for (size_t i = 0; i < kSizeDecompressed; i++)
+		EXPECT_EQ(decompressed.readByte(), kDataUncompressed[i]) << "At index " << i;
+
+	EXPECT_FALSE(decompressed.eos());
+
+	byte buffer[4];
+	EXPECT_EQ(decompressed.read(buffer, sizeof(buffer)), 0);
+	EXPECT_TRUE(decompressed.eos());
+}
+
+GTEST_TEST(LZMA1, readStreamSeek) {
+	static const size_t kSizeCompressed   = sizeof(kDataCompressed);
+	static const size_t kSizeDecompressed = strlen(kDataUncompressed);
+
+	Common::LZMA1ReadStream decompressed(new Common::MemoryReadStream(kDataCompressed),
+	                                     kSizeCompressed, kSizeDecompressed);
+
+	// Forward
+	decompressed.seek(100);
+	EXPECT_EQ(decompressed.pos(), 100);
+	EXPECT_EQ(decompressed.readByte(), kDataUncompressed[100]);
+
+	// Backward
+	decompressed.seek(10);
+	EXPECT_EQ(decompressed.pos(), 10);
+	EXPECT_EQ(decompressed.readByte(), kDataUncompressed[10]);
+
+	decompressed.seek(-1, Common::SeekableReadStream::kOriginEnd);
+	EXPECT_EQ(decompressed.readByte(), kDataUncompressed[kSizeDecompressed - 1]);
+
+	EXPECT_THROW(decompressed.seek(kSizeDecompressed + 1), Common::Exception);
+}
+
+GTEST_TEST(LZMA1, readStreamSubStream) {
+	static const size_t kSizeCompressed   = sizeof(kDataCompressed);
+	static const size_t kSizeDecompressed = strlen(kDataUncompressed);
+
+	// The compressed data somewhere within a larger stream
+	std::vector<byte> data(16, 0xFF);
+	data.insert(data.end(), kDataCompressed, kDataCompressed + kSizeCompressed);
+	data.insert(data.end(), 16, 0xFF);
+
+	Common::MemoryReadStream parent(data.data(), data.size());
+	Common::LZMA1ReadStream decompressed(new Common::SeekableSubReadStream(&parent, 16, 16 + kSizeCompressed),
+	                                     kSizeCompressed, kSizeDecompressed);
+
+	// Someone else moving the parent stream doesn't matter
+	parent.seek(0);
+
+	for (size_t i = 0; i < kSizeDecompressed; i++)
+		EXPECT_EQ(decompressed.readByte(), kDataUncompressed[i]) << "At index " << i;
+}
+
+GTEST_TEST(LZMA1, readStreamFailOutputBig) {
+	static const size_t kSizeCompressed   = sizeof(kDataCompressed);
+	static const size_t kSizeDecompressed = strlen(kDataUncompressed) * 2;
+
+	Common::LZMA1ReadStream decompressed(new Common::MemoryReadStream(kDataCompressed),
+	                                     kSizeCompressed, kSizeDecompressed);
+
+	std::vector<byte> buffer(kSizeDecompressed);
+	EXPECT_THROW(decompressed.read(buffer.data(), buffer.size()), Common::Exception);
+}
+
+GTEST_TEST(LZMA1, readStreamFailInputCut) {
+	static const size_t kSizeCompressed   = sizeof(kDataCompressed) / 2;
+	static const size_t kSizeDecompressed = strlen(kDataUncompressed);
+
+	Common::LZMA1ReadStream decompressed(new Common::MemoryReadStream(kDataCompressed, kSizeCompressed),
+	                                     kSizeCompressed, kSizeDecompressed);
+
+	std::vector<byte> buffer(kSizeDecompressed);
+	EXPECT_THROW(decompressed.read(buffer.data(), buffer.size()), Common::Exception);
+}
@@ -28,8 +28,11 @@
 
 #include "gtest/gtest.h"
 
+#include "src/common/util.h"
+#include "src/common/error.h"
 #include "src/common/md5.h"
 #include "src/common/ustring.h"
+#include "src/common/readstream.h"
 #include "src/common/memreadstream.h"
 
 static const char *kString = "Foobar";
@@ -122,3 +125,145 @@ GTEST_TEST(MD5, compareVector) {
 
 	EXPECT_TRUE(Common::compareMD5Digest(data, digest));
 }
+
+/** Generate some data of this size that doesn't repeat every block. */
+static void createData(std::vector<byte> &data, size_t size, uint32 seed) {
+	data.resize(size);
+
+	for (size_t i = 0; i < size; i++) {
+		seed = seed * 1103515245 + 12345;
+		data[i] = seed >> 16;
+	}
+}
+
+GTEST_TEST(MD5, hashStreamUnbuffered) {
+	std::vector<byte> data;
+	createData(data, 200 * 1024 + 13, 0);
+
+	std::vector<byte> expected;
+	Common::hashMD5(data, expected);
+
+	// Not a MemoryReadStream, so this has to be read into a buffer
+	Common::MemoryReadStream memStream(&data[0], data.size());
+	Common::SeekableSubReadStream stream(&memStream, 0, memStream.size());
+
+	std::vector<byte> digest;
+	Common::hashMD5(stream, digest);
+
+	EXPECT_EQ(digest, expected);
+}
+
+GTEST_TEST(MD5, hashStreamPartial) {
+	std::vector<byte> data;
+	createData(data, 1000, 1);
+
+	std::vector<byte> expected;
+	Common::hashMD5(&data[100], data.size() - 100, expected);
+
+	Common::MemoryReadStream stream(&data[0], data.size());
+	stream.seek(100);
+
+	std::vector<byte> digest;
+	Common::hashMD5(stream, digest);
+
+	EXPECT_EQ(digest, expected);
+	EXPECT_EQ(stream.pos(), stream.size());
+}
+
+GTEST_TEST(MD5, hashMultiple) {
+	// Sizes around block and buffer boundaries, so that lanes run dry at different times
+	static const size_t kSizes[] = { 0, 1, 55, 56, 63, 64, 65, 128, 1000, 65535, 65536, 65537, 300000, 7 };
+
+	std::vector< std::vector<byte> > data(ARRAYSIZE(kSizes));
+	std::vector< std::vector<byte> > expected(ARRAYSIZE(kSizes));
+
+	for (size_t i = 0; i < ARRAYSIZE(kSizes); i++) {
+		createData(data[i], kSizes[i], i);
+		Common::hashMD5(data[i].data(), data[i].size(), expected[i]);
+	}
+
+	std::vector< std::vector<byte> > digests;
+
+	// Hashed in place
+	Common::hashMD5(ARRAYSIZE(kSizes), [&data](size_t i) {
+		return new Common::MemoryReadStream(data[i].data(), data[i].size());
+	}, digests);
+
+	ASSERT_EQ(digests.size(), ARRAYSIZE(kSizes));
+	for (size_t i = 0; i < ARRAYSIZE(kSizes); i++)
+		EXPECT_EQ(digests[i], expected[i]) << "At index " << i;
+
+	// Read into buffers
+	std::vector<Common::ReadStream *> streams;
+	for (size_t i = 0; i < ARRAYSIZE(kSizes); i++) {
+		Common::MemoryReadStream *memStream = new Common::MemoryReadStream(data[i].data(), data[i].size());
+		streams.push_back(new Common::SeekableSubReadStream(memStream, 0, data[i].size(), true));
+	}
+
+	Common::hashMD5(streams, digests);
+
+	ASSERT_EQ(digests.size(), ARRAYSIZE(kSizes));
+	for (size_t i = 0; i < ARRAYSIZE(kSizes); i++)
+		EXPECT_EQ(digests[i], expected[i]) << "At index " << i;
+
+	for (size_t i = 0; i < streams.size(); i++)
+		delete streams[i];
+}
+
+GTEST_TEST(MD5, hashMultipleOpenFail) {
+	std::vector< std::vector<byte> > digests;
+
+	Common::hashMD5(3, [](size_t i) -> Common::ReadStream * {
+		return (i == 1) ? 0 : new Common::MemoryReadStream(kData);
+	}, digests);
+
+	ASSERT_EQ(digests.size(), 3);
+
+	compareData(digests[0], kDigestData);
+	EXPECT_TRUE(digests[1].empty());
+	compareData(digests[2], kDigestData);
+}
+
+/** A stream of endless data that fails to read after a while. */
+class FailingReadStream : public Common::ReadStream {
+public:
+	FailingReadStream(size_t size) : _size(size) {
+	}
+
+	bool eos() const {
+		return false;
+	}
+
+	size_t read(void *dataPtr, size_t dataSize) {
+		if (dataSize > _size)
+			throw Common::Exception(Common::kReadError);
+
+		std::memset(dataPtr, 0, dataSize);
+		_size -= dataSize;
+
+		return dataSize;
+	}
+
+private:
+	size_t _size;
+};
+
+GTEST_TEST(MD5, hashMultipleReadFail) {
+	std::vector< std::vector<byte> > digests;
+
+	Common::hashMD5(6, [](size_t i) -> Common::ReadStream * {
+		if ((i % 2) == 1)
+			return new FailingReadStream(1000 * i);
+
+		return new Common::MemoryReadStream(kData);
+	}, digests);
+
+	ASSERT_EQ(digests.size(), 6);
+
+	for (size_t i = 0; i < 6; i++) {
+		if ((i % 2) == 1)
+			EXPECT_TRUE(digests[i].empty()) << "At index " << i;
+		else
+			compareData(digests[i], kDigestData);
+	}
+}
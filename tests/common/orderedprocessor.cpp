@@ -0,0 +1,125 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for our ordered parallel block processing.
+ */
+
+#include <vector>
+#include <atomic>
+#include <chrono>
+
+#include "gtest/gtest.h"
+
+#include "src/common/error.h"
+#include "src/common/thread.h"
+#include "src/common/orderedprocessor.h"
+
+static const size_t kBlockCount = 100;
+
+static void testOrder(size_t threadCount) {
+	std::vector<size_t> readOrder, writeOrder;
+
+	Common::processOrdered(kBlockCount, [&readOrder](size_t index, std::vector<byte> &data) {
+		readOrder.push_back(index);
+
+		data.assign(index + 1, index & 0xFF);
+
+	}, [](size_t index, std::vector<byte> &data) {
+		// Let later blocks overtake earlier ones
+		if ((index % 3) == 0)
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+		for (std::vector<byte>::iterator d = data.begin(); d != data.end(); ++d)
+			*d ^= 0xFF;
+
+	}, [&writeOrder](size_t index, std::vector<byte> &data) {
+		writeOrder.push_back(index);
+
+		ASSERT_EQ(data.size(), index + 1);
+		for (std::vector<byte>::const_iterator d = data.begin(); d != data.end(); ++d)
+			ASSERT_EQ(*d, (index & 0xFF) ^ 0xFF) << "At index " << index;
+
+	}, threadCount);
+
+	ASSERT_EQ(readOrder.size() , kBlockCount);
+	ASSERT_EQ(writeOrder.size(), kBlockCount);
+
+	for (size_t i = 0; i < kBlockCount; i++) {
+		EXPECT_EQ(readOrder[i] , i);
+		EXPECT_EQ(writeOrder[i], i);
+	}
+}
+
+GTEST_TEST(OrderedProcessor, singleThread) {
+	testOrder(1);
+}
+
+GTEST_TEST(OrderedProcessor, threads) {
+	testOrder(4);
+}
+
+GTEST_TEST(OrderedProcessor, boundedReadAhead) {
+	std::atomic<size_t> read(0), written(0), maxAhead(0);
+
+	Common::processOrdered(kBlockCount, [&](size_t UNUSED(index), std::vector<byte> &UNUSED(data)) {
+		read++;
+
+		const size_t ahead = read - written;
+		if (ahead > maxAhead)
+			maxAhead = ahead;
+
+	}, [](size_t UNUSED(index), std::vector<byte> &UNUSED(data)) {
+	}, [&](size_t UNUSED(index), std::vector<byte> &UNUSED(data)) {
+		written++;
+	}, 4);
+
+	EXPECT_EQ(read, kBlockCount);
+	EXPECT_EQ(written, kBlockCount);
+
+	// Never more than two blocks per thread in flight
+	EXPECT_LE(maxAhead, 8);
+}
+
+GTEST_TEST(OrderedProcessor, processFail) {
+	std::vector<size_t> written;
+
+	EXPECT_THROW(Common::processOrdered(kBlockCount, [](size_t UNUSED(index), std::vector<byte> &UNUSED(data)) {
+	}, [](size_t index, std::vector<byte> &UNUSED(data)) {
+		if (index == 42)
+			throw Common::Exception("Processing failed");
+	}, [&written](size_t index, std::vector<byte> &UNUSED(data)) {
+		written.push_back(index);
+	}, 4), Common::Exception);
+
+	// All blocks before the broken one have still been written
+	ASSERT_EQ(written.size(), 42);
+	for (size_t i = 0; i < written.size(); i++)
+		EXPECT_EQ(written[i], i);
+}
+
+GTEST_TEST(OrderedProcessor, readFail) {
+	EXPECT_THROW(Common::processOrdered(kBlockCount, [](size_t index, std::vector<byte> &UNUSED(data)) {
+		if (index == 23)
+			throw Common::Exception("Reading failed");
+	}, [](size_t UNUSED(index), std::vector<byte> &UNUSED(data)) {
+	}, [](size_t UNUSED(index), std::vector<byte> &UNUSED(data)) {
+	}, 4), Common::Exception);
+}
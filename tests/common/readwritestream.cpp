@@ -0,0 +1,89 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for our memory read/write stream.
+ */
+
+#include "gtest/gtest.h"
+
+#include "src/common/util.h"
+#include "src/common/error.h"
+#include "src/common/readwritestream.h"
+
+GTEST_TEST(MemoryReadWriteStream, readWrite) {
+	static const byte kData[4] = { 0x12, 0x34, 0x56, 0x78 };
+	Common::MemoryReadWriteStream stream(kData, ARRAYSIZE(kData));
+
+	EXPECT_EQ(stream.size(), 4);
+	EXPECT_EQ(stream.readUint16LE(), 0x3412);
+
+	// Writing continues at the current position
+	stream.writeByte(0x9A);
+	EXPECT_EQ(stream.pos(), 3);
+	EXPECT_EQ(stream.readByte(), 0x78);
+
+	stream.seek(0);
+	EXPECT_EQ(stream.readUint32BE(), 0x12349A78);
+
+	byte data;
+	EXPECT_FALSE(stream.eos());
+	EXPECT_EQ(stream.read(&data, 1), 0);
+	EXPECT_TRUE(stream.eos());
+}
+
+GTEST_TEST(MemoryReadWriteStream, extend) {
+	Common::MemoryReadWriteStream stream;
+
+	EXPECT_EQ(stream.size(), 0);
+
+	stream.writeUint32LE(0x78563412);
+	EXPECT_EQ(stream.size(), 4);
+
+	// Writing past the end extends the stream
+	stream.seek(2);
+	stream.writeUint32LE(0xDEADBEEF);
+	EXPECT_EQ(stream.size(), 6);
+
+	stream.seek(0);
+	EXPECT_EQ(stream.readUint16LE(), 0x3412);
+	EXPECT_EQ(stream.readUint32LE(), 0xDEADBEEF);
+
+	EXPECT_THROW(stream.seek(7), Common::Exception);
+}
+
+GTEST_TEST(MemoryReadWriteStream, truncate) {
+	static const byte kData[4] = { 0x12, 0x34, 0x56, 0x78 };
+	Common::MemoryReadWriteStream stream(kData, ARRAYSIZE(kData));
+
+	stream.seek(0, Common::SeekableReadStream::kOriginEnd);
+
+	stream.truncate(2);
+	EXPECT_EQ(stream.size(), 2);
+	EXPECT_EQ(stream.pos(), 2);
+
+	stream.truncate(3);
+	EXPECT_EQ(stream.size(), 3);
+
+	stream.seek(0);
+	EXPECT_EQ(stream.readByte(), 0x12);
+	EXPECT_EQ(stream.readByte(), 0x34);
+	EXPECT_EQ(stream.readByte(), 0x00);
+}
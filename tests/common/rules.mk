@@ -70,6 +70,11 @@ tests_common_test_memwritestream_SOURCES  = tests/common/memwritestream.cpp
 tests_common_test_memwritestream_LDADD    = $(common_LIBS)
 tests_common_test_memwritestream_CXXFLAGS = $(test_CXXFLAGS)
 
+check_PROGRAMS                            += tests/common/test_readwritestream
+tests_common_test_readwritestream_SOURCES  = tests/common/readwritestream.cpp
+tests_common_test_readwritestream_LDADD    = $(common_LIBS)
+tests_common_test_readwritestream_CXXFLAGS = $(test_CXXFLAGS)
+
 check_PROGRAMS                     += tests/common/test_readfile
 tests_common_test_readfile_SOURCES  = tests/common/readfile.cpp
 tests_common_test_readfile_LDADD    = $(common_LIBS)
@@ -167,6 +172,16 @@ tests_common_test_filelist_SOURCES  = tests/common/filelist.cpp
 tests_common_test_filelist_LDADD    = $(common_LIBS)
 tests_common_test_filelist_CXXFLAGS = $(test_CXXFLAGS)
 
+check_PROGRAMS                     += tests/common/test_filetree
+tests_common_test_filetree_SOURCES  = tests/common/filetree.cpp
+tests_common_test_filetree_LDADD    = $(common_LIBS)
+tests_common_test_filetree_CXXFLAGS = $(test_CXXFLAGS)
+
+check_PROGRAMS                        += tests/common/test_filewatcher
+tests_common_test_filewatcher_SOURCES  = tests/common/filewatcher.cpp
+tests_common_test_filewatcher_LDADD    = $(common_LIBS)
+tests_common_test_filewatcher_CXXFLAGS = $(test_CXXFLAGS)
+
 check_PROGRAMS                 += tests/common/test_hash
 tests_common_test_hash_SOURCES  = tests/common/hash.cpp
 tests_common_test_hash_LDADD    = $(common_LIBS)
@@ -177,6 +192,11 @@ tests_common_test_md5_SOURCES  = tests/common/md5.cpp
 tests_common_test_md5_LDADD    = $(common_LIBS)
 tests_common_test_md5_CXXFLAGS = $(test_CXXFLAGS)
 
+check_PROGRAMS                   += tests/common/test_xxhash
+tests_common_test_xxhash_SOURCES  = tests/common/xxhash.cpp
+tests_common_test_xxhash_LDADD    = $(common_LIBS)
+tests_common_test_xxhash_CXXFLAGS = $(test_CXXFLAGS)
+
 check_PROGRAMS                    += tests/common/test_deflate
 tests_common_test_deflate_SOURCES  = tests/common/deflate.cpp
 tests_common_test_deflate_LDADD    = $(common_LIBS)
@@ -187,6 +207,21 @@ tests_common_test_zipfile_SOURCES  = tests/common/zipfile.cpp
 tests_common_test_zipfile_LDADD    = $(common_LIBS)
 tests_common_test_zipfile_CXXFLAGS = $(test_CXXFLAGS)
 
+check_PROGRAMS                      += tests/common/test_zipwriter
+tests_common_test_zipwriter_SOURCES  = tests/common/zipwriter.cpp
+tests_common_test_zipwriter_LDADD    = $(common_LIBS)
+tests_common_test_zipwriter_CXXFLAGS = $(test_CXXFLAGS)
+
+check_PROGRAMS                             += tests/common/test_orderedprocessor
+tests_common_test_orderedprocessor_SOURCES  = tests/common/orderedprocessor.cpp
+tests_common_test_orderedprocessor_LDADD    = $(common_LIBS)
+tests_common_test_orderedprocessor_CXXFLAGS = $(test_CXXFLAGS)
+
+check_PROGRAMS                     += tests/common/test_thread
+tests_common_test_thread_SOURCES  = tests/common/thread.cpp
+tests_common_test_thread_LDADD    = $(common_LIBS)
+tests_common_test_thread_CXXFLAGS = $(test_CXXFLAGS)
+
 check_PROGRAMS                 += tests/common/test_lzma
 tests_common_test_lzma_SOURCES  = tests/common/lzma.cpp
 tests_common_test_lzma_LDADD    = $(common_LIBS)
@@ -196,3 +231,13 @@ check_PROGRAMS                  += tests/common/test_maths
 tests_common_test_maths_SOURCES  = tests/common/maths.cpp
 tests_common_test_maths_LDADD    = $(common_LIBS)
 tests_common_test_maths_CXXFLAGS = $(test_CXXFLAGS)
+
+check_PROGRAMS               += tests/common/test_fft
+tests_common_test_fft_SOURCES  = tests/common/fft.cpp
+tests_common_test_fft_LDADD    = $(common_LIBS)
+tests_common_test_fft_CXXFLAGS = $(test_CXXFLAGS)
+
+check_PROGRAMS                    += tests/common/test_floatdsp
+tests_common_test_floatdsp_SOURCES  = tests/common/floatdsp.cpp
+tests_common_test_floatdsp_LDADD    = $(common_LIBS)
+tests_common_test_floatdsp_CXXFLAGS = $(test_CXXFLAGS)
@@ -0,0 +1,85 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for our threading helpers.
+ */
+
+#include <vector>
+#include <atomic>
+
+#include "gtest/gtest.h"
+
+#include "src/common/error.h"
+#include "src/common/thread.h"
+
+GTEST_TEST(Thread, getThreadCount) {
+	EXPECT_GE(Common::getThreadCount(), 1);
+	EXPECT_EQ(Common::getThreadCount(3), 3);
+}
+
+GTEST_TEST(Thread, runThreads) {
+	std::vector<std::atomic<size_t> > calls(4);
+
+	Common::runThreads(calls.size(), [&calls](size_t thread) {
+		calls[thread]++;
+	});
+
+	for (size_t i = 0; i < calls.size(); i++)
+		EXPECT_EQ(calls[i], 1) << "At thread " << i;
+}
+
+GTEST_TEST(Thread, parallelFor) {
+	static const size_t kCount = 1000;
+
+	std::vector<std::atomic<size_t> > calls(kCount);
+	std::atomic<bool> badThread(false);
+
+	Common::parallelFor(kCount, [&](size_t index, size_t thread) {
+		if (thread >= 4)
+			badThread = true;
+
+		calls[index]++;
+	}, 4);
+
+	EXPECT_FALSE(badThread);
+
+	for (size_t i = 0; i < kCount; i++)
+		EXPECT_EQ(calls[i], 1) << "At index " << i;
+}
+
+GTEST_TEST(Thread, parallelForEmpty) {
+	Common::parallelFor(0, [](size_t UNUSED(index), size_t UNUSED(thread)) {
+		FAIL();
+	}, 4);
+}
+
+GTEST_TEST(Thread, parallelForException) {
+	EXPECT_THROW(Common::parallelFor(100, [](size_t index, size_t UNUSED(thread)) {
+		if (index == 23)
+			throw Common::Exception("Foobar");
+	}, 4), Common::Exception);
+
+	// Not only our own exceptions are passed on
+	EXPECT_THROW(Common::parallelFor(100, [](size_t index, size_t UNUSED(thread)) {
+		if (index == 42)
+			throw 42;
+	}, 4), int);
+}
@@ -0,0 +1,61 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for our xxHash64 implementation.
+ */
+
+#include <cstring>
+
+#include "gtest/gtest.h"
+
+#include "src/common/xxhash.h"
+#include "src/common/memreadstream.h"
+
+static const char *kString = "Foobar";
+
+static void createData(byte (&data)[100]) {
+	for (size_t i = 0; i < sizeof(data); i++)
+		data[i] = i;
+}
+
+GTEST_TEST(XXH64, hashEmpty) {
+	EXPECT_EQ(Common::hashXXH64(static_cast<const byte *>(0), 0), UINT64_C(0xEF46DB3751D8E999));
+}
+
+GTEST_TEST(XXH64, hashData) {
+	EXPECT_EQ(Common::hashXXH64(reinterpret_cast<const byte *>(kString), strlen(kString)),
+	          UINT64_C(0x9DE0B9C33B6693DF));
+
+	byte data[100];
+	createData(data);
+
+	EXPECT_EQ(Common::hashXXH64(data, sizeof(data)), UINT64_C(0x6AC1E58032166597));
+	EXPECT_EQ(Common::hashXXH64(data, sizeof(data), 42), UINT64_C(0x819D2B726001D507));
+}
+
+GTEST_TEST(XXH64, hashStream) {
+	byte data[100];
+	createData(data);
+
+	Common::MemoryReadStream stream(data);
+
+	EXPECT_EQ(Common::hashXXH64(stream), UINT64_C(0x6AC1E58032166597));
+}
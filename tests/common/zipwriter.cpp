@@ -0,0 +1,169 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for our ZIP file writer.
+ */
+
+#include <cstring>
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "src/common/zipwriter.h"
+#include "src/common/zipfile.h"
+#include "src/common/deflate.h"
+#include "src/common/memreadstream.h"
+#include "src/common/memwritestream.h"
+#include "src/common/strutil.h"
+#include "src/common/error.h"
+
+// Percy Bysshe Shelley's "Ozymandias"
+static const char *kData =
+	"I met a traveller from an antique land\n"
+	"Who said: Two vast and trunkless legs of stone\n"
+	"Stand in the desert. Near them, on the sand,\n"
+	"Half sunk, a shattered visage lies, whose frown,\n"
+	"And wrinkled lip, and sneer of cold command,\n"
+	"Tell that its sculptor well those passions read\n"
+	"Which yet survive, stamped on these lifeless things,\n"
+	"The hand that mocked them and the heart that fed:\n"
+	"And on the pedestal these words appear:\n"
+	"'My name is Ozymandias, king of kings:\n"
+	"Look on my works, ye Mighty, and despair!'\n"
+	"Nothing beside remains. Round the decay\n"
+	"Of that colossal wreck, boundless and bare\n"
+	"The lone and level sands stretch far away.";
+
+static Common::SeekableReadStream *createData(size_t index) {
+	// Make every file a bit different, and some of them a bit larger
+	Common::UString data = Common::composeString(index) + "\n";
+	for (size_t i = 0; i <= (index % 4); i++)
+		data += kData;
+
+	byte *buffer = new byte[data.size()];
+	std::memcpy(buffer, data.c_str(), data.size());
+
+	return new Common::MemoryReadStream(buffer, data.size(), true);
+}
+
+static Common::UString createName(size_t index) {
+	return Common::UString::format("dir%u/file%u.txt", (uint)(index % 3), (uint)index);
+}
+
+static void compareFile(const Common::ZipFile &zip, size_t index) {
+	std::unique_ptr<Common::SeekableReadStream> expected(createData(index));
+	std::unique_ptr<Common::SeekableReadStream> file(zip.getFile(index));
+
+	ASSERT_EQ(file->size(), expected->size()) << "At file " << index;
+
+	for (size_t i = 0; i < expected->size(); i++)
+		ASSERT_EQ(file->readByte(), expected->readByte()) << "At file " << index << ", index " << i;
+}
+
+static void testRoundTrip(size_t fileCount, bool compress, int level, size_t threadCount) {
+	Common::ZipWriter writer;
+	writer.setCompressionLevel(level);
+
+	for (size_t i = 0; i < fileCount; i++)
+		writer.add(createName(i), createData(i), compress);
+
+	ASSERT_EQ(writer.getFileCount(), fileCount);
+
+	Common::MemoryWriteStreamDynamic output(true);
+	writer.write(output, threadCount);
+
+	EXPECT_EQ(writer.getFileCount(), 0);
+
+	const Common::ZipFile zip(new Common::MemoryReadStream(output.getData(), output.size()));
+
+	const Common::ZipFile::FileList &files = zip.getFiles();
+	ASSERT_EQ(files.size(), fileCount);
+
+	size_t index = 0;
+	for (Common::ZipFile::FileList::const_iterator f = files.begin(); f != files.end(); ++f, ++index) {
+		EXPECT_EQ(f->index, index);
+		EXPECT_STREQ(f->name.c_str(), createName(index).toLower().c_str());
+
+		compareFile(zip, index);
+	}
+}
+
+GTEST_TEST(ZIPWriter, store) {
+	testRoundTrip(10, false, Common::kCompressionLevelDefault, 4);
+}
+
+GTEST_TEST(ZIPWriter, compress) {
+	testRoundTrip(10, true, Common::kCompressionLevelDefault, 4);
+}
+
+GTEST_TEST(ZIPWriter, compressBest) {
+	testRoundTrip(10, true, Common::kCompressionLevelBest, 4);
+}
+
+GTEST_TEST(ZIPWriter, compressSingleThread) {
+	testRoundTrip(10, true, Common::kCompressionLevelDefault, 1);
+}
+
+GTEST_TEST(ZIPWriter, compressManyFiles) {
+	testRoundTrip(200, true, Common::kCompressionLevelDefault, 0);
+}
+
+GTEST_TEST(ZIPWriter, empty) {
+	Common::ZipWriter writer;
+
+	Common::MemoryWriteStreamDynamic output(true);
+	writer.write(output);
+
+	// Only the end of central directory record
+	ASSERT_EQ(output.size(), 22);
+	EXPECT_EQ(READ_LE_UINT32(output.getData()), 0x06054B50);
+	EXPECT_EQ(READ_LE_UINT16(output.getData() + 10), 0);
+}
+
+GTEST_TEST(ZIPWriter, storeIncompressible) {
+	// Compressing a file that doesn't get any smaller stores it instead
+	static const byte kIncompressible[] = { 0x7A, 0x13, 0xC5, 0x01 };
+
+	Common::ZipWriter writer;
+	writer.add("random.bin", new Common::MemoryReadStream(kIncompressible));
+
+	Common::MemoryWriteStreamDynamic output(true);
+	writer.write(output);
+
+	const byte *data = output.getData();
+
+	// Local file header, with compression method 0
+	ASSERT_GE(output.size(), 30 + 10 + sizeof(kIncompressible));
+	EXPECT_EQ(READ_LE_UINT32(data), 0x04034B50);
+	EXPECT_EQ(READ_LE_UINT16(data + 8), 0);
+	EXPECT_EQ(READ_LE_UINT32(data + 18), sizeof(kIncompressible));
+	EXPECT_EQ(READ_LE_UINT32(data + 22), sizeof(kIncompressible));
+	EXPECT_EQ(std::memcmp(data + 30 + 10, kIncompressible, sizeof(kIncompressible)), 0);
+
+	const Common::ZipFile zip(new Common::MemoryReadStream(output.getData(), output.size()));
+	ASSERT_EQ(zip.getFiles().size(), 1);
+
+	std::unique_ptr<Common::SeekableReadStream> file(zip.getFile(0));
+	ASSERT_EQ(file->size(), sizeof(kIncompressible));
+	for (size_t i = 0; i < sizeof(kIncompressible); i++)
+		EXPECT_EQ(file->readByte(), kIncompressible[i]) << "At index " << i;
+}
@@ -0,0 +1,155 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for the items of the resource tree.
+ */
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "src/common/util.h"
+
+#include "src/aurora/archive.h"
+
+#include "src/gui/resourcetreeitem.h"
+
+/** An archive with only a resource list. */
+class TestArchive : public Aurora::Archive {
+public:
+	TestArchive() {
+		addResource("ozymandias", 0, Aurora::kFileTypeTXT);
+		addResource(""          , 0x1234, Aurora::kFileTypeTGA);
+		addResource("Anarchy"   , 0, Aurora::kFileType2DA);
+	}
+
+	const ResourceList &getResources() const {
+		return _resources;
+	}
+
+	Common::SeekableReadStream *getResource(uint32 UNUSED(index), bool UNUSED(tryNoCopy) = false) const {
+		return 0;
+	}
+
+	std::vector<const Resource *> getResourcePointers() const {
+		std::vector<const Resource *> resources;
+		for (ResourceList::const_iterator r = _resources.begin(); r != _resources.end(); ++r)
+			resources.push_back(&*r);
+
+		return resources;
+	}
+
+private:
+	ResourceList _resources;
+
+	void addResource(const char *name, uint64 hash, Aurora::FileType type) {
+		_resources.push_back(Resource());
+
+		_resources.back().name  = name;
+		_resources.back().hash  = hash;
+		_resources.back().type  = type;
+		_resources.back().index = _resources.size() - 1;
+	}
+};
+
+GTEST_TEST(ResourceTreeItem, archiveMembers) {
+	TestArchive archive;
+
+	GUI::ResourceTreeItem root("archive");
+	root.addArchiveMembers(&archive, archive.getResourcePointers());
+
+	ASSERT_EQ(root.childCount(), 3);
+
+	// Sorted by name, nameless resources named after their hash
+	static const char * const kNames[3] = { "4660.tga", "Anarchy.2da", "ozymandias.txt" };
+	static const uint32 kIndices[3] = { 1, 2, 0 };
+
+	for (int i = 0; i < 3; i++) {
+		const GUI::ResourceTreeItem *item = root.childAt(i);
+		ASSERT_NE(item, nullptr) << "At index " << i;
+
+		EXPECT_TRUE(item->isArchiveMember()) << "At index " << i;
+		EXPECT_EQ(item->row(), i) << "At index " << i;
+		EXPECT_EQ(item->getParent(), &root) << "At index " << i;
+		EXPECT_EQ(item->getResourceIndex(), kIndices[i]) << "At index " << i;
+
+		EXPECT_EQ(item->getName().toStdString(), kNames[i]) << "At index " << i;
+		EXPECT_EQ(item->getPath().toStdString(), (root.getPath() + "/" + kNames[i]).toStdString()) << "At index " << i;
+	}
+
+	EXPECT_EQ(root.childAt(0)->getFileType(), Aurora::kFileTypeTGA);
+	EXPECT_EQ(root.childAt(1)->getFileType(), Aurora::kFileType2DA);
+	EXPECT_EQ(root.childAt(2)->getFileType(), Aurora::kFileTypeTXT);
+}
+
+GTEST_TEST(ResourceTreeItem, cachedName) {
+	TestArchive archive;
+
+	GUI::ResourceTreeItem root("archive");
+	root.addArchiveMembers(&archive, archive.getResourcePointers());
+
+	const GUI::ResourceTreeItem *item = root.childAt(2);
+	ASSERT_NE(item, nullptr);
+
+	const QString name1 = item->getName();
+	const QString name2 = item->getName();
+
+	EXPECT_EQ(name1.toStdString(), "ozymandias.txt");
+
+	// The second call returns the name created by the first
+	EXPECT_TRUE(name1.isSharedWith(name2));
+}
+
+GTEST_TEST(ResourceTreeItem, childrenAndArchiveMembers) {
+	TestArchive archive;
+
+	GUI::ResourceTreeItem root("archive");
+	root.addArchiveMembers(&archive, archive.getResourcePointers());
+
+	// Real children come before the archive members
+	GUI::ResourceTreeItem *child = new GUI::ResourceTreeItem("child");
+	root.addChild(child);
+
+	ASSERT_EQ(root.childCount(), 4);
+
+	EXPECT_EQ(child->row(), 0);
+	EXPECT_EQ(root.childAt(0), child);
+
+	for (int i = 0; i < 4; i++) {
+		const GUI::ResourceTreeItem *item = root.childAt(i);
+		ASSERT_NE(item, nullptr) << "At index " << i;
+
+		EXPECT_EQ(item->row(), i) << "At index " << i;
+		EXPECT_EQ(item->isArchiveMember(), i > 0) << "At index " << i;
+	}
+
+	root.removeChild(0);
+
+	ASSERT_EQ(root.childCount(), 3);
+
+	for (int i = 0; i < 3; i++) {
+		const GUI::ResourceTreeItem *item = root.childAt(i);
+		ASSERT_NE(item, nullptr) << "At index " << i;
+
+		EXPECT_EQ(item->row(), i) << "At index " << i;
+		EXPECT_TRUE(item->isArchiveMember()) << "At index " << i;
+	}
+}
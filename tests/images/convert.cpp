@@ -0,0 +1,201 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for our image data conversion into 32-bit RGBA/BGRA.
+ */
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "src/common/types.h"
+#include "src/common/error.h"
+#include "src/common/cpu.h"
+
+#include "src/images/convert.h"
+
+// Not a multiple of any vector size, to also exercise the tail handling
+static const size_t kPixelCount = 67;
+
+static std::vector<byte> createRandom(size_t size, uint32 seed) {
+	std::vector<byte> data(size);
+
+	for (size_t i = 0; i < data.size(); i++) {
+		seed = seed * 1664525 + 1013904223;
+
+		data[i] = seed >> 24;
+	}
+
+	return data;
+}
+
+static void setSIMDEnabled(bool enabled) {
+	Common::setCPUFeatureEnabled(Common::kCPUFeatureSSE2 , enabled);
+	Common::setCPUFeatureEnabled(Common::kCPUFeatureSSSE3, enabled);
+}
+
+/** Convert random pixels with the generic and the SIMD code paths, and compare the results. */
+static void compareCodePaths(Images::PixelFormat format, size_t bpp, bool bgra) {
+	const std::vector<byte> src = createRandom(kPixelCount * bpp, format + 1);
+
+	std::vector<byte> generic(kPixelCount * 4), simd(kPixelCount * 4);
+
+	setSIMDEnabled(false);
+	if (bgra)
+		Images::convertToBGRA8(&generic[0], &src[0], format, kPixelCount);
+	else
+		Images::convertToRGBA8(&generic[0], &src[0], format, kPixelCount);
+
+	setSIMDEnabled(true);
+	if (bgra)
+		Images::convertToBGRA8(&simd[0], &src[0], format, kPixelCount);
+	else
+		Images::convertToRGBA8(&simd[0], &src[0], format, kPixelCount);
+
+	for (size_t i = 0; i < generic.size(); i++)
+		EXPECT_EQ(simd[i], generic[i]) << "At index " << i;
+}
+
+GTEST_TEST(ImagesConvert, R8G8B8) {
+	static const byte kSrc[] = { 0x01, 0x02, 0x03 };
+	byte rgba[4], bgra[4];
+
+	Images::convertToRGBA8(rgba, kSrc, Images::kPixelFormatR8G8B8, 1);
+	Images::convertToBGRA8(bgra, kSrc, Images::kPixelFormatR8G8B8, 1);
+
+	EXPECT_EQ(rgba[0], 0x01);
+	EXPECT_EQ(rgba[1], 0x02);
+	EXPECT_EQ(rgba[2], 0x03);
+	EXPECT_EQ(rgba[3], 0xFF);
+
+	EXPECT_EQ(bgra[0], 0x03);
+	EXPECT_EQ(bgra[1], 0x02);
+	EXPECT_EQ(bgra[2], 0x01);
+	EXPECT_EQ(bgra[3], 0xFF);
+
+	compareCodePaths(Images::kPixelFormatR8G8B8, 3, false);
+	compareCodePaths(Images::kPixelFormatR8G8B8, 3, true);
+}
+
+GTEST_TEST(ImagesConvert, B8G8R8) {
+	static const byte kSrc[] = { 0x01, 0x02, 0x03 };
+	byte rgba[4];
+
+	Images::convertToRGBA8(rgba, kSrc, Images::kPixelFormatB8G8R8, 1);
+
+	EXPECT_EQ(rgba[0], 0x03);
+	EXPECT_EQ(rgba[1], 0x02);
+	EXPECT_EQ(rgba[2], 0x01);
+	EXPECT_EQ(rgba[3], 0xFF);
+
+	compareCodePaths(Images::kPixelFormatB8G8R8, 3, false);
+	compareCodePaths(Images::kPixelFormatB8G8R8, 3, true);
+}
+
+GTEST_TEST(ImagesConvert, R8G8B8A8) {
+	static const byte kSrc[] = { 0x01, 0x02, 0x03, 0x04 };
+	byte rgba[4], bgra[4];
+
+	Images::convertToRGBA8(rgba, kSrc, Images::kPixelFormatR8G8B8A8, 1);
+	Images::convertToBGRA8(bgra, kSrc, Images::kPixelFormatR8G8B8A8, 1);
+
+	EXPECT_EQ(rgba[0], 0x01);
+	EXPECT_EQ(rgba[3], 0x04);
+
+	EXPECT_EQ(bgra[0], 0x03);
+	EXPECT_EQ(bgra[1], 0x02);
+	EXPECT_EQ(bgra[2], 0x01);
+	EXPECT_EQ(bgra[3], 0x04);
+
+	compareCodePaths(Images::kPixelFormatR8G8B8A8, 4, false);
+	compareCodePaths(Images::kPixelFormatR8G8B8A8, 4, true);
+}
+
+GTEST_TEST(ImagesConvert, B8G8R8A8) {
+	static const byte kSrc[] = { 0x01, 0x02, 0x03, 0x04 };
+	byte rgba[4];
+
+	Images::convertToRGBA8(rgba, kSrc, Images::kPixelFormatB8G8R8A8, 1);
+
+	EXPECT_EQ(rgba[0], 0x03);
+	EXPECT_EQ(rgba[1], 0x02);
+	EXPECT_EQ(rgba[2], 0x01);
+	EXPECT_EQ(rgba[3], 0x04);
+
+	compareCodePaths(Images::kPixelFormatB8G8R8A8, 4, false);
+	compareCodePaths(Images::kPixelFormatB8G8R8A8, 4, true);
+}
+
+GTEST_TEST(ImagesConvert, R5G6B5) {
+	// R = 0x1E, G = 0x21, B = 0x03
+	static const byte kSrc[] = { 0x23, 0xF4 };
+	byte rgba[4];
+
+	Images::convertToRGBA8(rgba, kSrc, Images::kPixelFormatR5G6B5, 1);
+
+	EXPECT_EQ(rgba[0], 0x1E);
+	EXPECT_EQ(rgba[1], 0x21);
+	EXPECT_EQ(rgba[2], 0x03);
+	EXPECT_EQ(rgba[3], 0xFF);
+
+	compareCodePaths(Images::kPixelFormatR5G6B5, 2, false);
+	compareCodePaths(Images::kPixelFormatR5G6B5, 2, true);
+}
+
+GTEST_TEST(ImagesConvert, A1R5G5B5) {
+	// A = 1, R = 0x1D, G = 0x01, B = 0x03
+	static const byte kSrc[] = { 0x23, 0xF4, 0x23, 0x74 };
+	byte rgba[8];
+
+	Images::convertToRGBA8(rgba, kSrc, Images::kPixelFormatA1R5G5B5, 2);
+
+	EXPECT_EQ(rgba[0], 0x1D);
+	EXPECT_EQ(rgba[1], 0x01);
+	EXPECT_EQ(rgba[2], 0x03);
+	EXPECT_EQ(rgba[3], 0xFF);
+	EXPECT_EQ(rgba[7], 0x00);
+
+	compareCodePaths(Images::kPixelFormatA1R5G5B5, 2, false);
+	compareCodePaths(Images::kPixelFormatA1R5G5B5, 2, true);
+}
+
+GTEST_TEST(ImagesConvert, Depth16) {
+	static const byte kSrc[] = { 0x80, 0x12, 0xFF, 0x7F };
+	byte rgba[8];
+
+	Images::convertToRGBA8(rgba, kSrc, Images::kPixelFormatDepth16, 2);
+
+	EXPECT_EQ(rgba[0], 0x25);
+	EXPECT_EQ(rgba[1], 0x25);
+	EXPECT_EQ(rgba[2], 0x25);
+	EXPECT_EQ(rgba[3], 0xFF);
+	EXPECT_EQ(rgba[7], 0x00);
+
+	compareCodePaths(Images::kPixelFormatDepth16, 2, false);
+	compareCodePaths(Images::kPixelFormatDepth16, 2, true);
+}
+
+GTEST_TEST(ImagesConvert, unsupported) {
+	static const byte kSrc[16] = { 0 };
+	byte rgba[64];
+
+	EXPECT_THROW(Images::convertToRGBA8(rgba, kSrc, Images::kPixelFormatDXT1, 1), Common::Exception);
+}
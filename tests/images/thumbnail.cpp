@@ -0,0 +1,299 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for our thumbnail creation.
+ */
+
+#include <cstring>
+
+#include <memory>
+#include <vector>
+#include <atomic>
+
+#include <boost/filesystem.hpp>
+
+#include "gtest/gtest.h"
+
+#include "src/common/util.h"
+#include "src/common/error.h"
+#include "src/common/platform.h"
+
+#include "src/images/decoder.h"
+#include "src/images/thumbnail.h"
+#include "src/images/thumbnailservice.h"
+
+/** An R8G8B8A8 image with a full mip map chain, each mip map filled with its level. */
+class TestImage : public Images::Decoder {
+public:
+	TestImage(int width, int height) {
+		while (true) {
+			MipMap *mipMap = new MipMap;
+			_mipMaps.push_back(mipMap);
+
+			mipMap->width  = width;
+			mipMap->height = height;
+			mipMap->size   = width * height * 4;
+			mipMap->data   = std::make_unique<byte[]>(mipMap->size);
+
+			std::memset(mipMap->data.get(), _mipMaps.size() - 1, mipMap->size);
+
+			if ((width == 1) && (height == 1))
+				break;
+
+			width  = MAX(1, width  / 2);
+			height = MAX(1, height / 2);
+		}
+	}
+};
+
+GTEST_TEST(Thumbnail, findThumbnailMipMap) {
+	TestImage image(256, 128);
+
+	EXPECT_EQ(Images::findThumbnailMipMap(image, 1024), 0);
+	EXPECT_EQ(Images::findThumbnailMipMap(image,  256), 0);
+	EXPECT_EQ(Images::findThumbnailMipMap(image,  100), 1);
+	EXPECT_EQ(Images::findThumbnailMipMap(image,   64), 2);
+	EXPECT_EQ(Images::findThumbnailMipMap(image,    1), 8);
+}
+
+GTEST_TEST(Thumbnail, createThumbnail) {
+	TestImage image(256, 128);
+
+	Images::Thumbnail thumbnail;
+	Images::createThumbnail(image, 48, thumbnail);
+
+	// Scaled down from mip map 2, 64x32
+	EXPECT_EQ(thumbnail.width , 48);
+	EXPECT_EQ(thumbnail.height, 24);
+	ASSERT_EQ(thumbnail.data.size(), 48 * 24 * 4);
+
+	for (size_t i = 0; i < thumbnail.data.size(); i++)
+		EXPECT_EQ(thumbnail.data[i], 2) << "At index " << i;
+}
+
+GTEST_TEST(Thumbnail, createThumbnailSmall) {
+	TestImage image(16, 8);
+
+	Images::Thumbnail thumbnail;
+	Images::createThumbnail(image, 64, thumbnail);
+
+	EXPECT_EQ(thumbnail.width , 16);
+	EXPECT_EQ(thumbnail.height,  8);
+	ASSERT_EQ(thumbnail.data.size(), 16 * 8 * 4);
+}
+
+GTEST_TEST(Thumbnail, scaleDownRGBA8) {
+	static const byte kSource[4 * 2 * 4] = {
+		  0,   0,   0,   0,  100, 100, 100, 100,   10,  20,  30,  40,   10,  20,  30,  40,
+		100, 100, 100, 100,    0,   0,   0,   0,   10,  20,  30,  40,   10,  20,  30,  40
+	};
+
+	byte result[2 * 4];
+	Images::scaleDownRGBA8(kSource, 4, 2, result, 2, 1);
+
+	EXPECT_EQ(result[0],  50);
+	EXPECT_EQ(result[3],  50);
+	EXPECT_EQ(result[4],  10);
+	EXPECT_EQ(result[5],  20);
+	EXPECT_EQ(result[6],  30);
+	EXPECT_EQ(result[7],  40);
+}
+
+static void waitForThumbnails(Images::ThumbnailService &service, std::vector<Images::ThumbnailService::Key> &keys) {
+	while (service.isBusy())
+		std::this_thread::yield();
+
+	service.collectFinished(keys);
+}
+
+GTEST_TEST(ThumbnailService, get) {
+	Images::ThumbnailService service("", 32, 2);
+
+	std::atomic<int> loads(0);
+	auto loader = [&loads]() -> Images::Decoder * {
+		loads++;
+		return new TestImage(128, 128);
+	};
+
+	EXPECT_EQ(service.get(1, 0, loader), static_cast<const Images::Thumbnail *>(0));
+	EXPECT_EQ(service.get(1, 1, loader), static_cast<const Images::Thumbnail *>(0));
+
+	// Might already be finished, but is never queued twice
+	service.get(1, 0, loader);
+
+	std::vector<Images::ThumbnailService::Key> keys;
+	waitForThumbnails(service, keys);
+
+	EXPECT_EQ(keys.size(), 2);
+	EXPECT_EQ(loads, 2);
+
+	const Images::Thumbnail *thumbnail = service.get(1, 0, loader);
+	ASSERT_NE(thumbnail, static_cast<const Images::Thumbnail *>(0));
+	EXPECT_EQ(thumbnail->width , 32);
+	EXPECT_EQ(thumbnail->height, 32);
+
+	EXPECT_EQ(loads, 2);
+	EXPECT_FALSE(service.collectFinished(keys));
+}
+
+GTEST_TEST(ThumbnailService, broken) {
+	Images::ThumbnailService service("", 32, 1);
+
+	auto loader = []() -> Images::Decoder * {
+		throw Common::Exception("Broken");
+	};
+
+	EXPECT_EQ(service.get(1, 0, loader), static_cast<const Images::Thumbnail *>(0));
+
+	std::vector<Images::ThumbnailService::Key> keys;
+	waitForThumbnails(service, keys);
+
+	const Images::Thumbnail *thumbnail = service.get(1, 0, loader);
+	ASSERT_NE(thumbnail, static_cast<const Images::Thumbnail *>(0));
+	EXPECT_EQ(thumbnail->width, 0);
+	EXPECT_TRUE(thumbnail->data.empty());
+}
+
+GTEST_TEST(ThumbnailService, diskCache) {
+	Common::Platform::init();
+
+	const boost::filesystem::path directory = boost::filesystem::temp_directory_path() /
+	                                          boost::filesystem::unique_path("%%%%_%%%%_%%%%_%%%%.xoreos");
+
+	std::atomic<int> loads(0);
+	auto loader = [&loads]() -> Images::Decoder * {
+		loads++;
+		return new TestImage(64, 32);
+	};
+
+	const uint64 fingerprint = Images::ThumbnailService::getFingerprint("data/textures.erf", 1234, 5678);
+
+	{
+		Images::ThumbnailService service(directory.generic_string(), 32, 1);
+		service.get(fingerprint, 7, loader);
+
+		std::vector<Images::ThumbnailService::Key> keys;
+		waitForThumbnails(service, keys);
+	}
+
+	{
+		Images::ThumbnailService service(directory.generic_string(), 32, 1);
+		service.get(fingerprint, 7, loader);
+
+		std::vector<Images::ThumbnailService::Key> keys;
+		waitForThumbnails(service, keys);
+
+		const Images::Thumbnail *thumbnail = service.get(fingerprint, 7, loader);
+		ASSERT_NE(thumbnail, static_cast<const Images::Thumbnail *>(0));
+		EXPECT_EQ(thumbnail->width , 32);
+		EXPECT_EQ(thumbnail->height, 16);
+		EXPECT_EQ(thumbnail->data.size(), 32 * 16 * 4);
+	}
+
+	// The second service read the thumbnail from disk
+	EXPECT_EQ(loads, 1);
+
+	boost::filesystem::remove_all(directory);
+}
+
+GTEST_TEST(ThumbnailService, diskCacheOnly) {
+	Common::Platform::init();
+
+	const boost::filesystem::path directory = boost::filesystem::temp_directory_path() /
+	                                          boost::filesystem::unique_path("%%%%_%%%%_%%%%_%%%%.xoreos");
+
+	std::atomic<int> loads(0);
+	auto loader = [&loads]() -> Images::Decoder * {
+		loads++;
+		return new TestImage(64, 32);
+	};
+
+	Images::ThumbnailService service(directory.generic_string(), 32, 1);
+
+	// Not in the cache directory, so the look-up finishes without a thumbnail
+	EXPECT_EQ(service.get(1, 7, Images::ThumbnailService::ImageLoader()), static_cast<const Images::Thumbnail *>(0));
+
+	std::vector<Images::ThumbnailService::Key> keys;
+	waitForThumbnails(service, keys);
+
+	ASSERT_EQ(keys.size(), 1);
+	EXPECT_EQ(service.get(1, 7, Images::ThumbnailService::ImageLoader()), static_cast<const Images::Thumbnail *>(0));
+	EXPECT_FALSE(service.isBusy());
+
+	// With a loader, it's created
+	EXPECT_EQ(service.get(1, 7, loader), static_cast<const Images::Thumbnail *>(0));
+
+	keys.clear();
+	waitForThumbnails(service, keys);
+
+	ASSERT_EQ(keys.size(), 1);
+	EXPECT_EQ(loads, 1);
+
+	{
+		// And another service finds it in the cache directory
+		Images::ThumbnailService cached(directory.generic_string(), 32, 1);
+		EXPECT_EQ(cached.get(1, 7, Images::ThumbnailService::ImageLoader()), static_cast<const Images::Thumbnail *>(0));
+
+		keys.clear();
+		waitForThumbnails(cached, keys);
+
+		const Images::Thumbnail *thumbnail = cached.get(1, 7, Images::ThumbnailService::ImageLoader());
+		ASSERT_NE(thumbnail, static_cast<const Images::Thumbnail *>(0));
+		EXPECT_EQ(thumbnail->width , 32);
+		EXPECT_EQ(thumbnail->height, 16);
+	}
+
+	EXPECT_EQ(loads, 1);
+
+	boost::filesystem::remove_all(directory);
+}
+
+GTEST_TEST(ThumbnailService, diskCacheBroken) {
+	Common::Platform::init();
+
+	const boost::filesystem::path directory = boost::filesystem::temp_directory_path() /
+	                                          boost::filesystem::unique_path("%%%%_%%%%_%%%%_%%%%.xoreos");
+
+	std::atomic<int> loads(0);
+	auto loader = [&loads]() -> Images::Decoder * {
+		if (loads++ == 0)
+			throw Common::Exception(Common::kReadError);
+
+		return new TestImage(64, 32);
+	};
+
+	for (int i = 0; i < 2; i++) {
+		Images::ThumbnailService service(directory.generic_string(), 32, 1);
+		service.get(1, 7, loader);
+
+		std::vector<Images::ThumbnailService::Key> keys;
+		waitForThumbnails(service, keys);
+
+		// The first session failed to read the image, the second one tried again
+		const Images::Thumbnail *thumbnail = service.get(1, 7, loader);
+		ASSERT_NE(thumbnail, static_cast<const Images::Thumbnail *>(0));
+		EXPECT_EQ(thumbnail->width, (i == 0) ? 0 : 32);
+	}
+
+	EXPECT_EQ(loads, 2);
+
+	boost::filesystem::remove_all(directory);
+}
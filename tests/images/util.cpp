@@ -24,6 +24,8 @@
 
 #include <cstring>
 
+#include <vector>
+
 #include "gtest/gtest.h"
 
 #include "src/common/error.h"
@@ -479,3 +481,30 @@ GTEST_TEST(ImagesUtil, deSwizzleOffset) {
 	for (size_t i = 0; i < (kWidth * kHeight); i++)
 		EXPECT_EQ(buffer[i], kSwizzled[i]) << "At index " << i;
 }
+
+GTEST_TEST(ImagesUtil, deSwizzle) {
+	static const uint32 kSizes[][2] = { { 1, 1 }, { 4, 4 }, { 8, 2 }, { 2, 16 }, { 16, 5 }, { 32, 32 }, { 3, 8 } };
+
+	for (size_t s = 0; s < ARRAYSIZE(kSizes); s++) {
+		for (uint32 bpp = 1; bpp <= 5; bpp++) {
+			const uint32 width = kSizes[s][0], height = kSizes[s][1];
+
+			std::vector<byte> src(width * height * bpp);
+			for (size_t i = 0; i < src.size(); i++)
+				src[i] = (byte) (i * 7 + 3);
+
+			std::vector<byte> dst(src.size());
+			Images::deSwizzle(&dst[0], &src[0], width, height, bpp);
+
+			for (uint32 y = 0; y < height; y++) {
+				for (uint32 x = 0; x < width; x++) {
+					const uint32 offset = Images::deSwizzleOffset(x, y, width, height) * bpp;
+
+					for (uint32 p = 0; p < bpp; p++)
+						EXPECT_EQ(dst[(y * width + x) * bpp + p], src[offset + p]) <<
+							"At " << width << "x" << height << "x" << bpp << ", " << x << "." << y << "." << p;
+				}
+			}
+		}
+	}
+}
@@ -39,5 +39,7 @@ include tests/version/rules.mk
 include tests/common/rules.mk
 include tests/aurora/rules.mk
 include tests/images/rules.mk
+include tests/sound/rules.mk
+include tests/gui/rules.mk
 
 TESTS += $(check_PROGRAMS)
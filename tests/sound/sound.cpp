@@ -0,0 +1,118 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for the sound manager's offline rendering.
+ */
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "src/common/util.h"
+#include "src/common/error.h"
+#include "src/common/memreadstream.h"
+#include "src/common/memwritestream.h"
+
+#include "src/sound/sound.h"
+
+static const int    kRate     = 22050;
+static const int    kChannels = 2;
+static const size_t kSamples  = 100000; // Several times the size of all buffers of a channel
+
+static int16 getSample(size_t n) {
+	return (int16) ((n * 7919) & 0xFFFF);
+}
+
+/** Create a 16-bit PCM WAVE file containing kSamples samples. */
+static Common::SeekableReadStream *createWAVE() {
+	Common::MemoryWriteStreamDynamic wave(false);
+
+	const uint32 dataSize = kSamples * 2;
+
+	wave.writeUint32BE(MKTAG('R', 'I', 'F', 'F'));
+	wave.writeUint32LE(36 + dataSize);
+	wave.writeUint32BE(MKTAG('W', 'A', 'V', 'E'));
+
+	wave.writeUint32BE(MKTAG('f', 'm', 't', ' '));
+	wave.writeUint32LE(16);
+	wave.writeUint16LE(1);
+	wave.writeUint16LE(kChannels);
+	wave.writeUint32LE(kRate);
+	wave.writeUint32LE(kRate * kChannels * 2);
+	wave.writeUint16LE(kChannels * 2);
+	wave.writeUint16LE(16);
+
+	wave.writeUint32BE(MKTAG('d', 'a', 't', 'a'));
+	wave.writeUint32LE(dataSize);
+
+	for (size_t i = 0; i < kSamples; i++)
+		wave.writeUint16LE((uint16) getSample(i));
+
+	return new Common::MemoryReadStream(wave.getData(), wave.size(), true);
+}
+
+GTEST_TEST(SoundManagerOffline, render) {
+	SoundMan.initOffline();
+	ASSERT_TRUE(SoundMan.isOffline());
+
+	Sound::ChannelHandle channel = SoundMan.playSoundFile(createWAVE(), Sound::kSoundTypeUnknown);
+
+	Common::MemoryWriteStreamDynamic output(true);
+	const Sound::RenderStatistics stats = SoundMan.renderChannel(channel, &output);
+
+	EXPECT_EQ(stats.channels, kChannels);
+	EXPECT_EQ(stats.rate, kRate);
+	EXPECT_EQ(stats.samples, kSamples / kChannels);
+	EXPECT_EQ(stats.bytes, kSamples * 2);
+
+	ASSERT_EQ(output.size(), kSamples * 2);
+
+	const int16 *data = reinterpret_cast<const int16 *>(output.getData());
+	for (size_t i = 0; i < kSamples; i++)
+		EXPECT_EQ(data[i], getSample(i)) << "At index " << i;
+
+	// The channel has been freed after rendering
+	EXPECT_FALSE(SoundMan.isValidChannel(channel));
+
+	SoundMan.deinit();
+}
+
+GTEST_TEST(SoundManagerOffline, renderWithoutOutput) {
+	SoundMan.initOffline();
+
+	Sound::ChannelHandle channel = SoundMan.playSoundFile(createWAVE(), Sound::kSoundTypeUnknown);
+
+	const Sound::RenderStatistics stats = SoundMan.renderChannel(channel);
+
+	EXPECT_EQ(stats.samples, kSamples / kChannels);
+	EXPECT_EQ(stats.bytes, kSamples * 2);
+
+	SoundMan.deinit();
+}
+
+GTEST_TEST(SoundManagerOffline, renderInvalidChannel) {
+	SoundMan.initOffline();
+
+	Sound::ChannelHandle channel;
+	EXPECT_THROW(SoundMan.renderChannel(channel), Common::Exception);
+
+	SoundMan.deinit();
+}
@@ -0,0 +1,378 @@
+/* Phaethon - A FLOSS resource explorer for BioWare's Aurora engine games
+ *
+ * Phaethon is the legal property of its developers, whose names
+ * can be found in the AUTHORS file distributed with this source
+ * distribution.
+ *
+ * Phaethon is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or (at your option) any later version.
+ *
+ * Phaethon is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Phaethon. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file
+ *  Unit tests for the parallel WMA decoder.
+ */
+
+#include <cstring>
+
+#include <vector>
+#include <memory>
+
+#include "gtest/gtest.h"
+
+#include "src/common/util.h"
+#include "src/common/memreadstream.h"
+#include "src/common/ptrvector.h"
+
+#include "src/sound/audiostream.h"
+
+#include "src/sound/decoders/wma.h"
+#include "src/sound/decoders/wmadata.h"
+
+static const uint32 kRate       = 22050;
+static const uint8  kChannels   = 2;
+static const uint32 kBitRate    = 128000; // High enough to not use noise coding
+static const uint32 kBlockAlign = 256;
+static const size_t kPackets    = 256;    // Enough for several segments
+
+static const int kFrameLenBits    = 10; // For 22050Hz
+static const int kBlockSizeCount  = 4;  // For 64kbps per channel with variable block lengths
+static const int kByteOffsetBits  = 10; // For 64kbps per channel at 22050Hz
+static const int kCoefHuffmanBase = 4;  // Coefficient Huffman tables for 22050Hz
+
+static const int kFrameCountMax = 14;
+
+static const uint16 kFlagBitReservoir     = 0x0002;
+static const uint16 kFlagVariableBlockLen = 0x0004;
+
+/** Simple LCG, so that the test data is the same everywhere. */
+class Random {
+public:
+	Random(uint32 seed) : _seed(seed) {
+	}
+
+	uint32 next(uint32 range) {
+		_seed = _seed * 1664525 + 1013904223;
+
+		return (_seed >> 8) % range;
+	}
+
+private:
+	uint32 _seed;
+};
+
+class BitWriter {
+public:
+	void put(uint32 value, int n) {
+		while (n-- > 0)
+			_bits.push_back(((value >> n) & 1) != 0);
+	}
+
+	void append(const std::vector<bool> &bits, size_t start = 0, size_t end = SIZE_MAX) {
+		_bits.insert(_bits.end(), bits.begin() + start, bits.begin() + MIN(end, bits.size()));
+	}
+
+	size_t size() const {
+		return _bits.size();
+	}
+
+	const std::vector<bool> &getBits() const {
+		return _bits;
+	}
+
+private:
+	std::vector<bool> _bits;
+};
+
+/** A minimal WMAv2 encoder that creates valid, but random, superframes.
+ *
+ *  We have no WMA encoder or WMA files at hand, so we create a stream that
+ *  exercises all the decoder state carried from one superframe to the next:
+ *  frames spanning superframes via the bit reservoir, variable block lengths,
+ *  exponents that are reused when a channel is left out and the overlap-add
+ *  buffer. The decoder is deterministic, so the parallel decoder has to
+ *  reproduce the serial output exactly.
+ */
+class WMAStreamCreator {
+public:
+	WMAStreamCreator(uint16 flags, uint32 rightChannelRate) : _rng(0x2A2A2A2A),
+		_variableBlockLen((flags & kFlagVariableBlockLen) != 0), _rightChannelRate(rightChannelRate),
+		_resetBlockLengths(true), _nextBlockSize(0) {
+
+		createCoefTables(0);
+		createCoefTables(1);
+	}
+
+	void createPackets(Common::PtrVector<Common::SeekableReadStream> &packets) {
+		static const size_t kCapacity = kBlockAlign * 8 - 8 - (kByteOffsetBits + 3);
+
+		std::vector<bool> carry;
+
+		for (size_t i = 0; i < kPackets; i++) {
+			BitWriter payload;
+
+			// The rest of the frame started in the last superframe
+			const size_t bitOffset = carry.size();
+			payload.append(carry);
+			carry.clear();
+
+			// New superframe, new block lengths
+			_resetBlockLengths = true;
+
+			int frameCount = 0;
+			while (payload.size() < kCapacity) {
+				std::vector<bool> frame;
+				createFrame(frame);
+
+				const size_t remaining = kCapacity - payload.size();
+				if ((frame.size() <= remaining) && (frameCount < kFrameCountMax)) {
+					payload.append(frame);
+					frameCount++;
+					continue;
+				}
+
+				// Overhang, decoded together with the start of the next superframe
+				payload.append(frame, 0, remaining);
+				if (frame.size() > remaining)
+					carry.assign(frame.begin() + remaining, frame.end());
+
+				while (payload.size() < kCapacity)
+					payload.put(_rng.next(2), 1);
+			}
+
+			BitWriter superframe;
+			superframe.put(i & 0xF, 4);
+			superframe.put(frameCount + 1, 4);
+			superframe.put(bitOffset, kByteOffsetBits + 3);
+			superframe.append(payload.getBits());
+
+			packets.push_back(createPacket(superframe.getBits()));
+		}
+	}
+
+private:
+	Random _rng;
+
+	bool   _variableBlockLen;
+	uint32 _rightChannelRate;
+
+	/** Mirrors the decoder: are the block lengths read anew in the next frame? */
+	bool _resetBlockLengths;
+	/** The block size already announced for the next block. */
+	int  _nextBlockSize;
+
+	std::vector<uint16> _coefSymbols[2]; ///< Coefficient codes with short runs.
+
+	void createCoefTables(int table) {
+		const Sound::WMACoefHuffmanParam &params = Sound::coefHuffmanParam[kCoefHuffmanBase + table];
+
+		// Same as WMACodec::initCoefHuffman()
+		int i = 2, k = 0;
+		while (i < params.n) {
+			const int l = params.levels[k++];
+
+			for (int run = 0; run < l; run++, i++)
+				if (run < 8)
+					_coefSymbols[table].push_back(i);
+		}
+	}
+
+	void putCoef(BitWriter &bits, int table, uint16 symbol) {
+		const Sound::WMACoefHuffmanParam &params = Sound::coefHuffmanParam[kCoefHuffmanBase + table];
+
+		bits.put(params.huffCodes[symbol], params.huffBits[symbol]);
+	}
+
+	void createFrame(std::vector<bool> &frame) {
+		BitWriter bits;
+
+		// Block sizes, filling up the frame
+		std::vector<int> blockSizes;
+
+		int frameLeft = 1 << kFrameLenBits;
+		while (frameLeft > 0) {
+			int size = 0;
+			if (_variableBlockLen) {
+				if (blockSizes.empty() && !_resetBlockLengths)
+					size = _nextBlockSize;
+				else
+					do {
+						size = _rng.next(kBlockSizeCount);
+					} while ((1 << (kFrameLenBits - size)) > frameLeft);
+			}
+
+			blockSizes.push_back(size);
+			frameLeft -= 1 << (kFrameLenBits - size);
+		}
+
+		for (size_t i = 0; i < blockSizes.size(); i++) {
+			const int bSize = blockSizes[i];
+
+			if (_variableBlockLen) {
+				if (_resetBlockLengths) {
+					bits.put(_rng.next(kBlockSizeCount), 2);
+					bits.put(bSize, 2);
+
+					_resetBlockLengths = false;
+				}
+
+				_nextBlockSize = (i + 1 < blockSizes.size()) ? blockSizes[i + 1] : _rng.next(kBlockSizeCount);
+				bits.put(_nextBlockSize, 2);
+			}
+
+			createBlock(bits, bSize);
+		}
+
+		frame = bits.getBits();
+	}
+
+	void createBlock(BitWriter &bits, int bSize) {
+		const bool msStereo = _rng.next(4) == 0;
+
+		const bool hasChannel[2] = { _rng.next(8) != 0, _rng.next(_rightChannelRate) == 0 };
+
+		bits.put(msStereo, 1);
+		bits.put(hasChannel[0], 1);
+		bits.put(hasChannel[1], 1);
+
+		if (!hasChannel[0] && !hasChannel[1])
+			return;
+
+		// Total gain
+		bits.put(1 + _rng.next(126), 7);
+
+		// Short blocks can reuse the exponents of the last block
+		const bool exponents = (bSize == 0) || (_rng.next(2) != 0);
+		if (bSize != 0)
+			bits.put(exponents, 1);
+
+		for (int i = 0; i < kChannels; i++) {
+			if (!hasChannel[i] || !exponents)
+				continue;
+
+			// LSP coefficients
+			for (int j = 0; j < Sound::kLSPCoefCount; j++)
+				bits.put(_rng.next(16), ((j == 0) || (j >= 8)) ? 3 : 4);
+		}
+
+		for (int i = 0; i < kChannels; i++) {
+			if (!hasChannel[i])
+				continue;
+
+			const int table = (i == 1) && msStereo;
+
+			// A few short runs of coefficients, then EOB
+			const uint32 count = _rng.next(5);
+			for (uint32 j = 0; j < count; j++) {
+				putCoef(bits, table, _coefSymbols[table][_rng.next(_coefSymbols[table].size())]);
+				bits.put(_rng.next(2), 1);
+			}
+
+			putCoef(bits, table, 1);
+		}
+	}
+
+	static Common::SeekableReadStream *createPacket(const std::vector<bool> &bits) {
+		byte *data = new byte[kBlockAlign];
+		std::memset(data, 0, kBlockAlign);
+
+		for (size_t i = 0; i < bits.size(); i++)
+			if (bits[i])
+				data[i >> 3] |= 0x80 >> (i & 7);
+
+		return new Common::MemoryReadStream(data, kBlockAlign, true);
+	}
+};
+
+/** WMAv2 extra data with the given flags. */
+static Common::SeekableReadStream *createExtraData(uint16 flags) {
+	static const size_t kSize = 6;
+
+	byte *data = new byte[kSize];
+	std::memset(data, 0, kSize);
+
+	WRITE_LE_UINT16(data + 4, flags);
+
+	return new Common::MemoryReadStream(data, kSize, true);
+}
+
+static void readAll(Sound::AudioStream &stream, std::vector<int16> &samples) {
+	int16 buffer[4096];
+
+	size_t n;
+	while ((n = stream.readBuffer(buffer, ARRAYSIZE(buffer))) > 0)
+		samples.insert(samples.end(), buffer, buffer + n);
+}
+
+/** Feed the packets one by one into a regular WMA stream. */
+static void decodeSerial(uint16 flags, const std::vector<Common::SeekableReadStream *> &packets,
+                         std::vector<int16> &samples) {
+
+	std::unique_ptr<Common::SeekableReadStream> extraData(createExtraData(flags));
+
+	std::unique_ptr<Sound::PacketizedAudioStream>
+		wma(Sound::makeWMAStream(2, kRate, kChannels, kBitRate, kBlockAlign, *extraData));
+
+	for (std::vector<Common::SeekableReadStream *>::const_iterator p = packets.begin(); p != packets.end(); ++p) {
+		(*p)->seek(0);
+		wma->queuePacket((*p)->readStream((*p)->size()));
+	}
+
+	wma->finish();
+
+	readAll(*wma, samples);
+}
+
+static void decodeParallel(uint16 flags, const std::vector<Common::SeekableReadStream *> &packets,
+                           size_t threadCount, std::vector<int16> &samples) {
+
+	std::unique_ptr<Common::SeekableReadStream> extraData(createExtraData(flags));
+
+	std::unique_ptr<Sound::RewindableAudioStream>
+		wma(Sound::decodeWMAStream(2, kRate, kChannels, kBitRate, kBlockAlign, *extraData, packets, threadCount));
+
+	readAll(*wma, samples);
+}
+
+static void compareDecoders(uint16 flags, uint32 rightChannelRate) {
+	Common::PtrVector<Common::SeekableReadStream> packets;
+	WMAStreamCreator(flags, rightChannelRate).createPackets(packets);
+
+	std::vector<int16> serial;
+	decodeSerial(flags, packets, serial);
+
+	ASSERT_FALSE(serial.empty());
+
+	static const size_t kThreadCounts[] = { 1, 2, 3, 8 };
+	for (size_t i = 0; i < ARRAYSIZE(kThreadCounts); i++) {
+		std::vector<int16> parallel;
+		decodeParallel(flags, packets, kThreadCounts[i], parallel);
+
+		ASSERT_EQ(parallel.size(), serial.size()) << "With " << kThreadCounts[i] << " threads";
+		EXPECT_TRUE(parallel == serial) << "With " << kThreadCounts[i] << " threads";
+	}
+}
+
+GTEST_TEST(WMAParallel, fixedBlockLength) {
+	compareDecoders(kFlagBitReservoir, 2);
+}
+
+GTEST_TEST(WMAParallel, variableBlockLength) {
+	compareDecoders(kFlagBitReservoir | kFlagVariableBlockLen, 2);
+}
+
+GTEST_TEST(WMAParallel, staleExponents) {
+	/* The right channel only rarely has data, so its exponents are often older
+	 * than the packets decoded to resync a segment. The boundary check has to
+	 * catch that and decode the segment again. */
+	compareDecoders(kFlagBitReservoir | kFlagVariableBlockLen, 64);
+}